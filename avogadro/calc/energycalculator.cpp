@@ -5,16 +5,75 @@
 
 #include "energycalculator.h"
 
+#include <avogadro/core/parallel.h>
+
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 namespace Avogadro::Calc {
 
 void EnergyCalculator::gradient(const TVector& x, TVector& grad)
 {
-  finiteGradient(x, grad);
+  numericalGradient(x, grad);
   cleanGradients(grad);
 }
 
+Real EnergyCalculator::valueAndGradient(const TVector& x, TVector& grad)
+{
+  Real energy = value(x);
+  gradient(x, grad);
+  return energy;
+}
+
+void EnergyCalculator::numericalGradient(const TVector& x, TVector& grad)
+{
+  // same step as cppoptlib::Problem::finiteGradient()
+  const Real eps = 2.2204e-6;
+  const Index size = x.rows();
+  grad.resize(size);
+  const bool useMask = (m_mask.rows() == x.rows());
+
+  // Each block of coordinates borrows a copy of the geometry and puts every
+  // coordinate back before returning it, so there is at most one copy for
+  // each worker thread.
+  std::vector<TVector> copies;
+  std::mutex copiesMutex;
+  auto block = [&](Index begin, Index end) {
+    TVector displaced;
+    {
+      std::lock_guard<std::mutex> lock(copiesMutex);
+      if (!copies.empty()) {
+        displaced.swap(copies.back());
+        copies.pop_back();
+      }
+    }
+    if (displaced.rows() == 0)
+      displaced = x;
+
+    for (Index d = begin; d < end; ++d) {
+      if (useMask && m_mask[d] == 0.0) {
+        grad[d] = 0.0; // frozen, no need to evaluate
+        continue;
+      }
+      displaced[d] = x[d] + eps;
+      Real forward = value(displaced);
+      displaced[d] = x[d] - eps;
+      Real backward = value(displaced);
+      displaced[d] = x[d];
+      grad[d] = (forward - backward) / (2.0 * eps);
+    }
+
+    std::lock_guard<std::mutex> lock(copiesMutex);
+    copies.push_back(std::move(displaced));
+  };
+
+  if (isThreadSafe())
+    Core::parallelFor(0, size, 3, block);
+  else
+    block(0, size);
+}
+
 void EnergyCalculator::cleanGradients(TVector& grad)
 {
   unsigned int size = grad.rows();
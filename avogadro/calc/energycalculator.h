@@ -87,6 +87,30 @@ public:
    */
   virtual void gradient(const TVector& x, TVector& grad) override;
 
+  /**
+   * Calculate both the energy and the gradients for this method. Methods
+   * which get both from the same pass over the atoms (or from the same call
+   * to an external program) should override this, since the line search
+   * in the optimizer asks for both at each trial step (see EnergyProblem).
+   * The default simply calls value() and gradient().
+   * @return the energy
+   */
+  virtual Real valueAndGradient(const TVector& x, TVector& grad);
+
+  /**
+   * @brief Indicate if value() can be called from several threads at once
+   * If so, the numerical gradient evaluates displaced geometries in
+   * parallel. Methods which cache state between calls or talk to an external
+   * process should leave this false.
+   */
+  virtual bool isThreadSafe() const { return false; }
+
+  /**
+   * Calculate the gradients with central finite differences, skipping
+   * frozen coordinates. This runs in parallel if isThreadSafe().
+   */
+  void numericalGradient(const TVector& x, TVector& grad);
+
   /**
    * Called to 'clean' gradients @param grad (e.g., for constraints)
    */
@@ -0,0 +1,24 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "energyproblem.h"
+
+namespace Avogadro::Calc {
+
+Real EnergyProblem::value(const TVector& x)
+{
+  m_x = x;
+  return m_calculator.valueAndGradient(x, m_gradient);
+}
+
+void EnergyProblem::gradient(const TVector& x, TVector& grad)
+{
+  if (x.rows() == m_x.rows() && x == m_x)
+    grad = m_gradient;
+  else
+    m_calculator.gradient(x, grad);
+}
+
+} // namespace Avogadro::Calc
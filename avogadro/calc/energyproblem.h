@@ -0,0 +1,50 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CALC_ENERGYPROBLEM_H
+#define AVOGADRO_CALC_ENERGYPROBLEM_H
+
+#include "avogadrocalcexport.h"
+
+#include "energycalculator.h"
+
+namespace Avogadro {
+namespace Calc {
+
+/**
+ * @class EnergyProblem energyproblem.h <avogadro/calc/energyproblem.h>
+ * @brief Passes an EnergyCalculator to the cppoptlib solvers.
+ *
+ * The More-Thuente line search used by the solvers asks for value(x) and
+ * then gradient(x) at every trial step. This evaluates both with one
+ * EnergyCalculator::valueAndGradient() call and answers the following
+ * gradient() from the result, so methods with a fused energy and gradient
+ * only do one pass per step.
+ *
+ * The calculator must outlive the problem, and its molecule and mask
+ * should not change while a solver runs.
+ */
+class AVOGADROCALC_EXPORT EnergyProblem : public cppoptlib::Problem<Real>
+{
+public:
+  explicit EnergyProblem(EnergyCalculator& calculator)
+    : m_calculator(calculator)
+  {
+  }
+
+  Real value(const TVector& x) override;
+  void gradient(const TVector& x, TVector& grad) override;
+
+private:
+  EnergyCalculator& m_calculator;
+  // the geometry and gradient from the last call to value()
+  TVector m_x;
+  TVector m_gradient;
+};
+
+} // end namespace Calc
+} // end namespace Avogadro
+
+#endif // AVOGADRO_CALC_ENERGYPROBLEM_H
@@ -7,13 +7,17 @@
 
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/neighborperceiver.h>
 #include <avogadro/core/unitcell.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace Avogadro::Calc {
 
 LennardJones::LennardJones()
-  : m_vdw(true), m_depth(100.0), m_exponent(6), m_cell(nullptr),
-    m_molecule(nullptr)
+  : m_molecule(nullptr), m_cell(nullptr), m_vdw(true), m_depth(100.0),
+    m_exponent(6), m_cutoff(0.0), m_skin(1.0)
 {
   // defined for 1-118
   for (unsigned int i = 1; i <= 118; ++i) {
@@ -23,9 +27,32 @@ LennardJones::LennardJones()
 
 LennardJones::~LennardJones() {}
 
+bool LennardJones::setConfiguration(Core::VariantMap& config)
+{
+  if (config.hasValue("cutoff"))
+    setCutoff(config.value("cutoff").toDouble());
+  if (config.hasValue("skin"))
+    setSkin(config.value("skin").toDouble());
+  return true;
+}
+
+void LennardJones::setCutoff(Real cutoff)
+{
+  m_cutoff = std::max(cutoff, Real(0.0));
+  m_listPositions.resize(0); // force a rebuild
+}
+
+void LennardJones::setSkin(Real skin)
+{
+  m_skin = std::max(skin, Real(0.0));
+  m_listPositions.resize(0);
+}
+
 void LennardJones::setMolecule(Core::Molecule* mol)
 {
   m_molecule = mol;
+  m_pairs.clear();
+  m_listPositions.resize(0);
 
   if (mol == nullptr) {
     return; // nothing to do
@@ -34,63 +61,135 @@ void LennardJones::setMolecule(Core::Molecule* mol)
   m_mask = mol->frozenAtomMask();
 
   m_cell = mol->unitCell(); // could be nullptr
-  int numAtoms = mol->atomCount();
+  Index numAtoms = mol->atomCount();
 
   // track atomic radii for this molecule
-  m_radii.setZero();
-  Eigen::MatrixXd radii(numAtoms, numAtoms);
+  m_radii.resize(numAtoms);
   Eigen::MatrixXd mask(numAtoms * 3, 1);
   mask.setOnes();
   m_mask = mask;
 
   for (Index i = 0; i < numAtoms; ++i) {
-    Core::Atom atom1 = mol->atom(i);
-    unsigned char number1 = atom1.atomicNumber();
-    double r1;
+    unsigned char number = mol->atomicNumber(i);
     if (m_vdw)
-      r1 = Core::Elements::radiusVDW(number1);
+      m_radii[i] = Core::Elements::radiusVDW(number);
     else
-      r1 = Core::Elements::radiusCovalent(number1);
-
-    for (Index j = i + 1; j < numAtoms; ++j) {
-      Core::Atom atom2 = mol->atom(j);
-      unsigned char number2 = atom2.atomicNumber();
-      double r2;
-      if (m_vdw)
-        r2 = Core::Elements::radiusVDW(number2);
-      else
-        r2 = Core::Elements::radiusCovalent(number2);
-
-      radii(i, j) = r1 + r2; // expected distance
+      m_radii[i] = Core::Elements::radiusCovalent(number);
+  }
+}
+
+void LennardJones::updateNeighborList(const Eigen::VectorXd& x)
+{
+  const Index numAtoms = x.rows() / 3;
+  if (m_listPositions.rows() == x.rows()) {
+    // Verlet criterion: pairs can only come within the cutoff once an atom
+    // has moved by more than half of the skin
+    const Real limit = 0.25 * m_skin * m_skin;
+    bool current = true;
+    for (Index i = 0; i < numAtoms && current; ++i) {
+      const Real moved =
+        (x.segment<3>(3 * i) - m_listPositions.segment<3>(3 * i))
+          .squaredNorm();
+      current = moved <= limit;
     }
+    if (current)
+      return;
+  }
+
+  Core::Array<Vector3> positions(numAtoms);
+  for (Index i = 0; i < numAtoms; ++i)
+    positions[i] = Vector3(x[3 * i], x[3 * i + 1], x[3 * i + 2]);
+
+  const float range = static_cast<float>(m_cutoff + m_skin);
+  m_pairs.clear();
+  auto addPair = [&](Index i, Index j, const Vector3&, double) {
+    // atoms do not interact with their own periodic images
+    if (i != j)
+      m_pairs.emplace_back(i, j);
+  };
+  if (m_cell != nullptr) {
+    Core::NeighborPerceiver(positions, range, *m_cell).visitPairs(addPair);
+    // a pair is listed once per image in range, but only the minimum image
+    // counts in evaluate()
+    std::sort(m_pairs.begin(), m_pairs.end());
+    m_pairs.erase(std::unique(m_pairs.begin(), m_pairs.end()), m_pairs.end());
+  } else {
+    Core::NeighborPerceiver(positions, range).visitPairs(addPair);
   }
 
-  m_radii = radii;
+  m_listPositions = x;
 }
 
-Real LennardJones::value(const Eigen::VectorXd& x)
+Real LennardJones::pairEnergy(Index i, Index j, Real r, Real& dE) const
+{
+  const Real ratio = std::pow((m_radii[i] + m_radii[j]) / r, m_exponent);
+  // dE/dr = depth * (-2n (R/r)^2n + 2n (R/r)^n) / r
+  dE = m_depth * 2 * m_exponent * (ratio - ratio * ratio) / r;
+  return m_depth * (ratio * ratio - 2.0 * ratio);
+}
+
+Real LennardJones::evaluate(const Eigen::VectorXd& x, Eigen::VectorXd* grad)
 {
+  if (grad != nullptr) {
+    grad->resize(x.rows());
+    grad->setZero(); // clear the gradients
+  }
+
   if (!m_molecule)
     return 0.0;
 
   // FYI https://en.wikipedia.org/wiki/Lennard-Jones_potential
-  //@todo handle unit cells and minimum distances
-  int numAtoms = m_molecule->atomCount();
-
   Real energy = 0.0;
-  // we put the conditional here outside the double loop
-  if (m_cell == nullptr) {
+  // force is ipos - jpos, or its minimum image
+  auto addPair = [&](Index i, Index j, Vector3 force) {
+    Real r = force.norm();
+    if (r < 0.1)
+      r = 0.1; // ensure we don't divide by zero
+
+    Real dE = 0.0;
+    Real e = pairEnergy(i, j, r, dE);
+    if (m_cutoff > 0.0) {
+      // shifted force, so that the energy and its derivative both go
+      // smoothly to zero at the cutoff
+      Real dECutoff = 0.0;
+      const Real eCutoff = pairEnergy(i, j, m_cutoff, dECutoff);
+      e -= eCutoff + (r - m_cutoff) * dECutoff;
+      dE -= dECutoff;
+    }
+    energy += e;
+    if (grad == nullptr)
+      return;
+
+    force = (dE / r) * force;
+
+    // update gradients
+    for (unsigned int c = 0; c < 3; ++c) {
+      (*grad)[3 * i + c] += force[c];
+      (*grad)[3 * j + c] -= force[c];
+    }
+  };
+
+  Index numAtoms = x.rows() / 3;
+  if (m_cutoff > 0.0) {
+    // only the pairs from the neighbor list
+    updateNeighborList(x);
+    const Real cutoffSq = m_cutoff * m_cutoff;
+    for (const auto& pair : m_pairs) {
+      const Index i = pair.first;
+      const Index j = pair.second;
+      Vector3 force = x.segment<3>(3 * i) - x.segment<3>(3 * j);
+      if (m_cell != nullptr)
+        force = m_cell->minimumImage(force);
+      if (force.squaredNorm() < cutoffSq)
+        addPair(i, j, force);
+    }
+  } else if (m_cell == nullptr) {
     // regular molecule
     for (Index i = 0; i < numAtoms; ++i) {
       Vector3 ipos(x[3 * i], x[3 * i + 1], x[3 * i + 2]);
       for (Index j = i + 1; j < numAtoms; ++j) {
         Vector3 jpos(x[3 * j], x[3 * j + 1], x[3 * j + 2]);
-        Real r = (ipos - jpos).norm();
-        if (r < 0.1)
-          r = 0.1; // ensure we don't divide by zero
-
-        Real ratio = pow((m_radii(i, j) / r), m_exponent);
-        energy += m_depth * (ratio * ratio - 2.0 * (ratio));
+        addPair(i, j, ipos - jpos);
       }
     }
   } else {
@@ -99,86 +198,33 @@ Real LennardJones::value(const Eigen::VectorXd& x)
       Vector3 ipos(x[3 * i], x[3 * i + 1], x[3 * i + 2]);
       for (Index j = i + 1; j < numAtoms; ++j) {
         Vector3 jpos(x[3 * j], x[3 * j + 1], x[3 * j + 2]);
-        Real r = m_cell->distance(ipos, jpos);
-        if (r < 0.1)
-          r = 0.1; // ensure we don't divide by zero
-
-        Real ratio = pow((m_radii(i, j) / r), m_exponent);
-        energy += m_depth * (ratio * ratio - 2.0 * (ratio));
+        addPair(i, j, m_cell->minimumImage(ipos - jpos));
       }
     }
   }
 
+  // handle any constraints
+  if (grad != nullptr)
+    cleanGradients(*grad);
+
   // qDebug() << " lj: " << energy;
   return energy;
 }
 
-void LennardJones::gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad)
+Real LennardJones::value(const Eigen::VectorXd& x)
 {
-  if (!m_molecule)
-    return;
-
-  // clear the gradients
-  grad.setZero();
-
-  int numAtoms = m_molecule->atomCount();
-  // we put the conditional here outside the double loop
-  if (m_cell == nullptr) {
-    // regular molecule
-    for (Index i = 0; i < numAtoms; ++i) {
-      Vector3 ipos(x[3 * i], x[3 * i + 1], x[3 * i + 2]);
-      for (Index j = i + 1; j < numAtoms; ++j) {
-        Vector3 jpos(x[3 * j], x[3 * j + 1], x[3 * j + 2]);
-        Vector3 force = ipos - jpos;
-
-        Real r = force.norm();
-        if (r < 0.1)
-          r = 0.1; // ensure we don't divide by zero
-
-        Real rad = pow(m_radii(i, j), m_exponent);
-        Real term1 = -2 * (m_exponent)*rad * rad * pow(r, -2 * m_exponent - 1);
-        Real term2 = 2 * (m_exponent)*rad * pow(r, -1 * m_exponent - 1);
-        Real dE = m_depth * (term1 + term2);
-
-        force = (dE / r) * force;
-
-        // update gradients
-        for (unsigned int c = 0; c < 3; ++c) {
-          grad[3 * i + c] += force[c];
-          grad[3 * j + c] -= force[c];
-        }
-      }
-    }
-  } else {
-    // unit cell
-    for (Index i = 0; i < numAtoms; ++i) {
-      Vector3 ipos(x[3 * i], x[3 * i + 1], x[3 * i + 2]);
-      for (Index j = i + 1; j < numAtoms; ++j) {
-        Vector3 jpos(x[3 * j], x[3 * j + 1], x[3 * j + 2]);
-        Vector3 force = m_cell->minimumImage(ipos - jpos);
-
-        Real r = force.norm();
-        if (r < 0.1)
-          r = 0.1; // ensure we don't divide by zero
-
-        Real rad = pow(m_radii(i, j), m_exponent);
-        Real term1 = -2 * (m_exponent)*rad * rad * pow(r, -2 * m_exponent - 1);
-        Real term2 = 2 * (m_exponent)*rad * pow(r, -1 * m_exponent - 1);
-        Real dE = m_depth * (term1 + term2);
-
-        force = (dE / r) * force;
+  return evaluate(x, nullptr);
+}
 
-        // update gradients
-        for (unsigned int c = 0; c < 3; ++c) {
-          grad[3 * i + c] += force[c];
-          grad[3 * j + c] -= force[c];
-        }
-      }
-    }
-  }
+void LennardJones::gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad)
+{
+  evaluate(x, &grad);
+}
 
-  // handle any constraints
-  cleanGradients(grad);
+Real LennardJones::valueAndGradient(const Eigen::VectorXd& x,
+                                    Eigen::VectorXd& grad)
+{
+  return evaluate(x, &grad);
 }
 
 } // namespace Avogadro::Calc
@@ -10,6 +10,9 @@
 
 #include <avogadro/calc/energycalculator.h>
 
+#include <utility>
+#include <vector>
+
 namespace Avogadro {
 namespace Core {
 class Molecule;
@@ -32,29 +35,83 @@ public:
 
   std::string description() const override
   {
-    return "Universal Lennard-Jones potential";
+    return "Universal Lennard-Jones potential. An optional cutoff uses a "
+           "shifted-force potential, which goes smoothly to zero at the cutoff.";
   }
 
   bool acceptsUnitCell() const override { return true; }
 
+  /**
+   * Without a cutoff, value() only reads the molecule's parameters. With a
+   * cutoff, it may rebuild the neighbor list, so it is not thread safe.
+   */
+  bool isThreadSafe() const override { return m_cutoff <= 0.0; }
+
   Core::Molecule::ElementMask elements() const override { return (m_elements); }
 
   Real value(const Eigen::VectorXd& x) override;
   void gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad) override;
+  Real valueAndGradient(const Eigen::VectorXd& x,
+                        Eigen::VectorXd& grad) override;
+
+  /**
+   * Reads the "cutoff" and "skin" options (in Angstrom), if present.
+   */
+  bool setConfiguration(Core::VariantMap& config) override;
 
   /**
    * Called when the current molecule changes.
    */
   void setMolecule(Core::Molecule* mol) override;
 
+  /**
+   * Only include pairs of atoms closer than @a cutoff (Angstrom), found with a
+   * Verlet neighbor list. The potential is shifted so that both the energy
+   * and the force of a pair go to zero at the cutoff. A cutoff of zero (the
+   * default) includes every pair of atoms, without any shift.
+   *
+   * In a unit cell each pair of atoms interacts once, through its minimum
+   * image, with or without a cutoff. Atoms never interact with their own
+   * images.
+   */
+  void setCutoff(Real cutoff);
+  Real cutoff() const { return m_cutoff; }
+
+  /**
+   * The neighbor list includes pairs up to cutoff() + skin() apart, and is
+   * only rebuilt once some atom has moved by more than half the skin.
+   */
+  void setSkin(Real skin);
+  Real skin() const { return m_skin; }
+
 protected:
+  /**
+   * Computes the energy, and the gradient as well if @a grad is not null, in
+   * one pass over the pairs of atoms.
+   */
+  Real evaluate(const Eigen::VectorXd& x, Eigen::VectorXd* grad);
+
+  /** Rebuilds the neighbor list if atoms moved too far since the last build. */
+  void updateNeighborList(const Eigen::VectorXd& x);
+
+  /** @return The unshifted energy of a pair, and its derivative in @a dE. */
+  Real pairEnergy(Index i, Index j, Real r, Real& dE) const;
+
   Core::Molecule* m_molecule;
   Core::UnitCell* m_cell;
-  Eigen::MatrixXd m_radii;
+  // atomic radius for each atom, the expected distance is the sum of two
+  std::vector<Real> m_radii;
   bool m_vdw;
   Real m_depth;
   int m_exponent;
 
+  Real m_cutoff;
+  Real m_skin;
+  // Verlet neighbor list: pairs of atoms, and the coordinates the list was
+  // built from
+  std::vector<std::pair<Index, Index>> m_pairs;
+  Eigen::VectorXd m_listPositions;
+
   Core::Molecule::ElementMask m_elements;
 };
 
@@ -0,0 +1,129 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/unitcell.h>
+#include <avogadro/core/version.h>
+#include <avogadro/core/xrdpattern.h>
+#include <avogadro/io/fileformatmanager.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::UnitCell;
+using Avogadro::Core::XrdPattern;
+using Avogadro::Io::FileFormatManager;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+void printHelp();
+
+// Parses "--name=value" into value, if current has that name.
+bool option(const string& current, const string& name, double& value)
+{
+  const string prefix = "--" + name + "=";
+  if (current.compare(0, prefix.size(), prefix) != 0)
+    return false;
+  value = std::atof(current.c_str() + prefix.size());
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  // Process the command line arguments, see what has been requested.
+  XrdPattern xrd;
+  string inFormat;
+  bool reflections = false;
+  std::vector<string> inFiles;
+  for (int i = 1; i < argc; ++i) {
+    string current(argv[i]);
+    double value = 0.0;
+    if (current == "--help" || current == "-h") {
+      printHelp();
+      return 0;
+    } else if (current == "--version" || current == "-v") {
+      cout << "Version: " << Avogadro::version() << endl;
+      return 0;
+    } else if (current == "-i" && i + 1 < argc) {
+      inFormat = argv[++i];
+    } else if (current == "--reflections") {
+      reflections = true;
+    } else if (option(current, "wavelength", value)) {
+      xrd.setWavelength(value);
+    } else if (option(current, "peakwidth", value)) {
+      xrd.setPeakWidth(value);
+    } else if (option(current, "numpoints", value)) {
+      xrd.setPointCount(static_cast<size_t>(value));
+    } else if (option(current, "max2theta", value)) {
+      xrd.setMax2Theta(value);
+    } else {
+      inFiles.push_back(current);
+    }
+  }
+
+  if (inFiles.empty()) {
+    printHelp();
+    return 1;
+  }
+
+  // Each structure is written as its own block, headed by the file name.
+  FileFormatManager& mgr = FileFormatManager::instance();
+  int failures = 0;
+  for (const auto& inFile : inFiles) {
+    Molecule mol;
+    if (!mgr.readFile(mol, inFile, inFormat)) {
+      cerr << "Failed to read " << inFile << endl;
+      ++failures;
+      continue;
+    }
+    const UnitCell* cell = mol.unitCell();
+    if (!cell) {
+      cerr << "No unit cell in " << inFile << endl;
+      ++failures;
+      continue;
+    }
+
+    Array<Vector3> fractional(mol.atomCount());
+    for (Index i = 0; i < mol.atomCount(); ++i)
+      fractional[i] = cell->toFractional(mol.atomPosition3d(i));
+    if (!xrd.compute(*cell, fractional, mol.atomicNumbers())) {
+      cerr << "Failed to compute the pattern of " << inFile << endl;
+      ++failures;
+      continue;
+    }
+
+    cout << "# " << inFile << "\n";
+    if (reflections) {
+      cout << "#    h    k    l    d    2Theta    multiplicity    intensity\n";
+      for (const auto& line : xrd.reflections()) {
+        cout << line.h << " " << line.k << " " << line.l << " "
+             << line.dSpacing << " " << line.twoTheta << " "
+             << line.multiplicity << " " << line.intensity << "\n";
+      }
+    } else {
+      cout << "#    2Theta    ICalc\n";
+      for (const auto& point : xrd.pattern())
+        cout << point.first << " " << point.second << "\n";
+    }
+    cout << endl;
+  }
+
+  return failures == 0 ? 0 : 1;
+}
+
+void printHelp()
+{
+  cout << "Usage: avoxrd [-i <input-type>] [--wavelength=<angstrom>] "
+          "[--peakwidth=<degrees>] [--numpoints=<count>] "
+          "[--max2theta=<degrees>] [--reflections] <infilename>...\n"
+       << endl;
+}
@@ -141,6 +141,7 @@ int main(int argc, char* argv[])
     cout << "1  " << orbitalNumber << endl;
 
   auto* m_tools = new GaussianSetTools(&mol);
+  m_tools->calculateMolecularOrbital(*m_qube, orbitalNumber);
 
   // print the qube values
   int linecount = 0;
@@ -149,8 +150,7 @@ int main(int argc, char* argv[])
       linecount = 0;
       printf("\n");
     }
-    double value =
-      m_tools->calculateMolecularOrbital(m_qube->position(i), orbitalNumber);
+    double value = (*m_qube->data())[i];
     printf("%13.5E", value);
     // line wrapping
     linecount++;
@@ -7,6 +7,11 @@
 
 #include "molecule.h"
 #include "mutex.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
 
 namespace Avogadro::Core {
 
@@ -280,6 +285,83 @@ void Cube::fill(float value_)
   m_minValue = m_maxValue = value_;
 }
 
+void Cube::fillParallel(
+  const std::function<void(Index, Index, float*)>& evaluate,
+  const std::function<void(Index, Index)>& progress)
+{
+  fillParallel(
+    std::vector<Cube*>(1, this),
+    [&evaluate](Index first, Index count, float* const* values) {
+      evaluate(first, count, values[0]);
+    },
+    progress);
+}
+
+bool Cube::fillParallel(
+  const std::vector<Cube*>& cubes,
+  const std::function<void(Index, Index, float* const*)>& evaluate,
+  const std::function<void(Index, Index)>& progress)
+{
+  if (cubes.empty())
+    return true;
+
+  // every cube has to sample the same points
+  const Cube& grid = *cubes[0];
+  for (const Cube* cube : cubes) {
+    if (cube->m_points != grid.m_points || cube->m_min != grid.m_min ||
+        cube->m_spacing != grid.m_spacing ||
+        cube->m_data.size() != grid.m_data.size())
+      return false;
+  }
+  if (grid.m_data.empty())
+    return true;
+
+  // slabs of whole planes, large enough to keep scheduling overhead small
+  const Index planes = grid.m_points.x();
+  const Index planeSize = grid.m_data.size() / planes;
+  const Index slabPlanes = std::max<Index>(1, 8192 / planeSize);
+  const Index slabs = (planes + slabPlanes - 1) / slabPlanes;
+
+  // minimum and maximum for each cube and slab, merged at the end
+  const size_t count = cubes.size();
+  std::vector<float> minValues(slabs * count,
+                               std::numeric_limits<float>::max());
+  std::vector<float> maxValues(slabs * count,
+                               std::numeric_limits<float>::lowest());
+  std::atomic<Index> slabsDone(0);
+
+  parallelFor(0, planes, slabPlanes, [&](Index begin, Index end) {
+    const Index first = begin * planeSize;
+    const Index points = (end - begin) * planeSize;
+    std::vector<float*> values(count);
+    for (size_t c = 0; c < count; ++c)
+      values[c] = cubes[c]->m_data.data() + first;
+
+    evaluate(first, points, values.data());
+
+    const Index slab = begin / slabPlanes;
+    for (size_t c = 0; c < count; ++c) {
+      auto range = std::minmax_element(values[c], values[c] + points);
+      minValues[slab * count + c] = *range.first;
+      maxValues[slab * count + c] = *range.second;
+    }
+    if (progress)
+      progress(++slabsDone, slabs);
+  });
+
+  for (size_t c = 0; c < count; ++c) {
+    cubes[c]->m_minValue = std::numeric_limits<float>::max();
+    cubes[c]->m_maxValue = std::numeric_limits<float>::lowest();
+    for (Index slab = 0; slab < slabs; ++slab) {
+      cubes[c]->m_minValue =
+        std::min(cubes[c]->m_minValue, minValues[slab * count + c]);
+      cubes[c]->m_maxValue =
+        std::max(cubes[c]->m_maxValue, maxValues[slab * count + c]);
+    }
+  }
+  return true;
+}
+
 bool Cube::fillStripe(
   unsigned int i, unsigned int j, unsigned int kfirst, unsigned int klast, float value_
 ) {
@@ -12,6 +12,7 @@
 
 #include "vector.h"
 
+#include <functional>
 #include <vector>
 
 namespace Avogadro {
@@ -214,6 +215,33 @@ public:
     unsigned int i, unsigned int j, unsigned int kfirst, unsigned int klast, float value
   );
 
+  /**
+   * @brief Fill the cube in parallel.
+   * The grid is split into slabs of whole x planes, which are contiguous in
+   * memory, and the slabs are handed out to worker threads (see
+   * parallelFor()). The minimum and maximum values are updated once every
+   * slab is done.
+   * @param evaluate Callable as evaluate(Index first, Index count,
+   * float* values), which must write the values of the @a count points
+   * starting at index @a first. It is called concurrently.
+   * @param progress Optional, called as progress(Index done, Index total)
+   * each time a slab is finished. It is called concurrently.
+   */
+  void fillParallel(const std::function<void(Index, Index, float*)>& evaluate,
+                    const std::function<void(Index, Index)>& progress =
+                      nullptr);
+
+  /**
+   * @brief Fill several cubes sharing the same grid in one parallel pass.
+   * As fillParallel(), but @a values[c] points to the storage for the
+   * slab in @p cubes[c].
+   * @return False if the cubes do not have the same limits and spacing.
+   */
+  static bool fillParallel(
+    const std::vector<Cube*>& cubes,
+    const std::function<void(Index, Index, float* const*)>& evaluate,
+    const std::function<void(Index, Index)>& progress = nullptr);
+
   /**
    * @return The minimum  value at any point in the Cube.
    */
@@ -0,0 +1,92 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "framecache.h"
+
+#include "mutex.h"
+
+#include <algorithm>
+
+namespace Avogadro::Core {
+
+FrameSource::~FrameSource() = default;
+
+FrameCache::FrameCache(std::shared_ptr<FrameSource> source, size_t capacity)
+  : m_source(std::move(source)), m_capacity(std::max<size_t>(capacity, 1)),
+    m_lock(new Mutex)
+{
+}
+
+FrameCache::~FrameCache()
+{
+  delete m_lock;
+}
+
+Index FrameCache::frameCount() const
+{
+  m_lock->lock();
+  const Index count = m_source ? m_source->frameCount() : 0;
+  m_lock->unlock();
+  return count;
+}
+
+Array<Vector3> FrameCache::frame(Index index)
+{
+  m_lock->lock();
+  auto it = m_lookup.find(index);
+  if (it != m_lookup.end()) {
+    // move it to the front, as the most recently used frame
+    m_frames.splice(m_frames.begin(), m_frames, it->second);
+    Array<Vector3> positions = it->second->second;
+    m_lock->unlock();
+    return positions;
+  }
+
+  Array<Vector3> positions;
+  if (m_source && index < m_source->frameCount() &&
+      m_source->readFrame(index, positions)) {
+    m_frames.emplace_front(index, positions);
+    m_lookup[index] = m_frames.begin();
+    trim();
+  } else {
+    positions.clear();
+  }
+  m_lock->unlock();
+  return positions;
+}
+
+void FrameCache::setCapacity(size_t capacity)
+{
+  m_lock->lock();
+  m_capacity = std::max<size_t>(capacity, 1);
+  trim();
+  m_lock->unlock();
+}
+
+size_t FrameCache::size() const
+{
+  m_lock->lock();
+  const size_t count = m_frames.size();
+  m_lock->unlock();
+  return count;
+}
+
+void FrameCache::clear()
+{
+  m_lock->lock();
+  m_frames.clear();
+  m_lookup.clear();
+  m_lock->unlock();
+}
+
+void FrameCache::trim()
+{
+  while (m_frames.size() > m_capacity) {
+    m_lookup.erase(m_frames.back().first);
+    m_frames.pop_back();
+  }
+}
+
+} // namespace Avogadro::Core
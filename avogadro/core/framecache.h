@@ -0,0 +1,103 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_FRAMECACHE_H
+#define AVOGADRO_CORE_FRAMECACHE_H
+
+#include "avogadrocoreexport.h"
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+namespace Avogadro {
+namespace Core {
+
+class Mutex;
+
+/**
+ * @class FrameSource framecache.h <avogadro/core/framecache.h>
+ * @brief Random access to the coordinate sets of a trajectory that is not
+ * held in memory, e.g., frames that are read from a file on demand.
+ */
+class AVOGADROCORE_EXPORT FrameSource
+{
+public:
+  virtual ~FrameSource();
+
+  /** @return The number of frames in the trajectory. */
+  virtual Index frameCount() const = 0;
+
+  /**
+   * Read the positions of frame @a index into @a positions.
+   * @return True on success.
+   */
+  virtual bool readFrame(Index index, Array<Vector3>& positions) = 0;
+};
+
+/**
+ * @class FrameCache framecache.h <avogadro/core/framecache.h>
+ * @brief A bounded cache of the frames of a FrameSource.
+ *
+ * Frames are read from the source the first time they are requested, and
+ * the least recently used frame is dropped once more than capacity() frames
+ * are held, so scrubbing through a trajectory of any length needs constant
+ * memory. All members may be called from several threads.
+ */
+class AVOGADROCORE_EXPORT FrameCache
+{
+public:
+  /** The number of frames held by default. */
+  static constexpr size_t DefaultCapacity = 32;
+
+  explicit FrameCache(std::shared_ptr<FrameSource> source,
+                      size_t capacity = DefaultCapacity);
+  ~FrameCache();
+
+  FrameCache(const FrameCache&) = delete;
+  FrameCache& operator=(const FrameCache&) = delete;
+
+  /** @return The number of frames in the source. */
+  Index frameCount() const;
+
+  /**
+   * @return Frame @a index, read from the source if it is not cached. The
+   * array is empty if the frame could not be read.
+   */
+  Array<Vector3> frame(Index index);
+
+  /** @return The maximum number of frames held in memory. */
+  size_t capacity() const { return m_capacity; }
+
+  /** Set the maximum number of frames held in memory (at least one). */
+  void setCapacity(size_t capacity);
+
+  /** @return The number of frames currently held in memory. */
+  size_t size() const;
+
+  /** Drop all cached frames. */
+  void clear();
+
+private:
+  void trim();
+
+  std::shared_ptr<FrameSource> m_source;
+  size_t m_capacity;
+  // Cached frames, the most recently used first.
+  std::list<std::pair<Index, Array<Vector3>>> m_frames;
+  std::unordered_map<Index, decltype(m_frames)::iterator> m_lookup;
+  Mutex* m_lock;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_FRAMECACHE_H
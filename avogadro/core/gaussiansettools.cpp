@@ -9,18 +9,46 @@
 #include "gaussianset.h"
 #include "molecule.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 using std::vector;
 
 namespace Avogadro::Core {
 
-GaussianSetTools::GaussianSetTools(Molecule* mol) : m_molecule(mol)
+namespace {
+// number of components (basis functions) in each type of shell
+Index componentCount(int type)
+{
+  switch (type) {
+    case GaussianSet::S:
+      return 1;
+    case GaussianSet::P:
+      return 3;
+    case GaussianSet::D:
+      return 6;
+    case GaussianSet::D5:
+      return 5;
+    case GaussianSet::F:
+      return 10;
+    case GaussianSet::F7:
+      return 7;
+    default:
+      // Not handled - no contribution
+      return 0;
+  }
+}
+} // namespace
+
+GaussianSetTools::GaussianSetTools(Molecule* mol)
+  : m_molecule(mol), m_basis(nullptr)
 {
   if (m_molecule) {
     m_basis = dynamic_cast<GaussianSet*>(m_molecule->basisSet());
     m_cutoffDistances.resize(7, 0.0); // s, p, d, f, g, h, i (for now)
-    calculateCutoffs();
+    if (m_basis)
+      calculateCutoffs();
   }
 }
 
@@ -28,30 +56,39 @@ GaussianSetTools::~GaussianSetTools() {}
 
 bool GaussianSetTools::calculateMolecularOrbital(Cube& cube, int moNumber) const
 {
-  for (size_t i = 0; i < cube.data()->size(); ++i) {
-    Vector3 pos = cube.position(i);
-    cube.setValue(i, calculateMolecularOrbital(pos, moNumber));
+  return calculateMolecularOrbitals(std::vector<Cube*>(1, &cube),
+                                    std::vector<int>(1, moNumber));
+}
+
+bool GaussianSetTools::calculateMolecularOrbitals(
+  const std::vector<Cube*>& cubes, const std::vector<int>& moNumbers) const
+{
+  if (cubes.size() != moNumbers.size())
+    return false;
+
+  const MatrixX& matrix = m_basis->moMatrix(m_type);
+  for (int mo : moNumbers) {
+    if (mo < 0 || mo >= static_cast<int>(matrix.cols()))
+      return false;
   }
-  return true;
+
+  return fillCubes(cubes, [&](GridBlock& block, MatrixX& results) {
+    contractOrbitals(block, matrix, moNumbers, results);
+  });
 }
 
 double GaussianSetTools::calculateMolecularOrbital(const Vector3& position,
                                                    int mo) const
 {
-  if (mo > static_cast<int>(m_basis->molecularOrbitalCount()))
-    return 0.0;
-
-  vector<double> values(calculateValues(position));
-
   const MatrixX& matrix = m_basis->moMatrix(m_type);
-  int matrixSize(static_cast<int>(matrix.rows()));
-
-  // Now calculate the value of the density at this point in space
-  double result(0.0);
-  for (int i = 0; i < matrixSize; ++i)
-    result += matrix(i, mo) * values[i];
+  if (mo < 0 || mo >= static_cast<int>(matrix.cols()))
+    return 0.0;
 
-  return result;
+  GridBlock block;
+  calculateValues(&position, 1, block);
+  MatrixX result;
+  contractOrbitals(block, matrix, std::vector<int>(1, mo), result);
+  return result(0, 0);
 }
 
 bool GaussianSetTools::calculateElectronDensity(Cube& cube) const
@@ -62,11 +99,17 @@ bool GaussianSetTools::calculateElectronDensity(Cube& cube) const
     m_basis->generateDensityMatrix();
   }
 
-  for (size_t i = 0; i < cube.data()->size(); ++i) {
-    Vector3 pos = cube.position(i);
-    cube.setValue(i, calculateElectronDensity(pos));
+  int matrixSize(static_cast<int>(m_basis->moMatrix().rows()));
+  if (matrix.rows() != matrixSize || matrix.cols() != matrixSize) {
+    cube.fill(0.0);
+    return true;
   }
-  return true;
+
+  return fillCubes(std::vector<Cube*>(1, &cube),
+                   [&](GridBlock& block, MatrixX& results) {
+                     results.resize(block.count, 1);
+                     contractDensity(block, matrix, results.data());
+                   });
 }
 
 double GaussianSetTools::calculateElectronDensity(const Vector3& position) const
@@ -78,28 +121,27 @@ double GaussianSetTools::calculateElectronDensity(const Vector3& position) const
     return 0.0;
   }
 
-  vector<double> values(calculateValues(position));
-
-  // Now calculate the value of the density at this point in space
+  GridBlock block;
+  calculateValues(&position, 1, block);
   double rho(0.0);
-  for (int i = 0; i < matrixSize; ++i) {
-    // Calculate the off-diagonal parts of the matrix
-    for (int j = 0; j < i; ++j)
-      rho += 2.0 * matrix(i, j) * (values[i] * values[j]);
-    // Now calculate the matrix diagonal
-    rho += matrix(i, i) * (values[i] * values[i]);
-  }
-
+  contractDensity(block, matrix, &rho);
   return rho;
 }
 
 bool GaussianSetTools::calculateSpinDensity(Cube& cube) const
 {
-  for (size_t i = 0; i < cube.data()->size(); ++i) {
-    Vector3 pos = cube.position(i);
-    cube.setValue(i, calculateSpinDensity(pos));
+  const MatrixX& matrix = m_basis->spinDensityMatrix();
+  int matrixSize(static_cast<int>(m_basis->moMatrix().rows()));
+  if (matrix.rows() != matrixSize || matrix.cols() != matrixSize) {
+    cube.fill(0.0);
+    return true;
   }
-  return true;
+
+  return fillCubes(std::vector<Cube*>(1, &cube),
+                   [&](GridBlock& block, MatrixX& results) {
+                     results.resize(block.count, 1);
+                     contractDensity(block, matrix, results.data());
+                   });
 }
 
 double GaussianSetTools::calculateSpinDensity(const Vector3& position) const
@@ -110,18 +152,10 @@ double GaussianSetTools::calculateSpinDensity(const Vector3& position) const
     return 0.0;
   }
 
-  vector<double> values(calculateValues(position));
-
-  // Now calculate the value of the density at this point in space
+  GridBlock block;
+  calculateValues(&position, 1, block);
   double rho(0.0);
-  for (int i = 0; i < matrixSize; ++i) {
-    // Calculate the off-diagonal parts of the matrix
-    for (int j = 0; j < i; ++j)
-      rho += 2.0 * matrix(i, j) * (values[i] * values[j]);
-    // Now calculate the matrix diagonal
-    rho += matrix(i, i) * (values[i] * values[i]);
-  }
-
+  contractDensity(block, matrix, &rho);
   return rho;
 }
 
@@ -181,284 +215,297 @@ inline void GaussianSetTools::calculateCutoffs()
   }
 }
 
-inline vector<double> GaussianSetTools::calculateValues(
-  const Vector3& position) const
+bool GaussianSetTools::fillCubes(
+  const std::vector<Cube*>& cubes,
+  const std::function<void(GridBlock&, MatrixX&)>& contract) const
 {
+  // make sure the basis is ready before the worker threads read it
   m_basis->initCalculation();
-  Index atomsSize = m_molecule->atomCount();
-  size_t basisSize = m_basis->symmetry().size();
-  const std::vector<int>& basis = m_basis->symmetry();
-  const std::vector<unsigned int>& atomIndices = m_basis->atomIndices();
-  vector<Vector3> deltas;
-  vector<double> dr2;
-  deltas.reserve(atomsSize);
-  dr2.reserve(atomsSize);
-
-  // Calculate our position
-  Vector3 pos(position * ANGSTROM_TO_BOHR);
-
-  // Calculate the deltas for the position
-  for (Index i = 0; i < atomsSize; ++i) {
-    deltas.emplace_back(pos -
-                        (m_molecule->atom(i).position3d() * ANGSTROM_TO_BOHR));
-    dr2.push_back(deltas[i].squaredNorm());
-  }
 
-  // Allocate space for the values to be calculated.
-  size_t matrixSize = m_basis->moMatrix().rows();
-  vector<double> values;
-  values.resize(matrixSize, 0.0);
+  return Cube::fillParallel(cubes, [&](Index first, Index count,
+                                       float* const* values) {
+    // each slab has its own workspace
+    GridBlock block;
+    vector<Vector3> positions(BlockSize);
+    MatrixX results;
+
+    const Cube& grid = *cubes[0];
+    for (Index start = 0; start < count; start += BlockSize) {
+      const Index points = std::min(BlockSize, count - start);
+      for (Index p = 0; p < points; ++p) {
+        positions[p] =
+          grid.position(static_cast<unsigned int>(first + start + p));
+      }
 
-  // Now calculate the values at this point in space
-  for (unsigned int i = 0; i < basisSize; ++i) {
-    // bail early if the distance is too big
-    double cutoff = m_cutoffDistances[symToL[basis[i]]];
-    if (dr2[atomIndices[i]] > cutoff)
-      continue;
+      calculateValues(positions.data(), points, block);
+      contract(block, results);
 
-    switch (basis[i]) {
-      case GaussianSet::S:
-        pointS(i, dr2[atomIndices[i]], values);
-        break;
-      case GaussianSet::P:
-        pointP(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
-        break;
-      case GaussianSet::D:
-        pointD(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
-        break;
-      case GaussianSet::D5:
-        pointD5(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
-        break;
-      case GaussianSet::F:
-        pointF(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
-        break;
-      case GaussianSet::F7:
-        pointF7(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
-        break;
-      default:
-        // Not handled - return a zero contribution
-        ;
+      for (size_t c = 0; c < cubes.size(); ++c) {
+        for (Index p = 0; p < points; ++p)
+          values[c][start + p] = static_cast<float>(results(p, c));
+      }
     }
-  }
-
-  return values;
+  }, m_progress);
 }
 
-inline void GaussianSetTools::pointS(unsigned int moIndex, double dr2,
-                                     vector<double>& values) const
+void GaussianSetTools::contractOrbitals(GridBlock& block,
+                                        const MatrixX& matrix,
+                                        const vector<int>& mos,
+                                        MatrixX& results) const
 {
-  // S type orbitals - the simplest of the calculations with one component
-  double tmp = 0.0;
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
-    tmp += m_basis->gtoCN()[cIndex++] * exp(-m_basis->gtoA()[i] * dr2);
+  // gather the coefficients of the significant functions, then a single
+  // matrix product gives every orbital at every point of the block
+  const Index significant = block.significant.size();
+  block.gathered.resize(significant, mos.size());
+  for (size_t m = 0; m < mos.size(); ++m) {
+    for (Index k = 0; k < significant; ++k)
+      block.gathered(k, m) = matrix(block.significant[k], mos[m]);
   }
-  // There is one MO coefficient per S shell basis.
-  values[m_basis->moIndices()[moIndex]] = tmp;
-}
 
-inline void GaussianSetTools::pointP(unsigned int moIndex, const Vector3& delta,
-                                     double dr2, vector<double>& values) const
-{
-  // P type orbitals have three components and each component has a different
-  // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
-  Vector3 components(Vector3::Zero());
-
-  // Now iterate through the P type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
-    double tmpGTO = exp(-m_basis->gtoA()[i] * dr2);
-    for (unsigned int j = 0; j < 3; ++j) {
-      // m_values[baseIndex + i] = m_basis->gtoCN()[cIndex++] * tmpGTO;
-      components[j] += m_basis->gtoCN()[cIndex++] * tmpGTO;
-    }
-  }
-  for (unsigned int i = 0; i < 3; ++i)
-    values[baseIndex + i] = components[i] * delta[i];
+  results.noalias() =
+    block.values.topLeftCorner(block.count, significant) * block.gathered;
 }
 
-inline void GaussianSetTools::pointD(unsigned int moIndex, const Vector3& delta,
-                                     double dr2, vector<double>& values) const
+void GaussianSetTools::contractDensity(GridBlock& block,
+                                       const MatrixX& matrix,
+                                       double* results) const
 {
-  // D type orbitals have six components and each component has a different
-  // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
-
-  double components[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-
-  vector<double>& gtoA = m_basis->gtoA();
-  vector<double>& gtoCN = m_basis->gtoCN();
-
-  // Now iterate through the D type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
-    // Calculate the common factor
-    double tmpGTO = exp(-gtoA[i] * dr2);
-    for (double& component : components)
-      component += gtoCN[cIndex++] * tmpGTO;
+  // only the block of the density matrix for the significant functions
+  // contributes: rho = sum_ij phi_i D_ij phi_j, i.e. rowsum((V D) .* V)
+  // Some readers (e.g., fchk) only fill the lower triangle, so only that is
+  // read and mirrored.
+  const Index count = block.count;
+  const Index significant = block.significant.size();
+  block.gathered.resize(significant, significant);
+  for (Index l = 0; l < significant; ++l) {
+    const Index j = block.significant[l];
+    for (Index k = 0; k < significant; ++k) {
+      const Index i = block.significant[k];
+      block.gathered(k, l) = matrix(std::max(i, j), std::min(i, j));
+    }
   }
 
-  double componentsD[6] = { delta.x() * delta.x(),   // xx
-                            delta.y() * delta.y(),   // yy
-                            delta.z() * delta.z(),   // zz
-                            delta.x() * delta.y(),   // xy
-                            delta.x() * delta.z(),   // xz
-                            delta.y() * delta.z() }; // yz
+  const auto values = block.values.topLeftCorner(count, significant);
+  block.product.noalias() = values * block.gathered;
 
-  for (int i = 0; i < 6; ++i)
-    values[baseIndex + i] += components[i] * componentsD[i];
+  Eigen::Map<Eigen::VectorXd> rho(results, count);
+  rho = block.product.cwiseProduct(values).rowwise().sum();
 }
 
-inline void GaussianSetTools::pointD5(unsigned int moIndex,
-                                      const Vector3& delta, double dr2,
-                                      vector<double>& values) const
+void GaussianSetTools::calculateValues(const Vector3* positions, Index count,
+                                       GridBlock& block) const
 {
-  // D type orbitals have five components and each component has a different
-  // MO weighting. Many things can be cached to save time.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
-  double components[5] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
-
-  vector<double>& gtoA = m_basis->gtoA();
-  vector<double>& gtoCN = m_basis->gtoCN();
-
-  // Now iterate through the D type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
-    // Calculate the common factor
-    double tmpGTO = exp(-gtoA[i] * dr2);
-    for (double& component : components)
-      component += gtoCN[cIndex++] * tmpGTO;
+  m_basis->initCalculation();
+  const Index atomsSize = m_molecule->atomCount();
+  const vector<int>& basis = m_basis->symmetry();
+  const vector<unsigned int>& atomIndices = m_basis->atomIndices();
+  const vector<unsigned int>& moIndices = m_basis->moIndices();
+  const vector<unsigned int>& gtoIndices = m_basis->gtoIndices();
+  const vector<unsigned int>& cIndices = m_basis->cIndices();
+  const vector<double>& gtoA = m_basis->gtoA();
+  const vector<double>& gtoCN = m_basis->gtoCN();
+  const Index matrixSize = m_basis->moMatrix().rows();
+
+  // only grow the workspace, so that it is allocated once per cube
+  block.count = count;
+  const Index rows = std::max(count, static_cast<Index>(block.dr2.rows()));
+  if (static_cast<Index>(block.dr2.rows()) != rows ||
+      static_cast<Index>(block.dr2.cols()) != atomsSize) {
+    block.dx.resize(rows, atomsSize);
+    block.dy.resize(rows, atomsSize);
+    block.dz.resize(rows, atomsSize);
+    block.dr2.resize(rows, atomsSize);
+    block.minDr2.resize(atomsSize);
+  }
+  if (static_cast<Index>(block.values.rows()) != rows ||
+      static_cast<Index>(block.values.cols()) < matrixSize) {
+    block.values.resize(rows, matrixSize);
+    block.radial.resize(rows, 10); // at most 10 components (F)
+    block.expTerm.resize(rows);
+    block.significant.reserve(matrixSize);
   }
 
-  // Calculate the prefactors
-  double xx = delta.x() * delta.x();
-  double yy = delta.y() * delta.y();
-  double zz = delta.z() * delta.z();
-  double xy = delta.x() * delta.y();
-  double xz = delta.x() * delta.z();
-  double yz = delta.y() * delta.z();
-
-  double componentsD[5] = { zz - dr2, // 0
-                            xz,       // 1p
-                            yz,       // 1n
-                            xx - yy,  // 2p
-                            xy };     // 2n
-
-  for (int i = 0; i < 5; ++i)
-    values[baseIndex + i] += componentsD[i] * components[i];
-}
-inline void GaussianSetTools::pointF(unsigned int moIndex, const Vector3& delta,
-                                     double dr2, vector<double>& values) const
-{
-  // F type orbitals have 10 components and each component has a different
-  // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
-
-  double components[10] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-
-  vector<double>& gtoA = m_basis->gtoA();
-  vector<double>& gtoCN = m_basis->gtoCN();
-
-  // Now iterate through the D type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
-    // Calculate the common factor
-    double tmpGTO = exp(-gtoA[i] * dr2);
-    for (double& component : components)
-      component += gtoCN[cIndex++] * tmpGTO;
+  // Calculate the deltas for the positions
+  for (Index a = 0; a < atomsSize; ++a) {
+    const Vector3 center(m_molecule->atomPosition3d(a) * ANGSTROM_TO_BOHR);
+    double* x = block.dx.col(a).data();
+    double* y = block.dy.col(a).data();
+    double* z = block.dz.col(a).data();
+    double* r2 = block.dr2.col(a).data();
+    double closest = std::numeric_limits<double>::max();
+    for (Index p = 0; p < count; ++p) {
+      const Vector3 delta(positions[p] * ANGSTROM_TO_BOHR - center);
+      x[p] = delta.x();
+      y[p] = delta.y();
+      z[p] = delta.z();
+      r2[p] = delta.squaredNorm();
+      closest = std::min(closest, r2[p]);
+    }
+    block.minDr2[a] = closest;
   }
 
-  double xxx = delta.x() * delta.x() * delta.x(); // xxx
-  double xxy = delta.x() * delta.x() * delta.y(); // xxy
-  double xxz = delta.x() * delta.x() * delta.z(); // xxz
-  double xyy = delta.x() * delta.y() * delta.y(); // xyy
-  double xyz = delta.x() * delta.y() * delta.z(); // xyz
-  double xzz = delta.x() * delta.z() * delta.z(); // xzz
-  double yyy = delta.y() * delta.y() * delta.y(); // yyy
-  double yyz = delta.y() * delta.y() * delta.z(); // yyz
-  double yzz = delta.y() * delta.z() * delta.z(); // yzz
-  double zzz = delta.z() * delta.z() * delta.z(); // zzz
-
-  double componentsF[10] = {
-    // molden order
-    // e.g https://gau2grid.readthedocs.io/en/latest/order.html
-    xxx, yyy, zzz, xyy, xxy, xxz, xzz, yzz, yyz, xyz
-  };
-
-  for (int i = 0; i < 10; ++i)
-    values[baseIndex + i] += components[i] * componentsF[i];
+  // Now calculate the values of each shell at these points
+  block.significant.clear();
+  for (size_t i = 0; i < basis.size(); ++i) {
+    const Index components = componentCount(basis[i]);
+    if (components == 0)
+      continue;
+
+    // skip the shell if every point is too far away
+    const unsigned int atom = atomIndices[i];
+    const double cutoff = m_cutoffDistances[symToL[basis[i]]];
+    if (block.minDr2[atom] > cutoff)
+      continue;
+
+    // contracted radial part, separately for each component since the
+    // normalized coefficients can differ (e.g., xx vs. xy)
+    const double* r2 = block.dr2.col(atom).data();
+    double* expTerm = block.expTerm.data();
+    for (Index c = 0; c < components; ++c)
+      std::fill_n(block.radial.col(c).data(), count, 0.0);
+
+    unsigned int cIndex = cIndices[i];
+    for (unsigned int j = gtoIndices[i]; j < gtoIndices[i + 1]; ++j) {
+      const double alpha = gtoA[j];
+      for (Index p = 0; p < count; ++p)
+        expTerm[p] = r2[p] > cutoff ? 0.0 : std::exp(-alpha * r2[p]);
+      for (Index c = 0; c < components; ++c) {
+        const double coefficient = gtoCN[cIndex++];
+        double* radial = block.radial.col(c).data();
+        for (Index p = 0; p < count; ++p)
+          radial[p] += coefficient * expTerm[p];
+      }
+    }
+
+    const Index column = static_cast<Index>(block.significant.size());
+    for (Index c = 0; c < components; ++c)
+      block.significant.push_back(moIndices[i] + c);
+    applyAngular(basis[i], atom, column, block);
+  }
 }
 
-inline void GaussianSetTools::pointF7(unsigned int moIndex,
-                                      const Vector3& delta, double dr2,
-                                      vector<double>& values) const
+void GaussianSetTools::applyAngular(int type, unsigned int atom, Index column,
+                                    GridBlock& block) const
 {
-  // F type orbitals have 7 components and each component has a different
-  // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
-
-  double components[7] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
-
-  vector<double>& gtoA = m_basis->gtoA();
-  vector<double>& gtoCN = m_basis->gtoCN();
-
-  // Now iterate through the D type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
-    // Calculate the common factor
-    double tmpGTO = exp(-gtoA[i] * dr2);
-    for (double& component : components)
-      component += gtoCN[cIndex++] * tmpGTO;
+  const Index count = block.count;
+  const double* x = block.dx.col(atom).data();
+  const double* y = block.dy.col(atom).data();
+  const double* z = block.dz.col(atom).data();
+  const double* r2 = block.dr2.col(atom).data();
+
+  const double* radial[10];
+  double* out[10];
+  for (Index c = 0; c < componentCount(type); ++c) {
+    radial[c] = block.radial.col(c).data();
+    out[c] = block.values.col(column + c).data();
   }
 
-  double xxx = delta.x() * delta.x() * delta.x(); // xxx
-  double xxy = delta.x() * delta.x() * delta.y(); // xxy
-  double xxz = delta.x() * delta.x() * delta.z(); // xxz
-  double xyy = delta.x() * delta.y() * delta.y(); // xyy
-  double xyz = delta.x() * delta.y() * delta.z(); // xyz
-  double xzz = delta.x() * delta.z() * delta.z(); // xzz
-  double yyy = delta.y() * delta.y() * delta.y(); // yyy
-  double yyz = delta.y() * delta.y() * delta.z(); // yyz
-  double yzz = delta.y() * delta.z() * delta.z(); // yzz
-  double zzz = delta.z() * delta.z() * delta.z(); // zzz
-
-  /*
-  spherical combinations borrowed from CASINO/Crystal documentation
-
-   linear combination
-3,0     z^3 - 3/2 * (x^2z + y^2z)      2z^3 - 3 * (x^2z + y^2z)      * 2
-3,1     6 * xz^2 - 3/2 * (x^3 + xy^2)  4xz^2 - x^3 - xy^2            * 2/3
-3,-1    6 * yz^2 - 3/2 * (x^2y + y^3)  4yz^2 - x^2y - y^3            * 2/3
-3,2     15 * (x^2z - y^2z)             x^2z - y^2z                   * 1/15
-3,-2    30 * xyz                       xyz                           * 1/30
-3,3     15 * x^3 - 45 * xy^2           x^3 - 3xy^2                   * 1/15
-3,-3    45 * x^2y - 15 * y^3           3x^2y - y^3                   * 1/15
-
-final normalization
-          (2 - delta_m,0) * (l - |m|)!
-*  root  ------------------------------                     (m-dependent)
-                (l + m)!
-*/
-  double root6 = 2.449489742783178;
-  double root60 = 7.745966692414834;
-  double root360 = 18.973665961010276;
-  double componentsF[7] = { zzz - 3.0 / 2.0 * (xxz + yyz),
-                            (6.0 * xzz - 3.0 / 2.0 * (xxx + xyy)) / root6,
-                            (6.0 * yzz - 3.0 / 2.0 * (xxy + yyy)) / root6,
-                            (15.0 * (xxz - yyz)) / root60,
-                            (30.0 * xyz) / root60,
-                            (15.0 * xxx - 45.0 * xyy) / root360,
-                            (45.0 * xxy - 15.0 * yyy) / root360 };
-
-  for (int i = 0; i < 7; ++i)
-    values[baseIndex + i] += components[i] * componentsF[i];
+  switch (type) {
+    case GaussianSet::S:
+      // S type orbitals - the simplest of the calculations with one component
+      for (Index p = 0; p < count; ++p)
+        out[0][p] = radial[0][p];
+      break;
+    case GaussianSet::P:
+      // P type orbitals have three components and each component has a
+      // different independent MO weighting
+      for (Index p = 0; p < count; ++p) {
+        out[0][p] = radial[0][p] * x[p];
+        out[1][p] = radial[1][p] * y[p];
+        out[2][p] = radial[2][p] * z[p];
+      }
+      break;
+    case GaussianSet::D:
+      // Cartesian D, order xx, yy, zz, xy, xz, yz
+      for (Index p = 0; p < count; ++p) {
+        out[0][p] = radial[0][p] * x[p] * x[p];
+        out[1][p] = radial[1][p] * y[p] * y[p];
+        out[2][p] = radial[2][p] * z[p] * z[p];
+        out[3][p] = radial[3][p] * x[p] * y[p];
+        out[4][p] = radial[4][p] * x[p] * z[p];
+        out[5][p] = radial[5][p] * y[p] * z[p];
+      }
+      break;
+    case GaussianSet::D5:
+      // Spherical D, order d0, d+1, d-1, d+2, d-2
+      for (Index p = 0; p < count; ++p) {
+        out[0][p] = radial[0][p] * (z[p] * z[p] - r2[p]);
+        out[1][p] = radial[1][p] * x[p] * z[p];
+        out[2][p] = radial[2][p] * y[p] * z[p];
+        out[3][p] = radial[3][p] * (x[p] * x[p] - y[p] * y[p]);
+        out[4][p] = radial[4][p] * x[p] * y[p];
+      }
+      break;
+    case GaussianSet::F:
+      // Cartesian F in molden order
+      // e.g https://gau2grid.readthedocs.io/en/latest/order.html
+      // xxx, yyy, zzz, xyy, xxy, xxz, xzz, yzz, yyz, xyz
+      for (Index p = 0; p < count; ++p) {
+        const double xx = x[p] * x[p];
+        const double yy = y[p] * y[p];
+        const double zz = z[p] * z[p];
+        out[0][p] = radial[0][p] * xx * x[p];
+        out[1][p] = radial[1][p] * yy * y[p];
+        out[2][p] = radial[2][p] * zz * z[p];
+        out[3][p] = radial[3][p] * x[p] * yy;
+        out[4][p] = radial[4][p] * xx * y[p];
+        out[5][p] = radial[5][p] * xx * z[p];
+        out[6][p] = radial[6][p] * x[p] * zz;
+        out[7][p] = radial[7][p] * y[p] * zz;
+        out[8][p] = radial[8][p] * yy * z[p];
+        out[9][p] = radial[9][p] * x[p] * y[p] * z[p];
+      }
+      break;
+    case GaussianSet::F7: {
+      /*
+      spherical combinations borrowed from CASINO/Crystal documentation
+
+       linear combination
+    3,0     z^3 - 3/2 * (x^2z + y^2z)      2z^3 - 3 * (x^2z + y^2z)      * 2
+    3,1     6 * xz^2 - 3/2 * (x^3 + xy^2)  4xz^2 - x^3 - xy^2            * 2/3
+    3,-1    6 * yz^2 - 3/2 * (x^2y + y^3)  4yz^2 - x^2y - y^3            * 2/3
+    3,2     15 * (x^2z - y^2z)             x^2z - y^2z                   * 1/15
+    3,-2    30 * xyz                       xyz                           * 1/30
+    3,3     15 * x^3 - 45 * xy^2           x^3 - 3xy^2                   * 1/15
+    3,-3    45 * x^2y - 15 * y^3           3x^2y - y^3                   * 1/15
+
+    final normalization
+              (2 - delta_m,0) * (l - |m|)!
+    *  root  ------------------------------                 (m-dependent)
+                    (l + m)!
+      */
+      const double root6 = 2.449489742783178;
+      const double root60 = 7.745966692414834;
+      const double root360 = 18.973665961010276;
+      for (Index p = 0; p < count; ++p) {
+        const double xx = x[p] * x[p];
+        const double yy = y[p] * y[p];
+        const double zz = z[p] * z[p];
+        const double xxx = xx * x[p];
+        const double xxy = xx * y[p];
+        const double xxz = xx * z[p];
+        const double xyy = x[p] * yy;
+        const double xyz = x[p] * y[p] * z[p];
+        const double xzz = x[p] * zz;
+        const double yyy = yy * y[p];
+        const double yyz = yy * z[p];
+        const double yzz = y[p] * zz;
+        const double zzz = zz * z[p];
+        out[0][p] = radial[0][p] * (zzz - 3.0 / 2.0 * (xxz + yyz));
+        out[1][p] =
+          radial[1][p] * (6.0 * xzz - 3.0 / 2.0 * (xxx + xyy)) / root6;
+        out[2][p] =
+          radial[2][p] * (6.0 * yzz - 3.0 / 2.0 * (xxy + yyy)) / root6;
+        out[3][p] = radial[3][p] * (15.0 * (xxz - yyz)) / root60;
+        out[4][p] = radial[4][p] * (30.0 * xyz) / root60;
+        out[5][p] = radial[5][p] * (15.0 * xxx - 45.0 * xyy) / root360;
+        out[6][p] = radial[6][p] * (45.0 * xxy - 15.0 * yyy) / root360;
+      }
+      break;
+    }
+    default:
+      break;
+  }
 }
 
 } // namespace Avogadro::Core
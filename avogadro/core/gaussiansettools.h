@@ -11,8 +11,10 @@
 #include "avogadrocore.h"
 
 #include "basisset.h"
+#include "matrix.h"
 #include "vector.h"
 
+#include <functional>
 #include <vector>
 
 namespace Avogadro {
@@ -26,6 +28,8 @@ class Molecule;
  * @class GaussianSetTools gaussiansettools.h <avogadro/core/gaussiansettools.h>
  * @brief Provide tools to calculate molecular orbitals, electron densities and
  * other derived data stored in a GaussianSet result.
+ *
+ * Cubes are filled in parallel, see Cube::fillParallel().
  * @author Marcus D. Hanwell
  */
 
@@ -41,6 +45,15 @@ public:
    */
   void setElectronType(BasisSet::ElectronType type) { m_type = type; }
 
+  /**
+   * @brief Set a function called as progress(done, total) while cubes are
+   * filled, see Cube::fillParallel(). It is called from worker threads.
+   */
+  void setProgressCallback(const std::function<void(Index, Index)>& progress)
+  {
+    m_progress = progress;
+  }
+
   /**
    * @brief Populate the cube with values for the molecular orbital.
    * @param cube The cube to be populated with values.
@@ -49,6 +62,18 @@ public:
    */
   bool calculateMolecularOrbital(Cube& cube, int molecularOrbitalNumber) const;
 
+  /**
+   * @brief Populate several cubes with molecular orbitals in one pass over
+   * the grid, so the basis functions are only evaluated once per point.
+   * @param cubes The cubes to be populated, which must all share the same
+   * limits and spacing.
+   * @param molecularOrbitalNumbers The molecular orbital for each cube.
+   * @return True on success, false on failure.
+   */
+  bool calculateMolecularOrbitals(
+    const std::vector<Cube*>& cubes,
+    const std::vector<int>& molecularOrbitalNumbers) const;
+
   /**
    * @brief Calculate the value of the specified molecular orbital at the
    * position specified.
@@ -96,10 +121,39 @@ public:
   bool isValid() const;
 
 private:
+  /**
+   * Scratch space for evaluating the basis functions at a block of points.
+   * Everything is stored with the points contiguous (one column per atom,
+   * component or basis function), so that the inner loops run over points.
+   */
+  struct GridBlock
+  {
+    Index count = 0;
+    // displacement of each point from each atom (Bohr)
+    MatrixX dx, dy, dz, dr2;
+    // the smallest dr2 for each atom, to screen whole shells
+    std::vector<double> minDr2;
+    // contracted radial part of the current shell, one column per component
+    MatrixX radial;
+    std::vector<double> expTerm;
+    // basis functions which are significant somewhere in the block, and
+    // their values (one column per significant function)
+    std::vector<Index> significant;
+    MatrixX values;
+    // the MO coefficients or density matrix elements of the significant
+    // functions, and their product with the values
+    MatrixX gathered;
+    MatrixX product;
+  };
+
+  // number of grid points evaluated together
+  static constexpr Index BlockSize = 128;
+
   Molecule* m_molecule;
   GaussianSet* m_basis;
   BasisSet::ElectronType m_type = BasisSet::Paired;
   std::vector<double> m_cutoffDistances;
+  std::function<void(Index, Index)> m_progress;
 
   bool isSmall(double value) const;
 
@@ -108,25 +162,34 @@ private:
   void calculateCutoffs();
 
   /**
-   * @brief Calculate the values at this position in space. The public calculate
-   * functions call this function to prepare values before multiplying by the
-   * molecular orbital or density matrix elements.
-   * @param position The position in space to calculate the value.
+   * @brief Calculate the values of the basis functions at a block of points.
+   * Shells which are beyond the cutoff for every point are skipped, and only
+   * the remaining basis functions are listed in @p block.significant.
+   * @param positions The positions in space (Angstrom).
+   * @param count The number of positions.
+   * @param block Workspace which receives the values, reused between blocks.
    */
-  std::vector<double> calculateValues(const Vector3& position) const;
-
-  void pointS(unsigned int index, double dr2,
-              std::vector<double>& values) const;
-  void pointP(unsigned int index, const Vector3& delta, double dr2,
-              std::vector<double>& values) const;
-  void pointD(unsigned int index, const Vector3& delta, double dr2,
-              std::vector<double>& values) const;
-  void pointD5(unsigned int index, const Vector3& delta, double dr2,
-               std::vector<double>& values) const;
-  void pointF(unsigned int index, const Vector3& delta, double dr2,
-              std::vector<double>& values) const;
-  void pointF7(unsigned int index, const Vector3& delta, double dr2,
-               std::vector<double>& values) const;
+  void calculateValues(const Vector3* positions, Index count,
+                       GridBlock& block) const;
+
+  // multiply the radial part of a shell by its angular components, storing
+  // the values starting at column @p column of block.values
+  void applyAngular(int type, unsigned int atom, Index column,
+                    GridBlock& block) const;
+
+  // contract the block values with the selected MO coefficient columns,
+  // giving one column of @p results per orbital
+  void contractOrbitals(GridBlock& block, const MatrixX& matrix,
+                        const std::vector<int>& mos, MatrixX& results) const;
+  // contract the block values with a (spin) density matrix
+  void contractDensity(GridBlock& block, const MatrixX& matrix,
+                       double* results) const;
+
+  // evaluate the cubes block by block in parallel, using @p contract to get
+  // the values (one column of the results per cube)
+  bool fillCubes(const std::vector<Cube*>& cubes,
+                 const std::function<void(GridBlock&, MatrixX&)>& contract)
+    const;
 
   // map from symmetry to angular momentum
   // S, SP, P, D, D5, F, F7, G, G9, etc.
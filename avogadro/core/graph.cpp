@@ -7,12 +7,24 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <set>
 #include <stack>
 
 namespace Avogadro::Core {
 
+namespace {
+// Revisions are unique across all graphs, so that a result cached for one
+// graph can never be taken for another one that happens to have as many
+// changes.
+size_t nextRevision()
+{
+  static std::atomic<size_t> revision(0);
+  return ++revision;
+}
+} // namespace
+
 Graph::Graph() {}
 
 Graph::Graph(size_t n)
@@ -23,12 +35,14 @@ Graph::Graph(size_t n)
     m_vertexToSubgraph[i] = -1;
     m_loneVertices.insert(i);
   }
+  m_revision = nextRevision();
 }
 
 Graph::~Graph() {}
 
 void Graph::setSize(size_t n)
 {
+  m_revision = nextRevision();
   // If the graph is being made smaller we first need to remove all of the edges
   // from the soon to be removed vertices.
   for (size_t i = n; i < m_adjacencyList.size(); ++i) {
@@ -60,6 +74,7 @@ bool Graph::isEmpty() const
 
 void Graph::clear()
 {
+  m_revision = nextRevision();
   m_adjacencyList.clear();
   m_edgeMap.clear();
   m_edgePairs.clear();
@@ -76,6 +91,7 @@ size_t Graph::addVertex()
 
 void Graph::removeVertex(size_t index)
 {
+  m_revision = nextRevision();
   assert(index < size());
   // Mark the subgraph as dirty, leave the work for later
   if (m_vertexToSubgraph[index] >= 0)
@@ -119,6 +135,7 @@ void Graph::removeVertex(size_t index)
 
 void Graph::swapVertexIndices(size_t a, size_t b)
 {
+  m_revision = nextRevision();
   // Swap all references to a and b in m_adjacencyList
   for (size_t i = 0; i < m_adjacencyList[a].size(); i++) {
     size_t otherIndex = m_adjacencyList[a][i];
@@ -181,6 +198,7 @@ size_t Graph::vertexCount() const
 
 size_t Graph::addEdge(size_t a, size_t b)
 {
+  m_revision = nextRevision();
   assert(a < size());
   assert(b < size());
   if (b < a)
@@ -244,6 +262,85 @@ size_t Graph::addEdge(size_t a, size_t b)
   return newEdgeIndex;
 }
 
+std::vector<size_t> Graph::addEdges(
+  const Array<std::pair<size_t, size_t>>& pairs)
+{
+  m_revision = nextRevision();
+  std::vector<size_t> result(pairs.size());
+  std::vector<size_t> touched;
+  touched.reserve(2 * pairs.size());
+  for (size_t k = 0; k < pairs.size(); ++k) {
+    size_t a = pairs[k].first;
+    size_t b = pairs[k].second;
+    assert(a < size());
+    assert(b < size());
+    if (b < a)
+      std::swap(a, b);
+
+    // Reuse an existing edge, degrees are small so a linear scan is fine.
+    const std::vector<size_t>& edgesA = m_edgeMap[a];
+    size_t existing = edgeCount();
+    for (size_t edgeIndex : edgesA) {
+      if (m_edgePairs[edgeIndex].first == b ||
+          m_edgePairs[edgeIndex].second == b) {
+        existing = edgeIndex;
+        break;
+      }
+    }
+    if (existing < edgeCount()) {
+      result[k] = existing;
+      continue;
+    }
+
+    size_t newEdgeIndex = edgeCount();
+    m_adjacencyList[a].push_back(b);
+    m_adjacencyList[b].push_back(a);
+    m_edgeMap[a].push_back(newEdgeIndex);
+    m_edgeMap[b].push_back(newEdgeIndex);
+    m_edgePairs.push_back(std::pair<size_t, size_t>(a, b));
+    result[k] = newEdgeIndex;
+    touched.push_back(a);
+    touched.push_back(b);
+  }
+
+  if (touched.empty())
+    return result;
+
+  // Merge every subgraph touched by the new edges into the largest of them,
+  // and mark it dirty: it will be split into its real connected components
+  // (with one traversal) the next time they are needed.
+  int target = -1;
+  for (size_t v : touched) {
+    int subgraph = m_vertexToSubgraph[v];
+    if (subgraph >= 0 &&
+        (target < 0 || m_subgraphToVertices[subgraph].size() >
+                         m_subgraphToVertices[target].size()))
+      target = subgraph;
+  }
+  if (target < 0)
+    target = createNewSubgraph();
+  for (size_t v : touched) {
+    int subgraph = m_vertexToSubgraph[v];
+    if (subgraph == target)
+      continue;
+    if (subgraph < 0) {
+      m_vertexToSubgraph[v] = target;
+      m_subgraphToVertices[target].insert(v);
+      m_loneVertices.erase(v);
+      continue;
+    }
+    for (size_t i : m_subgraphToVertices[subgraph]) {
+      m_subgraphToVertices[target].insert(i);
+      m_vertexToSubgraph[i] = target;
+    }
+    // Just leave it empty, it could be reused
+    m_subgraphToVertices[subgraph].clear();
+  }
+  m_subgraphDirty[target] = true;
+
+  return result;
+}
+
 std::set<size_t> Graph::checkConectivity(size_t a, size_t b) const
 {
   if (a == b) {
@@ -278,6 +375,7 @@ std::set<size_t> Graph::checkConectivity(size_t a, size_t b) const
 
 void Graph::removeEdge(size_t a, size_t b)
 {
+  m_revision = nextRevision();
   assert(a < size());
   assert(b < size());
 
@@ -340,6 +438,7 @@ void Graph::removeEdge(size_t edgeIndex)
 
 void Graph::removeEdges()
 {
+  m_revision = nextRevision();
   for (size_t i = 0; i < m_adjacencyList.size(); ++i) {
     m_adjacencyList[i].clear();
     m_edgeMap[i].clear();
@@ -353,6 +452,7 @@ void Graph::removeEdges()
 
 void Graph::removeEdges(size_t index)
 {
+  m_revision = nextRevision();
   m_vertexToSubgraph[index] = -1;
   m_loneVertices.insert(index);
   // Mark the subgraph as dirty, leave the work for later
@@ -366,6 +466,7 @@ void Graph::removeEdges(size_t index)
 
 void Graph::editEdgeInPlace(size_t edgeIndex, size_t a, size_t b)
 {
+  m_revision = nextRevision();
   auto& pair = m_edgePairs[edgeIndex];
 
   // Remove references to the deleted edge from both endpoints.
@@ -387,6 +488,7 @@ void Graph::editEdgeInPlace(size_t edgeIndex, size_t a, size_t b)
 
 void Graph::swapEdgeIndices(size_t edgeIndex1, size_t edgeIndex2)
 {
+  m_revision = nextRevision();
   // Find the 4 endpoints of both edges.
   const std::pair<size_t, size_t>& pair1 = m_edgePairs[edgeIndex1];
   std::array<size_t*, 2> changeTo2;
@@ -92,6 +92,16 @@ public:
    */
   size_t addEdge(size_t a, size_t b);
 
+  /**
+   * Adds edges between each pair of vertices in @p pairs, and returns the
+   * index of the edge for each pair. Pairs that are already connected (or
+   * repeated in @p pairs) keep their existing edge. New edges are appended in
+   * order, and connected components are only updated once for the whole
+   * batch, which is much faster than calling addEdge() repeatedly.
+   */
+  std::vector<size_t> addEdges(
+    const Array<std::pair<size_t, size_t>>& pairs);
+
   /**
    * Removes the edge between vertices @p a and @p b.
    * All vertices keep their indices. If the removed edge has an index lower
@@ -195,12 +205,20 @@ public:
    */
   size_t getConnectedID(size_t index) const;
 
+  /**
+   * @return a number that changes whenever vertices or edges are added,
+   * removed or reordered, so that results derived from the graph can be
+   * cached. Copies of a graph share its revision until either one changes.
+   */
+  size_t revision() const { return m_revision; }
+
 private:
   std::set<size_t> checkConectivity(size_t a, size_t b) const;
   std::vector<std::vector<size_t>> m_adjacencyList;
   std::vector<std::vector<size_t>> m_edgeMap;
   Array<std::pair<size_t, size_t>> m_edgePairs;
-  
+  size_t m_revision = 0;
+
   /** @return the (new or reused) index of a newly created empty subgraph. */
   int createNewSubgraph() const;
 
@@ -8,6 +8,8 @@
 #include "mutex.h"
 #include "neighborperceiver.h"
 
+#include <algorithm>
+
 using std::vector;
 
 namespace Avogadro::Core {
@@ -21,7 +23,7 @@ Mesh::Mesh() : m_stable(true), m_other(0), m_cube(0), m_lock(new Mutex)
 
 Mesh::Mesh(const Mesh& other)
   : m_vertices(other.m_vertices), m_normals(other.m_normals),
-    m_colors(other.m_colors), m_name(other.m_name), m_stable(true),
+    m_triangles(other.m_triangles), m_colors(other.m_colors), m_name(other.m_name), m_stable(true),
     m_isoValue(other.m_isoValue), m_other(other.m_other), m_cube(other.m_cube),
     m_lock(new Mutex)
 {
@@ -112,6 +114,19 @@ bool Mesh::addNormals(const Core::Array<Vector3f>& values)
   }
 }
 
+const Core::Array<unsigned int>& Mesh::triangles() const
+{
+  return m_triangles;
+}
+
+bool Mesh::setTriangles(const Core::Array<unsigned int>& values)
+{
+  if (values.size() % 3 != 0)
+    return false;
+  m_triangles = values;
+  return true;
+}
+
 const Core::Array<Color3f>& Mesh::colors() const
 {
   return m_colors;
@@ -148,6 +163,10 @@ bool Mesh::addColors(const Core::Array<Color3f>& values)
 
 bool Mesh::valid() const
 {
+  for (unsigned int index : m_triangles) {
+    if (index >= m_vertices.size())
+      return false;
+  }
   if (m_vertices.size() == m_normals.size()) {
     if (m_colors.size() == 1 || m_colors.size() == m_vertices.size())
       return true;
@@ -162,6 +181,7 @@ bool Mesh::clear()
 {
   m_vertices.clear();
   m_normals.clear();
+  m_triangles.clear();
   m_colors.clear();
   return true;
 }
@@ -169,7 +189,8 @@ bool Mesh::clear()
 Mesh& Mesh::operator=(const Mesh& other)
 {
   m_vertices = other.m_vertices;
-  m_normals = other.m_vertices;
+  m_normals = other.m_normals;
+  m_triangles = other.m_triangles;
   m_colors = other.m_colors;
   m_name = other.m_name;
   m_isoValue = other.m_isoValue;
@@ -183,6 +204,10 @@ void Mesh::smooth(int iterationCount)
     return;
   if (iterationCount <= 0)
     return;
+  if (!m_triangles.empty()) {
+    smoothIndexed(iterationCount);
+    return;
+  }
 
   // Map vertices to a plane and pass them to NeighborPerceiver
   // a line gives less performance, and a volume offers no more benefit
@@ -271,4 +296,58 @@ void Mesh::smooth(int iterationCount)
   }
 }
 
+void Mesh::smoothIndexed(int iterationCount)
+{
+  // The 1-ring of each vertex, in compressed rows. As for the unindexed
+  // mesh, a neighbor is listed once for every triangle sharing the edge.
+  const size_t vertexCount = m_vertices.size();
+  std::vector<size_t> ringStart(vertexCount + 1, 0);
+  for (unsigned int index : m_triangles)
+    ringStart[index + 1] += 2;
+  for (size_t v = 0; v < vertexCount; v++)
+    ringStart[v + 1] += ringStart[v];
+  std::vector<size_t> fill(ringStart.begin(), ringStart.end() - 1);
+  std::vector<unsigned int> ring(ringStart.back());
+  for (size_t t = 0; t < m_triangles.size(); t += 3) {
+    for (size_t corner = 0; corner < 3; corner++) {
+      const unsigned int v = m_triangles[t + corner];
+      ring[fill[v]++] = m_triangles[t + (corner + 1) % 3];
+      ring[fill[v]++] = m_triangles[t + (corner + 2) % 3];
+    }
+  }
+
+  float weight = 1.0f;
+  std::vector<Vector3f> inputVertices(vertexCount);
+  for (int iteration = iterationCount; iteration > 0; iteration--) {
+    std::copy(m_vertices.begin(), m_vertices.end(), inputVertices.begin());
+
+    // Apply Laplacian smoothing
+    for (size_t v = 0; v < vertexCount; v++) {
+      Vector3f output = weight * inputVertices[v];
+      float count = weight;
+      for (size_t n = ringStart[v]; n < ringStart[v + 1]; n++) {
+        if (ring[n] == v)
+          continue; // degenerate triangle
+        output += inputVertices[ring[n]];
+        count += 1.0f;
+      }
+      m_vertices[v] = output / count;
+    }
+  }
+
+  // Recompute normals
+  std::vector<Vector3f> normals(vertexCount, Vector3f::Zero());
+  for (size_t t = 0; t < m_triangles.size(); t += 3) {
+    const Vector3f& a = m_vertices[m_triangles[t]];
+    const Vector3f& b = m_vertices[m_triangles[t + 1]];
+    const Vector3f& c = m_vertices[m_triangles[t + 2]];
+    const Vector3f triangleNormal = (b - a).cross(c - a).normalized();
+    for (size_t corner = 0; corner < 3; corner++)
+      normals[m_triangles[t + corner]] += triangleNormal;
+  }
+  m_normals.resize(vertexCount);
+  for (size_t v = 0; v < vertexCount; v++)
+    m_normals[v] = normals[v].normalized();
+}
+
 } // End namespace Avogadro
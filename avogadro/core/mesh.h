@@ -29,6 +29,10 @@ class Mutex;
  * meshes should be owned by a Molecule. It should also be removed by the
  * Molecule that owns it. Meshes encapsulate triangular meshes that can also
  * have colors associated with each vertex.
+ *
+ * If no triangles are set, every three consecutive vertices form a triangle.
+ * Otherwise the triangles index into the vertices, which can then be shared
+ * between neighboring triangles.
  */
 
 class MeshPrivate;
@@ -162,6 +166,27 @@ public:
    */
   bool addNormals(const Core::Array<Vector3f>& values);
 
+  /**
+   * @return Array containing the vertex indices of the triangles, three per
+   * triangle. Empty if the vertices themselves form consecutive triangles.
+   */
+  const Core::Array<unsigned int>& triangles() const;
+
+  /**
+   * @return The number of triangles in the mesh.
+   */
+  unsigned int numTriangles() const
+  {
+    return static_cast<unsigned int>(
+      (m_triangles.empty() ? m_vertices.size() : m_triangles.size()) / 3);
+  }
+
+  /**
+   * Clear the triangles array and assign new values, three vertex indices
+   * per triangle.
+   */
+  bool setTriangles(const Core::Array<unsigned int>& values);
+
   /**
    * @return Array containing all of the colors in a one-dimensional array.
    */
@@ -225,8 +250,12 @@ public:
   friend class Molecule;
 
 private:
+  /** Smooth a mesh with triangles, whose vertices are already shared. */
+  void smoothIndexed(int iterationCount);
+
   Core::Array<Vector3f> m_vertices;
   Core::Array<Vector3f> m_normals;
+  Core::Array<unsigned int> m_triangles;
   Core::Array<Color3f> m_colors;
   std::string m_name;
   bool m_stable;
@@ -9,12 +9,15 @@
 #include "color3f.h"
 #include "cube.h"
 #include "elements.h"
+#include "framecache.h"
 #include "gaussianset.h"
 #include "layermanager.h"
 #include "mdlvalence_p.h"
 #include "mesh.h"
 #include "neighborperceiver.h"
+#include "parallel.h"
 #include "residue.h"
+#include "ringperceiver.h"
 #include "slaterset.h"
 #include "unitcell.h"
 
@@ -40,7 +43,9 @@ Molecule::Molecule(const Molecule& other)
     m_elements(other.m_elements), m_positions2d(other.m_positions2d),
     m_positions3d(other.m_positions3d), m_atomLabels(other.m_atomLabels),
     m_bondLabels(other.m_bondLabels), m_coordinates3d(other.m_coordinates3d),
-    m_timesteps(other.m_timesteps), m_hybridizations(other.m_hybridizations),
+    m_frameCache(other.m_frameCache), m_timesteps(other.m_timesteps),
+    m_frameCells(other.m_frameCells),
+    m_hybridizations(other.m_hybridizations),
     m_formalCharges(other.m_formalCharges), m_colors(other.m_colors),
     m_vibrationFrequencies(other.m_vibrationFrequencies),
     m_vibrationIRIntensities(other.m_vibrationIRIntensities),
@@ -137,7 +142,9 @@ Molecule::Molecule(Molecule&& other) noexcept
     m_elements(other.m_elements), m_positions2d(other.m_positions2d),
     m_positions3d(other.m_positions3d), m_atomLabels(other.m_atomLabels),
     m_bondLabels(other.m_bondLabels), m_coordinates3d(other.m_coordinates3d),
-    m_timesteps(other.m_timesteps), m_hybridizations(other.m_hybridizations),
+    m_frameCache(other.m_frameCache), m_timesteps(other.m_timesteps),
+    m_frameCells(other.m_frameCells),
+    m_hybridizations(other.m_hybridizations),
     m_formalCharges(other.m_formalCharges), m_colors(other.m_colors),
     m_vibrationFrequencies(other.m_vibrationFrequencies),
     m_vibrationIRIntensities(other.m_vibrationIRIntensities),
@@ -180,7 +187,9 @@ Molecule& Molecule::operator=(const Molecule& other)
     m_atomLabels = other.m_atomLabels;
     m_bondLabels = other.m_bondLabels;
     m_coordinates3d = other.m_coordinates3d;
+    m_frameCache = other.m_frameCache;
     m_timesteps = other.m_timesteps;
+    m_frameCells = other.m_frameCells;
     m_hybridizations = other.m_hybridizations;
     m_formalCharges = other.m_formalCharges;
     m_colors = other.m_colors,
@@ -243,7 +252,9 @@ Molecule& Molecule::operator=(Molecule&& other) noexcept
     m_atomLabels = other.m_atomLabels;
     m_bondLabels = other.m_bondLabels;
     m_coordinates3d = other.m_coordinates3d;
+    m_frameCache = other.m_frameCache;
     m_timesteps = other.m_timesteps;
+    m_frameCells = other.m_frameCells;
     m_hybridizations = other.m_hybridizations;
     m_formalCharges = other.m_formalCharges;
     m_colors = other.m_colors;
@@ -566,6 +577,33 @@ Molecule::AtomType Molecule::addAtom(unsigned char number, Vector3 position3d)
   return Molecule::addAtom(number);
 }
 
+void Molecule::addAtoms(const Array<unsigned char>& numbers,
+                        const Array<Vector3>& positions3d)
+{
+  assert(numbers.size() == positions3d.size());
+  if (numbers.empty())
+    return;
+
+  const Index previousCount = atomCount();
+  const bool hasPositions = m_positions3d.size() == previousCount;
+  m_atomicNumbers.reserve(previousCount + numbers.size());
+  if (hasPositions)
+    m_positions3d.reserve(previousCount + numbers.size());
+  for (Index i = 0; i < numbers.size(); ++i) {
+    m_atomicNumbers.push_back(numbers[i]);
+    if (hasPositions)
+      m_positions3d.push_back(positions3d[i]);
+    // we're not going to easily handle custom elements
+    if (numbers[i] <= element_count)
+      m_elements.set(numbers[i]);
+    else
+      m_elements.set(element_count - 1); // custom element
+    m_layers.addAtomToActiveLayer(previousCount + i);
+  }
+  m_graph.setSize(atomCount());
+  m_partialCharges.clear();
+}
+
 void Molecule::swapBond(Index a, Index b)
 {
   m_graph.swapEdgeIndices(a, b);
@@ -1174,6 +1212,7 @@ void Molecule::perceiveBondsSimple(const double tolerance, const double min)
 
   // cache atomic radii
   std::vector<double> radii(atomCount());
+  std::vector<bool> skip(atomCount());
   double max_radius = 0.0;
   for (size_t i = 0; i < radii.size(); i++) {
     radii[i] = Elements::radiusCovalent(atomicNumber(i));
@@ -1181,57 +1220,72 @@ void Molecule::perceiveBondsSimple(const double tolerance, const double min)
       radii[i] = 2.0;
     if (radii[i] > max_radius)
       max_radius = radii[i];
+    // Don't automatically bond nobel gases to anything
+    switch (atomicNumber(i)) {
+      case 2:  // He
+      case 10: // Ne
+      case 18: // Ar
+      case 36: // Kr
+        skip[i] = true;
+        break;
+      default:
+        break;
+    }
   }
 
   float maxDistance = 2.0 * max_radius + tolerance;
-  auto neighborPerceiver = NeighborPerceiver(m_positions3d, maxDistance);
+  // crystals also bond to the periodic images of their atoms
+  const NeighborPerceiver neighborPerceiver =
+    m_unitCell ? NeighborPerceiver(m_positions3d, maxDistance, *m_unitCell)
+               : NeighborPerceiver(m_positions3d, maxDistance);
 
   // check for bonds
   // O(n) average-case, O(n^2) worst-case
   // note that the "worst case" here would need to be an invalid molecule
-  Array<Index> neighbors;
-  for (Index i = 0; i < atomCount(); i++) {
-    Vector3 ipos = m_positions3d[i];
-    neighborPerceiver.getNeighborsInclusiveInPlace(neighbors, ipos);
-    for (unsigned long j : neighbors) {
-      double cutoff = radii[i] + radii[j] + tolerance;
-      Vector3 jpos = m_positions3d[j];
-      Vector3 diff = jpos - ipos;
-
-      // Don't automatically bond nobel gases to anything
-      switch (atomicNumber(i)) {
-        case 2:  // He
-        case 10: // Ne
-        case 18: // Ar
-        case 36: // Kr
-          continue;
-        default:
-          break;
-      }
-
-      // now for the other atom
-      switch (atomicNumber(j)) {
-        case 2:  // He
-        case 10: // Ne
-        case 18: // Ar
-        case 36: // Kr
-          continue;
-        default:
-          break;
-      }
-
-      if (std::fabs(diff[0]) > cutoff || std::fabs(diff[1]) > cutoff ||
-          std::fabs(diff[2]) > cutoff ||
-          (atomicNumber(i) == 1 && atomicNumber(j) == 1))
-        continue;
-
-      // check radius and add bond if needed
-      double cutoffSq = cutoff * cutoff;
-      double diffsq = diff.squaredNorm();
-      if (diffsq < cutoffSq && diffsq > min * min)
-        addBond(atom(i), atom(j), 1);
-    }
-  }
+  // each block of grid cells collects its own candidates, which are merged
+  // in order afterwards so the result does not depend on the thread count
+  const Array<unsigned char>& atomicNumbers = m_atomicNumbers;
+  const double minSq = min * min;
+  const Index cellCount = neighborPerceiver.cellCount();
+  const Index grainSize = std::max<Index>(
+    1, cellCount / (16 * static_cast<Index>(maxThreadCount())));
+  const Index blockCount =
+    atomCount() < 5000 ? 1 : (cellCount + grainSize - 1) / grainSize;
+  std::vector<std::vector<std::pair<Index, Index>>> blocks(blockCount);
+  parallelFor(0, cellCount, blockCount == 1 ? cellCount : grainSize,
+              [&](Index cellBegin, Index cellEnd) {
+    auto& pairs = blocks[blockCount == 1 ? 0 : cellBegin / grainSize];
+    neighborPerceiver.visitPairs(
+      cellBegin, cellEnd,
+      [&](Index i, Index j, const Vector3&, double diffsq) {
+        // an atom next to its own image is not a bond
+        if (i == j || skip[i] || skip[j] ||
+            (atomicNumbers[i] == 1 && atomicNumbers[j] == 1))
+          return;
+
+        // check radius and add bond if needed
+        double cutoff = radii[i] + radii[j] + tolerance;
+        double cutoffSq = cutoff * cutoff;
+        if (diffsq < cutoffSq && diffsq > minSq)
+          pairs.emplace_back(i, j);
+      });
+  });
+
+  Index total = 0;
+  for (const auto& pairs : blocks)
+    total += pairs.size();
+  Array<std::pair<Index, Index>> bondPairs;
+  bondPairs.reserve(total);
+  for (const auto& pairs : blocks)
+    bondPairs.insert(bondPairs.end(), pairs.begin(), pairs.end());
+  blocks.clear();
+
+  // keep the bond order independent of the cell layout; in small periodic
+  // cells a pair can be in range through more than one image
+  std::sort(bondPairs.begin(), bondPairs.end());
+  bondPairs.erase(std::unique(bondPairs.begin(), bondPairs.end()),
+                  bondPairs.end());
+  addBonds(bondPairs, Array<unsigned char>(bondPairs.size(), 1));
 }
 
 void Molecule::perceiveBondsFromResidueData()
@@ -1241,15 +1295,28 @@ void Molecule::perceiveBondsFromResidueData()
   }
 }
 
-int Molecule::coordinate3dCount()
+int Molecule::coordinate3dCount() const
 {
-  return static_cast<int>(m_coordinates3d.size());
+  Index count = m_coordinates3d.size();
+  if (m_frameCache)
+    count = std::max(count, m_frameCache->frameCount());
+  return static_cast<int>(count);
 }
 
 bool Molecule::setCoordinate3d(int coord)
 {
-  if (coord >= 0 && coord < static_cast<int>(m_coordinates3d.size())) {
-    m_positions3d = m_coordinates3d[coord];
+  if (coord >= 0 && coord < coordinate3dCount()) {
+    Array<Vector3> coords = coordinate3d(coord);
+    if (coords.empty() && !m_positions3d.empty())
+      return false; // the frame could not be read
+    m_positions3d = coords;
+    Matrix3 cellMatrix;
+    if (frameCell(coord, cellMatrix)) {
+      if (m_unitCell)
+        m_unitCell->setCellMatrix(cellMatrix);
+      else
+        m_unitCell = new UnitCell(cellMatrix);
+    }
     return true;
   }
   return false;
@@ -1258,11 +1325,21 @@ bool Molecule::setCoordinate3d(int coord)
 void Molecule::clearCoordinate3d()
 {
   m_coordinates3d.clear();
+  m_frameCache.reset();
+  m_frameCells.clear();
 }
 
 Array<Vector3> Molecule::coordinate3d(int index) const
 {
-  return m_coordinates3d[index];
+  if (index < 0)
+    return Array<Vector3>();
+  const auto i = static_cast<Index>(index);
+  if (i < m_coordinates3d.size() &&
+      (!m_frameCache || !m_coordinates3d[i].empty()))
+    return m_coordinates3d[i];
+  if (m_frameCache)
+    return m_frameCache->frame(i);
+  return Array<Vector3>();
 }
 
 bool Molecule::setCoordinate3d(const Array<Vector3>& coords, int index)
@@ -1273,6 +1350,15 @@ bool Molecule::setCoordinate3d(const Array<Vector3>& coords, int index)
   return true;
 }
 
+void Molecule::setFrameSource(std::shared_ptr<FrameSource> source,
+                              size_t cacheSize)
+{
+  if (source)
+    m_frameCache = std::make_shared<FrameCache>(std::move(source), cacheSize);
+  else
+    m_frameCache.reset();
+}
+
 double Molecule::timeStep(int index, bool& status)
 {
   if (static_cast<int>(m_timesteps.size()) <= index) {
@@ -1291,6 +1377,25 @@ bool Molecule::setTimeStep(double timestep, int index)
   return true;
 }
 
+bool Molecule::setFrameCell(const Matrix3& cellMatrix, int index)
+{
+  if (index < 0)
+    return false;
+  if (static_cast<int>(m_frameCells.size()) <= index)
+    m_frameCells.resize(index + 1, Matrix3::Zero());
+  m_frameCells[index] = cellMatrix;
+  return true;
+}
+
+bool Molecule::frameCell(int index, Matrix3& cellMatrix) const
+{
+  if (index < 0 || static_cast<int>(m_frameCells.size()) <= index ||
+      m_frameCells[index].isZero())
+    return false;
+  cellMatrix = m_frameCells[index];
+  return true;
+}
+
 Array<Vector3>& Molecule::forceVectors()
 {
   return m_forceVectors;
@@ -1323,6 +1428,15 @@ Index Molecule::residueCount() const
   return static_cast<Index>(m_residues.size());
 }
 
+const std::vector<std::vector<size_t>>& Molecule::rings() const
+{
+  if (m_ringsRevision != m_graph.revision()) {
+    m_rings = RingPerceiver(this).rings();
+    m_ringsRevision = m_graph.revision();
+  }
+  return m_rings;
+}
+
 bool Molecule::setBondPairs(const Array<std::pair<Index, Index>>& pairs)
 {
   if (pairs.size() == bondCount()) {
@@ -1475,11 +1589,16 @@ Array<unsigned char> Molecule::getAtomOrders(Index index) const
 void Molecule::addBonds(const Array<std::pair<Index, Index>>& bonds,
                         const Array<unsigned char>& orders)
 {
-  Index i = 0;
-  for (auto p : bonds) {
-    addBond(p.first, p.second, orders[i]);
-    ++i;
-  }
+  assert(bonds.size() == orders.size());
+  if (bonds.empty())
+    return;
+
+  std::vector<size_t> edges = m_graph.addEdges(bonds);
+  m_bondOrders.resize(m_graph.edgeCount(), 1);
+  for (Index i = 0; i < edges.size(); ++i)
+    m_bondOrders[edges[i]] = orders[i];
+  // any existing charges are invalidated
+  m_partialCharges.clear();
 }
 
 std::list<Index> Molecule::getAtomsAtLayer(size_t layer)
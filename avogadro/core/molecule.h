@@ -15,18 +15,22 @@
 #include "elements.h"
 #include "graph.h"
 #include "layer.h"
+#include "matrix.h"
 #include "variantmap.h"
 #include "vector.h"
 
 #include <bitset>
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 
 namespace Avogadro {
 namespace Core {
 class BasisSet;
 class Cube;
+class FrameCache;
+class FrameSource;
 class Mesh;
 class Residue;
 class UnitCell;
@@ -342,6 +346,14 @@ public:
   virtual AtomType addAtom(unsigned char atomicNumber);
   AtomType addAtom(unsigned char atomicNumber, Vector3 position3d);
 
+  /**
+   * Adds an atom for each of @a atomicNumbers, at the matching position from
+   * @a positions3d. The atoms are appended in one batch, which is much faster
+   * than repeated calls to addAtom() for large numbers of atoms.
+   */
+  virtual void addAtoms(const Array<unsigned char>& atomicNumbers,
+                        const Array<Vector3>& positions3d);
+
   /**
    * @brief Remove the specified atom from the molecule.
    * @param index The index of the atom to be removed.
@@ -573,7 +585,8 @@ public:
   /**
    * Perceives bonds in the molecule based on the 3D coordinates of the atoms.
    *  atoms are considered bonded if within the sum of radii
-   *  plus a small @p tolerance.
+   *  plus a small @p tolerance. If the molecule has a unit cell, atoms
+   *  are also bonded to the periodic images of their neighbors.
    * @param tolerance The calculation tolerance.
    * @param minDistance = atoms closer than the square of this are ignored
    */
@@ -597,7 +610,7 @@ public:
    */
   void perceiveSubstitutedCations();
 
-  int coordinate3dCount();
+  int coordinate3dCount() const;
   bool setCoordinate3d(int coord);
   Array<Vector3> coordinate3d(int index) const;
   bool setCoordinate3d(const Array<Vector3>& coords, int index);
@@ -607,12 +620,35 @@ public:
    */
   void clearCoordinate3d();
 
+  /**
+   * Read coordinate sets from @p source on demand, instead of storing them
+   * all, e.g., for trajectories too large to hold in memory. At most
+   * @p cacheSize frames are kept in memory at once. Sets stored with
+   * setCoordinate3d() take precedence over the frames of the source.
+   */
+  void setFrameSource(std::shared_ptr<FrameSource> source,
+                      size_t cacheSize = 32);
+
+  /**
+   * @return The cache of frames read from the frame source, or nullptr if
+   * all coordinate sets are stored in the molecule.
+   */
+  std::shared_ptr<FrameCache> frameCache() const { return m_frameCache; }
+
   /**
    * Timestep property is used when molecular dynamics trajectories are read
    */
   bool setTimeStep(double timestep, int index);
   double timeStep(int index, bool& status);
 
+  /**
+   * The unit cell of a coordinate set, for trajectories whose cell changes
+   * from frame to frame (e.g., constant pressure runs). setCoordinate3d()
+   * applies the cell of the new set to unitCell().
+   */
+  bool setFrameCell(const Matrix3& cellMatrix, int index);
+  bool frameCell(int index, Matrix3& cellMatrix) const;
+
   /** @return a vector of forces for the atoms in the molecule. */
   const Array<Vector3>& forceVectors() const;
 
@@ -691,6 +727,14 @@ public:
   /** @return the graph for the molecule. */
   inline const Graph& graph() const;
 
+  /**
+   * @return the smallest set of smallest rings, each as a list of atom indices
+   * in ring order. The rings are perceived on first use and kept until the
+   * bonds change.
+   * @sa RingPerceiver
+   */
+  const std::vector<std::vector<size_t>>& rings() const;
+
   /** @return a vector of atomic numbers for the atoms in the molecule. */
   inline const Array<unsigned char>& atomicNumbers() const;
 
@@ -786,8 +830,14 @@ public:
                                                      const Index& b);
   bool removeBonds(Index atom);
 
-  void addBonds(const Array<std::pair<Index, Index>>& bonds,
-                const Array<unsigned char>& orders);
+  /**
+   * Adds bonds between each pair of atoms in @a bonds, with the matching
+   * bond order from @a orders. Existing bonds only have their order updated.
+   * The bonds are inserted into the graph in one batch, which is much faster
+   * than repeated calls to addBond() for large numbers of bonds.
+   */
+  virtual void addBonds(const Array<std::pair<Index, Index>>& bonds,
+                        const Array<unsigned char>& orders);
 
   // chenge the bond index position
   void swapBond(Index a, Index b);
@@ -823,7 +873,9 @@ protected:
   Array<std::string> m_atomLabels;
   Array<std::string> m_bondLabels;
   Array<Array<Vector3>> m_coordinates3d; //!< Store conformers/trajectories.
+  std::shared_ptr<FrameCache> m_frameCache; //!< Frames read on demand.
   Array<double> m_timesteps;
+  Array<Matrix3> m_frameCells; //!< Zero for sets without their own cell.
   Array<AtomHybridization> m_hybridizations;
   Array<signed char> m_formalCharges;
   Array<Vector3> m_forceVectors;
@@ -851,6 +903,9 @@ protected:
 
 private:
   mutable Graph m_graph; // A transformation of the molecule to a graph.
+  // rings cached for the graph revision they were perceived at
+  mutable std::vector<std::vector<size_t>> m_rings;
+  mutable size_t m_ringsRevision = 0;
   // edge information
   Array<unsigned char> m_bondOrders;
   // vertex information
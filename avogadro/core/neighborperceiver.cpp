@@ -5,18 +5,36 @@
 
 #include "neighborperceiver.h"
 
+#include "unitcell.h"
+
+#include <algorithm>
+#include <cmath>
+
 namespace Avogadro::Core {
 
-NeighborPerceiver::NeighborPerceiver(const Array<Vector3> points, float maxDistance)
- : m_maxDistance(maxDistance), m_cachedArray(nullptr)
+namespace {
+// Upper bound on the number of grid cells, relative to the number of points.
+double maxCellCount(size_t points)
 {
-  if (!points.size()) return;
+  return 8.0 * static_cast<double>(points) + 4096.0;
+}
+} // namespace
+
+NeighborPerceiver::NeighborPerceiver(const Array<Vector3>& points,
+                                     float maxDistance)
+  : m_maxDistance(maxDistance), m_binSize(maxDistance), m_binCount{ 0, 0, 0 },
+    m_minPos(Vector3::Zero()), m_maxPos(Vector3::Zero()), m_periodic(false),
+    m_cellMatrix(Matrix3::Identity()), m_fractionalMatrix(Matrix3::Identity()),
+    m_planeSpacing(Vector3::Zero())
+{
+  if (!points.size())
+    return;
 
   // find bounding box
   m_minPos = points[0];
   m_maxPos = points[0];
   for (Index i = 1; i < points.size(); i++) {
-    Vector3 ipos = points[i];
+    const Vector3& ipos = points[i];
     for (size_t c = 0; c < 3; c++) {
       m_minPos(c) = std::min(ipos(c), m_minPos(c));
       m_maxPos(c) = std::max(ipos(c), m_maxPos(c));
@@ -25,40 +43,143 @@ NeighborPerceiver::NeighborPerceiver(const Array<Vector3> points, float maxDista
 
   // group points into cubic bins so that each point is only checked against
   // other points inside bins within a 3-dimensional Moore neighborhood
-  for (size_t c = 0; c < 3; c++)
-    m_binCount[c] = std::floor((m_maxPos(c) + 0.1 - m_minPos(c)) / m_maxDistance) + 1;
-  std::vector<std::vector<std::vector<std::vector<Index>>>> bins(
-    m_binCount[0], std::vector<std::vector<std::vector<Index>>>(
-      m_binCount[1], std::vector<std::vector<Index>>(
-        m_binCount[2], std::vector<Index>()
-      )
-    )
-  );
-  m_bins = bins;
+  // bins may be larger than the maximum distance, but never smaller; grow
+  // them if a sparse cloud (e.g., one far outlier) would need a huge grid
+  const double maxCells = maxCellCount(points.size());
+  if (!(m_binSize > 0.0))
+    m_binSize = 1.0;
+  for (;;) {
+    double total = 1.0;
+    for (size_t c = 0; c < 3; c++) {
+      m_binCount[c] = static_cast<int>(
+        std::floor((m_maxPos(c) + 0.1 - m_minPos(c)) / m_binSize) + 1);
+      total *= m_binCount[c];
+    }
+    if (total <= maxCells)
+      break;
+    m_binSize *= std::cbrt(total / maxCells) * 1.01;
+  }
+
+  m_positions.assign(points.begin(), points.end());
+  std::vector<Index> pointCell(points.size());
   for (Index i = 0; i < points.size(); i++) {
     std::array<int, 3> bin_index = getBinIndex(points[i]);
-    m_bins.at(bin_index[0]).at(bin_index[1]).at(bin_index[2]).push_back(i);
+    pointCell[i] = cellIndex(bin_index[0], bin_index[1], bin_index[2]);
+  }
+  sortPoints(pointCell);
+}
+
+NeighborPerceiver::NeighborPerceiver(const Array<Vector3>& points,
+                                     float maxDistance, const UnitCell& cell)
+  : m_maxDistance(maxDistance), m_binSize(maxDistance), m_binCount{ 0, 0, 0 },
+    m_minPos(Vector3::Zero()), m_maxPos(Vector3::Zero()), m_periodic(true),
+    m_cellMatrix(cell.cellMatrix()), m_fractionalMatrix(cell.fractionalMatrix())
+{
+  // The distance between opposite faces of the cell along each lattice
+  // direction is 1 / |row of the fractional matrix|. Splitting that into
+  // cells at least maxDistance wide means neighbors are never more than one
+  // cell apart, even for strongly skewed cells.
+  for (size_t c = 0; c < 3; c++)
+    m_planeSpacing(c) = 1.0 / m_fractionalMatrix.row(c).norm();
+
+  if (!(m_binSize > 0.0))
+    m_binSize = m_planeSpacing.minCoeff();
+  const double maxCells = maxCellCount(points.size());
+  double total = 1.0;
+  for (size_t c = 0; c < 3; c++) {
+    m_binCount[c] =
+      std::max(1, static_cast<int>(std::floor(m_planeSpacing(c) / m_binSize)));
+    total *= m_binCount[c];
+  }
+  if (total > maxCells) {
+    const double scale = std::cbrt(maxCells / total);
+    for (size_t c = 0; c < 3; c++)
+      m_binCount[c] = std::max(1, static_cast<int>(m_binCount[c] * scale));
+  }
+
+  if (!points.size())
+    return;
+
+  // wrap every point into the unit cell
+  m_positions.resize(points.size());
+  std::vector<Index> pointCell(points.size());
+  for (Index i = 0; i < points.size(); i++) {
+    m_positions[i] = queryPosition(points[i]);
+    std::array<int, 3> bin_index = getBinIndex(m_positions[i]);
+    pointCell[i] = cellIndex(bin_index[0], bin_index[1], bin_index[2]);
   }
+  sortPoints(pointCell);
+}
+
+void NeighborPerceiver::sortPoints(const std::vector<Index>& pointCell)
+{
+  // counting sort of the points by cell
+  const Index cells = static_cast<Index>(m_binCount[0]) * m_binCount[1] *
+                      m_binCount[2];
+  m_cellStart.assign(cells + 1, 0);
+  for (Index cell : pointCell)
+    ++m_cellStart[cell + 1];
+  for (Index cell = 0; cell < cells; cell++)
+    m_cellStart[cell + 1] += m_cellStart[cell];
+
+  std::vector<Index> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+  std::vector<Vector3> positions(pointCell.size());
+  m_points.resize(pointCell.size());
+  for (Index i = 0; i < pointCell.size(); i++) {
+    Index slot = fill[pointCell[i]]++;
+    m_points[slot] = i;
+    positions[slot] = m_positions[i];
+  }
+  m_positions.swap(positions);
 }
 
 void NeighborPerceiver::getNeighborsInclusiveInPlace(
     Array<Index> &out, const Vector3 &point
 ) const {
-  const std::array<int, 3> bin_index = getBinIndex(point);
-  if (&out == m_cachedArray && bin_index == m_cachedIndex)
+  out.clear();
+  if (m_points.empty())
     return;
 
-  m_cachedIndex = bin_index;
-  out.clear();
+  const std::array<int, 3> bin_index = getBinIndex(queryPosition(point));
+  if (m_periodic) {
+    // collect the distinct wrapped cells along each axis, so a cell is not
+    // reported twice when the grid is only one or two cells wide
+    std::array<std::vector<int>, 3> axes;
+    for (size_t c = 0; c < 3; c++) {
+      const int r = reach(c, m_maxDistance);
+      for (int i = bin_index[c] - r; i <= bin_index[c] + r; i++) {
+        int wrapped, shift;
+        wrapIndex(i, m_binCount[c], wrapped, shift);
+        if (std::find(axes[c].begin(), axes[c].end(), wrapped) ==
+            axes[c].end())
+          axes[c].push_back(wrapped);
+      }
+    }
+    for (int xi : axes[0]) {
+      for (int yi : axes[1]) {
+        for (int zi : axes[2]) {
+          const Index cell = cellIndex(xi, yi, zi);
+          out.insert(out.end(), m_points.begin() + m_cellStart[cell],
+                     m_points.begin() + m_cellStart[cell + 1]);
+        }
+      }
+    }
+    return;
+  }
+
   for (int xi = std::max(int(1), bin_index[0]) - 1;
       xi < std::min(m_binCount[0], bin_index[0] + 2); xi++) {
     for (int yi = std::max(int(1), bin_index[1]) - 1;
         yi < std::min(m_binCount[1], bin_index[1] + 2); yi++) {
-      for (int zi = std::max(int(1), bin_index[2]) - 1;
-          zi < std::min(m_binCount[2], bin_index[2] + 2); zi++) {
-        const std::vector<Index> &bin = m_bins[xi][yi][zi];
-        out.insert(out.end(), bin.begin(), bin.end());
-      }
+      // cells along z are contiguous, so copy the whole run at once
+      int zBegin = std::max(int(1), bin_index[2]) - 1;
+      int zEnd = std::min(m_binCount[2], bin_index[2] + 2);
+      if (zBegin >= zEnd)
+        continue;
+      const Index first = m_cellStart[cellIndex(xi, yi, zBegin)];
+      const Index last = m_cellStart[cellIndex(xi, yi, zEnd - 1) + 1];
+      out.insert(out.end(), m_points.begin() + first,
+                 m_points.begin() + last);
     }
   }
 }
@@ -70,13 +191,57 @@ Array<Index> NeighborPerceiver::getNeighborsInclusive(const Vector3 &point) cons
   return r;
 }
 
+void NeighborPerceiver::getNeighborsInPlace(Array<Index>& out,
+                                            const Vector3& point,
+                                            double radius) const
+{
+  out.clear();
+  visitNeighbors(point, radius,
+                 [&out](Index j, const Vector3&, double) { out.push_back(j); });
+}
+
+Vector3 NeighborPerceiver::queryPosition(const Vector3& point) const
+{
+  if (!m_periodic)
+    return point;
+  Vector3 frac = m_fractionalMatrix * point;
+  for (size_t c = 0; c < 3; c++)
+    frac(c) -= std::floor(frac(c));
+  return m_cellMatrix * frac;
+}
+
+int NeighborPerceiver::reach(size_t axis, double radius) const
+{
+  double cells;
+  if (m_periodic)
+    cells = std::ceil(radius * m_binCount[axis] / m_planeSpacing(axis));
+  else
+    cells = std::ceil(radius / m_binSize);
+  // never scan further than the grid (or a few periodic images) extends
+  const double limit = m_periodic ? 64.0 * m_binCount[axis]
+                                  : static_cast<double>(m_binCount[axis]);
+  return std::max(1, static_cast<int>(std::min(cells, limit)));
+}
+
 std::array<int, 3> NeighborPerceiver::getBinIndex(const Vector3 &point) const
 {
   std::array<int, 3> r;
+  if (m_periodic) {
+    // point is already wrapped, so only guard against rounding at the edge
+    const Vector3 frac = m_fractionalMatrix * point;
+    for (size_t c = 0; c < 3; c++) {
+      const int bin = static_cast<int>(std::floor(frac(c) * m_binCount[c]));
+      r[c] = std::min(std::max(bin, 0), m_binCount[c] - 1);
+    }
+    return r;
+  }
   for (size_t c = 0; c < 3; c++) {
-    r[c] = std::floor((point(c) - m_minPos(c)) / m_maxDistance);
+    // clamp far-away query points so the conversion cannot overflow
+    double bin = std::floor((point(c) - m_minPos(c)) / m_binSize);
+    bin = std::min(std::max(bin, -1.0e8), 1.0e8);
+    r[c] = static_cast<int>(bin);
   }
-  return r; 
+  return r;
 }
 
-} // namespace Avogadro
+} // namespace Avogadro::Core
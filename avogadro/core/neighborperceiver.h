@@ -11,17 +11,36 @@
 #include "avogadrocore.h"
 
 #include "array.h"
+#include "matrix.h"
 #include "vector.h"
 
+#include <algorithm>
 #include <array>
 #include <vector>
 
 namespace Avogadro {
 namespace Core {
 
+class UnitCell;
+
 /**
  * @class NeighborPerceiver neighborperceiver.h <avogadro/core/neighborperceiver.h>
  * @brief This class can be used to find physically neighboring points in linear average time.
+ *
+ * Points are sorted into a regular grid of cubic cells with a counting sort,
+ * and stored as a single array of point indices ordered by cell together with
+ * the offset of each cell in that array (a compressed sparse row layout). The
+ * positions are copied in the same order, so that scanning a cell touches
+ * contiguous memory.
+ *
+ * When constructed with a UnitCell, the grid is laid out in fractional
+ * coordinates instead and cell indices wrap around, so neighbors are found
+ * across periodic boundaries. Triclinic cells are supported: each cell of
+ * the grid is at least the maximum distance wide, measured perpendicular to
+ * its faces. Displacements reported for periodic neighbors point to the
+ * nearest image, which is the minimum image as long as the maximum distance
+ * is below half of the shortest perpendicular width of the unit cell. For
+ * larger distances every image within range is reported.
  */
 class AVOGADROCORE_EXPORT NeighborPerceiver
 {
@@ -33,8 +52,19 @@ public:
    * @param maxDistance All neighbors strictly within this distance will be detected.
    *                    Should be as low as possible for best performance.
    */
-  NeighborPerceiver(const Array<Vector3> points, float maxDistance);
-  
+  NeighborPerceiver(const Array<Vector3>& points, float maxDistance);
+
+  /**
+   * Creates a NeighborPerceiver for points in a periodic system.
+   *
+   * @param points Cartesian positions, which do not need to be wrapped into
+   *               the unit cell.
+   * @param maxDistance All neighbors strictly within this distance will be detected.
+   * @param cell The periodic unit cell.
+   */
+  NeighborPerceiver(const Array<Vector3>& points, float maxDistance,
+                    const UnitCell& cell);
+
   /**
    * Returns a list of neighboring points. Linear time to number of neighbors.
    * Can include some neighbors up to 2*sqrt(3) times the maximum distance.
@@ -44,7 +74,7 @@ public:
    * @param point Position to return neighbors of, can be located anywhere.
    */
   Array<Index> getNeighborsInclusive(const Vector3 &point) const;
-  
+
   /**
    * Fills an array with all neighboring points. Linear time to number of neighbors.
    * Can include some neighbors up to 2*sqrt(3) times the maximum distance.
@@ -53,19 +83,287 @@ public:
    * @param point Position to return neighbors of, can be located anywhere.
    */
   void getNeighborsInclusiveInPlace(Array<Index> &out, const Vector3 &point) const;
-  
+
+  /**
+   * Fills an array with the indices of all points strictly within @a radius
+   * of @a point. Unlike getNeighborsInclusiveInPlace(), the candidates are
+   * filtered by squared distance, so no further checks are needed. In
+   * periodic mode an index appears once per image within @a radius.
+   *
+   * @param out Array to output neighbor indices in (cleared first).
+   * @param point Position to return neighbors of, can be located anywhere.
+   * @param radius Search radius. Radii larger than the maximum distance are
+   *               supported, but scan more cells.
+   */
+  void getNeighborsInPlace(Array<Index>& out, const Vector3& point,
+                           double radius) const;
+
+  /**
+   * @overload
+   * Uses the maximum distance given in the constructor as the radius.
+   */
+  void getNeighborsInPlace(Array<Index>& out, const Vector3& point) const
+  {
+    getNeighborsInPlace(out, point, m_maxDistance);
+  }
+
+  /**
+   * Calls @a visitor for every point (or periodic image of a point) strictly
+   * within @a radius of @a point.
+   *
+   * @param visitor Callable as visitor(Index j, const Vector3& displacement,
+   *                double distanceSq), where displacement points from
+   *                @a point to the neighbor.
+   */
+  template <typename Visitor>
+  void visitNeighbors(const Vector3& point, double radius,
+                      Visitor&& visitor) const;
+
+  /**
+   * Calls @a visitor for every pair of points strictly closer than the
+   * maximum distance. Each unordered pair is visited exactly once (once per
+   * image in periodic mode), using a half-shell of neighboring cells.
+   *
+   * @param visitor Callable as visitor(Index i, Index j,
+   *                const Vector3& displacement, double distanceSq), with
+   *                i < j (i <= j for periodic self-images) and the
+   *                displacement pointing from i to j.
+   */
+  template <typename Visitor>
+  void visitPairs(Visitor&& visitor) const;
+
+  /**
+   * Calls @a visitor for every pair whose first point lies in cells
+   * [@a cellBegin, @a cellEnd) of the grid. Splitting cellCount() into
+   * disjoint ranges covers every pair exactly once, so the ranges can be
+   * processed concurrently.
+   */
+  template <typename Visitor>
+  void visitPairs(Index cellBegin, Index cellEnd, Visitor&& visitor) const;
+
+  /** @return The total number of cells in the grid. */
+  Index cellCount() const { return m_cellStart.empty() ? 0 : m_cellStart.size() - 1; }
+
+  /** @return The number of points sorted into the grid. */
+  Index pointCount() const { return m_points.size(); }
+
+  /** @return True if neighbors are found across periodic boundaries. */
+  bool isPeriodic() const { return m_periodic; }
+
 private:
+  void sortPoints(const std::vector<Index>& pointCell);
   std::array<int, 3> getBinIndex(const Vector3 &point) const;
+  /** @return The position used for lookups, wrapped if periodic. */
+  Vector3 queryPosition(const Vector3& point) const;
+  Index cellIndex(int x, int y, int z) const
+  {
+    return (static_cast<Index>(x) * m_binCount[1] + y) * m_binCount[2] + z;
+  }
+  /** Number of cells needed along @a axis to cover @a radius. */
+  int reach(size_t axis, double radius) const;
+  /** Floor division and modulo, used to wrap periodic cell indices. */
+  static void wrapIndex(int i, int n, int& wrapped, int& shift)
+  {
+    shift = (i >= 0) ? i / n : -((n - 1 - i) / n);
+    wrapped = i - shift * n;
+  }
+
 protected:
   float m_maxDistance;
+  double m_binSize;
   std::array<int, 3> m_binCount;
-  std::vector<std::vector<std::vector<std::vector<Index>>>> m_bins;
+  // Offsets into m_points for each cell, cellCount() + 1 entries.
+  std::vector<Index> m_cellStart;
+  // Point indices, sorted by cell.
+  std::vector<Index> m_points;
+  // Point positions, in the same order as m_points (wrapped if periodic).
+  std::vector<Vector3> m_positions;
   Vector3 m_minPos;
   Vector3 m_maxPos;
-  mutable Array<Index> *m_cachedArray;
-  mutable std::array<int, 3> m_cachedIndex;
+
+  bool m_periodic;
+  Matrix3 m_cellMatrix;
+  Matrix3 m_fractionalMatrix;
+  // Perpendicular distance between opposite faces of the unit cell.
+  Vector3 m_planeSpacing;
 };
 
+template <typename Visitor>
+void NeighborPerceiver::visitNeighbors(const Vector3& point, double radius,
+                                       Visitor&& visitor) const
+{
+  if (m_points.empty() || !(radius > 0.0))
+    return;
+
+  const double radiusSq = radius * radius;
+  const Vector3 pos = queryPosition(point);
+  const std::array<int, 3> bin = getBinIndex(pos);
+  std::array<int, 3> lo, hi;
+  for (size_t c = 0; c < 3; c++) {
+    const int r = reach(c, radius);
+    lo[c] = bin[c] - r;
+    hi[c] = bin[c] + r + 1;
+    if (!m_periodic) {
+      lo[c] = std::max(0, lo[c]);
+      hi[c] = std::min(m_binCount[c], hi[c]);
+      if (lo[c] >= hi[c])
+        return;
+    }
+  }
+
+  if (!m_periodic) {
+    for (int xi = lo[0]; xi < hi[0]; xi++) {
+      for (int yi = lo[1]; yi < hi[1]; yi++) {
+        // cells along z are contiguous
+        const Index first = m_cellStart[cellIndex(xi, yi, lo[2])];
+        const Index last = m_cellStart[cellIndex(xi, yi, hi[2] - 1) + 1];
+        for (Index k = first; k < last; k++) {
+          const Vector3 diff = m_positions[k] - pos;
+          const double distSq = diff.squaredNorm();
+          if (distSq < radiusSq)
+            visitor(m_points[k], diff, distSq);
+        }
+      }
+    }
+    return;
+  }
+
+  std::array<int, 3> wrapped, shift;
+  for (int xi = lo[0]; xi < hi[0]; xi++) {
+    wrapIndex(xi, m_binCount[0], wrapped[0], shift[0]);
+    for (int yi = lo[1]; yi < hi[1]; yi++) {
+      wrapIndex(yi, m_binCount[1], wrapped[1], shift[1]);
+      for (int zi = lo[2]; zi < hi[2]; zi++) {
+        wrapIndex(zi, m_binCount[2], wrapped[2], shift[2]);
+        const Vector3 image =
+          m_cellMatrix * Vector3(shift[0], shift[1], shift[2]) - pos;
+        const Index cell = cellIndex(wrapped[0], wrapped[1], wrapped[2]);
+        for (Index k = m_cellStart[cell]; k < m_cellStart[cell + 1]; k++) {
+          const Vector3 diff = m_positions[k] + image;
+          const double distSq = diff.squaredNorm();
+          if (distSq < radiusSq)
+            visitor(m_points[k], diff, distSq);
+        }
+      }
+    }
+  }
+}
+
+template <typename Visitor>
+void NeighborPerceiver::visitPairs(Visitor&& visitor) const
+{
+  visitPairs(0, cellCount(), visitor);
+}
+
+template <typename Visitor>
+void NeighborPerceiver::visitPairs(Index cellBegin, Index cellEnd,
+                                   Visitor&& visitor) const
+{
+  // The 13 "forward" neighbors of a cell; together with the cell itself they
+  // cover every adjacent pair of cells exactly once.
+  static const int halfShell[13][3] = {
+    { 1, 0, 0 },  { -1, 1, 0 }, { 0, 1, 0 },  { 1, 1, 0 },   { -1, -1, 1 },
+    { 0, -1, 1 }, { 1, -1, 1 }, { -1, 0, 1 }, { 0, 0, 1 },   { 1, 0, 1 },
+    { -1, 1, 1 }, { 0, 1, 1 },  { 1, 1, 1 }
+  };
+  const double cutoffSq = static_cast<double>(m_maxDistance) * m_maxDistance;
+
+  auto emit = [&](Index a, Index b, const Vector3& diff, double distSq) {
+    if (m_points[a] <= m_points[b])
+      visitor(m_points[a], m_points[b], diff, distSq);
+    else
+      visitor(m_points[b], m_points[a], Vector3(-diff), distSq);
+  };
+
+  std::array<int, 3> r = { 1, 1, 1 };
+  if (m_periodic) {
+    for (size_t c = 0; c < 3; c++)
+      r[c] = reach(c, m_maxDistance);
+  }
+
+  cellEnd = std::min(cellEnd, cellCount());
+  for (Index cell = cellBegin; cell < cellEnd; ++cell) {
+    const Index begin = m_cellStart[cell];
+    const Index end = m_cellStart[cell + 1];
+    if (begin == end)
+      continue;
+    const int x = static_cast<int>(cell / (static_cast<Index>(m_binCount[1]) *
+                                           m_binCount[2]));
+    const int y = static_cast<int>((cell / m_binCount[2]) % m_binCount[1]);
+    const int z = static_cast<int>(cell % m_binCount[2]);
+
+    if (!m_periodic) {
+      // pairs within the cell
+      for (Index a = begin; a < end; ++a) {
+        for (Index b = a + 1; b < end; ++b) {
+          const Vector3 diff = m_positions[b] - m_positions[a];
+          const double distSq = diff.squaredNorm();
+          if (distSq < cutoffSq)
+            emit(a, b, diff, distSq);
+        }
+      }
+
+      // pairs with the forward half of the neighboring cells
+      for (const auto& offset : halfShell) {
+        const int nx = x + offset[0];
+        const int ny = y + offset[1];
+        const int nz = z + offset[2];
+        if (nx < 0 || ny < 0 || nz < 0 || nx >= m_binCount[0] ||
+            ny >= m_binCount[1] || nz >= m_binCount[2])
+          continue;
+        const Index other = cellIndex(nx, ny, nz);
+        const Index otherBegin = m_cellStart[other];
+        const Index otherEnd = m_cellStart[other + 1];
+        for (Index a = begin; a < end; ++a) {
+          for (Index b = otherBegin; b < otherEnd; ++b) {
+            const Vector3 diff = m_positions[b] - m_positions[a];
+            const double distSq = diff.squaredNorm();
+            if (distSq < cutoffSq)
+              emit(a, b, diff, distSq);
+          }
+        }
+      }
+      continue;
+    }
+
+    // Periodic: with wrapping, a neighboring cell may be reached through
+    // several images (or be the cell itself), so scan the full stencil and
+    // keep each (a, b, image) triple from one side only.
+    std::array<int, 3> wrapped, shift;
+    for (int dx = -r[0]; dx <= r[0]; dx++) {
+      wrapIndex(x + dx, m_binCount[0], wrapped[0], shift[0]);
+      for (int dy = -r[1]; dy <= r[1]; dy++) {
+        wrapIndex(y + dy, m_binCount[1], wrapped[1], shift[1]);
+        for (int dz = -r[2]; dz <= r[2]; dz++) {
+          wrapIndex(z + dz, m_binCount[2], wrapped[2], shift[2]);
+          const bool zeroShift = !shift[0] && !shift[1] && !shift[2];
+          // for a point and its own image, keep the "positive" image
+          const bool positiveShift =
+            shift[0] > 0 ||
+            (shift[0] == 0 && (shift[1] > 0 || (shift[1] == 0 && shift[2] > 0)));
+          const Vector3 image =
+            m_cellMatrix * Vector3(shift[0], shift[1], shift[2]);
+          const Index other = cellIndex(wrapped[0], wrapped[1], wrapped[2]);
+          const Index otherBegin = m_cellStart[other];
+          const Index otherEnd = m_cellStart[other + 1];
+          if (otherEnd <= begin && other != cell)
+            continue; // every b < a, handled from the other side
+          for (Index a = begin; a < end; ++a) {
+            for (Index b = std::max(a, otherBegin); b < otherEnd; ++b) {
+              if (b == a && (zeroShift || !positiveShift))
+                continue;
+              const Vector3 diff = m_positions[b] + image - m_positions[a];
+              const double distSq = diff.squaredNorm();
+              if (distSq < cutoffSq)
+                emit(a, b, diff, distSq);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 } // namespace Core
 } // namespace Avogadro
 
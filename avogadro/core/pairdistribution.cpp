@@ -0,0 +1,130 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "pairdistribution.h"
+
+#include "neighborperceiver.h"
+#include "parallel.h"
+#include "unitcell.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro::Core {
+
+PairDistribution::PairDistribution(double maxRadius, double binWidth)
+  : m_maxRadius(std::max(maxRadius, 0.0)),
+    m_binWidth(binWidth > 0.0 ? binWidth : 0.1), m_first(0), m_second(0),
+    m_frameCount(0)
+{
+  const auto bins = static_cast<size_t>(std::ceil(m_maxRadius / m_binWidth));
+  m_counts.assign(bins, 0);
+  m_weighted.assign(bins, 0.0);
+}
+
+void PairDistribution::setElements(unsigned char first, unsigned char second)
+{
+  m_first = first;
+  m_second = second;
+  clear();
+}
+
+void PairDistribution::clear()
+{
+  m_frameCount = 0;
+  std::fill(m_counts.begin(), m_counts.end(), 0);
+  std::fill(m_weighted.begin(), m_weighted.end(), 0.0);
+}
+
+bool PairDistribution::addFrame(const Array<Vector3>& positions,
+                                const Array<unsigned char>& atomicNumbers,
+                                const UnitCell& cell)
+{
+  const bool partial = m_first != 0 || m_second != 0;
+  if (positions.empty() ||
+      (partial && atomicNumbers.size() != positions.size()))
+    return false;
+  const double volume = cell.volume();
+  if (!(volume > 0.0))
+    return false;
+
+  // An atom matches an element of zero whatever its own element.
+  auto matches = [&](Index i, unsigned char element) {
+    return element == 0 || atomicNumbers[i] == element;
+  };
+  size_t firstCount = positions.size();
+  size_t secondCount = positions.size();
+  if (partial) {
+    firstCount = secondCount = 0;
+    for (Index i = 0; i < positions.size(); ++i) {
+      firstCount += matches(i, m_first) ? 1 : 0;
+      secondCount += matches(i, m_second) ? 1 : 0;
+    }
+  }
+  // still a valid frame, just one without any such pairs
+  ++m_frameCount;
+  if (firstCount == 0 || secondCount == 0 || m_counts.empty())
+    return true;
+
+  const NeighborPerceiver perceiver(positions,
+                                    static_cast<float>(m_maxRadius), cell);
+  const Index cells = perceiver.cellCount();
+  const Index grain =
+    std::max<Index>(1, cells / (8 * static_cast<Index>(maxThreadCount())));
+  const Index chunks = (cells + grain - 1) / grain;
+  const size_t bins = m_counts.size();
+
+  // one dense histogram per chunk, so no locking is needed while counting
+  std::vector<std::vector<size_t>> histograms(chunks);
+  parallelFor(0, cells, grain, [&](Index begin, Index end) {
+    std::vector<size_t>& histogram = histograms[begin / grain];
+    histogram.assign(bins, 0);
+    perceiver.visitPairs(
+      begin, end, [&](Index i, Index j, const Vector3&, double distanceSq) {
+        // counted from i to j and from j to i, where the elements match
+        const size_t weight =
+          (matches(i, m_first) && matches(j, m_second) ? 1 : 0) +
+          (matches(i, m_second) && matches(j, m_first) ? 1 : 0);
+        if (weight == 0)
+          return;
+        const auto bin =
+          static_cast<size_t>(std::sqrt(distanceSq) / m_binWidth);
+        if (bin < bins)
+          histogram[bin] += weight;
+      });
+  });
+
+  const double scale = volume / (static_cast<double>(firstCount) *
+                                 static_cast<double>(secondCount));
+  for (const auto& histogram : histograms) {
+    if (histogram.empty())
+      continue;
+    for (size_t k = 0; k < bins; ++k) {
+      m_counts[k] += histogram[k];
+      m_weighted[k] += histogram[k] * scale;
+    }
+  }
+  return true;
+}
+
+std::vector<std::pair<double, double>> PairDistribution::distribution() const
+{
+  std::vector<std::pair<double, double>> result;
+  result.reserve(m_counts.size());
+  for (size_t k = 0; k < m_counts.size(); ++k) {
+    const double inner = k * m_binWidth;
+    const double outer = std::min(inner + m_binWidth, m_maxRadius);
+    // the volume of the spherical shell covered by this bin
+    const double shell =
+      4.0 / 3.0 * M_PI * (outer * outer * outer - inner * inner * inner);
+    double value = 0.0;
+    if (m_frameCount > 0 && shell > 0.0)
+      value = m_weighted[k] / (shell * m_frameCount);
+    result.emplace_back(0.5 * (inner + outer), value);
+  }
+  return result;
+}
+
+} // namespace Avogadro::Core
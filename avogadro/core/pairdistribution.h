@@ -0,0 +1,107 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_PAIRDISTRIBUTION_H
+#define AVOGADRO_CORE_PAIRDISTRIBUTION_H
+
+#include "avogadrocoreexport.h"
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <utility>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class UnitCell;
+
+/**
+ * @class PairDistribution pairdistribution.h <avogadro/core/pairdistribution.h>
+ * @brief The radial pair distribution function g(r) of a periodic system.
+ *
+ * Pairs within the maximum radius are found with a periodic
+ * NeighborPerceiver, so every periodic image within range is counted without
+ * building a supercell. The cells of the grid are split among threads, each
+ * filling a histogram of its own that is summed once all are done.
+ *
+ * Frames added with addFrame() are accumulated, so the result is the average
+ * over all of them, e.g., the frames of a trajectory. The distribution can be
+ * restricted to the pairs between two elements (a partial distribution).
+ */
+class AVOGADROCORE_EXPORT PairDistribution
+{
+public:
+  /**
+   * @param maxRadius The largest distance included, in Angstrom.
+   * @param binWidth The width of each bin of the histogram, in Angstrom.
+   */
+  explicit PairDistribution(double maxRadius = 10.0, double binWidth = 0.1);
+
+  /** @return The largest distance included. */
+  double maxRadius() const { return m_maxRadius; }
+
+  /** @return The width of each bin. */
+  double binWidth() const { return m_binWidth; }
+
+  /** @return The number of bins in the histogram. */
+  size_t binCount() const { return m_counts.size(); }
+
+  /**
+   * Only count pairs between atoms of elements @a first and @a second. Use
+   * zero for both (the default) to count all pairs. Clears the accumulated
+   * frames.
+   */
+  void setElements(unsigned char first, unsigned char second);
+
+  /**
+   * Add the pairs of one frame to the histogram.
+   * @param positions Cartesian positions of the atoms.
+   * @param atomicNumbers Atomic numbers of the atoms, only needed when
+   *                      restricted to a pair of elements.
+   * @param cell The periodic unit cell of the frame.
+   * @return False if the frame could not be used (no atoms, mismatched
+   *         arrays or a degenerate cell).
+   */
+  bool addFrame(const Array<Vector3>& positions,
+                const Array<unsigned char>& atomicNumbers,
+                const UnitCell& cell);
+
+  /** @return The number of frames accumulated so far. */
+  size_t frameCount() const { return m_frameCount; }
+
+  /** Drop all accumulated frames. */
+  void clear();
+
+  /**
+   * @return The number of pairs counted in each bin, over all frames. Pairs
+   * of the same element are counted once from each atom.
+   */
+  const std::vector<size_t>& counts() const { return m_counts; }
+
+  /**
+   * @return The distribution as pairs of the radius at the center of each
+   * bin and g(r), averaged over all frames.
+   */
+  std::vector<std::pair<double, double>> distribution() const;
+
+private:
+  double m_maxRadius;
+  double m_binWidth;
+  unsigned char m_first;
+  unsigned char m_second;
+  size_t m_frameCount;
+  std::vector<size_t> m_counts;
+  // Sum over frames of the counts times volume / (N_first * N_second).
+  std::vector<double> m_weighted;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_PAIRDISTRIBUTION_H
@@ -0,0 +1,93 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+
+#ifndef AVO_NO_THREADS
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+namespace Avogadro::Core {
+
+namespace {
+std::atomic<unsigned int> s_maxThreadCount(0);
+}
+
+unsigned int maxThreadCount()
+{
+#ifdef AVO_NO_THREADS
+  return 1;
+#else
+  unsigned int count = s_maxThreadCount.load();
+  if (count == 0)
+    count = std::thread::hardware_concurrency();
+  return std::max(count, 1u);
+#endif
+}
+
+void setMaxThreadCount(unsigned int count)
+{
+  s_maxThreadCount.store(count);
+}
+
+void parallelFor(Index begin, Index end, Index grainSize,
+                 const std::function<void(Index, Index)>& task)
+{
+  if (end <= begin)
+    return;
+  grainSize = std::max<Index>(grainSize, 1);
+  const Index chunks = (end - begin + grainSize - 1) / grainSize;
+  const unsigned int threads = static_cast<unsigned int>(
+    std::min<Index>(chunks, maxThreadCount()));
+
+  if (threads <= 1) {
+    for (Index i = begin; i < end; i += grainSize)
+      task(i, std::min(end, i + grainSize));
+    return;
+  }
+
+#ifndef AVO_NO_THREADS
+  std::atomic<Index> nextChunk(0);
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto worker = [&]() {
+    for (;;) {
+      const Index chunk = nextChunk.fetch_add(1);
+      if (chunk >= chunks)
+        return;
+      const Index chunkBegin = begin + chunk * grainSize;
+      try {
+        task(chunkBegin, std::min(end, chunkBegin + grainSize));
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+          error = std::current_exception();
+        // stop handing out further chunks
+        nextChunk.store(chunks);
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (unsigned int i = 1; i < threads; ++i)
+    pool.emplace_back(worker);
+  worker();
+  for (auto& thread : pool)
+    thread.join();
+
+  if (error)
+    std::rethrow_exception(error);
+#endif
+}
+
+} // namespace Avogadro::Core
@@ -0,0 +1,52 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_PARALLEL_H
+#define AVOGADRO_CORE_PARALLEL_H
+
+#include "avogadrocoreexport.h"
+
+#include "avogadrocore.h"
+
+#include <functional>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @return The number of worker threads used by parallelFor(). Defaults to the
+ * number of hardware threads, and is always at least one. Builds without
+ * thread support (Python wheels) always return one.
+ */
+AVOGADROCORE_EXPORT unsigned int maxThreadCount();
+
+/**
+ * Limit the number of worker threads used by parallelFor(). Passing zero
+ * restores the default (the number of hardware threads).
+ */
+AVOGADROCORE_EXPORT void setMaxThreadCount(unsigned int count);
+
+/**
+ * Run @a task over the index range [@a begin, @a end), split into chunks of
+ * at most @a grainSize indices. Chunks are handed out to the worker threads
+ * one at a time as they finish, so uneven chunks still balance. The calling
+ * thread takes part in the work, and if there is only one chunk (or one
+ * thread) the task simply runs inline.
+ *
+ * Chunk boundaries are multiples of @a grainSize from @a begin, so
+ * (chunkBegin - begin) / grainSize can be used to index per-chunk results.
+ * Any exception thrown by @a task is rethrown in the calling thread once all
+ * workers have finished.
+ *
+ * @param task Callable as task(Index chunkBegin, Index chunkEnd).
+ */
+AVOGADROCORE_EXPORT void parallelFor(
+  Index begin, Index end, Index grainSize,
+  const std::function<void(Index, Index)>& task);
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_PARALLEL_H
@@ -6,6 +6,7 @@
 #include "ringperceiver.h"
 
 #include "molecule.h"
+#include "parallel.h"
 
 #include <algorithm>
 #include <cstring>
@@ -297,7 +298,7 @@ bool Sssr::isUnique(const std::vector<size_t>& path) const
     if (ring.size() >= path.size())
       continue;
 
-    for (size_t i = 0; i < ring.size(); i++) {
+    for (size_t i = 0; i < ring.size() - 1; i++) {
       pathBonds.erase(std::make_pair(std::min(ring[i], ring[i + 1]),
                                      std::max(ring[i], ring[i + 1])));
     }
@@ -333,13 +334,15 @@ bool Sssr::isUnique(const std::vector<size_t>& path) const
   return true;
 }
 
-std::vector<std::vector<size_t>> perceiveRings(const Graph& graph)
+// The path-included distance matrix method, run on one ring system. The
+// matrices are dense, so the graph must be connected and small.
+std::vector<std::vector<size_t>> perceiveRingSystem(const Graph& graph)
 {
   size_t n = graph.size();
 
-  size_t ringCount = graph.vertexCount() - graph.edgeCount() + 1;
-  if (ringCount == 0)
+  if (graph.edgeCount() < n)
     return std::vector<std::vector<size_t>>();
+  size_t ringCount = graph.edgeCount() - n + 1;
 
   // Algorithm 1 - create the distance and pid matrices.
   DistanceMatrix D(n);
@@ -456,6 +459,148 @@ std::vector<std::vector<size_t>> perceiveRings(const Graph& graph)
   return sssr.rings();
 }
 
+// Split the graph into its ring systems, the biconnected components left once
+// the atoms in no ring have been trimmed away, each as a graph of its own.
+// The vertices of each system are returned in the order of its local indices.
+void ringSystems(const Graph& graph, std::vector<Graph>& systems,
+                 std::vector<std::vector<size_t>>& vertices)
+{
+  const size_t n = graph.size();
+  const size_t none = std::numeric_limits<size_t>::max();
+  std::vector<std::vector<size_t>> neighbors(n);
+  std::vector<size_t> degree(n);
+  for (size_t i = 0; i < n; ++i) {
+    neighbors[i] = graph.neighbors(i);
+    degree[i] = neighbors[i].size();
+  }
+
+  // Trim chains and lone atoms from their ends inwards.
+  std::vector<bool> trimmed(n, false);
+  std::vector<size_t> leaves;
+  for (size_t i = 0; i < n; ++i) {
+    if (degree[i] < 2)
+      leaves.push_back(i);
+  }
+  while (!leaves.empty()) {
+    const size_t leaf = leaves.back();
+    leaves.pop_back();
+    trimmed[leaf] = true;
+    for (size_t neighbor : neighbors[leaf]) {
+      if (!trimmed[neighbor] && --degree[neighbor] == 1)
+        leaves.push_back(neighbor);
+    }
+  }
+
+  // Tarjan's biconnected components over what is left, without recursion so
+  // that long ring chains cannot overflow the stack.
+  struct Frame
+  {
+    size_t vertex;
+    size_t parent;
+    size_t next;
+  };
+  std::vector<size_t> order(n, 0);
+  std::vector<size_t> low(n, 0);
+  std::vector<size_t> local(n, none);
+  std::vector<std::pair<size_t, size_t>> edges;
+  std::vector<Frame> frames;
+  size_t time = 0;
+  for (size_t root = 0; root < n; ++root) {
+    if (trimmed[root] || order[root] != 0)
+      continue;
+    order[root] = low[root] = ++time;
+    frames.push_back({ root, none, 0 });
+    while (!frames.empty()) {
+      Frame& frame = frames.back();
+      const size_t v = frame.vertex;
+      if (frame.next < neighbors[v].size()) {
+        const size_t w = neighbors[v][frame.next++];
+        if (trimmed[w] || w == frame.parent)
+          continue;
+        if (order[w] == 0) {
+          edges.emplace_back(v, w);
+          order[w] = low[w] = ++time;
+          frames.push_back({ w, v, 0 });
+        } else if (order[w] < order[v]) {
+          edges.emplace_back(v, w);
+          low[v] = std::min(low[v], order[w]);
+        }
+        continue;
+      }
+
+      frames.pop_back();
+      if (frames.empty())
+        break;
+      const size_t u = frames.back().vertex;
+      low[u] = std::min(low[u], low[v]);
+      if (low[v] < order[u])
+        continue;
+
+      // u separates the edges stacked since (u, v) from the rest.
+      std::vector<std::pair<size_t, size_t>> component;
+      std::pair<size_t, size_t> edge;
+      do {
+        edge = edges.back();
+        edges.pop_back();
+        component.push_back(edge);
+      } while (edge != std::make_pair(u, v));
+      // a single edge joining two ring systems has no ring
+      if (component.size() < 2)
+        continue;
+
+      std::vector<size_t> systemVertices;
+      for (const auto& e : component) {
+        for (size_t vertex : { e.first, e.second }) {
+          if (local[vertex] == none) {
+            local[vertex] = systemVertices.size();
+            systemVertices.push_back(vertex);
+          }
+        }
+      }
+      Graph system(systemVertices.size());
+      for (const auto& e : component)
+        system.addEdge(local[e.first], local[e.second]);
+      // articulation atoms can be in several systems
+      for (size_t vertex : systemVertices)
+        local[vertex] = none;
+
+      systems.push_back(std::move(system));
+      vertices.push_back(std::move(systemVertices));
+    }
+  }
+}
+
+std::vector<std::vector<size_t>> perceiveRings(const Graph& graph)
+{
+  std::vector<Graph> systems;
+  std::vector<std::vector<size_t>> vertices;
+  ringSystems(graph, systems, vertices);
+
+  // The ring systems are independent, and most are small.
+  std::vector<std::vector<std::vector<size_t>>> systemRings(systems.size());
+  parallelFor(0, systems.size(), 1, [&](Index begin, Index end) {
+    for (Index i = begin; i < end; ++i) {
+      systemRings[i] = perceiveRingSystem(systems[i]);
+      for (auto& ring : systemRings[i]) {
+        for (size_t& vertex : ring)
+          vertex = vertices[i][vertex];
+      }
+    }
+  });
+
+  std::vector<std::vector<size_t>> rings;
+  for (auto& system : systemRings) {
+    for (auto& ring : system)
+      rings.push_back(std::move(ring));
+  }
+  std::stable_sort(rings.begin(), rings.end(),
+                   [](const std::vector<size_t>& a,
+                      const std::vector<size_t>& b) {
+                     return a.size() < b.size();
+                   });
+  return rings;
+}
+
 } // end anonymous namespace
 
 RingPerceiver::RingPerceiver(const Molecule* m)
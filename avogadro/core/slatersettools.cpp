@@ -5,6 +5,7 @@
 
 #include "slatersettools.h"
 
+#include "cube.h"
 #include "molecule.h"
 #include "slaterset.h"
 
@@ -25,13 +26,37 @@ SlaterSetTools::~SlaterSetTools()
 {
 }
 
+bool SlaterSetTools::calculateMolecularOrbital(Cube& cube, int mo) const
+{
+  // make sure the basis is ready before the worker threads read it
+  m_basis->initCalculation();
+  cube.fillParallel([&](Index first, Index count, float* values) {
+    // each slab has its own workspace
+    Workspace work;
+    for (Index i = 0; i < count; ++i) {
+      const Vector3 pos = cube.position(static_cast<unsigned int>(first + i));
+      values[i] = static_cast<float>(molecularOrbital(pos, mo, work));
+    }
+  }, m_progress);
+  return true;
+}
+
 double SlaterSetTools::calculateMolecularOrbital(const Vector3& position,
                                                  int mo) const
+{
+  m_basis->initCalculation();
+  Workspace work;
+  return molecularOrbital(position, mo, work);
+}
+
+double SlaterSetTools::molecularOrbital(const Vector3& position, int mo,
+                                        Workspace& work) const
 {
   if (mo > static_cast<int>(m_basis->molecularOrbitalCount()))
     return 0.0;
 
-  vector<double> values(calculateValues(position));
+  calculateValues(position, work);
+  const vector<double>& values = work.values;
 
   const MatrixX& matrix = m_basis->normalizedMatrix();
   int matrixSize(static_cast<int>(matrix.rows()));
@@ -45,14 +70,36 @@ double SlaterSetTools::calculateMolecularOrbital(const Vector3& position,
   return result;
 }
 
+bool SlaterSetTools::calculateElectronDensity(Cube& cube) const
+{
+  m_basis->initCalculation();
+  cube.fillParallel([&](Index first, Index count, float* values) {
+    Workspace work;
+    for (Index i = 0; i < count; ++i) {
+      const Vector3 pos = cube.position(static_cast<unsigned int>(first + i));
+      values[i] = static_cast<float>(electronDensity(pos, work));
+    }
+  }, m_progress);
+  return true;
+}
+
 double SlaterSetTools::calculateElectronDensity(const Vector3& position) const
+{
+  m_basis->initCalculation();
+  Workspace work;
+  return electronDensity(position, work);
+}
+
+double SlaterSetTools::electronDensity(const Vector3& position,
+                                       Workspace& work) const
 {
   const MatrixX& matrix = m_basis->densityMatrix();
   int matrixSize(static_cast<int>(m_basis->normalizedMatrix().rows()));
   if (matrix.rows() != matrixSize || matrix.cols() != matrixSize)
     return 0.0;
 
-  vector<double> values(calculateValues(position));
+  calculateValues(position, work);
+  const vector<double>& values = work.values;
 
   // Now calculate the value of the density at this point in space
   double rho(0.0);
@@ -67,6 +114,13 @@ double SlaterSetTools::calculateElectronDensity(const Vector3& position) const
   return rho;
 }
 
+bool SlaterSetTools::calculateSpinDensity(Cube& cube) const
+{
+  // not yet implemented for Slater basis sets
+  cube.fill(0.0);
+  return true;
+}
+
 double SlaterSetTools::calculateSpinDensity(const Vector3&) const
 {
   return 0.0;
@@ -88,10 +142,9 @@ inline bool SlaterSetTools::isSmall(double val) const
     return false;
 }
 
-vector<double> SlaterSetTools::calculateValues(const Vector3& position) const
+void SlaterSetTools::calculateValues(const Vector3& position,
+                                     Workspace& work) const
 {
-  m_basis->initCalculation();
-
   Index atomsSize = m_molecule->atomCount();
   size_t basisSize = m_basis->zetas().size();
 
@@ -101,19 +154,19 @@ vector<double> SlaterSetTools::calculateValues(const Vector3& position) const
   const vector<double>& factors = m_basis->factors();
   const vector<double>& zetas = m_basis->zetas();
 
-  vector<Vector3> deltas;
-  vector<double> dr2;
-  deltas.reserve(atomsSize);
-  dr2.reserve(atomsSize);
+  // only allocates on the first point of a slab
+  vector<Vector3>& deltas = work.deltas;
+  vector<double>& dr2 = work.dr2;
+  deltas.resize(atomsSize);
+  dr2.resize(atomsSize);
 
   // Calculate the deltas for the position
   for (Index i = 0; i < atomsSize; ++i) {
-    deltas.emplace_back(position - m_molecule->atom(i).position3d());
-    dr2.push_back(deltas[i].squaredNorm());
+    deltas[i] = position - m_molecule->atom(i).position3d();
+    dr2[i] = deltas[i].squaredNorm();
   }
 
-  // Allocate space for the values to be calculated.
-  vector<double> values;
+  vector<double>& values = work.values;
   values.resize(basisSize);
 
   // Now calculate the values at this point in space
@@ -156,8 +209,6 @@ vector<double> SlaterSetTools::calculateValues(const Vector3& position) const
         values[i] = 0.0;
     }
   }
-
-  return values;
 }
 
 } // End Avogadro namespace
@@ -12,11 +12,13 @@
 
 #include "vector.h"
 
+#include <functional>
 #include <vector>
 
 namespace Avogadro {
 namespace Core {
 
+class Cube;
 class Molecule;
 class SlaterSet;
 
@@ -33,6 +35,24 @@ public:
   explicit SlaterSetTools(Molecule* mol = nullptr);
   ~SlaterSetTools();
 
+  /**
+   * @brief Set a function called as progress(done, total) while cubes are
+   * filled, see Cube::fillParallel(). It is called from worker threads.
+   */
+  void setProgressCallback(const std::function<void(Index, Index)>& progress)
+  {
+    m_progress = progress;
+  }
+
+  /**
+   * @brief Populate the cube with values for the molecular orbital. The cube
+   * is filled in parallel, see Cube::fillParallel().
+   * @param cube The cube to be populated with values.
+   * @param molecularOrbitalNumber The molecular orbital number.
+   * @return True on success, false on failure.
+   */
+  bool calculateMolecularOrbital(Cube& cube, int molecularOrbitalNumber) const;
+
   /**
    * @brief Calculate the value of the specified molecular orbital at the
    * position specified.
@@ -51,6 +71,13 @@ public:
    */
   double calculateElectronDensity(const Vector3& position) const;
 
+  /**
+   * @brief Populate the cube with values for the electron density.
+   * @param cube The cube to be populated with values.
+   * @return True on success, false on failure.
+   */
+  bool calculateElectronDensity(Cube& cube) const;
+
   /**
    * @brief Calculate the value of the electron spin density at the position
    * specified.
@@ -59,6 +86,13 @@ public:
    */
   double calculateSpinDensity(const Vector3& position) const;
 
+  /**
+   * @brief Populate the cube with values for the spin density.
+   * @param cube The cube to be populated with values.
+   * @return True on success, false on failure.
+   */
+  bool calculateSpinDensity(Cube& cube) const;
+
   /**
    * @brief Check that the basis set is valid and can be used.
    * @return True if valid, false otherwise.
@@ -66,18 +100,38 @@ public:
   bool isValid() const;
 
 private:
+  /**
+   * Scratch space for evaluating the basis functions at a point. The cube
+   * functions keep one for each slab, so the buffers are only allocated once.
+   */
+  struct Workspace
+  {
+    // displacement of the point from each atom, and its squared length
+    std::vector<Vector3> deltas;
+    std::vector<double> dr2;
+    // value of each basis function at the point
+    std::vector<double> values;
+  };
+
   Molecule* m_molecule;
   SlaterSet* m_basis;
+  std::function<void(Index, Index)> m_progress;
 
   bool isSmall(double value) const;
 
+  // the per-point calculations, once the basis is initialized
+  double molecularOrbital(const Vector3& position, int mo,
+                          Workspace& work) const;
+  double electronDensity(const Vector3& position, Workspace& work) const;
+
   /**
-   * @brief Calculate the values at this position in space. The public calculate
+   * @brief Calculate the values at this position in space. The calculate
    * functions call this function to prepare values before multiplying by the
    * molecular orbital or density matrix elements.
    * @param position The position in space to calculate the value.
+   * @param work Workspace which receives the values in work.values.
    */
-  std::vector<double> calculateValues(const Vector3& position) const;
+  void calculateValues(const Vector3& position, Workspace& work) const;
 };
 
 } // End Core namespace
@@ -4,9 +4,14 @@
 ******************************************************************************/
 
 #include <algorithm> // for std::count()
+#include <array>
 #include <cassert>
 #include <cctype> // for isdigit()
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
 #include "array.h"
 #include "crystaltools.h"
@@ -258,6 +263,117 @@ Array<Vector3> SpaceGroups::getTransforms(unsigned short hallNumber,
   return ret;
 }
 
+namespace {
+
+// Finds atoms of one element within a cartesian tolerance of a point. The
+// atoms are hashed into bins of their fractional coordinates that are at least
+// the tolerance wide, so a query only looks at the 27 bins around the point.
+// Periodic hashes wrap the bins and compare minimum image distances.
+class AtomHash
+{
+public:
+  AtomHash(const UnitCell& cell, double tolerance, bool periodic)
+    : m_cell(cell), m_tolerance(tolerance), m_periodic(periodic)
+  {
+    for (int i = 0; i < 3; ++i) {
+      // spacing of the lattice planes normal to axis i
+      const double spacing = 1.0 / cell.fractionalMatrix().row(i).norm();
+      const double bins = std::floor(spacing / std::max(tolerance, 1e-12));
+      m_bins[i] = static_cast<int64_t>(std::clamp(bins, 1.0, 1048576.0));
+    }
+  }
+
+  void insert(Index index, unsigned char atomicNumber, const Vector3& position)
+  {
+    m_atoms[key(bin(position))].push_back({ index, atomicNumber, position });
+  }
+
+  // Calls visit(index) for each atom of the element within the tolerance.
+  template <typename Visitor>
+  void visit(unsigned char atomicNumber, const Vector3& position,
+             Visitor visit) const
+  {
+    const std::array<int64_t, 3> center = bin(position);
+    std::array<std::vector<int64_t>, 3> neighbors;
+    for (int i = 0; i < 3; ++i) {
+      for (int64_t offset = -1; offset <= 1; ++offset) {
+        int64_t index = center[i] + offset;
+        if (m_periodic)
+          index = ((index % m_bins[i]) + m_bins[i]) % m_bins[i];
+        // small periodic cells would otherwise visit a bin twice
+        if (std::find(neighbors[i].begin(), neighbors[i].end(), index) ==
+            neighbors[i].end())
+          neighbors[i].push_back(index);
+      }
+    }
+
+    for (int64_t x : neighbors[0]) {
+      for (int64_t y : neighbors[1]) {
+        for (int64_t z : neighbors[2]) {
+          auto it = m_atoms.find(key({ x, y, z }));
+          if (it == m_atoms.end())
+            continue;
+          for (const Entry& atom : it->second) {
+            if (atom.atomicNumber != atomicNumber)
+              continue;
+            const Real distance =
+              m_periodic ? m_cell.distance(atom.position, position)
+                         : (atom.position - position).norm();
+            if (distance <= m_tolerance)
+              visit(atom.index);
+          }
+        }
+      }
+    }
+  }
+
+  bool contains(unsigned char atomicNumber, const Vector3& position) const
+  {
+    bool found = false;
+    visit(atomicNumber, position, [&found](Index) { found = true; });
+    return found;
+  }
+
+private:
+  struct Entry
+  {
+    Index index;
+    unsigned char atomicNumber;
+    Vector3 position;
+  };
+
+  std::array<int64_t, 3> bin(const Vector3& position) const
+  {
+    const Vector3 fractional = m_cell.toFractional(position);
+    std::array<int64_t, 3> result;
+    for (int i = 0; i < 3; ++i) {
+      // keep stray atoms far outside the cell from overflowing the key
+      const double scaled =
+        std::clamp(fractional[i], -1024.0, 1024.0) * m_bins[i];
+      result[i] = static_cast<int64_t>(std::floor(scaled));
+      if (m_periodic)
+        result[i] = ((result[i] % m_bins[i]) + m_bins[i]) % m_bins[i];
+    }
+    return result;
+  }
+
+  // Distinct bins may share a key, which only costs extra distance checks.
+  static uint64_t key(const std::array<int64_t, 3>& bin)
+  {
+    return (static_cast<uint64_t>(bin[0]) << 42) ^
+           (static_cast<uint64_t>(bin[1]) << 21) ^
+           static_cast<uint64_t>(bin[2]);
+  }
+
+  const UnitCell& m_cell;
+  double m_tolerance;
+  bool m_periodic;
+  std::array<int64_t, 3> m_bins;
+  std::unordered_map<uint64_t, std::vector<Entry>> m_atoms;
+};
+
+} // namespace
+
 void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
                                double cartTol, bool wrapToCell, bool allCopies)
 {
@@ -269,8 +385,15 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
   Array<Vector3> positions = mol.atomPositions3d();
   Index numAtoms = mol.atomCount();
 
-  // We are going to loop through the original atoms. That is why
-  // we have numAtoms cached instead of using atomCount().
+  AtomHash present(*uc, cartTol, true);
+  for (Index i = 0; i < numAtoms; ++i)
+    present.insert(i, atomicNumbers[i], positions[i]);
+
+  // The new atoms are collected here and added to the molecule in one go.
+  Array<unsigned char> newNumbers;
+  Array<Vector3> newPositions;
+
+  // We are going to loop through the original atoms.
   for (Index i = 0; i < numAtoms; ++i) {
     unsigned char atomicNum = atomicNumbers[i];
     Vector3 pos = uc->toFractional(positions[i]);
@@ -284,25 +407,16 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
 
       // If there is already an atom in this location within a
       // certain tolerance, do not add the atom.
-      bool atomAlreadyPresent = false;
-      for (Index k = 0; k < mol.atomCount(); k++) {
-        // If it does not have the same atomic number, skip over it.
-        if (mol.atomicNumber(k) != atomicNum)
-          continue;
-        Real distance = uc->distance(mol.atomPosition3d(k), newCandidate);
-        if (distance <= cartTol)
-          atomAlreadyPresent = true;
-      }
-
-      // If there is already an atom present here, just continue
-      if (atomAlreadyPresent)
+      if (present.contains(atomicNum, newCandidate))
         continue;
 
       // If we got this far, add the atom!
-      Atom newAtom = mol.addAtom(atomicNum);
-      newAtom.setPosition3d(newCandidate);
+      present.insert(numAtoms + newNumbers.size(), atomicNum, newCandidate);
+      newNumbers.push_back(atomicNum);
+      newPositions.push_back(newCandidate);
     }
   }
+  mol.addAtoms(newNumbers, newPositions);
 
   if (wrapToCell)
     CrystalTools::wrapAtomsToUnitCell(mol);
@@ -317,6 +431,15 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
   atomicNumbers = mol.atomicNumbers();
   positions = mol.atomPositions3d();
   numAtoms = mol.atomCount();
+
+  // The copies are periodic images of each other, so only compare them
+  // within the cell.
+  AtomHash copies(*uc, cartTol, false);
+  for (Index i = 0; i < numAtoms; ++i)
+    copies.insert(i, atomicNumbers[i], positions[i]);
+  newNumbers.clear();
+  newPositions.clear();
+
   for (Index i = 0; i < numAtoms; ++i) {
     unsigned char atomicNum = atomicNumbers[i];
     Vector3 pos = uc->toFractional(positions[i]);
@@ -362,27 +485,16 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
 
       // If there is already an atom in this location within a
       // certain tolerance, do not add the atom.
-      bool atomAlreadyPresent = false;
-      for (Index k = 0; k < mol.atomCount(); k++) {
-        // If it does not have the same atomic number, skip over it.
-        if (mol.atomicNumber(k) != atomicNum)
-          continue;
-
-        Real distance = (mol.atomPosition3d(k) - newCandidate).norm();
-
-        if (distance <= cartTol)
-          atomAlreadyPresent = true;
-      }
-
-      // If there is already an atom present here, just continue
-      if (atomAlreadyPresent)
+      if (copies.contains(atomicNum, newCandidate))
         continue;
 
       // If we got this far, add the atom!
-      Atom newAtom = mol.addAtom(atomicNum);
-      newAtom.setPosition3d(newCandidate);
+      copies.insert(numAtoms + newNumbers.size(), atomicNum, newCandidate);
+      newNumbers.push_back(atomicNum);
+      newPositions.push_back(newCandidate);
     }
   }
+  mol.addAtoms(newNumbers, newPositions);
 }
 
 void SpaceGroups::reduceToAsymmetricUnit(Molecule& mol,
@@ -393,39 +505,42 @@ void SpaceGroups::reduceToAsymmetricUnit(Molecule& mol,
     return;
   UnitCell* uc = mol.unitCell();
 
-  // The number of atoms may change as we remove atoms, so don't cache
-  // the number of atoms, atomic positions, or atomic numbers
-  // There's no point in looking at the last atom
-  for (Index i = 0; i + 1 < mol.atomCount(); ++i) {
-    unsigned char atomicNum = mol.atomicNumber(i);
-    Vector3 pos = uc->toFractional(mol.atomPosition3d(i));
-    Array<Vector3> transformAtoms = getTransforms(hallNumber, pos);
+  const Array<unsigned char> atomicNumbers = mol.atomicNumbers();
+  const Array<Vector3> positions = mol.atomPositions3d();
+  const Index numAtoms = mol.atomCount();
 
-    // Loop through the rest of the atoms in this crystal and see if any match
-    // up with a transform
-    for (Index j = i + 1; j < mol.atomCount(); ++j) {
-      // If the atomic number does not match, skip over it
-      if (mol.atomicNumber(j) != atomicNum)
-        continue;
+  AtomHash atoms(*uc, cartTol, true);
+  for (Index i = 0; i < numAtoms; ++i)
+    atoms.insert(i, atomicNumbers[i], positions[i]);
 
-      Vector3 trialPos = mol.atomPosition3d(j);
-      // Loop through the transform atoms
-      // We skip 0 because it is the original atom.
-      for (Index k = 1; k < transformAtoms.size(); ++k) {
-        // The transform atoms are in fractional coordinates. Convert to
-        // cartesian.
-        Vector3 transformPos = uc->toCartesian(transformAtoms[k]);
-        Real distance = uc->distance(trialPos, transformPos);
-        // Is the atom within the cartesian tolerance distance?
-        if (distance <= cartTol) {
-          // Remove this atom and adjust the index
-          mol.removeAtom(j);
-          --j;
-          break;
-        }
-      }
+  // Each atom that is kept marks any later atom that matches up with one of
+  // its transforms for removal.
+  std::vector<bool> removed(numAtoms, false);
+  for (Index i = 0; i < numAtoms; ++i) {
+    if (removed[i])
+      continue;
+    unsigned char atomicNum = atomicNumbers[i];
+    Vector3 pos = uc->toFractional(positions[i]);
+    Array<Vector3> transformAtoms = getTransforms(hallNumber, pos);
+
+    // We skip 0 because it is the original atom.
+    for (Index k = 1; k < transformAtoms.size(); ++k) {
+      // The transform atoms are in fractional coordinates. Convert to
+      // cartesian.
+      Vector3 transformPos = uc->toCartesian(transformAtoms[k]);
+      atoms.visit(atomicNum, transformPos, [&](Index j) {
+        if (j > i)
+          removed[j] = true;
+      });
     }
   }
+
+  // Remove from the back, so the atom swapped into a removed slot is always
+  // one that is kept.
+  for (Index i = numAtoms; i > 0; --i) {
+    if (removed[i - 1])
+      mol.removeAtom(i - 1);
+  }
 }
 
 const char* SpaceGroups::transformsString(unsigned short hallNumber)
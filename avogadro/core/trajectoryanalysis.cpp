@@ -0,0 +1,324 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "trajectoryanalysis.h"
+
+#include "molecule.h"
+#include "parallel.h"
+
+#include <Eigen/SVD>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Avogadro::Core {
+
+namespace {
+
+const double notANumber = std::numeric_limits<double>::quiet_NaN();
+
+// Frames are copied out of the molecule into plain vectors on the calling
+// thread before the parallel loops: copying an Array from several threads
+// is not safe, as its shared data is reference counted without atomics.
+typedef std::vector<Vector3> Points;
+
+// Move the centroid of the points to the origin.
+void center(Points& points)
+{
+  Vector3 centroid = Vector3::Zero();
+  for (const auto& point : points)
+    centroid += point;
+  centroid /= static_cast<double>(points.size());
+  for (auto& point : points)
+    point -= centroid;
+}
+
+double squaredNorm(const Points& points)
+{
+  double sum = 0.0;
+  for (const auto& point : points)
+    sum += point.squaredNorm();
+  return sum;
+}
+
+// Correlation matrix sum(a_i b_i^T) of two point sets of the same size.
+Matrix3 correlation(const Points& a, const Points& b)
+{
+  Matrix3 h = Matrix3::Zero();
+  for (size_t i = 0; i < a.size(); ++i)
+    h.noalias() += a[i] * b[i].transpose();
+  return h;
+}
+
+// The minimum RMSD of two centered point sets over all rotations, from the
+// singular values of their correlation matrix, without forming the rotation.
+double alignedRmsd(const Points& a, double aNormSq, const Points& b,
+                   double bNormSq)
+{
+  const Matrix3 h = correlation(a, b);
+  const Vector3 sigma = Eigen::JacobiSVD<Matrix3>(h).singularValues();
+  // a reflection would fit better; take the best proper rotation instead
+  const double sign = h.determinant() < 0.0 ? -1.0 : 1.0;
+  const double deviation =
+    aNormSq + bNormSq - 2.0 * (sigma(0) + sigma(1) + sign * sigma(2));
+  return std::sqrt(std::max(deviation, 0.0) / a.size());
+}
+
+// The Kabsch rotation of two centered point sets, taking mobile onto target.
+Matrix3 centeredRotation(const Points& mobile, const Points& target)
+{
+  const Eigen::JacobiSVD<Matrix3> svd(correlation(mobile, target),
+                                      Eigen::ComputeFullU |
+                                        Eigen::ComputeFullV);
+  Matrix3 sign = Matrix3::Identity();
+  sign(2, 2) =
+    (svd.matrixV() * svd.matrixU().transpose()).determinant() < 0.0 ? -1.0
+                                                                     : 1.0;
+  return svd.matrixV() * sign * svd.matrixU().transpose();
+}
+
+double plainRmsd(const Points& a, const Points& b)
+{
+  double sum = 0.0;
+  for (size_t i = 0; i < a.size(); ++i)
+    sum += (a[i] - b[i]).squaredNorm();
+  return std::sqrt(sum / a.size());
+}
+
+// Frames are handed out to threads in chunks of this many at least.
+const Index frameGrain = 16;
+
+// Long trajectories are copied and processed this many frames at a time, so
+// that they need not fit into memory at once.
+Index frameBatch()
+{
+  return 4 * frameGrain * static_cast<Index>(maxThreadCount());
+}
+
+} // namespace
+
+TrajectoryAnalysis::TrajectoryAnalysis(const Molecule& molecule)
+  : m_molecule(molecule), m_aligned(true)
+{
+}
+
+Index TrajectoryAnalysis::frameCount() const
+{
+  const int count = m_molecule.coordinate3dCount();
+  // a molecule without coordinate sets is a single frame
+  if (count <= 0)
+    return m_molecule.atomCount() > 0 ? 1 : 0;
+  return static_cast<Index>(count);
+}
+
+std::vector<Vector3> TrajectoryAnalysis::frame(Index index) const
+{
+  // const, so that reading it never detaches from the molecule's copy
+  const Array<Vector3> positions =
+    m_molecule.coordinate3dCount() > 0
+      ? m_molecule.coordinate3d(static_cast<int>(index))
+      : (index == 0 ? m_molecule.atomPositions3d() : Array<Vector3>());
+  if (positions.size() != m_molecule.atomCount() || positions.empty())
+    return Points();
+  if (m_atoms.empty())
+    return Points(positions.begin(), positions.end());
+
+  Points selected(m_atoms.size());
+  for (size_t i = 0; i < m_atoms.size(); ++i) {
+    if (m_atoms[i] >= positions.size())
+      return Points();
+    selected[i] = positions[m_atoms[i]];
+  }
+  return selected;
+}
+
+std::vector<double> TrajectoryAnalysis::rmsd(Index reference) const
+{
+  const Index frames = frameCount();
+  std::vector<double> result(frames, notANumber);
+  Points ref = frame(reference);
+  if (ref.empty())
+    return result;
+  if (m_aligned)
+    center(ref);
+  const double refNormSq = squaredNorm(ref);
+
+  const Index batchSize = frameBatch();
+  std::vector<Points> batch;
+  for (Index first = 0; first < frames; first += batchSize) {
+    const Index last = std::min(first + batchSize, frames);
+    batch.resize(last - first);
+    for (Index i = first; i < last; ++i)
+      batch[i - first] = frame(i);
+
+    parallelFor(first, last, frameGrain, [&](Index begin, Index end) {
+      for (Index i = begin; i < end; ++i) {
+        Points& positions = batch[i - first];
+        if (positions.size() != ref.size())
+          continue;
+        if (m_aligned) {
+          center(positions);
+          result[i] =
+            alignedRmsd(positions, squaredNorm(positions), ref, refNormSq);
+        } else {
+          result[i] = plainRmsd(positions, ref);
+        }
+      }
+    });
+  }
+  return result;
+}
+
+std::vector<double> TrajectoryAnalysis::rmsf(Index reference) const
+{
+  Points ref = frame(reference);
+  if (ref.empty())
+    return std::vector<double>();
+  if (m_aligned)
+    center(ref);
+  const size_t atoms = ref.size();
+
+  // Sums of positions and squared positions, one set per chunk of frames.
+  struct Sums
+  {
+    std::vector<Vector3> position;
+    std::vector<double> squared;
+    Index frames = 0;
+  };
+  const Index frames = frameCount();
+  const Index batchSize = frameBatch();
+  std::vector<Sums> chunks((batchSize + frameGrain - 1) / frameGrain);
+  std::vector<Points> batch;
+
+  std::vector<Vector3> position(atoms, Vector3::Zero());
+  std::vector<double> squared(atoms, 0.0);
+  Index counted = 0;
+  for (Index first = 0; first < frames; first += batchSize) {
+    const Index last = std::min(first + batchSize, frames);
+    batch.resize(last - first);
+    for (Index i = first; i < last; ++i)
+      batch[i - first] = frame(i);
+
+    parallelFor(first, last, frameGrain, [&](Index begin, Index end) {
+      Sums& sums = chunks[(begin - first) / frameGrain];
+      sums.position.assign(atoms, Vector3::Zero());
+      sums.squared.assign(atoms, 0.0);
+      for (Index i = begin; i < end; ++i) {
+        Points& positions = batch[i - first];
+        if (positions.size() != atoms)
+          continue;
+        if (m_aligned) {
+          center(positions);
+          const Matrix3 rotation = centeredRotation(positions, ref);
+          for (auto& point : positions)
+            point = rotation * point;
+        }
+        for (size_t j = 0; j < atoms; ++j) {
+          sums.position[j] += positions[j];
+          sums.squared[j] += positions[j].squaredNorm();
+        }
+        ++sums.frames;
+      }
+    });
+
+    for (auto& sums : chunks) {
+      if (sums.frames == 0)
+        continue;
+      for (size_t j = 0; j < atoms; ++j) {
+        position[j] += sums.position[j];
+        squared[j] += sums.squared[j];
+      }
+      counted += sums.frames;
+      sums.frames = 0;
+    }
+  }
+
+  std::vector<double> result(atoms, notANumber);
+  if (counted == 0)
+    return result;
+  for (size_t j = 0; j < atoms; ++j) {
+    const Vector3 mean = position[j] / counted;
+    result[j] =
+      std::sqrt(std::max(squared[j] / counted - mean.squaredNorm(), 0.0));
+  }
+  return result;
+}
+
+MatrixX TrajectoryAnalysis::rmsdMatrix(const std::vector<Index>& frames) const
+{
+  std::vector<Index> indices = frames;
+  if (indices.empty()) {
+    indices.resize(frameCount());
+    for (Index i = 0; i < indices.size(); ++i)
+      indices[i] = i;
+  }
+  const Index n = indices.size();
+
+  // every pair is compared, so all of the frames are kept
+  std::vector<Points> positions(n);
+  for (Index i = 0; i < n; ++i)
+    positions[i] = frame(indices[i]);
+  std::vector<double> normSq(n, 0.0);
+  if (m_aligned) {
+    parallelFor(0, n, frameGrain, [&](Index begin, Index end) {
+      for (Index i = begin; i < end; ++i) {
+        if (positions[i].empty())
+          continue;
+        center(positions[i]);
+        normSq[i] = squaredNorm(positions[i]);
+      }
+    });
+  }
+
+  MatrixX result = MatrixX::Constant(n, n, notANumber);
+  // row i fills the upper triangle, and mirrors it into column i
+  parallelFor(0, n, 1, [&](Index begin, Index end) {
+    for (Index i = begin; i < end; ++i) {
+      if (positions[i].empty())
+        continue;
+      result(i, i) = 0.0;
+      for (Index j = i + 1; j < n; ++j) {
+        if (positions[j].size() != positions[i].size())
+          continue;
+        const double value =
+          m_aligned ? alignedRmsd(positions[i], normSq[i], positions[j],
+                                  normSq[j])
+                    : plainRmsd(positions[i], positions[j]);
+        result(i, j) = value;
+        result(j, i) = value;
+      }
+    }
+  });
+  return result;
+}
+
+double TrajectoryAnalysis::rmsd(const Array<Vector3>& a,
+                                const Array<Vector3>& b, bool aligned)
+{
+  if (a.empty() || a.size() != b.size())
+    return notANumber;
+  Points x(a.begin(), a.end());
+  Points y(b.begin(), b.end());
+  if (!aligned)
+    return plainRmsd(x, y);
+  center(x);
+  center(y);
+  return alignedRmsd(x, squaredNorm(x), y, squaredNorm(y));
+}
+
+Matrix3 TrajectoryAnalysis::kabschRotation(const Array<Vector3>& mobile,
+                                           const Array<Vector3>& target)
+{
+  if (mobile.empty() || mobile.size() != target.size())
+    return Matrix3::Identity();
+  Points x(mobile.begin(), mobile.end());
+  Points y(target.begin(), target.end());
+  center(x);
+  center(y);
+  return centeredRotation(x, y);
+}
+
+} // namespace Avogadro::Core
@@ -0,0 +1,105 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_TRAJECTORYANALYSIS_H
+#define AVOGADRO_CORE_TRAJECTORYANALYSIS_H
+
+#include "avogadrocoreexport.h"
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "matrix.h"
+#include "vector.h"
+
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+
+/**
+ * @class TrajectoryAnalysis trajectoryanalysis.h
+ * <avogadro/core/trajectoryanalysis.h>
+ * @brief Structural analysis of the frames of a trajectory: RMSD to a
+ * reference frame, per-atom RMSF and pairwise RMSD matrices.
+ *
+ * Frames are read with Molecule::coordinate3d(), so trajectories held by a
+ * FrameCache are read on demand, and the molecule itself is never modified.
+ * Frames are processed in parallel. Unless disabled with setAligned(), each
+ * frame is first superposed onto the other by the rotation and translation
+ * that minimize the RMSD (the Kabsch algorithm). Frames that cannot be read,
+ * or have the wrong number of atoms, give NaN results or are skipped.
+ */
+class AVOGADROCORE_EXPORT TrajectoryAnalysis
+{
+public:
+  /** The molecule must outlive the analysis. */
+  explicit TrajectoryAnalysis(const Molecule& molecule);
+
+  /** @return The number of frames in the trajectory. */
+  Index frameCount() const;
+
+  /**
+   * Restrict fitting and RMSD to a subset of the atoms (e.g., the backbone).
+   * An empty list (the default) uses all atoms.
+   */
+  void setAtoms(const std::vector<Index>& atoms) { m_atoms = atoms; }
+  const std::vector<Index>& atoms() const { return m_atoms; }
+
+  /** Whether frames are superposed before comparing them. @{ */
+  void setAligned(bool aligned) { m_aligned = aligned; }
+  bool aligned() const { return m_aligned; }
+  /** @} */
+
+  /** @return The RMSD of every frame to frame @a reference, in Angstrom. */
+  std::vector<double> rmsd(Index reference = 0) const;
+
+  /**
+   * @return The root mean square fluctuation of each selected atom about its
+   * average position, in Angstrom, with every frame superposed onto frame
+   * @a reference first.
+   */
+  std::vector<double> rmsf(Index reference = 0) const;
+
+  /**
+   * @return The symmetric matrix of RMSDs between every pair of @a frames
+   * (all frames if empty), e.g., for clustering. The selected frames are
+   * held in memory while the matrix is computed.
+   */
+  MatrixX rmsdMatrix(const std::vector<Index>& frames = {}) const;
+
+  /**
+   * @return The RMSD between two sets of positions, optionally after
+   * superposing them. NaN if the sizes differ or are zero.
+   */
+  static double rmsd(const Array<Vector3>& a, const Array<Vector3>& b,
+                     bool aligned = true);
+
+  /**
+   * @return The rotation that best superposes the centered points of
+   * @a mobile onto the centered points of @a target, so that
+   * target[i] - center(target) ~ rotation * (mobile[i] - center(mobile)).
+   */
+  static Matrix3 kabschRotation(const Array<Vector3>& mobile,
+                                const Array<Vector3>& target);
+
+private:
+  /**
+   * @return A copy of the selected atoms of frame @a index, empty if invalid.
+   * Only called on the calling thread, never from the parallel loops.
+   */
+  std::vector<Vector3> frame(Index index) const;
+
+  const Molecule& m_molecule;
+  std::vector<Index> m_atoms;
+  bool m_aligned;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_TRAJECTORYANALYSIS_H
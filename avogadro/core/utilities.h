@@ -6,8 +6,12 @@
 #ifndef AVOGADRO_CORE_UTILITIES_H
 #define AVOGADRO_CORE_UTILITIES_H
 
+#include <charconv>
+#include <locale>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace Avogadro {
@@ -34,6 +38,35 @@ inline std::vector<std::string> split(const std::string& string, char delimiter,
   return elements;
 }
 
+/**
+ * @brief Split the supplied @p string by the @p delimiter without copying.
+ * @param string The string to be split up.
+ * @param delimiter The delimiter to split the string by.
+ * @param tokens Filled with views into @p string. Any previous contents are
+ * discarded, but the capacity is reused so a loop over many lines only
+ * allocates while the vector grows.
+ * @param skipEmpty If true any empty items will be skipped.
+ * @return The number of items.
+ * @warning The views are only valid while @p string is alive and unmodified.
+ */
+inline size_t split(std::string_view string, char delimiter,
+                    std::vector<std::string_view>& tokens,
+                    bool skipEmpty = true)
+{
+  tokens.clear();
+  size_t start = 0;
+  // like std::getline, a trailing delimiter does not add an empty item
+  while (start < string.size()) {
+    size_t end = string.find(delimiter, start);
+    if (end == std::string_view::npos)
+      end = string.size();
+    if (!skipEmpty || end > start)
+      tokens.push_back(string.substr(start, end - start));
+    start = end + 1;
+  }
+  return tokens.size();
+}
+
 /**
  * @brief Search the input string for the search string.
  * @param input String to be examined.
@@ -70,32 +103,108 @@ inline std::string trimmed(const std::string& input)
   return input.substr(start, end - start + 1);
 }
 
+namespace internal {
+
+/** Character types are read as a single character, not as a number. */
+template <typename T>
+constexpr bool isCharacter = std::is_same_v<T, char> ||
+                             std::is_same_v<T, signed char> ||
+                             std::is_same_v<T, unsigned char>;
+
+template <typename T>
+constexpr bool isFromCharsInteger =
+  std::is_integral_v<T> && !std::is_same_v<T, bool> && !isCharacter<T>;
+
+#ifdef __cpp_lib_to_chars
+template <typename T>
+constexpr bool isFromCharsFloat = std::is_floating_point_v<T>;
+#else
+// Some standard libraries only provide the integer overloads.
+template <typename T>
+constexpr bool isFromCharsFloat = false;
+#endif
+
+inline bool isSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+         c == '\v';
+}
+
+} // namespace internal
+
 /**
  * @brief Cast the inputString to the specified type.
  * @param inputString String to cast to the specified type.
+ * @param ok Set to true on success, and false if the string could not be
+ * converted to the specified type.
+ *
+ * Numbers and words are parsed in place without allocating, following the
+ * rules of reading the value from a std::istream in the "C" locale: leading
+ * whitespace is skipped and parsing stops at the first character that is not
+ * part of the value. Values that are out of range for @p T are failures.
  */
 template <typename T>
-T lexicalCast(const std::string& inputString)
+T lexicalCast(std::string_view inputString, bool& ok)
 {
-  T value;
-  std::istringstream(inputString) >> value;
-  return value;
+  const char* begin = inputString.data();
+  const char* end = begin + inputString.size();
+
+  if constexpr (internal::isFromCharsInteger<T> ||
+                internal::isFromCharsFloat<T> || internal::isCharacter<T> ||
+                std::is_same_v<T, std::string>) {
+    while (begin != end && internal::isSpace(*begin))
+      ++begin;
+
+    if constexpr (internal::isCharacter<T>) {
+      ok = begin != end;
+      return ok ? static_cast<T>(*begin) : T();
+    } else if constexpr (std::is_same_v<T, std::string>) {
+      const char* wordEnd = begin;
+      while (wordEnd != end && !internal::isSpace(*wordEnd))
+        ++wordEnd;
+      ok = wordEnd != begin;
+      return T(begin, wordEnd);
+    } else {
+      // from_chars accepts a minus sign but not a plus sign
+      if (end - begin > 1 && *begin == '+' && begin[1] != '-')
+        ++begin;
+
+      T value = T();
+      std::from_chars_result result;
+      if constexpr (std::is_unsigned_v<T>) {
+        if (begin != end && *begin == '-') {
+          // streams negate unsigned values modulo 2^n
+          long long signedValue = 0;
+          result = std::from_chars(begin, end, signedValue);
+          value = static_cast<T>(signedValue);
+        } else {
+          result = std::from_chars(begin, end, value);
+        }
+      } else {
+        result = std::from_chars(begin, end, value);
+      }
+      ok = result.ec == std::errc();
+      return ok ? value : T();
+    }
+  } else {
+    std::istringstream stream{ std::string(inputString) };
+    stream.imbue(std::locale::classic());
+    T value = T();
+    stream >> value;
+    ok = !stream.fail();
+    return value;
+  }
 }
 
 /**
  * @brief Cast the inputString to the specified type.
  * @param inputString String to cast to the specified type.
- * @param ok Set to true on success, and false if the string could not be
- * converted to the specified type.
  */
 template <typename T>
-T lexicalCast(const std::string& inputString, bool& ok)
+T lexicalCast(std::string_view inputString)
 {
-  T value;
-  std::istringstream stream(inputString);
-  stream >> value;
-  ok = !stream.fail();
-  return value;
+  bool ok;
+  return lexicalCast<T>(inputString, ok);
 }
 
 } // end Core namespace
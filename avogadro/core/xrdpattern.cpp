@@ -0,0 +1,653 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "xrdpattern.h"
+
+#include "matrix.h"
+#include "parallel.h"
+#include "unitcell.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <tuple>
+
+namespace Avogadro::Core {
+
+namespace {
+
+// Cromer-Mann coefficients, f(s) = sum a_i exp(-b_i s^2) + c, with
+// s = sin(theta) / lambda. International Tables for Crystallography, Vol. C,
+// Table 6.1.1.4. Every element from hydrogen to californium, so that entry
+// Z - 1 holds element Z.
+struct CromerMann
+{
+  unsigned char atomicNumber;
+  double a[4];
+  double b[4];
+  double c;
+};
+
+const CromerMann cromerMann[] = {
+  { 1,
+    { 0.489918, 0.262003, 0.196767, 0.049879 },
+    { 20.6593, 7.74039, 49.5519, 2.20159 },
+    0.001305 },
+  { 2, { 0.8734, 0.6309, 0.3112, 0.178 }, { 9.1037, 3.3568, 22.9276, 0.9821 },
+    0.0064 },
+  { 3,
+    { 1.1282, 0.7508, 0.6175, 0.4653 },
+    { 3.9546, 1.0524, 85.3905, 168.261 },
+    0.0377 },
+  { 4,
+    { 1.5919, 1.1278, 0.5391, 0.7029 },
+    { 43.6427, 1.8623, 103.483, 0.542 },
+    0.0385 },
+  { 5,
+    { 2.0545, 1.3326, 1.0979, 0.7068 },
+    { 23.2185, 1.021, 60.3498, 0.1403 },
+    -0.1932 },
+  { 6,
+    { 2.31, 1.02, 1.5886, 0.865 },
+    { 20.8439, 10.2075, 0.5687, 51.6512 },
+    0.2156 },
+  { 7,
+    { 12.2126, 3.1322, 2.0125, 1.1663 },
+    { 0.0057, 9.8933, 28.9975, 0.5826 },
+    -11.529 },
+  { 8,
+    { 3.0485, 2.2868, 1.5463, 0.867 },
+    { 13.2771, 5.7011, 0.3239, 32.9089 },
+    0.2508 },
+  { 9,
+    { 3.5392, 2.6412, 1.517, 1.0243 },
+    { 10.2825, 4.2944, 0.2615, 26.1476 },
+    0.2776 },
+  { 10,
+    { 3.9553, 3.1125, 1.4546, 1.1251 },
+    { 8.4042, 3.4262, 0.2306, 21.7184 },
+    0.3515 },
+  { 11,
+    { 4.7626, 3.1736, 1.2674, 1.1128 },
+    { 3.285, 8.8422, 0.3136, 129.424 },
+    0.676 },
+  { 12,
+    { 5.4204, 2.1735, 1.2269, 2.3073 },
+    { 2.8275, 79.2611, 0.3808, 7.1937 },
+    0.8584 },
+  { 13,
+    { 6.4202, 1.9002, 1.5936, 1.9646 },
+    { 3.0387, 0.7426, 31.5472, 85.0886 },
+    1.1151 },
+  { 14,
+    { 6.2915, 3.0353, 1.9891, 1.541 },
+    { 2.4386, 32.3337, 0.6785, 81.6937 },
+    1.1407 },
+  { 15,
+    { 6.4345, 4.1791, 1.78, 1.4908 },
+    { 1.9067, 27.157, 0.526, 68.1645 },
+    1.1149 },
+  { 16,
+    { 6.9053, 5.2034, 1.4379, 1.5863 },
+    { 1.4679, 22.2151, 0.2536, 56.172 },
+    0.8669 },
+  { 17,
+    { 11.4604, 7.1964, 6.2556, 1.6455 },
+    { 0.0104, 1.1662, 18.5194, 47.7784 },
+    -9.5574 },
+  { 18,
+    { 7.4845, 6.7723, 0.6539, 1.6442 },
+    { 0.9072, 14.8407, 43.8983, 33.3929 },
+    1.4445 },
+  { 19,
+    { 8.2186, 7.4398, 1.0519, 0.8659 },
+    { 12.7949, 0.7748, 213.187, 41.6841 },
+    1.4228 },
+  { 20,
+    { 8.6266, 7.3873, 1.5899, 1.0211 },
+    { 10.4421, 0.6599, 85.7484, 178.437 },
+    1.3751 },
+  { 21,
+    { 9.189, 7.3679, 1.6409, 1.468 },
+    { 9.0213, 0.5729, 136.108, 51.3531 },
+    1.3329 },
+  { 22,
+    { 9.7595, 7.3558, 1.6991, 1.9021 },
+    { 7.8508, 0.5, 35.6338, 116.105 },
+    1.2807 },
+  { 23,
+    { 10.2971, 7.3511, 2.0703, 2.0571 },
+    { 6.8657, 0.4385, 26.8938, 102.478 },
+    1.2199 },
+  { 24,
+    { 10.6406, 7.3537, 3.324, 1.4922 },
+    { 6.1038, 0.392, 20.2626, 98.7399 },
+    1.1832 },
+  { 25,
+    { 11.2819, 7.3573, 3.0193, 2.2441 },
+    { 5.3409, 0.3432, 17.8674, 83.7543 },
+    1.0896 },
+  { 26,
+    { 11.7695, 7.3573, 3.5222, 2.3045 },
+    { 4.7611, 0.3072, 15.3535, 76.8805 },
+    1.0369 },
+  { 27,
+    { 12.2841, 7.3409, 4.0034, 2.3488 },
+    { 4.2791, 0.2784, 13.5359, 71.1692 },
+    1.0118 },
+  { 28,
+    { 12.8376, 7.292, 4.4438, 2.38 },
+    { 3.8785, 0.2565, 12.1763, 66.3421 },
+    1.0341 },
+  { 29,
+    { 13.338, 7.1676, 5.6158, 1.6735 },
+    { 3.5828, 0.247, 11.3966, 64.8126 },
+    1.191 },
+  { 30,
+    { 14.0743, 7.0318, 5.1652, 2.41 },
+    { 3.2655, 0.2333, 10.3163, 58.7097 },
+    1.3041 },
+  { 31,
+    { 15.2354, 6.7006, 4.3591, 2.9623 },
+    { 3.0669, 0.2412, 10.7805, 61.4135 },
+    1.7189 },
+  { 32,
+    { 16.0816, 6.3747, 3.7068, 3.683 },
+    { 2.8509, 0.2516, 11.4468, 54.7625 },
+    2.1313 },
+  { 33,
+    { 16.6723, 6.0701, 3.4313, 4.2779 },
+    { 2.6345, 0.2647, 12.9479, 47.7972 },
+    2.531 },
+  { 34,
+    { 17.0006, 5.8196, 3.9731, 4.3543 },
+    { 2.4098, 0.2726, 15.2372, 43.8163 },
+    2.8409 },
+  { 35,
+    { 17.1789, 5.2358, 5.6377, 3.9851 },
+    { 2.1723, 16.5796, 0.2609, 41.4328 },
+    2.9557 },
+  { 36,
+    { 17.3555, 6.7286, 5.5493, 3.5375 },
+    { 1.9384, 16.5623, 0.2261, 73.5654 },
+    2.825 },
+  { 37,
+    { 17.1784, 9.6435, 5.1399, 1.5292 },
+    { 1.7888, 17.3151, 0.2748, 164.934 },
+    3.4873 },
+  { 38,
+    { 17.5663, 9.8184, 5.422, 2.6694 },
+    { 1.5564, 14.0988, 0.1664, 132.376 },
+    2.5064 },
+  { 39,
+    { 17.776, 10.2946, 5.72629, 3.26588 },
+    { 1.4029, 12.8006, 0.125599, 104.354 },
+    1.91213 },
+  { 40,
+    { 17.8765, 10.948, 5.41732, 3.65721 },
+    { 1.27618, 11.916, 0.117622, 87.6627 },
+    2.06929 },
+  { 41,
+    { 17.6142, 12.0144, 4.04183, 3.53346 },
+    { 1.18865, 11.766, 0.204785, 69.7957 },
+    3.75591 },
+  { 42,
+    { 3.7025, 17.2356, 12.8876, 3.7429 },
+    { 0.2772, 1.0958, 11.004, 61.6584 },
+    4.3875 },
+  { 43,
+    { 19.1301, 11.0948, 4.64901, 2.71263 },
+    { 0.864132, 8.14487, 21.5707, 86.8472 },
+    5.40428 },
+  { 44,
+    { 19.2674, 12.9182, 4.86337, 1.56756 },
+    { 0.80852, 8.43467, 24.7997, 94.2928 },
+    5.37874 },
+  { 45,
+    { 19.2957, 14.3501, 4.73425, 1.28918 },
+    { 0.751536, 8.21758, 25.8749, 98.6062 },
+    5.328 },
+  { 46,
+    { 19.3319, 15.5017, 5.29537, 0.605844 },
+    { 0.698655, 7.98929, 25.2052, 76.8986 },
+    5.26593 },
+  { 47,
+    { 19.2808, 16.6885, 4.8045, 1.0463 },
+    { 0.6446, 7.4726, 24.6605, 99.8156 },
+    5.179 },
+  { 48,
+    { 19.2214, 17.6444, 4.461, 1.6029 },
+    { 0.5946, 6.9089, 24.7008, 87.4825 },
+    5.0694 },
+  { 49,
+    { 19.1624, 18.5596, 4.2948, 2.0396 },
+    { 0.5476, 6.3776, 25.8499, 92.8029 },
+    4.9391 },
+  { 50,
+    { 19.1889, 19.1005, 4.4585, 2.4663 },
+    { 5.8303, 0.5031, 26.8909, 83.9571 },
+    4.7821 },
+  { 51,
+    { 19.6418, 19.0455, 5.0371, 2.6827 },
+    { 5.3034, 0.4607, 27.9074, 75.2825 },
+    4.5909 },
+  { 52,
+    { 19.9644, 19.0138, 6.14487, 2.5239 },
+    { 4.81742, 0.420885, 28.5284, 70.8403 },
+    4.352 },
+  { 53,
+    { 20.1472, 18.9949, 7.5138, 2.2735 },
+    { 4.347, 0.3814, 27.766, 66.8776 },
+    4.0712 },
+  { 54, { 20.2933, 19.0298, 8.9767, 1.99 }, { 3.9282, 0.344, 26.4659, 64.2658 },
+    3.7118 },
+  { 55,
+    { 20.3892, 19.1062, 10.662, 1.4953 },
+    { 3.569, 0.3107, 24.3879, 213.904 },
+    3.3352 },
+  { 56,
+    { 20.3361, 19.297, 10.888, 2.6959 },
+    { 3.216, 0.2756, 20.2073, 167.202 },
+    2.7731 },
+  { 57,
+    { 20.578, 19.599, 11.3727, 3.28719 },
+    { 2.94817, 0.244475, 18.7726, 133.124 },
+    2.14678 },
+  { 58,
+    { 21.1671, 19.7695, 11.8513, 3.33049 },
+    { 2.81219, 0.226836, 17.6083, 127.113 },
+    1.86264 },
+  { 59,
+    { 22.044, 19.6697, 12.3856, 2.82428 },
+    { 2.77393, 0.222087, 16.7669, 143.644 },
+    2.0583 },
+  { 60,
+    { 22.6845, 19.6847, 12.774, 2.85137 },
+    { 2.66248, 0.210628, 15.885, 137.903 },
+    1.98486 },
+  { 61,
+    { 23.3405, 19.6095, 13.1235, 2.87516 },
+    { 2.5627, 0.202088, 15.1009, 132.721 },
+    2.02876 },
+  { 62,
+    { 24.0042, 19.4258, 13.4396, 2.89604 },
+    { 2.47274, 0.196451, 14.3996, 128.007 },
+    2.20963 },
+  { 63,
+    { 24.6274, 19.0886, 13.7603, 2.9227 },
+    { 2.3879, 0.1942, 13.7546, 123.174 },
+    2.5745 },
+  { 64,
+    { 25.0709, 19.0798, 13.8518, 3.54545 },
+    { 2.25341, 0.181951, 12.9331, 101.398 },
+    2.4196 },
+  { 65,
+    { 25.8976, 18.2185, 14.3167, 2.95354 },
+    { 2.24256, 0.196143, 12.6648, 115.362 },
+    3.58324 },
+  { 66,
+    { 26.507, 17.6383, 14.5596, 2.96577 },
+    { 2.1802, 0.202172, 12.1899, 111.874 },
+    4.29728 },
+  { 67,
+    { 26.9049, 17.294, 14.5583, 3.63837 },
+    { 2.07051, 0.19794, 11.4407, 92.6566 },
+    4.56796 },
+  { 68,
+    { 27.6563, 16.4285, 14.9779, 2.98233 },
+    { 2.07356, 0.223545, 11.3604, 105.703 },
+    5.92046 },
+  { 69,
+    { 28.1819, 15.8851, 15.1542, 2.98706 },
+    { 2.02859, 0.238849, 10.9975, 102.961 },
+    6.75621 },
+  { 70,
+    { 28.6641, 15.4345, 15.3087, 2.98963 },
+    { 1.9889, 0.257119, 10.6647, 100.417 },
+    7.56672 },
+  { 71,
+    { 28.9476, 15.2208, 15.1, 3.71601 },
+    { 1.90182, 9.98519, 0.261033, 84.3298 },
+    7.97628 },
+  { 72,
+    { 29.144, 15.1726, 14.7586, 4.30013 },
+    { 1.83262, 9.5999, 0.275116, 72.029 },
+    8.58154 },
+  { 73,
+    { 29.2024, 15.2293, 14.5135, 4.76492 },
+    { 1.77333, 9.37046, 0.295977, 63.3644 },
+    9.24354 },
+  { 74,
+    { 29.0818, 15.43, 14.4327, 5.11982 },
+    { 1.72029, 9.2259, 0.321703, 57.056 },
+    9.8875 },
+  { 75,
+    { 28.7621, 15.7189, 14.5564, 5.44174 },
+    { 1.67191, 9.09227, 0.3505, 52.0861 },
+    10.472 },
+  { 76,
+    { 28.1894, 16.155, 14.9305, 5.67589 },
+    { 1.62903, 8.97948, 0.382661, 48.1647 },
+    11.0005 },
+  { 77,
+    { 27.3049, 16.7296, 15.6115, 5.83377 },
+    { 1.59279, 8.86553, 0.417916, 45.0011 },
+    11.4722 },
+  { 78,
+    { 27.0059, 17.7639, 15.7131, 5.7837 },
+    { 1.51293, 8.81174, 0.424593, 38.6103 },
+    11.6883 },
+  { 79,
+    { 16.8819, 18.5913, 25.5582, 5.86 },
+    { 0.4611, 8.6216, 1.4826, 36.3956 },
+    12.0658 },
+  { 80,
+    { 20.6809, 19.0417, 21.6575, 5.9676 },
+    { 0.545, 8.4484, 1.5729, 38.3246 },
+    12.6089 },
+  { 81,
+    { 27.5446, 19.1584, 15.538, 5.52593 },
+    { 0.65515, 8.70751, 1.96347, 45.8149 },
+    13.1746 },
+  { 82,
+    { 31.0617, 13.0637, 18.442, 5.9696 },
+    { 0.6902, 2.3576, 8.618, 47.2579 },
+    13.4118 },
+  { 83,
+    { 33.3689, 12.951, 16.5877, 6.4692 },
+    { 0.704, 2.9238, 8.7937, 48.0093 },
+    13.5782 },
+  { 84,
+    { 34.6726, 15.4733, 13.1138, 7.02588 },
+    { 0.700999, 3.55078, 9.55642, 47.0045 },
+    13.677 },
+  { 85,
+    { 35.3163, 19.0211, 9.49887, 7.42518 },
+    { 0.68587, 3.97458, 11.3824, 45.4715 },
+    13.7108 },
+  { 86,
+    { 35.5631, 21.2816, 8.0037, 7.4433 },
+    { 0.6631, 4.0691, 14.0422, 44.2473 },
+    13.6905 },
+  { 87,
+    { 35.9299, 23.0547, 12.1439, 2.11253 },
+    { 0.646453, 4.17619, 23.1052, 150.645 },
+    13.7247 },
+  { 88,
+    { 35.763, 22.9064, 12.4739, 3.21097 },
+    { 0.616341, 3.87135, 19.9887, 142.325 },
+    13.6211 },
+  { 89,
+    { 35.6597, 23.1032, 12.5977, 4.08655 },
+    { 0.589092, 3.65155, 18.599, 117.02 },
+    13.5266 },
+  { 90,
+    { 35.5645, 23.4219, 12.7473, 4.80703 },
+    { 0.563359, 3.46204, 17.8309, 99.1722 },
+    13.4314 },
+  { 91,
+    { 35.8847, 23.2948, 14.1891, 4.17287 },
+    { 0.547751, 3.41519, 16.9235, 105.251 },
+    13.4287 },
+  { 92,
+    { 36.0228, 23.4128, 14.9491, 4.188 },
+    { 0.5293, 3.3253, 16.0927, 100.613 },
+    13.3966 },
+  { 93,
+    { 36.1874, 23.5964, 15.6402, 4.1855 },
+    { 0.511929, 3.25396, 15.3622, 97.4908 },
+    13.3573 },
+  { 94,
+    { 36.5254, 23.8083, 16.7707, 3.47947 },
+    { 0.499384, 3.26371, 14.9455, 105.98 },
+    13.3812 },
+  { 95,
+    { 36.6706, 24.0992, 17.3415, 3.49331 },
+    { 0.483629, 3.20647, 14.3136, 102.273 },
+    13.3592 },
+  { 96,
+    { 36.6488, 24.4096, 17.399, 4.21665 },
+    { 0.465154, 3.08997, 13.4346, 88.4834 },
+    13.2887 },
+  { 97,
+    { 36.7881, 24.7736, 17.8919, 4.23284 },
+    { 0.451018, 3.04619, 12.8946, 86.003 },
+    13.2754 },
+  { 98,
+    { 36.9185, 25.1995, 18.3317, 4.24391 },
+    { 0.437533, 3.00775, 12.4044, 83.7881 },
+    13.2674 },
+};
+
+double cromerMannFactor(const CromerMann& coefficients, double sSq)
+{
+  double f = coefficients.c;
+  for (int i = 0; i < 4; ++i)
+    f += coefficients.a[i] * std::exp(-coefficients.b[i] * sSq);
+  return f;
+}
+
+// Structure factors of all reflections in the same chunk are computed with
+// the atoms of each element packed together.
+struct ElementAtoms
+{
+  unsigned char atomicNumber;
+  Eigen::Matrix<double, Eigen::Dynamic, 3> fractional;
+};
+
+struct Reflection
+{
+  int h, k, l;
+  double dSpacing;
+  double structureFactorSq;
+};
+
+// Reflections closer than this (relative) are taken as equivalent.
+const double equalTolerance = 1e-6;
+
+bool nearlyEqual(double a, double b, double scale)
+{
+  return std::abs(a - b) <= equalTolerance * scale;
+}
+
+} // namespace
+
+XrdPattern::XrdPattern()
+  : m_wavelength(1.5056), m_peakWidth(0.52958), m_pointCount(1000),
+    m_max2Theta(162.0)
+{
+}
+
+bool XrdPattern::hasScatteringFactor(unsigned char atomicNumber)
+{
+  return atomicNumber <= std::size(cromerMann);
+}
+
+double XrdPattern::scatteringFactor(unsigned char atomicNumber, double s)
+{
+  if (atomicNumber == 0)
+    return 0.0;
+  if (!hasScatteringFactor(atomicNumber))
+    return std::numeric_limits<double>::quiet_NaN();
+  return cromerMannFactor(cromerMann[atomicNumber - 1], s * s);
+}
+
+bool XrdPattern::compute(const UnitCell& cell, const Array<Vector3>& fractional,
+                         const Array<unsigned char>& atomicNumbers)
+{
+  m_reflections.clear();
+  if (fractional.empty() || fractional.size() != atomicNumbers.size() ||
+      !(m_wavelength > 0.0) || !(m_max2Theta > 0.0) || !(cell.volume() > 0.0))
+    return false;
+  if (!std::all_of(atomicNumbers.begin(), atomicNumbers.end(),
+                   hasScatteringFactor)) {
+    return false;
+  }
+
+  // The smallest d-spacing seen at the maximum angle.
+  const double maxTheta = std::min(m_max2Theta, 180.0) * M_PI / 360.0;
+  const double dMin = m_wavelength / (2.0 * std::sin(maxTheta));
+  const double maxInverseDSq = 1.0 / (dMin * dMin);
+
+  // 1/d^2 = hkl^T G* hkl, with the reciprocal metric tensor G*. Along each
+  // axis |h| <= |a| / d, as h = a . (reciprocal vector of hkl).
+  const Matrix3& toFractional = cell.fractionalMatrix();
+  const Matrix3 metric = toFractional * toFractional.transpose();
+  const int hMax = static_cast<int>(std::floor(cell.a() / dMin));
+  const int kMax = static_cast<int>(std::floor(cell.b() / dMin));
+  const int lMax = static_cast<int>(std::floor(cell.c() / dMin));
+
+  // Only one of each Friedel pair hkl / -h-k-l is kept, as they have the
+  // same intensity.
+  std::vector<Reflection> reflections;
+  for (int h = 0; h <= hMax; ++h) {
+    for (int k = (h == 0 ? 0 : -kMax); k <= kMax; ++k) {
+      const Eigen::Vector2d hk(h, k);
+      const double hkPart = hk.dot(metric.topLeftCorner<2, 2>() * hk);
+      const double lLinear = 2.0 * (h * metric(0, 2) + k * metric(1, 2));
+      for (int l = (h == 0 && k == 0 ? 1 : -lMax); l <= lMax; ++l) {
+        const double inverseDSq = hkPart + l * (lLinear + l * metric(2, 2));
+        if (inverseDSq > maxInverseDSq || !(inverseDSq > 0.0))
+          continue;
+        reflections.push_back({ h, k, l, 1.0 / std::sqrt(inverseDSq), 0.0 });
+      }
+    }
+  }
+
+  std::map<unsigned char, std::vector<Index>> byElement;
+  for (Index i = 0; i < fractional.size(); ++i)
+    byElement[atomicNumbers[i]].push_back(i);
+  std::vector<ElementAtoms> elements;
+  for (const auto& element : byElement) {
+    ElementAtoms atoms;
+    atoms.atomicNumber = element.first;
+    atoms.fractional.resize(element.second.size(), 3);
+    for (size_t j = 0; j < element.second.size(); ++j)
+      atoms.fractional.row(j) = fractional[element.second[j]].transpose();
+    elements.push_back(std::move(atoms));
+  }
+
+  parallelFor(0, reflections.size(), 256, [&](Index begin, Index end) {
+    Eigen::ArrayXd phase;
+    for (Index r = begin; r < end; ++r) {
+      Reflection& reflection = reflections[r];
+      const Vector3 hkl(reflection.h, reflection.k, reflection.l);
+      const double s = 0.5 / reflection.dSpacing;
+      std::complex<double> factor(0.0, 0.0);
+      for (const auto& atoms : elements) {
+        phase = (2.0 * M_PI) * (atoms.fractional * hkl).array();
+        factor += scatteringFactor(atoms.atomicNumber, s) *
+                  std::complex<double>(phase.cos().sum(), phase.sin().sum());
+      }
+      reflection.structureFactorSq = std::norm(factor);
+    }
+  });
+
+  // Drop systematic absences, then merge reflections that a powder cannot
+  // tell apart: same spacing, same structure factor.
+  double totalFactor = 0.0;
+  for (Index i = 0; i < fractional.size(); ++i)
+    totalFactor += atomicNumbers[i];
+  const double absent = equalTolerance * totalFactor * totalFactor;
+  reflections.erase(std::remove_if(reflections.begin(), reflections.end(),
+                                   [absent](const Reflection& reflection) {
+                                     return reflection.structureFactorSq <=
+                                            absent;
+                                   }),
+                    reflections.end());
+  std::sort(reflections.begin(), reflections.end(),
+            [](const Reflection& a, const Reflection& b) {
+              if (a.dSpacing != b.dSpacing)
+                return a.dSpacing > b.dSpacing;
+              return std::make_tuple(a.h, a.k, a.l) >
+                     std::make_tuple(b.h, b.k, b.l);
+            });
+
+  const double maxFactorSq = totalFactor * totalFactor;
+  for (size_t first = 0; first < reflections.size();) {
+    size_t last = first + 1;
+    while (last < reflections.size() &&
+           nearlyEqual(reflections[last].dSpacing, reflections[first].dSpacing,
+                       reflections[first].dSpacing))
+      ++last;
+    // within the same spacing, group equal structure factors; the
+    // representative is the first with the largest indices
+    std::stable_sort(reflections.begin() + first, reflections.begin() + last,
+                     [](const Reflection& a, const Reflection& b) {
+                       return a.structureFactorSq > b.structureFactorSq;
+                     });
+    for (size_t i = first; i < last;) {
+      size_t j = i + 1;
+      while (j < last && nearlyEqual(reflections[j].structureFactorSq,
+                                     reflections[i].structureFactorSq,
+                                     maxFactorSq))
+        ++j;
+      const Reflection& reflection = reflections[i];
+      XrdReflection line;
+      line.h = reflection.h;
+      line.k = reflection.k;
+      line.l = reflection.l;
+      line.dSpacing = reflection.dSpacing;
+      const double theta = std::asin(
+        std::min(1.0, m_wavelength / (2.0 * reflection.dSpacing)));
+      line.twoTheta = 2.0 * theta * 180.0 / M_PI;
+      // each kept reflection stands for its Friedel pair as well
+      line.multiplicity = static_cast<unsigned int>(2 * (j - i));
+      line.structureFactorSq = reflection.structureFactorSq;
+      const double cos2Theta = std::cos(2.0 * theta);
+      const double sinTheta = std::sin(theta);
+      const double lorentzPolarization =
+        (1.0 + cos2Theta * cos2Theta) /
+        (sinTheta * sinTheta * std::cos(theta));
+      line.intensity =
+        line.multiplicity * line.structureFactorSq * lorentzPolarization;
+      m_reflections.push_back(line);
+      i = j;
+    }
+    first = last;
+  }
+  std::stable_sort(m_reflections.begin(), m_reflections.end(),
+                   [](const XrdReflection& a, const XrdReflection& b) {
+                     return a.twoTheta < b.twoTheta;
+                   });
+  return true;
+}
+
+std::vector<std::pair<double, double>> XrdPattern::pattern() const
+{
+  std::vector<std::pair<double, double>> result;
+  if (m_pointCount == 0)
+    return result;
+
+  const double step =
+    m_pointCount > 1 ? m_max2Theta / (m_pointCount - 1) : m_max2Theta;
+  std::vector<double> profile(m_pointCount, 0.0);
+  const double sigma =
+    std::max(m_peakWidth, 1e-6) / (2.0 * std::sqrt(2.0 * std::log(2.0)));
+  // peaks are cut off at five standard deviations
+  const double reach = 5.0 * sigma;
+  for (const auto& line : m_reflections) {
+    const auto lo = static_cast<long>(
+      std::max(0.0, std::ceil((line.twoTheta - reach) / step)));
+    const auto hi = static_cast<long>(
+      std::min<double>(m_pointCount - 1, (line.twoTheta + reach) / step));
+    for (long i = lo; i <= hi; ++i) {
+      const double x = (i * step - line.twoTheta) / sigma;
+      profile[i] += line.intensity * std::exp(-0.5 * x * x);
+    }
+  }
+
+  const double highest = *std::max_element(profile.begin(), profile.end());
+  const double scale = highest > 0.0 ? 100.0 / highest : 0.0;
+  result.reserve(m_pointCount);
+  for (size_t i = 0; i < m_pointCount; ++i)
+    result.emplace_back(i * step, profile[i] * scale);
+  return result;
+}
+
+} // namespace Avogadro::Core
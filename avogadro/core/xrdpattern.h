@@ -0,0 +1,139 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_XRDPATTERN_H
+#define AVOGADRO_CORE_XRDPATTERN_H
+
+#include "avogadrocoreexport.h"
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <utility>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class UnitCell;
+
+/**
+ * @brief One line of a powder diffraction pattern: a set of reflections that
+ * are equivalent in a powder, i.e., that have the same d-spacing and
+ * structure factor.
+ */
+struct XrdReflection
+{
+  /** Miller indices of one of the reflections. */
+  int h;
+  int k;
+  int l;
+  /** Interplanar spacing, in Angstrom. */
+  double dSpacing;
+  /** Diffraction angle 2 theta, in degrees. */
+  double twoTheta;
+  /** Number of reflections merged into this line. */
+  unsigned int multiplicity;
+  /** Squared modulus of the structure factor of each reflection. */
+  double structureFactorSq;
+  /**
+   * Integrated intensity of the line: multiplicity, squared structure factor
+   * and the Lorentz-polarization factor, in arbitrary units.
+   */
+  double intensity;
+};
+
+/**
+ * @class XrdPattern xrdpattern.h <avogadro/core/xrdpattern.h>
+ * @brief Calculates the theoretical powder X-ray diffraction pattern of a
+ * crystal.
+ *
+ * All reflections within the maximum diffraction angle are enumerated from
+ * the reciprocal lattice, and their structure factors are summed over the
+ * atoms of the unit cell, with atoms of the same element sharing one
+ * scattering factor. The reflections are spread over threads. Reflections
+ * with the same d-spacing and structure factor are merged into one line,
+ * and the lines are broadened into a profile with Gaussian peaks.
+ *
+ * Atomic scattering factors use the Cromer-Mann coefficients of the
+ * International Tables for Crystallography, which cover hydrogen to
+ * californium. Thermal motion and anomalous dispersion are not included.
+ */
+class AVOGADROCORE_EXPORT XrdPattern
+{
+public:
+  XrdPattern();
+
+  /** The X-ray wavelength, in Angstrom. @{ */
+  double wavelength() const { return m_wavelength; }
+  void setWavelength(double wavelength) { m_wavelength = wavelength; }
+  /** @} */
+
+  /** The full width at half maximum of the peaks, in degrees 2 theta. @{ */
+  double peakWidth() const { return m_peakWidth; }
+  void setPeakWidth(double width) { m_peakWidth = width; }
+  /** @} */
+
+  /** The number of points in the profile returned by pattern(). @{ */
+  size_t pointCount() const { return m_pointCount; }
+  void setPointCount(size_t count) { m_pointCount = count; }
+  /** @} */
+
+  /** The largest diffraction angle 2 theta, in degrees. @{ */
+  double max2Theta() const { return m_max2Theta; }
+  void setMax2Theta(double angle) { m_max2Theta = angle; }
+  /** @} */
+
+  /**
+   * Compute the reflections of a crystal.
+   * @param cell The unit cell.
+   * @param fractional Fractional coordinates of the atoms in the cell.
+   * @param atomicNumbers Atomic numbers of the atoms.
+   * @return False if the input or the settings are invalid, or an atom is
+   * an element without a scattering factor.
+   */
+  bool compute(const UnitCell& cell, const Array<Vector3>& fractional,
+               const Array<unsigned char>& atomicNumbers);
+
+  /** @return The lines of the last computed pattern, by increasing angle. */
+  const std::vector<XrdReflection>& reflections() const
+  {
+    return m_reflections;
+  }
+
+  /**
+   * @return The profile of the last computed pattern as pairs of 2 theta (in
+   * degrees) and intensity, scaled so that the highest point is 100.
+   */
+  std::vector<std::pair<double, double>> pattern() const;
+
+  /**
+   * @return The X-ray scattering factor of an atom, in electrons, or NaN if
+   * the element has none.
+   * @param atomicNumber The element of the atom.
+   * @param s sin(theta) / wavelength, in inverse Angstrom.
+   */
+  static double scatteringFactor(unsigned char atomicNumber, double s);
+
+  /**
+   * @return True if scatteringFactor() is tabulated for the element, i.e. up
+   * to californium. Dummy atoms (atomic number 0) scatter nothing.
+   */
+  static bool hasScatteringFactor(unsigned char atomicNumber);
+
+private:
+  double m_wavelength;
+  double m_peakWidth;
+  size_t m_pointCount;
+  double m_max2Theta;
+  std::vector<XrdReflection> m_reflections;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_XRDPATTERN_H
@@ -18,8 +18,15 @@
 
 #include <nlohmann/json.hpp>
 
-#include <iomanip>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <string_view>
 
 using json = nlohmann::json;
 
@@ -90,6 +97,577 @@ json eigenColToJson(const MatrixX& matrix, int column)
   return j;
 }
 
+namespace {
+
+// Arrays which can hold a value per atom, bond or basis function. They are
+// streamed into flat buffers instead of json values, and '*' matches any key.
+const char* const streamedArrays[] = {
+  "atoms/colors",
+  "atoms/coords/3d",
+  "atoms/coords/3d fractional",
+  "atoms/coords/3dFractional",
+  "atoms/coords/3dSets/*",
+  "atoms/elements/number",
+  "atoms/formalCharges",
+  "atoms/layer",
+  "atoms/partialCharges/*",
+  "atoms/selected",
+  "bonds/connections/index",
+  "bonds/order",
+  "orbitals/alphaCoefficients",
+  "orbitals/betaCoefficients",
+  "orbitals/moCoefficients",
+  "orbitals/sets/*/alphaCoefficients",
+  "orbitals/sets/*/betaCoefficients",
+  "orbitals/sets/*/moCoefficients",
+  "vibrations/eigenVectors/*",
+};
+
+// Values which are not read at all.
+const char* const skippedValues[] = {
+  "atoms/coords/2d",
+  "cube",
+};
+
+// Do not trust array sizes from MessagePack headers beyond this.
+const size_t maxReserve = 1 << 24;
+
+template <size_t N>
+bool matchesAny(const vector<string>& path, const char* const (&patterns)[N])
+{
+  for (const char* pattern : patterns) {
+    const std::string_view view(pattern);
+    size_t start = 0;
+    bool match = true;
+    for (const auto& segment : path) {
+      size_t end = std::min(view.find('/', start), view.size());
+      if (start > view.size() ||
+          (view.substr(start, end - start) != "*" &&
+           view.substr(start, end - start) != segment)) {
+        match = false;
+        break;
+      }
+      start = end + 1;
+    }
+    if (match && start > view.size())
+      return true;
+  }
+  return false;
+}
+
+// A streamed array of numbers or booleans.
+struct NumericArray
+{
+  vector<double> values;
+  bool numbers = true;
+  bool booleans = true;
+
+  bool isNumeric() const { return numbers && !values.empty(); }
+  bool isBoolean() const { return booleans && !values.empty(); }
+  size_t size() const { return values.size(); }
+
+  // integers wrap around when converted to narrower types, as in json
+  long long integer(size_t i) const { return static_cast<long long>(values[i]); }
+
+  Array<Vector3> vectors() const
+  {
+    Array<Vector3> result(values.size() / 3);
+    for (size_t i = 0; i < result.size(); ++i)
+      result[i] = Vector3(values[3 * i], values[3 * i + 1], values[3 * i + 2]);
+    return result;
+  }
+};
+
+// SAX handler building the document without the streamed arrays, which are
+// left as null placeholders. Works for both JSON and MessagePack input.
+class CjsonReader
+{
+public:
+  json& root() { return m_root; }
+
+  /** @return The streamed array at the '/' separated @p path, if any. */
+  const NumericArray* array(const std::string& path) const
+  {
+    auto it = m_arrays.find(path);
+    return it != m_arrays.end() ? &it->second : nullptr;
+  }
+
+  /** @return The streamed array at @p path if it only holds numbers. */
+  const NumericArray* numericArray(const std::string& path) const
+  {
+    const NumericArray* result = array(path);
+    return result && result->isNumeric() ? result : nullptr;
+  }
+
+  bool null() { return value(json()); }
+
+  bool boolean(bool value)
+  {
+    if (m_array && !m_skip) {
+      m_array->values.push_back(value ? 1.0 : 0.0);
+      m_array->numbers = false;
+      return true;
+    }
+    return this->value(json(value));
+  }
+
+  bool number_integer(json::number_integer_t value)
+  {
+    return number(static_cast<double>(value), json(value));
+  }
+
+  bool number_unsigned(json::number_unsigned_t value)
+  {
+    return number(static_cast<double>(value), json(value));
+  }
+
+  bool number_float(json::number_float_t value, const json::string_t&)
+  {
+    return number(value, json(value));
+  }
+
+  bool string(json::string_t& value) { return this->value(json(value)); }
+
+  // only sent by newer versions of the library for MessagePack bin values
+  template <typename Binary>
+  bool binary(Binary&)
+  {
+    return value(json());
+  }
+
+  bool start_object(std::size_t) { return startContainer(false, 0); }
+
+  bool key(json::string_t& key)
+  {
+    m_key = key;
+    return true;
+  }
+
+  bool end_object() { return endContainer(); }
+
+  bool start_array(std::size_t size) { return startContainer(true, size); }
+
+  bool end_array() { return endContainer(); }
+
+  bool parse_error(std::size_t, const std::string&,
+                   const nlohmann::detail::exception&)
+  {
+    return false;
+  }
+
+private:
+  bool number(double value, json&& element)
+  {
+    if (m_array && !m_skip) {
+      m_array->values.push_back(value);
+      m_array->booleans = false;
+      return true;
+    }
+    return this->value(std::move(element));
+  }
+
+  bool value(json&& element)
+  {
+    if (m_array && !m_skip)
+      m_array->numbers = m_array->booleans = false;
+    else if (!m_skip)
+      insert(std::move(element));
+    return true;
+  }
+
+  json* insert(json&& element)
+  {
+    if (m_stack.empty()) {
+      m_root = std::move(element);
+      return &m_root;
+    }
+    json& parent = *m_stack.back();
+    if (parent.is_object()) {
+      json& slot = parent[m_key];
+      slot = std::move(element);
+      return &slot;
+    }
+    parent.push_back(std::move(element));
+    return &parent.back();
+  }
+
+  bool startContainer(bool isArray, std::size_t size)
+  {
+    if (m_array || m_skip) {
+      // nested values make a streamed array invalid
+      if (m_array)
+        m_array->numbers = m_array->booleans = false;
+      ++m_skip;
+      return true;
+    }
+    if (m_stack.empty()) {
+      m_root = isArray ? json::array() : json::object();
+      m_stack.push_back(&m_root);
+      return true;
+    }
+
+    const json& parent = *m_stack.back();
+    m_path.push_back(parent.is_object() ? m_key
+                                        : std::to_string(parent.size()));
+    if (matchesAny(m_path, skippedValues)) {
+      m_path.pop_back();
+      m_skip = 1;
+      return true;
+    }
+    if (isArray && matchesAny(m_path, streamedArrays)) {
+      std::string path = m_path.front();
+      for (size_t i = 1; i < m_path.size(); ++i)
+        path += '/' + m_path[i];
+      m_path.pop_back();
+      m_array = &m_arrays[path];
+      *m_array = NumericArray();
+      // JSON does not know the size in advance, MessagePack does
+      if (size != static_cast<std::size_t>(-1))
+        m_array->values.reserve(std::min(size, maxReserve));
+      insert(json());
+      return true;
+    }
+    m_stack.push_back(insert(isArray ? json::array() : json::object()));
+    return true;
+  }
+
+  bool endContainer()
+  {
+    if (m_skip) {
+      --m_skip;
+    } else if (m_array) {
+      m_array = nullptr;
+    } else {
+      m_stack.pop_back();
+      if (!m_stack.empty())
+        m_path.pop_back();
+    }
+    return true;
+  }
+
+  json m_root;
+  // open containers, and their keys or indices below the root
+  vector<json*> m_stack;
+  vector<std::string> m_path;
+  std::string m_key;
+  std::map<std::string, NumericArray> m_arrays;
+  NumericArray* m_array = nullptr;
+  // depth of nested values that are being ignored
+  size_t m_skip = 0;
+};
+
+// Writes a document as indented JSON, exactly like json::dump(2) does, or as
+// MessagePack. Arrays registered with stream() are written straight from the
+// molecule in place of their null placeholders, without copying them into
+// the document first.
+class CjsonWriter
+{
+public:
+  using Elements = std::function<void(CjsonWriter&)>;
+
+  CjsonWriter(std::ostream& out, bool isJson) : m_out(out), m_json(isJson) {}
+
+  /**
+   * Make @p placeholder null, and write it as an array of @p size elements
+   * which @p elements writes with number(), integer(), boolean() or string().
+   * The placeholder must stay at the same address in the document.
+   */
+  void stream(json& placeholder, size_t size, Elements elements)
+  {
+    placeholder = nullptr;
+    m_streams[&placeholder] = Stream{ size, std::move(elements) };
+  }
+
+  void write(const json& root) { writeValue(root, 0); }
+
+  void number(double value)
+  {
+    nextElement();
+    if (!m_json) {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      m_out.put(static_cast<char>(0xcb));
+      writeBigEndian(bits, 8);
+    } else if (!std::isfinite(value)) {
+      m_out << "null";
+    } else {
+      writeDouble(value);
+    }
+  }
+
+  void integer(long long value)
+  {
+    nextElement();
+    writeInteger(value);
+  }
+
+  void boolean(bool value)
+  {
+    nextElement();
+    writeBoolean(value);
+  }
+
+  void string(const std::string& value)
+  {
+    nextElement();
+    writeString(value);
+  }
+
+private:
+  struct Stream
+  {
+    size_t size;
+    Elements elements;
+  };
+
+  void writeValue(const json& value, int depth)
+  {
+    switch (value.type()) {
+      case json::value_t::object:
+        if (m_json) {
+          if (value.empty()) {
+            m_out << "{}";
+            break;
+          }
+          m_out << '{';
+          for (auto it = value.begin(); it != value.end(); ++it) {
+            m_out << (it == value.begin() ? "\n" : ",\n");
+            indent(depth + 1);
+            writeString(it.key());
+            m_out << ": ";
+            writeValue(it.value(), depth + 1);
+          }
+          m_out << '\n';
+          indent(depth);
+          m_out << '}';
+        } else {
+          writeHeader(value.size(), 0x80, 0xde);
+          for (auto it = value.begin(); it != value.end(); ++it) {
+            writeString(it.key());
+            writeValue(it.value(), depth + 1);
+          }
+        }
+        break;
+      case json::value_t::array:
+        beginArray(value.size(), depth);
+        for (const auto& element : value) {
+          nextElement();
+          // nested arrays overwrite the element state
+          const std::string separator = m_separator;
+          writeValue(element, depth + 1);
+          m_first = false;
+          m_separator = separator;
+        }
+        endArray(value.size(), depth);
+        break;
+      case json::value_t::null: {
+        auto it = m_streams.find(&value);
+        if (it != m_streams.end()) {
+          beginArray(it->second.size, depth);
+          it->second.elements(*this);
+          endArray(it->second.size, depth);
+        } else {
+          m_out << (m_json ? "null" : "\xc0");
+        }
+        break;
+      }
+      case json::value_t::boolean:
+        writeBoolean(value.get<bool>());
+        break;
+      case json::value_t::number_integer:
+        writeInteger(value.get<json::number_integer_t>());
+        break;
+      case json::value_t::string:
+        writeString(value.get_ref<const json::string_t&>());
+        break;
+      default:
+        // unsigned and floating point numbers, as the library does it
+        if (m_json)
+          m_out << value.dump();
+        else
+          json::to_msgpack(value, m_out);
+    }
+  }
+
+  void beginArray(size_t size, int depth)
+  {
+    if (m_json)
+      m_out << (size > 0 ? "[" : "[]");
+    else
+      writeHeader(size, 0x90, 0xdc);
+    m_first = true;
+    m_separator = ",\n" + std::string(2 * (depth + 1), ' ');
+  }
+
+  void nextElement()
+  {
+    if (!m_json)
+      return;
+    // no comma before the first element
+    const size_t skip = m_first ? 1 : 0;
+    m_out.write(m_separator.data() + skip,
+                static_cast<std::streamsize>(m_separator.size() - skip));
+    m_first = false;
+  }
+
+  void endArray(size_t size, int depth)
+  {
+    if (m_json && size > 0) {
+      m_out << '\n';
+      indent(depth);
+      m_out << ']';
+    }
+  }
+
+  void indent(int depth)
+  {
+    for (int i = 0; i < depth; ++i)
+      m_out << "  ";
+  }
+
+  void writeBigEndian(uint64_t value, int bytes)
+  {
+    for (int i = bytes - 1; i >= 0; --i)
+      m_out.put(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+
+  // map and array headers, @p fix is the code of the short form
+  void writeHeader(size_t size, unsigned char fix, unsigned char code16)
+  {
+    if (size <= 15) {
+      m_out.put(static_cast<char>(fix | size));
+    } else if (size <= 0xffff) {
+      m_out.put(static_cast<char>(code16));
+      writeBigEndian(size, 2);
+    } else {
+      m_out.put(static_cast<char>(code16 + 1));
+      writeBigEndian(size, 4);
+    }
+  }
+
+  // shortest round trip digits, formatted like json::dump() does
+  void writeDouble(double value)
+  {
+#ifdef __cpp_lib_to_chars
+    // "-d.ddde-XX" to sign, digits and exponent
+    char buffer[32];
+    const char* end = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                                    std::chars_format::scientific)
+                        .ptr;
+    const char* e = std::find(static_cast<const char*>(buffer), end, 'e');
+    char digits[24];
+    int k = 0;
+    for (const char* c = buffer; c < e; ++c) {
+      if (*c >= '0' && *c <= '9')
+        digits[k++] = *c;
+    }
+    int exponent = 0;
+    std::from_chars(e + (e[1] == '+' ? 2 : 1), end, exponent);
+
+    // n is the position of the decimal point in the digits
+    char result[48];
+    char* out = result;
+    if (buffer[0] == '-')
+      *out++ = '-';
+    const int n = exponent + 1;
+    if (k <= n && n <= 15) {
+      out = std::copy(digits, digits + k, out);
+      out = std::fill_n(out, n - k, '0');
+      *out++ = '.';
+      *out++ = '0';
+    } else if (0 < n && n <= 15) {
+      out = std::copy(digits, digits + n, out);
+      *out++ = '.';
+      out = std::copy(digits + n, digits + k, out);
+    } else if (-4 < n && n <= 0) {
+      *out++ = '0';
+      *out++ = '.';
+      out = std::fill_n(out, -n, '0');
+      out = std::copy(digits, digits + k, out);
+    } else {
+      *out++ = digits[0];
+      if (k > 1) {
+        *out++ = '.';
+        out = std::copy(digits + 1, digits + k, out);
+      }
+      *out++ = 'e';
+      *out++ = exponent < 0 ? '-' : '+';
+      if (std::abs(exponent) < 10)
+        *out++ = '0';
+      out = std::to_chars(out, result + sizeof(result), std::abs(exponent)).ptr;
+    }
+    m_out.write(result, out - result);
+#else
+    m_out << json(value).dump();
+#endif
+  }
+
+  void writeInteger(long long value)
+  {
+    if (m_json) {
+      char buffer[24];
+      char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+      m_out.write(buffer, end - buffer);
+    } else if (value >= 0) {
+      const auto bits = static_cast<uint64_t>(value);
+      if (bits < 128) {
+        m_out.put(static_cast<char>(bits));
+      } else {
+        const int bytes =
+          bits <= 0xff ? 1 : bits <= 0xffff ? 2 : bits <= 0xffffffff ? 4 : 8;
+        const int codes[] = { 0, 0xcc, 0xcd, 0, 0xce, 0, 0, 0, 0xcf };
+        m_out.put(static_cast<char>(codes[bytes]));
+        writeBigEndian(bits, bytes);
+      }
+    } else if (value >= -32) {
+      m_out.put(static_cast<char>(value));
+    } else {
+      const int bytes = value >= INT8_MIN    ? 1
+                        : value >= INT16_MIN ? 2
+                        : value >= INT32_MIN ? 4
+                                             : 8;
+      const int codes[] = { 0, 0xd0, 0xd1, 0, 0xd2, 0, 0, 0, 0xd3 };
+      m_out.put(static_cast<char>(codes[bytes]));
+      writeBigEndian(static_cast<uint64_t>(value), bytes);
+    }
+  }
+
+  void writeBoolean(bool value)
+  {
+    if (m_json)
+      m_out << (value ? "true" : "false");
+    else
+      m_out.put(static_cast<char>(value ? 0xc3 : 0xc2));
+  }
+
+  void writeString(const std::string& value)
+  {
+    if (m_json) {
+      m_out << json(value).dump();
+      return;
+    }
+    const size_t size = value.size();
+    if (size <= 31) {
+      m_out.put(static_cast<char>(0xa0 | size));
+    } else {
+      const int bytes = size <= 0xff ? 1 : size <= 0xffff ? 2 : 4;
+      const int codes[] = { 0, 0xd9, 0xda, 0, 0xdb };
+      m_out.put(static_cast<char>(codes[bytes]));
+      writeBigEndian(size, bytes);
+    }
+    m_out.write(value.data(), static_cast<std::streamsize>(size));
+  }
+
+  std::ostream& m_out;
+  bool m_json;
+  std::map<const json*, Stream> m_streams;
+  // state of the array being written
+  bool m_first = true;
+  std::string m_separator;
+};
+
+} // namespace
+
 bool CjsonFormat::read(std::istream& file, Molecule& molecule)
 {
   return deserialize(file, molecule, true);
@@ -98,17 +676,22 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
 bool CjsonFormat::deserialize(std::istream& file, Molecule& molecule,
                               bool isJson)
 {
-  json jsonRoot;
+  // The arrays which can be large are streamed straight into flat buffers,
+  // everything else is read into a (small) document.
+  CjsonReader reader;
+  bool parsed;
   if (isJson)
-    jsonRoot = json::parse(file, nullptr, false);
+    parsed = json::sax_parse(file, &reader);
   else // msgpack
-    jsonRoot = json::from_msgpack(file);
+    parsed = json::sax_parse(file, &reader, json::input_format_t::msgpack);
 
-  if (jsonRoot.is_discarded()) {
+  if (!parsed) {
     appendError("Error reading CJSON file.");
     return false;
   }
 
+  json& jsonRoot = reader.root();
+
   if (!jsonRoot.is_object()) {
     appendError("Error: Input is not a JSON object.");
     return false;
@@ -137,12 +720,13 @@ bool CjsonFormat::deserialize(std::istream& file, Molecule& molecule,
     return false;
   }
 
-  json atomicNumbers = atoms["elements"]["number"];
+  const NumericArray* atomicNumbers =
+    reader.numericArray("atoms/elements/number");
   // This represents our minimal spec for a molecule - atoms that have an
   // atomic number.
-  if (isNumericArray(atomicNumbers) && atomicNumbers.size() > 0) {
-    for (auto& atomicNumber : atomicNumbers)
-      molecule.addAtom(atomicNumber);
+  if (atomicNumbers) {
+    for (size_t i = 0; i < atomicNumbers->size(); ++i)
+      molecule.addAtom(static_cast<unsigned char>(atomicNumbers->integer(i)));
   } else {
     // we're done, actually - this is an empty file
     return true;
@@ -150,14 +734,9 @@ bool CjsonFormat::deserialize(std::istream& file, Molecule& molecule,
   Index atomCount = molecule.atomCount();
 
   // 3d coordinates if available for our atoms
-  json atomicCoords = atoms["coords"]["3d"];
-  if (isNumericArray(atomicCoords) && atomicCoords.size() == 3 * atomCount) {
-    for (Index i = 0; i < atomCount; ++i) {
-      auto a = molecule.atom(i);
-      a.setPosition3d(Vector3(atomicCoords[3 * i], atomicCoords[3 * i + 1],
-                              atomicCoords[3 * i + 2]));
-    }
-  }
+  const NumericArray* atomicCoords = reader.numericArray("atoms/coords/3d");
+  if (atomicCoords && atomicCoords->size() == 3 * atomCount)
+    molecule.setAtomPositions3d(atomicCoords->vectors());
 
   // todo? 2d position
   // labels
@@ -169,76 +748,79 @@ bool CjsonFormat::deserialize(std::istream& file, Molecule& molecule,
   }
 
   // formal charges
-  json formalCharges = atoms["formalCharges"];
-  if (formalCharges.is_array() && formalCharges.size() == atomCount) {
-    for (size_t i = 0; i < atomCount; ++i) {
-      molecule.atom(i).setFormalCharge(formalCharges[i]);
-    }
+  const NumericArray* formalCharges =
+    reader.numericArray("atoms/formalCharges");
+  if (formalCharges && formalCharges->size() == atomCount) {
+    Array<signed char> charges(atomCount);
+    for (size_t i = 0; i < atomCount; ++i)
+      charges[i] = static_cast<signed char>(formalCharges->integer(i));
+    molecule.setFormalCharges(charges);
   }
 
   // Check for coordinate sets, and read them in if found, e.g. trajectories.
   json coordSets = atoms["coords"]["3dSets"];
   if (coordSets.is_array() && coordSets.size()) {
     for (unsigned int i = 0; i < coordSets.size(); ++i) {
-      Array<Vector3> setArray;
-      json set = coordSets[i];
-      if (isNumericArray(set)) {
-        for (unsigned int j = 0; j < set.size() / 3; ++j) {
-          setArray.push_back(
-            Vector3(set[3 * j], set[3 * j + 1], set[3 * j + 2]));
-        }
-        molecule.setCoordinate3d(setArray, i);
-      }
+      const NumericArray* set =
+        reader.numericArray("atoms/coords/3dSets/" + std::to_string(i));
+      if (set)
+        molecule.setCoordinate3d(set->vectors(), i);
     }
     // Make sure the first step is active once we are done loading the sets.
     molecule.setCoordinate3d(0);
   }
 
   // Read in colors if they are present.
-  json colors = atoms["colors"];
-  if (colors.is_array() && colors.size() == 3 * atomCount) {
+  const NumericArray* colors = reader.numericArray("atoms/colors");
+  if (colors && colors->size() == 3 * atomCount) {
+    Array<Vector3ub> atomColors(atomCount);
     for (Index i = 0; i < atomCount; ++i) {
-      Vector3ub color(colors[3 * i], colors[3 * i + 1], colors[3 * i + 2]);
-      molecule.setColor(i, color);
+      for (int j = 0; j < 3; ++j)
+        atomColors[i][j] = static_cast<unsigned char>(colors->integer(3 * i + j));
     }
+    molecule.setColors(atomColors);
   }
 
   // Selection is optional, but if present should be loaded.
-  json selection = atoms["selected"];
-  if (isBooleanArray(selection) && selection.size() == atomCount)
+  const NumericArray* selection = reader.array("atoms/selected");
+  if (selection && (selection->isBoolean() || selection->isNumeric()) &&
+      selection->size() == atomCount)
     for (Index i = 0; i < atomCount; ++i)
-      molecule.setAtomSelected(i, selection[i]);
-  else if (isNumericArray(selection) && selection.size() == atomCount)
-    for (Index i = 0; i < atomCount; ++i)
-      molecule.setAtomSelected(i, selection[i] != 0);
-  if (atoms.find("layer") != atoms.end()) {
-    json layerJson = atoms["layer"];
-    if (isNumericArray(layerJson)) {
-      auto& layer = LayerManager::getMoleculeInfo(&molecule)->layer;
-      for (Index i = 0; i < atomCount; ++i) {
-        while (layerJson[i] > layer.maxLayer()) {
-          layer.addLayer();
-        }
-        layer.addAtom(layerJson[i], i);
+      molecule.setAtomSelected(i, selection->values[i] != 0);
+  const NumericArray* layerArray = reader.numericArray("atoms/layer");
+  if (layerArray) {
+    auto& layer = LayerManager::getMoleculeInfo(&molecule)->layer;
+    for (Index i = 0; i < atomCount && i < layerArray->size(); ++i) {
+      const auto atomLayer = static_cast<size_t>(layerArray->integer(i));
+      while (atomLayer > layer.maxLayer()) {
+        layer.addLayer();
       }
+      layer.addAtom(atomLayer, i);
     }
   }
 
   // Bonds are optional, but if present should be loaded.
   json bonds = jsonRoot["bonds"];
-  if (bonds.is_object() && isNumericArray(bonds["connections"]["index"])) {
-    json connections = bonds["connections"]["index"];
-    for (unsigned int i = 0; i < connections.size() / 2; ++i) {
-      molecule.addBond(static_cast<Index>(connections[2 * i]),
-                       static_cast<Index>(connections[2 * i + 1]), 1);
-    }
-    json order = bonds["order"];
-    if (isNumericArray(order)) {
-      for (unsigned int i = 0; i < molecule.bondCount() && i < order.size();
-           ++i) {
-        molecule.bond(i).setOrder(static_cast<int>(order[i]));
-      }
+  const NumericArray* connections =
+    reader.numericArray("bonds/connections/index");
+  if (bonds.is_object() && connections) {
+    // add the bonds in one batch, skipping any to missing atoms
+    const NumericArray* order = reader.numericArray("bonds/order");
+    Array<std::pair<Index, Index>> bondPairs;
+    Array<unsigned char> bondOrders;
+    bondPairs.reserve(connections->size() / 2);
+    bondOrders.reserve(connections->size() / 2);
+    for (size_t i = 0; i < connections->size() / 2; ++i) {
+      const auto first = static_cast<Index>(connections->integer(2 * i));
+      const auto second = static_cast<Index>(connections->integer(2 * i + 1));
+      if (first >= atomCount || second >= atomCount)
+        continue;
+      bondPairs.push_back(std::make_pair(first, second));
+      bondOrders.push_back(order && i < order->size()
+                             ? static_cast<unsigned char>(order->integer(i))
+                             : 1);
     }
+    molecule.addBonds(bondPairs, bondOrders);
 
     // are there bond labels?
     json bondLabels = bonds["labels"];
@@ -330,19 +912,12 @@ bool CjsonFormat::deserialize(std::istream& file, Molecule& molecule,
     }
   }
 
-  json fractional = atoms["coords"]["3dFractional"];
-  if (!fractional.is_array())
-    fractional = atoms["coords"]["3d fractional"];
-  if (fractional.is_array() && fractional.size() == 3 * atomCount &&
-      isNumericArray(fractional) && molecule.unitCell()) {
-    Array<Vector3> fcoords;
-    fcoords.reserve(atomCount);
-    for (Index i = 0; i < atomCount; ++i) {
-      fcoords.push_back(Vector3(static_cast<Real>(fractional[i * 3 + 0]),
-                                static_cast<Real>(fractional[i * 3 + 1]),
-                                static_cast<Real>(fractional[i * 3 + 2])));
-    }
-    CrystalTools::setFractionalCoordinates(molecule, fcoords);
+  const NumericArray* fractional = reader.array("atoms/coords/3dFractional");
+  if (!fractional)
+    fractional = reader.array("atoms/coords/3d fractional");
+  if (fractional && fractional->size() == 3 * atomCount &&
+      fractional->isNumeric() && molecule.unitCell()) {
+    CrystalTools::setFractionalCoordinates(molecule, fractional->vectors());
   }
 
   // Basis set is optional, if present read it in.
@@ -411,25 +986,15 @@ bool CjsonFormat::deserialize(std::istream& file, Molecule& molecule,
           numArray.push_back(static_cast<unsigned int>(number));
         basis->setMolecularOrbitalNumber(numArray);
       }
-      json moCoefficients = orbitals["moCoefficients"];
-      json moCoefficientsA = orbitals["alphaCoefficients"];
-      json moCoefficientsB = orbitals["betaCoefficients"];
+      auto moCoefficients = reader.numericArray("orbitals/moCoefficients");
+      auto moCoefficientsA = reader.numericArray("orbitals/alphaCoefficients");
+      auto moCoefficientsB = reader.numericArray("orbitals/betaCoefficients");
       bool openShell = false;
-      if (isNumericArray(moCoefficients)) {
-        std::vector<double> coeffs;
-        for (auto& moCoefficient : moCoefficients)
-          coeffs.push_back(static_cast<double>(moCoefficient));
-        basis->setMolecularOrbitals(coeffs);
-      } else if (isNumericArray(moCoefficientsA) &&
-                 isNumericArray(moCoefficientsB)) {
-        std::vector<double> coeffsA;
-        for (auto& i : moCoefficientsA)
-          coeffsA.push_back(static_cast<double>(i));
-        std::vector<double> coeffsB;
-        for (auto& i : moCoefficientsB)
-          coeffsB.push_back(static_cast<double>(i));
-        basis->setMolecularOrbitals(coeffsA, BasisSet::Alpha);
-        basis->setMolecularOrbitals(coeffsB, BasisSet::Beta);
+      if (moCoefficients) {
+        basis->setMolecularOrbitals(moCoefficients->values);
+      } else if (moCoefficientsA && moCoefficientsB) {
+        basis->setMolecularOrbitals(moCoefficientsA->values, BasisSet::Alpha);
+        basis->setMolecularOrbitals(moCoefficientsB->values, BasisSet::Beta);
         openShell = true;
       } else {
         std::cout << "No orbital cofficients found!" << std::endl;
@@ -439,24 +1004,18 @@ bool CjsonFormat::deserialize(std::istream& file, Molecule& molecule,
       if (orbitals["sets"].is_array() && orbitals["sets"].size()) {
         json orbSets = orbitals["sets"];
         for (unsigned int idx = 0; idx < orbSets.size(); ++idx) {
-          moCoefficients = orbSets[idx]["moCoefficients"];
-          moCoefficientsA = orbSets[idx]["alphaCoefficients"];
-          moCoefficientsB = orbSets[idx]["betaCoefficients"];
-          if (isNumericArray(moCoefficients)) {
-            std::vector<double> coeffs;
-            for (auto& moCoefficient : moCoefficients)
-              coeffs.push_back(static_cast<double>(moCoefficient));
-            basis->setMolecularOrbitals(coeffs, BasisSet::Paired, idx);
-          } else if (isNumericArray(moCoefficientsA) &&
-                     isNumericArray(moCoefficientsB)) {
-            std::vector<double> coeffsA;
-            for (auto& i : moCoefficientsA)
-              coeffsA.push_back(static_cast<double>(i));
-            std::vector<double> coeffsB;
-            for (auto& i : moCoefficientsB)
-              coeffsB.push_back(static_cast<double>(i));
-            basis->setMolecularOrbitals(coeffsA, BasisSet::Alpha, idx);
-            basis->setMolecularOrbitals(coeffsB, BasisSet::Beta, idx);
+          const string set = "orbitals/sets/" + std::to_string(idx) + '/';
+          moCoefficients = reader.numericArray(set + "moCoefficients");
+          moCoefficientsA = reader.numericArray(set + "alphaCoefficients");
+          moCoefficientsB = reader.numericArray(set + "betaCoefficients");
+          if (moCoefficients) {
+            basis->setMolecularOrbitals(moCoefficients->values,
+                                        BasisSet::Paired, idx);
+          } else if (moCoefficientsA && moCoefficientsB) {
+            basis->setMolecularOrbitals(moCoefficientsA->values,
+                                        BasisSet::Alpha, idx);
+            basis->setMolecularOrbitals(moCoefficientsB->values,
+                                        BasisSet::Beta, idx);
             openShell = true;
           }
         }
@@ -529,16 +1088,11 @@ bool CjsonFormat::deserialize(std::istream& file, Molecule& molecule,
     json displacements = vibrations["eigenVectors"];
     if (displacements.is_array()) {
       Array<Array<Vector3>> disps;
-      for (auto arr : displacements) {
-        if (isNumericArray(arr)) {
-          Array<Vector3> mode;
-          mode.resize(arr.size() / 3);
-          double* ptr = &mode[0][0];
-          for (auto& j : arr) {
-            *(ptr++) = static_cast<double>(j);
-          }
-          disps.push_back(mode);
-        }
+      for (size_t i = 0; i < displacements.size(); ++i) {
+        const NumericArray* mode =
+          reader.numericArray("vibrations/eigenVectors/" + std::to_string(i));
+        if (mode)
+          disps.push_back(mode->vectors());
       }
       molecule.setVibrationLx(disps);
     }
@@ -669,11 +1223,12 @@ bool CjsonFormat::deserialize(std::istream& file, Molecule& molecule,
   if (partialCharges.is_object()) {
     // keys are types, values are arrays of charges
     for (auto& kv : partialCharges.items()) {
-      MatrixX charges(atomCount, 1);
-      if (isNumericArray(kv.value()) && kv.value().size() == atomCount) {
-        for (size_t i = 0; i < kv.value().size(); ++i) {
-          charges(i, 0) = kv.value()[i];
-        }
+      const NumericArray* values =
+        reader.numericArray("atoms/partialCharges/" + kv.key());
+      if (values && values->size() == atomCount) {
+        MatrixX charges(atomCount, 1);
+        for (size_t i = 0; i < atomCount; ++i)
+          charges(i, 0) = values->values[i];
         molecule.setPartialCharges(kv.key(), charges);
       }
     }
@@ -729,6 +1284,8 @@ bool CjsonFormat::serialize(std::ostream& file, const Molecule& molecule,
     opts = json::object();
 
   json root;
+  // The arrays which can be large are written straight from the molecule.
+  CjsonWriter writer(file, isJson);
 
   root["chemicalJson"] = 1;
 
@@ -894,21 +1451,22 @@ bool CjsonFormat::serialize(std::ostream& file, const Molecule& molecule,
     // on when we have just one (paired), or two (alpha and beta) to write.
     auto moMatrix = gaussian->moMatrix();
     auto betaMatrix = gaussian->moMatrix(BasisSet::Beta);
-    json moCoefficients;
-    for (int j = 0; j < moMatrix.cols(); ++j)
-      for (int i = 0; i < moMatrix.rows(); ++i)
-        moCoefficients.push_back(moMatrix(i, j));
+    auto coefficients = [](const MatrixX& matrix) {
+      return [matrix](CjsonWriter& out) {
+        for (int j = 0; j < matrix.cols(); ++j)
+          for (int i = 0; i < matrix.rows(); ++i)
+            out.number(matrix(i, j));
+      };
+    };
 
     if (betaMatrix.cols() > 0 && betaMatrix.rows() > 0) {
-      json moBeta;
-      for (int j = 0; j < moMatrix.cols(); ++j)
-        for (int i = 0; i < moMatrix.rows(); ++i)
-          moBeta.push_back(moMatrix(i, j));
-
-      root["orbitals"]["alphaCoefficients"] = moCoefficients;
-      root["orbitals"]["betaCoefficients"] = moBeta;
+      writer.stream(root["orbitals"]["alphaCoefficients"], moMatrix.size(),
+                    coefficients(moMatrix));
+      writer.stream(root["orbitals"]["betaCoefficients"], betaMatrix.size(),
+                    coefficients(betaMatrix));
     } else {
-      root["orbitals"]["moCoefficients"] = moCoefficients;
+      writer.stream(root["orbitals"]["moCoefficients"], moMatrix.size(),
+                    coefficients(moMatrix));
     }
 
     // Some energy, occupation, and number data potentially.
@@ -960,10 +1518,6 @@ bool CjsonFormat::serialize(std::ostream& file, const Molecule& molecule,
   // Write out any cubes that are present in the molecule.
   if (molecule.cubeCount() > 0) {
     const Cube* cube = molecule.cube(0);
-    json cubeData;
-    for (float it : *cube->data()) {
-      cubeData.push_back(it);
-    }
     // Get the origin, max, spacing, and dimensions to place in the object.
     json cubeObj;
     json cubeMin;
@@ -981,131 +1535,139 @@ bool CjsonFormat::serialize(std::ostream& file, const Molecule& molecule,
     cubeDims.push_back(cube->dimensions().y());
     cubeDims.push_back(cube->dimensions().z());
     cubeObj["dimensions"] = cubeDims;
-    cubeObj["scalars"] = cubeData;
     root["cube"] = cubeObj;
+    writer.stream(root["cube"]["scalars"], cube->data()->size(),
+                  [cube](CjsonWriter& out) {
+                    for (float value : *cube->data())
+                      out.number(value);
+                  });
   }
 
   // Create and populate the atom arrays.
-  if (molecule.atomCount()) {
-    json elements;
-    json selected;
-    json colors;
-
-    Vector3ub color;
-    bool hasCustomColors = molecule.colors().size() == molecule.atomCount();
-    for (Index i = 0; i < molecule.atomCount(); ++i) {
-      elements.push_back(molecule.atom(i).atomicNumber());
-      selected.push_back(molecule.atomSelected(i));
-
-      color = molecule.color(i);
-      colors.push_back(color.x());
-      colors.push_back(color.y());
-      colors.push_back(color.z());
-    }
-    root["atoms"]["elements"]["number"] = elements;
-    if (!molecule.isSelectionEmpty())
-      root["atoms"]["selected"] = selected;
-    if (hasCustomColors)
-      root["atoms"]["colors"] = colors;
+  const Index atomCount = molecule.atomCount();
+  if (atomCount) {
+    json& atoms = root["atoms"];
+    writer.stream(atoms["elements"]["number"], atomCount,
+                  [&molecule](CjsonWriter& out) {
+                    for (unsigned char number : molecule.atomicNumbers())
+                      out.integer(number);
+                  });
+    if (!molecule.isSelectionEmpty()) {
+      writer.stream(atoms["selected"], atomCount,
+                    [&molecule, atomCount](CjsonWriter& out) {
+                      for (Index i = 0; i < atomCount; ++i)
+                        out.boolean(molecule.atomSelected(i));
+                    });
+    }
+    if (molecule.colors().size() == atomCount) {
+      writer.stream(atoms["colors"], 3 * atomCount,
+                    [&molecule](CjsonWriter& out) {
+                      for (const auto& color : molecule.colors())
+                        for (int j = 0; j < 3; ++j)
+                          out.integer(color[j]);
+                    });
+    }
 
     // check for partial charges
     auto partialCharges = molecule.partialChargeTypes();
     if (!partialCharges.empty()) {
       // add them to the atoms object
       for (const auto& type : partialCharges) {
-        MatrixX chargesMatrix = molecule.partialCharges(type);
-        json charges;
-        for (Index i = 0; i < molecule.atomCount(); ++i) {
-          charges.push_back(chargesMatrix(i, 0));
-        }
-        root["atoms"]["partialCharges"][type] = charges;
+        writer.stream(atoms["partialCharges"][type], atomCount,
+                      [charges = molecule.partialCharges(type),
+                       atomCount](CjsonWriter& out) {
+                        for (Index i = 0; i < atomCount; ++i)
+                          out.number(charges(i, 0));
+                      });
       }
     }
 
     // 3d positions:
-    if (molecule.atomPositions3d().size() == molecule.atomCount()) {
+    if (molecule.atomPositions3d().size() == atomCount) {
       // everything gets real-space Cartesians
-      json coords3d;
-      for (const auto& it : molecule.atomPositions3d()) {
-        coords3d.push_back(it.x());
-        coords3d.push_back(it.y());
-        coords3d.push_back(it.z());
-      }
-      root["atoms"]["coords"]["3d"] = coords3d;
+      auto coordinates = [](const Array<Vector3>& positions) {
+        return [positions](CjsonWriter& out) {
+          for (const auto& it : positions) {
+            out.number(it.x());
+            out.number(it.y());
+            out.number(it.z());
+          }
+        };
+      };
+      writer.stream(atoms["coords"]["3d"], 3 * atomCount,
+                    coordinates(molecule.atomPositions3d()));
 
       // if the unit cell exists, also write fractional coords
       if (molecule.unitCell()) {
-        json coordsFractional;
         Array<Vector3> fcoords;
         CrystalTools::fractionalCoordinates(
           *molecule.unitCell(), molecule.atomPositions3d(), fcoords);
-        for (auto& fcoord : fcoords) {
-          coordsFractional.push_back(fcoord.x());
-          coordsFractional.push_back(fcoord.y());
-          coordsFractional.push_back(fcoord.z());
-        }
-        root["atoms"]["coords"]["3dFractional"] = coordsFractional;
+        writer.stream(atoms["coords"]["3dFractional"], 3 * fcoords.size(),
+                      coordinates(fcoords));
       }
     }
 
     // 2d positions:
-    if (molecule.atomPositions2d().size() == molecule.atomCount()) {
-      json coords2d;
-      for (const auto& it : molecule.atomPositions2d()) {
-        coords2d.push_back(it.x());
-        coords2d.push_back(it.y());
-      }
-      root["atoms"]["coords"]["2d"] = coords2d;
+    if (molecule.atomPositions2d().size() == atomCount) {
+      writer.stream(atoms["coords"]["2d"], 2 * atomCount,
+                    [&molecule](CjsonWriter& out) {
+                      for (const auto& it : molecule.atomPositions2d()) {
+                        out.number(it.x());
+                        out.number(it.y());
+                      }
+                    });
     }
   }
 
   // check for atom labels
-  Array atomLabels = molecule.atomLabels();
-  if (atomLabels.size() == molecule.atomCount()) {
-    json labels;
-    for (Index i = 0; i < molecule.atomCount(); ++i) {
-      labels.push_back(atomLabels[i]);
-    }
-    root["atoms"]["labels"] = labels;
+  if (molecule.atomLabels().size() == atomCount) {
+    writer.stream(root["atoms"]["labels"], atomCount,
+                  [labels = molecule.atomLabels()](CjsonWriter& out) {
+                    for (const auto& label : labels)
+                      out.string(label);
+                  });
   }
 
   // formal charges
-  json formalCharges;
-  for (size_t i = 0; i < molecule.atomCount(); ++i) {
-    formalCharges.push_back(molecule.formalCharge(i));
-  }
-  root["atoms"]["formalCharges"] = formalCharges;
+  writer.stream(root["atoms"]["formalCharges"], atomCount,
+                [&molecule, atomCount](CjsonWriter& out) {
+                  for (Index i = 0; i < atomCount; ++i)
+                    out.integer(molecule.formalCharge(i));
+                });
 
   auto layer = LayerManager::getMoleculeInfo(&molecule)->layer;
   if (layer.atomCount()) {
-    json atomLayer;
-    for (Index i = 0; i < layer.atomCount(); ++i) {
-      atomLayer.push_back(layer.getLayerID(i));
-    }
-    root["atoms"]["layer"] = atomLayer;
+    writer.stream(root["atoms"]["layer"], layer.atomCount(),
+                  [&layer](CjsonWriter& out) {
+                    for (Index i = 0; i < layer.atomCount(); ++i)
+                      out.integer(static_cast<long long>(layer.getLayerID(i)));
+                  });
   }
 
   // Create and populate the bond arrays.
-  if (molecule.bondCount()) {
-    json connections;
-    json order;
-    for (Index i = 0; i < molecule.bondCount(); ++i) {
-      Bond bond = molecule.bond(i);
-      connections.push_back(bond.atom1().index());
-      connections.push_back(bond.atom2().index());
-      order.push_back(bond.order());
-    }
-    root["bonds"]["connections"]["index"] = connections;
-    root["bonds"]["order"] = order;
+  const Index bondCount = molecule.bondCount();
+  if (bondCount) {
+    writer.stream(root["bonds"]["connections"]["index"], 2 * bondCount,
+                  [&molecule, bondCount](CjsonWriter& out) {
+                    for (Index i = 0; i < bondCount; ++i) {
+                      const auto pair = molecule.bondPair(i);
+                      out.integer(static_cast<long long>(pair.first));
+                      out.integer(static_cast<long long>(pair.second));
+                    }
+                  });
+    writer.stream(root["bonds"]["order"], bondCount,
+                  [&molecule](CjsonWriter& out) {
+                    for (unsigned char order : molecule.bondOrders())
+                      out.integer(order);
+                  });
 
     // check if there are bond labels
-    Array bondLabels = molecule.bondLabels();
-    if (bondLabels.size() == molecule.bondCount()) {
-      json labels;
-      for (Index i = 0; i < molecule.bondCount(); ++i) {
-        labels.push_back(bondLabels[i]);
-      }
-      root["bonds"]["labels"] = labels;
+    if (molecule.bondLabels().size() == bondCount) {
+      writer.stream(root["bonds"]["labels"], bondCount,
+                    [labels = molecule.bondLabels()](CjsonWriter& out) {
+                      for (const auto& label : labels)
+                        out.string(label);
+                    });
     }
   }
 
@@ -1147,21 +1709,14 @@ bool CjsonFormat::serialize(std::ostream& file, const Molecule& molecule,
     json freqs;
     json inten;
     json raman;
-    json eigenVectors;
+    json eigenVectors = json::array();
     for (size_t i = 0; i < molecule.vibrationFrequencies().size(); ++i) {
       modes.push_back(static_cast<unsigned int>(i) + 1);
       freqs.push_back(molecule.vibrationFrequencies()[i]);
       inten.push_back(molecule.vibrationIRIntensities()[i]);
       if (molecule.vibrationRamanIntensities().size() > i)
         raman.push_back(molecule.vibrationRamanIntensities()[i]);
-      Core::Array<Vector3> atomDisplacements = molecule.vibrationLx(i);
-      json eigenVector;
-      for (auto pos : atomDisplacements) {
-        eigenVector.push_back(pos[0]);
-        eigenVector.push_back(pos[1]);
-        eigenVector.push_back(pos[2]);
-      }
-      eigenVectors.push_back(eigenVector);
+      eigenVectors.push_back(nullptr);
     }
     root["vibrations"]["modes"] = modes;
     root["vibrations"]["frequencies"] = freqs;
@@ -1169,6 +1724,19 @@ bool CjsonFormat::serialize(std::ostream& file, const Molecule& molecule,
     if (molecule.vibrationRamanIntensities().size() > 0)
       root["vibrations"]["ramanIntensities"] = raman;
     root["vibrations"]["eigenVectors"] = eigenVectors;
+    // the displacements are only copied from the molecule one mode at a time
+    for (size_t i = 0; i < eigenVectors.size(); ++i) {
+      const auto mode = static_cast<int>(i);
+      writer.stream(root["vibrations"]["eigenVectors"][i],
+                    3 * molecule.vibrationLx(mode).size(),
+                    [&molecule, mode](CjsonWriter& out) {
+                      for (const auto& pos : molecule.vibrationLx(mode)) {
+                        out.number(pos[0]);
+                        out.number(pos[1]);
+                        out.number(pos[2]);
+                      }
+                    });
+    }
   }
 
   auto names = LayerManager::getMoleculeInfo(&molecule);
@@ -1198,11 +1766,7 @@ bool CjsonFormat::serialize(std::ostream& file, const Molecule& molecule,
     root["layer"]["settings"][settings.first] = setting;
   }
 
-  if (isJson)
-    file << std::setw(2) << root;
-  else { // write msgpack
-    json::to_msgpack(root, file);
-  }
+  writer.write(root);
 
   return true;
 }
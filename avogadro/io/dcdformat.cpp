@@ -4,7 +4,6 @@
 ******************************************************************************/
 
 #include "dcdformat.h"
-#include "struct.h"
 
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
@@ -13,6 +12,8 @@
 #include <avogadro/core/vector.h>
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <istream>
 #include <ostream>
@@ -31,203 +32,179 @@ using Core::Atom;
 using Core::Molecule;
 using Core::UnitCell;
 
-#ifndef _WIN32
-#endif
-
-#define DCD_EOF (-1)
 constexpr int DCD_MAGIC = 84;
 constexpr int DCD_IS_CHARMM = 0x01;
 constexpr int DCD_HAS_4DIMS = 0x02;
 constexpr int DCD_HAS_EXTRA_BLOCK = 0x04;
 
-int swap_integer(int inp)
+namespace {
+// Value stored at @p bytes, in the byte order of the file.
+template <typename T>
+T unpack(const char* bytes, bool swap)
+{
+  char tmp[sizeof(T)];
+  for (size_t i = 0; i < sizeof(T); ++i)
+    tmp[i] = swap ? bytes[sizeof(T) - 1 - i] : bytes[i];
+  T value;
+  memcpy(&value, tmp, sizeof(T));
+  return value;
+}
+
+// Reads a Fortran record, which is framed by its length before and after.
+bool readRecord(std::istream& in, bool swap, vector<char>& data)
+{
+  char marker[sizeof(int)];
+  if (!in.read(marker, sizeof(int)))
+    return false;
+  const int size = unpack<int>(marker, swap);
+  if (size < 0)
+    return false;
+  data.resize(size);
+  if (!in.read(data.data(), size) || !in.read(marker, sizeof(int)))
+    return false;
+  return unpack<int>(marker, swap) == size;
+}
+
+// Finds the data of a Fortran record in memory and moves @p data past it.
+const char* mappedRecord(const char*& data, const char* end, bool swap,
+                         size_t& size)
+{
+  if (end - data < static_cast<std::ptrdiff_t>(2 * sizeof(int)))
+    return nullptr;
+  const int length = unpack<int>(data, swap);
+  if (length < 0 ||
+      end - data < static_cast<std::ptrdiff_t>(length + 2 * sizeof(int)) ||
+      unpack<int>(data + sizeof(int) + length, swap) != length)
+    return nullptr;
+  const char* record = data + sizeof(int);
+  data = record + length + sizeof(int);
+  size = static_cast<size_t>(length);
+  return record;
+}
+
+template <bool Swap>
+inline float loadFloat(const char* bytes)
+{
+  uint32_t word;
+  memcpy(&word, bytes, sizeof(word));
+  if (Swap) {
+    word = (word >> 24) | ((word >> 8) & 0x0000ff00u) |
+           ((word << 8) & 0x00ff0000u) | (word << 24);
+  }
+  float value;
+  memcpy(&value, &word, sizeof(value));
+  return value;
+}
+
+// Interleaves the x, y and z blocks of a frame into positions. The loops
+// are branch free, so that the compiler can vectorize the conversion.
+template <bool Swap>
+void interleave(const char* x, const char* y, const char* z, Index count,
+                Vector3* positions)
 {
-  return (((inp << 24) & 0xff000000) | ((inp << 8) & 0x00ff0000) |
-          ((inp >> 8) & 0x0000ff00) | ((inp >> 24) & 0x000000ff));
+  for (Index i = 0; i < count; ++i) {
+    const Index offset = i * sizeof(float);
+    positions[i] = Vector3(loadFloat<Swap>(x + offset),
+                           loadFloat<Swap>(y + offset),
+                           loadFloat<Swap>(z + offset));
+  }
 }
 
-char swap_endian(char endian)
+void interleave(const char* x, const char* y, const char* z, Index count,
+                bool swap, Vector3* positions)
 {
-  if (endian == '>')
-    return '<';
+  if (swap)
+    interleave<true>(x, y, z, count, positions);
   else
-    return '>';
+    interleave<false>(x, y, z, count, positions);
 }
+} // namespace
 
-DcdFormat::DcdFormat() {}
+DcdFormat::DcdFormat()
+  : m_swap(false), m_charmm(0), m_atomCount(0), m_delta(0.0)
+{
+}
 
 DcdFormat::~DcdFormat() {}
 
-bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
+bool DcdFormat::readHeader(std::istream& in)
 {
-  /** Endian type, Buffer and Format char containers for unpacking and storing
-   * data using struct library */
-  char endian = '>';
-  char buff[BUFSIZ];
-  char fmt[BUFSIZ];
-
-  /** Variables to store various components from the binary data unpacked using
-   * the struct library */
-  char raw[84];
-  char* remarks;
-  double DELTA;
-  int magic;
-  int charmm;
-  int NAMNF;
-  int NTITLE;
-  int lenRemarks;
-  int NATOMS;
-  int blockSize;
-
-  // Determining size of file
-  inStream.seekg(0, inStream.end);
-  int fileLen = inStream.tellg();
-  inStream.seekg(0, inStream.beg);
-
-  // Reading magic number
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &magic);
-  if (magic != DCD_MAGIC) {
-    magic = swap_integer(magic);
-    endian = swap_endian(endian);
-    if (magic != DCD_MAGIC) {
+  vector<char> raw;
+  char magic[sizeof(int)];
+  if (!in.read(magic, sizeof(int))) {
+    appendError("File does not start with magic number 84.");
+    return false;
+  }
+  // the first record length tells us the byte order of the file
+  m_swap = false;
+  if (unpack<int>(magic, false) != DCD_MAGIC) {
+    m_swap = true;
+    if (unpack<int>(magic, true) != DCD_MAGIC) {
       appendError("File does not start with magic number 84.");
       return false;
     }
   }
-
-  // CORD
-  snprintf(fmt, sizeof(fmt), "%c%ds", endian, magic);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, raw);
-  if (raw[0] != 'C' || raw[1] != 'O' || raw[2] != 'R' || raw[3] != 'D') {
+  in.seekg(-static_cast<std::streamoff>(sizeof(int)), std::ios_base::cur);
+  if (!readRecord(in, m_swap, raw) || raw[0] != 'C' || raw[1] != 'O' ||
+      raw[2] != 'R' || raw[3] != 'D') {
     appendError("Keyword CORD not found.");
     return false;
   }
 
   // Determining whether the trajectory file is from CHARMM or not
-  if (*(reinterpret_cast<int*>(raw + 80)) != 0) {
-    charmm = DCD_IS_CHARMM;
-    if (*(reinterpret_cast<int*>(raw + 44)) != 0)
-      charmm |= DCD_HAS_EXTRA_BLOCK;
-
-    if (*(reinterpret_cast<int*>(raw + 48)) == 1)
-      charmm |= DCD_HAS_4DIMS;
-  } else {
-    charmm = 0;
+  m_charmm = 0;
+  if (unpack<int>(&raw[80], m_swap) != 0) {
+    m_charmm = DCD_IS_CHARMM;
+    if (unpack<int>(&raw[44], m_swap) != 0)
+      m_charmm |= DCD_HAS_EXTRA_BLOCK;
+    if (unpack<int>(&raw[48], m_swap) == 1)
+      m_charmm |= DCD_HAS_4DIMS;
   }
 
   // number of fixed atoms
-  NAMNF = *(reinterpret_cast<int*>(raw + 36));
+  const int NAMNF = unpack<int>(&raw[36], m_swap);
 
   // DELTA (timestep) is stored as a double with X-PLOR but as a float with
   // CHARMM
-  if (charmm & DCD_IS_CHARMM) {
-    float ftmp;
-    ftmp = *(reinterpret_cast<float*>(raw + 40));
-
-    DELTA = static_cast<double>(ftmp);
-  } else {
-    (DELTA) = *(reinterpret_cast<double*>(raw + 40));
-  }
+  if (m_charmm & DCD_IS_CHARMM)
+    m_delta = static_cast<double>(unpack<float>(&raw[40], m_swap));
+  else
+    m_delta = unpack<double>(&raw[40], m_swap);
 
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &magic);
-
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &blockSize);
-
-  if (((blockSize - 4) % 80) == 0) {
-    // Read NTITLE, the number of 80 character title strings
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &NTITLE);
-    lenRemarks = NTITLE * 80;
-    remarks = reinterpret_cast<char*>(malloc(lenRemarks));
-    snprintf(fmt, sizeof(fmt), "%c%ds", endian, lenRemarks);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, remarks);
-
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    int endSize;
-    struct_unpack(buff, fmt, &endSize);
-  } else {
+  // the title, as NTITLE strings of 80 characters
+  if (!readRecord(in, m_swap, raw) || raw.size() < 4 ||
+      (raw.size() - 4) % 80 != 0) {
     appendError("Block size must be 4 plus a multiple of 80.");
     return false;
   }
 
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  int fourInput;
-  struct_unpack(buff, fmt, &fourInput);
-  if (fourInput != 4) {
-    // Error
-  }
-
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &NATOMS);
-
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &fourInput);
-  if (fourInput != 4) {
-    appendError("Expected token 4. Read token " + to_string(fourInput));
+  if (!readRecord(in, m_swap, raw) || raw.size() != 4) {
+    appendError("Expected token 4. Read token " + to_string(raw.size()));
     return false;
   }
+  m_atomCount = unpack<int>(raw.data(), m_swap);
 
   if (NAMNF != 0) {
-    int** FREEINDEXES =
-      reinterpret_cast<int**>(calloc((NATOMS - NAMNF), sizeof(int)));
-    if (*FREEINDEXES == nullptr) {
-      appendError("MALLOC failed.");
-      return false;
-    }
-
-    /* Read in index array size */
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    int arrSize;
-    struct_unpack(buff, fmt, &arrSize);
-
-    if (arrSize != (NATOMS - NAMNF) * 4) {
-      appendError("DCD file contains bad format.");
-      return false;
-    }
-
-    snprintf(fmt, sizeof(fmt), "%c%di", endian, (NATOMS - NAMNF));
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, *FREEINDEXES);
-
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &arrSize);
-
-    if (arrSize != (NATOMS - NAMNF) * 4) {
-      appendError("DCD file contains bad format.");
-      return false;
-    }
+    // later frames only list the free atoms, which is not supported
+    appendError("DCD files with fixed atoms are not supported.");
+    return false;
   }
+  return true;
+}
 
+bool DcdFormat::readCoordinates(std::istream& in, Array<Vector3>& positions,
+                                UnitCell** cell)
+{
+  vector<char> block;
   // CHARMM trajectories have an extra block to be read, that contains
   // information about the unit cell
-  if ((charmm & DCD_IS_CHARMM) && (charmm & DCD_HAS_EXTRA_BLOCK)) {
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    int leadingNum;
-    struct_unpack(buff, fmt, &leadingNum);
-
-    if (leadingNum == 48) {
+  if ((m_charmm & DCD_IS_CHARMM) && (m_charmm & DCD_HAS_EXTRA_BLOCK)) {
+    if (!readRecord(in, m_swap, block))
+      return false;
+    if (cell != nullptr && block.size() == 48) {
       double unitcell[6];
-      for (double & aa : unitcell) {
-        snprintf(fmt, sizeof(fmt), "%c%dd", endian, 1);
-        inStream.read(buff, struct_calcsize(fmt));
-        struct_unpack(buff, fmt, &aa);
-      }
+      for (int i = 0; i < 6; ++i)
+        unitcell[i] = unpack<double>(&block[8 * i], m_swap);
       if (unitcell[1] >= -1.0 && unitcell[1] <= 1.0 && unitcell[3] >= -1.0 &&
           unitcell[3] <= 1.0 && unitcell[4] >= -1.0 && unitcell[4] <= 1.0) {
         // CHARMM and certain NAMD files have the cosines instead of angles
@@ -237,67 +214,48 @@ bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
         unitcell[3] = M_PI_2 - asin(unitcell[3]); /* cosAC */
         unitcell[1] = M_PI_2 - asin(unitcell[1]); /* cosAB */
       }
-
-      mol.setUnitCell(new UnitCell(unitcell[0], unitcell[2], unitcell[5],
-                                   unitcell[4], unitcell[3], unitcell[1]));
-    } else {
-      inStream.read(buff, leadingNum);
+      *cell = new UnitCell(unitcell[0], unitcell[2], unitcell[5], unitcell[4],
+                           unitcell[3], unitcell[1]);
     }
-    inStream.read(buff, sizeof(int));
   }
 
-  // Reading the atom coordinates
-  int formatint[6];
-  Array<float> cx, cy, cz;
-  cx.reserve(NATOMS);
-  cy.reserve(NATOMS);
-  cz.reserve(NATOMS);
-
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &formatint[0]);
-
-  for (int i = 0; i < NATOMS; ++i) {
-    // X coordinates
-    snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &cx[i]);
-    /* code */
+  // Reading the atom coordinates, one block for each of x, y and z
+  vector<char> blocks[3];
+  for (auto& xyz : blocks) {
+    if (!readRecord(in, m_swap, xyz) ||
+        xyz.size() != m_atomCount * sizeof(float))
+      return false;
   }
+  positions.resize(m_atomCount);
+  interleave(blocks[0].data(), blocks[1].data(), blocks[2].data(),
+             m_atomCount, m_swap, positions.data());
 
-  snprintf(fmt, sizeof(fmt), "%c2i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &formatint[1], &formatint[2]);
-
-  for (int i = 0; i < NATOMS; ++i) {
-    // Y coordinates
-    snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &cy[i]);
-  }
+  // Skipping fourth dimension block
+  if ((m_charmm & DCD_IS_CHARMM) && (m_charmm & DCD_HAS_4DIMS))
+    return readRecord(in, m_swap, block);
+  return true;
+}
 
-  snprintf(fmt, sizeof(fmt), "%c2i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &formatint[3], &formatint[4]);
+bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
+{
+  if (!readHeader(inStream))
+    return false;
 
-  for (int i = 0; i < NATOMS; ++i) {
-    // Z coordinates
-    snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &cz[i]);
+  Array<Vector3> positions;
+  UnitCell* cell = nullptr;
+  if (!readCoordinates(inStream, positions, &cell)) {
+    delete cell;
+    appendError("Error reading the first frame.");
+    return false;
   }
-
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &formatint[5]);
+  if (cell != nullptr)
+    mol.setUnitCell(cell);
 
   typedef map<string, unsigned char> AtomTypeMap;
   AtomTypeMap atomTypes;
   unsigned char customElementCounter = CustomElementMin;
 
-  for (int i = 0; i < NATOMS; ++i) {
-    Vector3 pos(cx[i], cy[i], cz[i]);
-
+  for (int i = 0; i < m_atomCount; ++i) {
     AtomTypeMap::const_iterator it;
     atomTypes.insert(std::make_pair(to_string(i), customElementCounter++));
     it = atomTypes.find(to_string(i));
@@ -306,23 +264,11 @@ bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
     //   return false;
     // }
     Atom newAtom = mol.addAtom(it->second);
-    newAtom.setPosition3d(pos);
+    newAtom.setPosition3d(positions[i]);
   }
 
   mol.setTimeStep(0, 0);
 
-  // Skipping fourth dimension block
-  if ((charmm & DCD_IS_CHARMM) && (charmm & DCD_HAS_EXTRA_BLOCK)) {
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    int sizeToRead;
-    struct_unpack(buff, fmt, &sizeToRead);
-
-    inStream.read(buff, sizeToRead);
-
-    inStream.read(buff, sizeof(int));
-  }
-
   // Set the custom element map if needed
   if (!atomTypes.empty()) {
     Molecule::CustomElementMap elementMap;
@@ -334,73 +280,71 @@ bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
 
   mol.setCoordinate3d(mol.atomPositions3d(), 0);
 
-  // Do we have an animation?
-  int coordSet = 1;
-  while ((static_cast<int>(inStream.tellg()) != fileLen) &&
-         (static_cast<int>(inStream.tellg()) != DCD_EOF)) {
-    // Reading the atom coordinates
-    Array<Vector3> positions;
-    positions.reserve(NATOMS);
-
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &formatint[0]);
-
-    for (int i = 0; i < NATOMS; ++i) {
-      // X coordinates
-      snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-      inStream.read(buff, struct_calcsize(fmt));
-      struct_unpack(buff, fmt, &cx[i]);
-    }
-
-    snprintf(fmt, sizeof(fmt), "%c2i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &formatint[1], &formatint[2]);
-
-    for (int i = 0; i < NATOMS; ++i) {
-      // Y coordinates
-      snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-      inStream.read(buff, struct_calcsize(fmt));
-      struct_unpack(buff, fmt, &cy[i]);
-    }
+  // All frames have the size of the first, so a file is indexed without
+  // reading it and frames are read when they are shown.
+  if (attachFrames(inStream, mol))
+    return true;
 
-    snprintf(fmt, sizeof(fmt), "%c2i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &formatint[3], &formatint[4]);
-
-    for (int i = 0; i < NATOMS; ++i) {
-      // Z coordinates
-      snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-      inStream.read(buff, struct_calcsize(fmt));
-      struct_unpack(buff, fmt, &cz[i]);
-    }
-
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &formatint[5]);
+  int coordSet = 1;
+  while (inStream.peek() != std::char_traits<char>::eof() &&
+         readCoordinates(inStream, positions, nullptr)) {
+    mol.setTimeStep(m_delta * coordSet, coordSet);
+    mol.setCoordinate3d(positions, coordSet++);
+  }
 
-    for (int i = 0; i < NATOMS; ++i) {
-      Vector3 pos(cx[i], cy[i], cz[i]);
-      positions.push_back(pos);
-    }
+  return true;
+}
 
-    mol.setTimeStep(DELTA * coordSet, coordSet);
+bool DcdFormat::indexFrames(std::istream& in,
+                            std::vector<std::streamoff>& offsets,
+                            std::vector<double>& times,
+                            std::vector<Matrix3>&)
+{
+  if (!readHeader(in))
+    return false;
 
-    // Skipping fourth dimension block
-    if ((charmm & DCD_IS_CHARMM) && (charmm & DCD_HAS_EXTRA_BLOCK)) {
-      snprintf(fmt, sizeof(fmt), "%c1i", endian);
-      inStream.read(buff, struct_calcsize(fmt));
-      int sizeToRead;
-      struct_unpack(buff, fmt, &sizeToRead);
+  // every frame has the same size, so measure the first one
+  const std::streamoff first = in.tellg();
+  Array<Vector3> positions;
+  if (!readCoordinates(in, positions, nullptr))
+    return false;
+  const std::streamoff frameSize = in.tellg() - first;
+  in.seekg(0, std::ios_base::end);
+  const std::streamoff end = in.tellg();
+
+  for (std::streamoff offset = first; offset + frameSize <= end;
+       offset += frameSize) {
+    times.push_back(m_delta * offsets.size());
+    offsets.push_back(offset);
+  }
+  return true;
+}
 
-      inStream.read(buff, sizeToRead);
+bool DcdFormat::readFramePositions(std::istream& in,
+                                   Array<Vector3>& positions)
+{
+  return readCoordinates(in, positions, nullptr);
+}
 
-      inStream.read(buff, sizeof(int));
-    }
+bool DcdFormat::readMappedFrame(const char* begin, const char* end,
+                                Array<Vector3>& positions)
+{
+  // the frame is decoded where it lies in the mapping, without copying
+  const char* data = begin;
+  size_t size = 0;
+  if ((m_charmm & DCD_IS_CHARMM) && (m_charmm & DCD_HAS_EXTRA_BLOCK) &&
+      mappedRecord(data, end, m_swap, size) == nullptr)
+    return false;
 
-    mol.setCoordinate3d(positions, coordSet++);
+  const char* blocks[3];
+  for (auto& xyz : blocks) {
+    xyz = mappedRecord(data, end, m_swap, size);
+    if (xyz == nullptr || size != m_atomCount * sizeof(float))
+      return false;
   }
-
+  positions.resize(m_atomCount);
+  interleave(blocks[0], blocks[1], blocks[2], m_atomCount, m_swap,
+             positions.data());
   return true;
 }
 
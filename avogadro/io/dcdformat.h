@@ -9,6 +9,9 @@
 #include "fileformat.h"
 
 namespace Avogadro {
+namespace Core {
+class UnitCell;
+}
 namespace Io {
 
 /**
@@ -43,6 +46,32 @@ public:
 
   bool read(std::istream& inStream, Core::Molecule& molecule) override;
   bool write(std::ostream& outStream, const Core::Molecule& molecule) override;
+
+protected:
+  bool indexFrames(std::istream& in, std::vector<std::streamoff>& offsets,
+                   std::vector<double>& times,
+                   std::vector<Matrix3>& cells) override;
+  bool readFramePositions(std::istream& in,
+                          Core::Array<Vector3>& positions) override;
+  bool readMappedFrame(const char* begin, const char* end,
+                       Core::Array<Vector3>& positions) override;
+
+private:
+  /** Read the header, up to the start of the first frame. */
+  bool readHeader(std::istream& in);
+
+  /**
+   * Read the frame at the current position in @p in. If @p cell is not null
+   * and the frame has a unit cell, a new cell is returned in it.
+   */
+  bool readCoordinates(std::istream& in, Core::Array<Vector3>& positions,
+                       Core::UnitCell** cell);
+
+  // Layout of the file, from readHeader().
+  bool m_swap; // the file has the opposite byte order to this machine
+  int m_charmm;
+  int m_atomCount;
+  double m_delta; // time between frames
 };
 
 } // end Io namespace
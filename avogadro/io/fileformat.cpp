@@ -4,10 +4,16 @@
 ******************************************************************************/
 
 #include "fileformat.h"
+#include "mappedfile.h"
+#include "progressbuffer.h"
+
+#include <avogadro/core/framecache.h>
+#include <avogadro/core/molecule.h>
 
 #include <algorithm>
 #include <fstream>
 #include <locale>
+#include <memory>
 #include <sstream>
 
 namespace Avogadro::Io {
@@ -16,12 +22,36 @@ using std::ifstream;
 using std::locale;
 using std::ofstream;
 
-FileFormat::FileFormat() : m_mode(None), m_in(nullptr), m_out(nullptr) {}
+namespace {
+// Reads frames on demand from a trajectory opened by a format.
+class FileFrameSource : public Core::FrameSource
+{
+public:
+  explicit FileFrameSource(FileFormat* format) : m_format(format) {}
+
+  Index frameCount() const override { return m_format->frameCount(); }
+
+  bool readFrame(Index index, Core::Array<Vector3>& positions) override
+  {
+    return m_format->readFrame(index, positions);
+  }
+
+private:
+  std::unique_ptr<FileFormat> m_format;
+};
+} // namespace
+
+FileFormat::FileFormat()
+  : m_canceled(false), m_deferDerivedData(false), m_mode(None), m_in(nullptr),
+    m_out(nullptr), m_map(nullptr), m_tracked(nullptr)
+{
+}
 
 FileFormat::~FileFormat()
 {
   delete m_in;
   delete m_out;
+  delete m_map;
 }
 
 bool FileFormat::validateFileName(const std::string& fileName)
@@ -101,14 +131,21 @@ void FileFormat::close()
     delete m_out;
     m_out = nullptr;
   }
+  if (m_map) {
+    delete m_map;
+    m_map = nullptr;
+  }
   m_mode = None;
+  m_frameOffsets.clear();
+  m_frameTimes.clear();
+  m_frameCells.clear();
 }
 
 bool FileFormat::readMolecule(Core::Molecule& molecule)
 {
   if (!m_in)
     return false;
-  return read(*m_in, molecule);
+  return readTracked(*m_in, molecule);
 }
 
 bool FileFormat::writeMolecule(const Core::Molecule& molecule)
@@ -148,7 +185,7 @@ bool FileFormat::readString(const std::string& string, Core::Molecule& molecule)
   // Imbue the standard C locale.
   locale cLocale("C");
   stream.imbue(cLocale);
-  return read(stream, molecule);
+  return readTracked(stream, molecule);
 }
 
 bool FileFormat::writeString(std::string& string,
@@ -163,10 +200,130 @@ bool FileFormat::writeString(std::string& string,
   return result;
 }
 
+bool FileFormat::readTracked(std::istream& in, Core::Molecule& molecule)
+{
+  bool result = false;
+  {
+    ProgressBuffer buffer(in.rdbuf(), m_progress, m_canceled);
+    std::istream tracked(&buffer);
+    tracked.imbue(in.getloc());
+    m_tracked = &in == m_in ? &tracked : nullptr;
+    result = read(tracked, molecule);
+    m_tracked = nullptr;
+    // as if read() had read the source directly
+    in.setstate(tracked.rdstate());
+  }
+
+  if (m_canceled) {
+    appendError("Reading was canceled.");
+    m_canceled = false;
+    return false;
+  }
+  return result;
+}
+
+bool FileFormat::completeRead(Core::Molecule&)
+{
+  return true;
+}
+
+bool FileFormat::openTrajectory(const std::string& fileName_, bool mapFile)
+{
+  if (!open(fileName_, Read))
+    return false;
+
+  std::vector<std::streamoff> offsets;
+  std::vector<double> times;
+  std::vector<Matrix3> cells;
+  if (!indexFrames(*m_in, offsets, times, cells) || offsets.empty()) {
+    close();
+    return false;
+  }
+  m_frameOffsets.swap(offsets);
+  if (times.size() == m_frameOffsets.size())
+    m_frameTimes.swap(times);
+  if (cells.size() == m_frameOffsets.size())
+    m_frameCells.swap(cells);
+
+  // fall back to the stream if the file cannot be mapped
+  if (mapFile) {
+    m_map = new MappedFile;
+    if (!m_map->open(fileName_)) {
+      delete m_map;
+      m_map = nullptr;
+    }
+  }
+  return true;
+}
+
+bool FileFormat::readFrame(Index index, Core::Array<Vector3>& positions)
+{
+  if (!m_in || index >= m_frameOffsets.size())
+    return false;
+
+  if (m_map) {
+    const auto size = static_cast<std::streamoff>(m_map->size());
+    const std::streamoff begin = m_frameOffsets[index];
+    const std::streamoff end = index + 1 < m_frameOffsets.size()
+                                 ? m_frameOffsets[index + 1]
+                                 : size;
+    if (begin > end || end > size)
+      return false;
+    return readMappedFrame(m_map->data() + begin, m_map->data() + end,
+                           positions);
+  }
+
+  // a previous read may have hit the end of the file
+  m_in->clear();
+  m_in->seekg(m_frameOffsets[index]);
+  return m_in->good() && readFramePositions(*m_in, positions);
+}
+
+bool FileFormat::indexFrames(std::istream&, std::vector<std::streamoff>&,
+                             std::vector<double>&, std::vector<Matrix3>&)
+{
+  return false;
+}
+
+bool FileFormat::readFramePositions(std::istream&, Core::Array<Vector3>&)
+{
+  return false;
+}
+
+bool FileFormat::readMappedFrame(const char* begin, const char* end,
+                                 Core::Array<Vector3>& positions)
+{
+  MemoryBuffer buffer(begin, end);
+  std::istream in(&buffer);
+  in.imbue(locale::classic());
+  return readFramePositions(in, positions);
+}
+
+bool FileFormat::attachFrames(std::istream& in, Core::Molecule& molecule)
+{
+  // only files can be reopened, not strings or other streams
+  if ((&in != m_in && &in != m_tracked) || m_fileName.empty())
+    return false;
+
+  std::unique_ptr<FileFormat> frames(newInstance());
+  frames->setOptions(m_options);
+  if (!frames->openTrajectory(m_fileName) || frames->frameCount() < 2)
+    return false;
+
+  for (size_t i = 0; i < frames->m_frameTimes.size(); ++i)
+    molecule.setTimeStep(frames->m_frameTimes[i], static_cast<int>(i));
+  for (size_t i = 0; i < frames->m_frameCells.size(); ++i)
+    molecule.setFrameCell(frames->m_frameCells[i], static_cast<int>(i));
+  molecule.setFrameSource(
+    std::make_shared<FileFrameSource>(frames.release()));
+  return true;
+}
+
 void FileFormat::clear()
 {
   m_fileName.clear();
   m_error.clear();
+  m_canceled = false;
 }
 
 void FileFormat::appendError(const std::string& errorString, bool newLine)
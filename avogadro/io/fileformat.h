@@ -7,8 +7,14 @@
 #define AVOGADRO_IO_FILEFORMAT_H
 
 #include "avogadroioexport.h"
+#include <avogadro/core/array.h>
 #include <avogadro/core/avogadrocore.h>
+#include <avogadro/core/matrix.h>
+#include <avogadro/core/vector.h>
 
+#include <atomic>
+#include <functional>
+#include <ios>
 #include <istream>
 #include <ostream>
 #include <string>
@@ -21,6 +27,7 @@ class Molecule;
 }
 
 namespace Io {
+class MappedFile;
 
 /**
  * @class FileFormat fileformat.h <avogadro/io/fileformat.h>
@@ -167,6 +174,83 @@ public:
    */
   bool writeString(std::string& string, const Core::Molecule& molecule);
 
+  /**
+   * @brief Open a trajectory for random access to its frames.
+   * @param fileName The full path to the trajectory file.
+   * @param mapFile Read frames straight from a memory mapping of the file,
+   * rather than through a stream, if the file can be mapped.
+   * @return True if the format supports random access and at least one frame
+   * was found.
+   *
+   * The file is scanned once to record where each frame starts, after which
+   * readFrame() only reads the requested frame. The file stays open until
+   * close() is called.
+   */
+  bool openTrajectory(const std::string& fileName, bool mapFile = true);
+
+  /**
+   * @return The number of frames found by openTrajectory(), or zero.
+   */
+  Index frameCount() const { return m_frameOffsets.size(); }
+
+  /**
+   * @brief Read the atom positions of a single frame.
+   * @param index The frame, between 0 and frameCount() - 1.
+   * @param positions Set to the positions of the atoms in the frame.
+   * @return True on success, false on failure.
+   */
+  bool readFrame(Index index, Core::Array<Vector3>& positions);
+
+  /**
+   * Called while reading with the number of bytes read so far and the total
+   * size of the input, or -1 if the size is unknown.
+   */
+  typedef std::function<void(std::streamoff, std::streamoff)> ProgressCallback;
+
+  /**
+   * @brief Report progress while reading with readMolecule(), readFile() or
+   * readString(). The callback is called from the thread doing the reading,
+   * each time another block of the input is read.
+   */
+  void setProgressCallback(const ProgressCallback& callback)
+  {
+    m_progress = callback;
+  }
+
+  /**
+   * @brief Cancel the read in progress, or the next one if none is running.
+   *
+   * This may be called from any thread. The reader sees the end of the input
+   * at the next block, and the read returns false with an error. Only reads
+   * with readMolecule(), readFile() or readString() can be canceled. clear()
+   * withdraws a request that no read has seen yet.
+   */
+  void cancel() { m_canceled = true; }
+
+  /**
+   * @return True if cancel() was called and the read has not yet stopped.
+   */
+  bool isCanceled() const { return m_canceled; }
+
+  /**
+   * @brief Skip data that is derived from what was read, such as bonds
+   * perceived from the geometry, so that read() returns as soon as the atoms
+   * and the first frame are in place. completeRead() adds the derived data
+   * afterwards. Formats that derive nothing ignore this. Default: false.
+   */
+  void setDeferDerivedData(bool defer) { m_deferDerivedData = defer; }
+
+  /** @return True if read() skips derived data. */
+  bool deferDerivedData() const { return m_deferDerivedData; }
+
+  /**
+   * @brief Add the derived data that read() skipped because
+   * deferDerivedData() was set, e.g. perceive bonds and residues.
+   * @param molecule The molecule that was read.
+   * @return True on success. The default does nothing and returns true.
+   */
+  virtual bool completeRead(Core::Molecule& molecule);
+
   /**
    * @brief Get the error string, contains errors/warnings encountered.
    * @return String containing any errors or warnings encountered.
@@ -246,15 +330,81 @@ protected:
    */
   void appendError(const std::string& errorString, bool newLine = true);
 
+  /**
+   * @brief Record the start of each frame in a trajectory.
+   * @param in The stream, positioned at the start of the file.
+   * @param offsets Filled with the stream offset of every frame, suitable for
+   * readFramePositions().
+   * @param times The time step of every frame, if the file has them.
+   * @param cells The unit cell matrix of every frame, if the file has them.
+   * @return False if the format does not support random access (the
+   * default), or the file could not be indexed.
+   */
+  virtual bool indexFrames(std::istream& in,
+                           std::vector<std::streamoff>& offsets,
+                           std::vector<double>& times,
+                           std::vector<Matrix3>& cells);
+
+  /**
+   * @brief Read the positions of the frame starting at the current position
+   * of @p in, as recorded by indexFrames().
+   * @return True on success, false on failure (the default).
+   */
+  virtual bool readFramePositions(std::istream& in,
+                                  Core::Array<Vector3>& positions);
+
+  /**
+   * @brief Read the positions of the frame stored in [@p begin, @p end) of
+   * a memory mapped trajectory.
+   *
+   * The range runs from the offset recorded by indexFrames() to the start of
+   * the next frame, or the end of the file. The default reads the range as a
+   * stream with readFramePositions(), without copying it; binary formats can
+   * decode the data in place instead.
+   */
+  virtual bool readMappedFrame(const char* begin, const char* end,
+                               Core::Array<Vector3>& positions);
+
+  /**
+   * @brief Let @p molecule read the remaining frames of the file being read
+   * on demand, rather than storing them all up front.
+   *
+   * This is intended to be called from read() once the first frame is in
+   * place. It only succeeds when @p in is a file with more than one frame,
+   * readers should fall back to reading every frame otherwise. Any time steps
+   * and unit cells found while indexing the file are set on @p molecule.
+   * @param in The stream passed to read().
+   * @param molecule The molecule being read.
+   * @return True if the frames will be read on demand.
+   */
+  bool attachFrames(std::istream& in, Core::Molecule& molecule);
+
 private:
+  /**
+   * Read @p in with read(), reporting progress and honoring cancel().
+   */
+  bool readTracked(std::istream& in, Core::Molecule& molecule);
+
   std::string m_error;
   std::string m_fileName;
   std::string m_options;
 
+  ProgressCallback m_progress;
+  std::atomic<bool> m_canceled;
+  bool m_deferDerivedData;
+
   // Streams for reading/writing data, especially streaming data in/out.
   Operation m_mode;
   std::istream* m_in;
   std::ostream* m_out;
+  MappedFile* m_map;
+  // The stream read() is reading m_in through, see readTracked().
+  std::istream* m_tracked;
+
+  // Start, time step and cell of each frame, from openTrajectory().
+  std::vector<std::streamoff> m_frameOffsets;
+  std::vector<double> m_frameTimes;
+  std::vector<Matrix3> m_frameCells;
 };
 
 inline FileFormat::Operation operator|(FileFormat::Operation a,
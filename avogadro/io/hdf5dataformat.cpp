@@ -8,6 +8,8 @@
 #include "hdf5.h"
 
 #include <avogadro/core/array.h>
+#include <avogadro/core/cube.h>
+#include <avogadro/core/framecache.h>
 
 #include <algorithm>
 #include <cstdio>
@@ -40,12 +42,19 @@ protected:
 class Hdf5DataFormat::Private
 {
 public:
-  Private() : fileId(H5I_INVALID_HID), threshold(1024) {}
+  Private()
+    : fileId(H5I_INVALID_HID), threshold(1024), compressionLevel(0),
+      chunkSize(1 << 20), singlePrecision(false)
+  {
+  }
 
   std::string filename;
   hid_t fileId;
 
   size_t threshold;
+  int compressionLevel;
+  size_t chunkSize;
+  bool singlePrecision;
 };
 
 namespace {
@@ -69,12 +78,20 @@ public:
   }
 };
 
+// Matrices are stored row-major, unlike MatrixX. Older files hold the
+// column-major buffer of the matrix instead, and have no layout attribute.
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+  RowMajorMatrixX;
+const char* const LayoutAttribute = "layout";
+const std::string RowMajorLayout = "row-major";
+
+template <typename Matrix>
 class ResizeMatrixX : public Avogadro::Io::Hdf5DataFormat::ResizeContainer
 {
-  MatrixX& m_data;
+  Matrix& m_data;
 
 public:
-  ResizeMatrixX(MatrixX& data) : m_data(data) {}
+  ResizeMatrixX(Matrix& data) : m_data(data) {}
   bool resize(const std::vector<int>& dims)
   {
     if (dims.size() != 2)
@@ -113,6 +130,191 @@ public:
   void* dataPointer() { return &m_data[0]; }
 };
 
+// Closes an HDF5 object when it goes out of scope.
+class Handle
+{
+public:
+  Handle(hid_t id_, herr_t (*close)(hid_t)) : m_id(id_), m_close(close) {}
+  ~Handle()
+  {
+    if (m_id >= 0)
+      m_close(m_id);
+  }
+  Handle(const Handle&) = delete;
+  Handle& operator=(const Handle&) = delete;
+
+  hid_t id() const { return m_id; }
+  bool valid() const { return m_id >= 0; }
+
+private:
+  hid_t m_id;
+  herr_t (*m_close)(hid_t);
+};
+
+// Chunk dimensions of about targetBytes: the largest dimension is halved
+// until the chunk fits, so that chunks are roughly as long in every direction
+// and any slice of the dataset touches few of them.
+std::vector<hsize_t> chunkDimensions(const std::vector<hsize_t>& dims,
+                                     size_t elementSize, size_t targetBytes)
+{
+  std::vector<hsize_t> chunk(dims);
+  for (;;) {
+    hsize_t bytes = elementSize;
+    for (hsize_t dim : chunk)
+      bytes *= dim;
+    auto largest = std::max_element(chunk.begin(), chunk.end());
+    if (bytes <= targetBytes || *largest <= 1)
+      return chunk;
+    *largest = (*largest + 1) / 2;
+  }
+}
+
+// Create a dataset at path, with any intermediate groups. The dataset is
+// chunked if chunk is not empty, and compressed if level is positive.
+hid_t createDataset(hid_t fileId, const std::string& path, hid_t type,
+                    const std::vector<hsize_t>& dims,
+                    const std::vector<hsize_t>& chunk, int level,
+                    bool extendible)
+{
+  std::vector<hsize_t> maxDims(dims);
+  if (extendible)
+    maxDims[0] = H5S_UNLIMITED;
+  Handle space(H5Screate_simple(static_cast<int>(dims.size()), dims.data(),
+                                maxDims.data()),
+               H5Sclose);
+  Handle linkProperties(H5Pcreate(H5P_LINK_CREATE), H5Pclose);
+  Handle properties(H5Pcreate(H5P_DATASET_CREATE), H5Pclose);
+  if (!space.valid() || !linkProperties.valid() || !properties.valid() ||
+      H5Pset_create_intermediate_group(linkProperties.id(), 1) < 0) {
+    return H5I_INVALID_HID;
+  }
+
+  if (!chunk.empty()) {
+    if (H5Pset_chunk(properties.id(), static_cast<int>(chunk.size()),
+                     chunk.data()) < 0) {
+      return H5I_INVALID_HID;
+    }
+    // shuffling the bytes of the values first compresses floats much better
+    if (level > 0 && (H5Pset_shuffle(properties.id()) < 0 ||
+                      H5Pset_deflate(properties.id(),
+                                     static_cast<unsigned>(level)) < 0)) {
+      return H5I_INVALID_HID;
+    }
+  }
+
+  return H5Dcreate(fileId, path.c_str(), type, space.id(),
+                   linkProperties.id(), properties.id(), H5P_DEFAULT);
+}
+
+// The dimensions of a dataset, or an empty vector on error.
+std::vector<hsize_t> dimensions(hid_t dataspace)
+{
+  int ndims = H5Sget_simple_extent_ndims(dataspace);
+  if (ndims <= 0)
+    return std::vector<hsize_t>();
+  std::vector<hsize_t> dims(static_cast<size_t>(ndims));
+  if (H5Sget_simple_extent_dims(dataspace, dims.data(), nullptr) != ndims)
+    dims.clear();
+  return dims;
+}
+
+// Read or write the block at start with the given size of an open dataset.
+bool transferBlock(hid_t dataset, hid_t memoryType,
+                   const std::vector<hsize_t>& start,
+                   const std::vector<hsize_t>& count, void* data, bool write)
+{
+  Handle fileSpace(H5Dget_space(dataset), H5Sclose);
+  Handle memorySpace(
+    H5Screate_simple(static_cast<int>(count.size()), count.data(), nullptr),
+    H5Sclose);
+  if (!fileSpace.valid() || !memorySpace.valid() ||
+      H5Sselect_hyperslab(fileSpace.id(), H5S_SELECT_SET, start.data(),
+                          nullptr, count.data(), nullptr) < 0) {
+    return false;
+  }
+  if (write) {
+    return H5Dwrite(dataset, memoryType, memorySpace.id(), fileSpace.id(),
+                    H5P_DEFAULT, data) >= 0;
+  }
+  return H5Dread(dataset, memoryType, memorySpace.id(), fileSpace.id(),
+                 H5P_DEFAULT, data) >= 0;
+}
+
+bool writeAttribute(hid_t object, const char* name, hid_t type, hsize_t size,
+                    const void* data)
+{
+  Handle space(H5Screate_simple(1, &size, nullptr), H5Sclose);
+  if (!space.valid())
+    return false;
+  Handle attribute(
+    H5Acreate(object, name, type, space.id(), H5P_DEFAULT, H5P_DEFAULT),
+    H5Aclose);
+  return attribute.valid() && H5Awrite(attribute.id(), type, data) >= 0;
+}
+
+bool readAttribute(hid_t object, const char* name, hid_t type, hsize_t size,
+                   void* data)
+{
+  if (H5Aexists(object, name) <= 0)
+    return false;
+  Handle attribute(H5Aopen(object, name, H5P_DEFAULT), H5Aclose);
+  Handle space(attribute.valid() ? H5Aget_space(attribute.id())
+                                 : H5I_INVALID_HID,
+               H5Sclose);
+  return space.valid() &&
+         H5Sget_simple_extent_npoints(space.id()) ==
+           static_cast<hssize_t>(size) &&
+         H5Aread(attribute.id(), type, data) >= 0;
+}
+
+// A string attribute stored as characters, or an empty string.
+std::string readStringAttribute(hid_t object, const char* name)
+{
+  std::string value;
+  if (H5Aexists(object, name) <= 0)
+    return value;
+  Handle attribute(H5Aopen(object, name, H5P_DEFAULT), H5Aclose);
+  Handle space(attribute.valid() ? H5Aget_space(attribute.id())
+                                 : H5I_INVALID_HID,
+               H5Sclose);
+  if (!space.valid())
+    return value;
+  value.resize(static_cast<size_t>(
+    std::max<hssize_t>(H5Sget_simple_extent_npoints(space.id()), 0)));
+  if (!value.empty() &&
+      H5Aread(attribute.id(), H5T_NATIVE_CHAR, &value[0]) < 0) {
+    value.clear();
+  }
+  return value;
+}
+
+// Reads frames on demand from a dataset written by Hdf5DataFormat::writeFrame.
+class Hdf5FrameSource : public Core::FrameSource
+{
+public:
+  Hdf5FrameSource(const std::string& path) : m_path(path), m_frameCount(0) {}
+
+  bool open(const std::string& filename)
+  {
+    if (!m_file.openFile(filename, Hdf5DataFormat::ReadOnly))
+      return false;
+    m_frameCount = m_file.frameCount(m_path);
+    return m_frameCount > 0;
+  }
+
+  Index frameCount() const override { return m_frameCount; }
+
+  bool readFrame(Index index, Core::Array<Vector3>& positions) override
+  {
+    return m_file.readFrame(m_path, index, positions);
+  }
+
+private:
+  Hdf5DataFormat m_file;
+  std::string m_path;
+  Index m_frameCount;
+};
+
 } // end unnamed namespace
 
 // end doxygen exclude:
@@ -225,6 +427,36 @@ bool Hdf5DataFormat::exceedsThreshold(const Core::Array<double>& data) const
   return exceedsThreshold(data.size() * sizeof(double));
 }
 
+void Hdf5DataFormat::setCompressionLevel(int level)
+{
+  d->compressionLevel = std::clamp(level, 0, 9);
+}
+
+int Hdf5DataFormat::compressionLevel() const
+{
+  return d->compressionLevel;
+}
+
+void Hdf5DataFormat::setChunkSize(size_t bytes)
+{
+  d->chunkSize = std::max<size_t>(bytes, 1);
+}
+
+size_t Hdf5DataFormat::chunkSize() const
+{
+  return d->chunkSize;
+}
+
+void Hdf5DataFormat::setSinglePrecision(bool single)
+{
+  d->singlePrecision = single;
+}
+
+bool Hdf5DataFormat::singlePrecision() const
+{
+  return d->singlePrecision;
+}
+
 bool Hdf5DataFormat::datasetExists(const std::string& path) const
 {
   if (!isOpen())
@@ -333,44 +565,29 @@ bool Hdf5DataFormat::writeRawDataset(const std::string& path,
   }
 
   // Get dimensions of data.
-  hsize_t* hdims = new hsize_t[ndims];
-  for (int i = 0; i < ndims; ++i) {
-    hdims[i] = static_cast<hsize_t>(dims[i]);
-  }
-
-  // Create a dataspace description.
-  hid_t dataspace_id = H5Screate_simple(ndims, hdims, nullptr);
-  delete[] hdims;
-  if (dataspace_id < 0)
-    return false;
-
-  // Create any intermediate groups if needed:
-  hid_t lcpl_id = H5Pcreate(H5P_LINK_CREATE);
-  if (lcpl_id == -1 || H5Pset_create_intermediate_group(lcpl_id, 1) < 0) {
-    H5Sclose(dataspace_id);
-    return false;
+  std::vector<hsize_t> hdims(dims, dims + ndims);
+
+  // Compressed data must be chunked, and empty datasets cannot be.
+  std::vector<hsize_t> chunk;
+  const size_t elementSize =
+    d->singlePrecision ? sizeof(float) : sizeof(double);
+  if (d->compressionLevel > 0 &&
+      std::find(hdims.begin(), hdims.end(), 0) == hdims.end()) {
+    chunk = chunkDimensions(hdims, elementSize, d->chunkSize);
   }
 
   // Create the dataset.
-  hid_t dataset_id = H5Dcreate(d->fileId, path.c_str(), H5T_NATIVE_DOUBLE,
-                               dataspace_id, lcpl_id, H5P_DEFAULT, H5P_DEFAULT);
-  if (dataset_id < 0) {
-    H5Sclose(dataspace_id);
+  Handle dataset(createDataset(d->fileId, path,
+                               d->singlePrecision ? H5T_NATIVE_FLOAT
+                                                  : H5T_NATIVE_DOUBLE,
+                               hdims, chunk, d->compressionLevel, false),
+                 H5Dclose);
+  if (!dataset.valid())
     return false;
-  }
 
   // Write the actual data.
-  herr_t err = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, dataspace_id,
-                        H5P_DEFAULT, data);
-
-  // Cleanup.
-  H5Dclose(dataset_id);
-  H5Sclose(dataspace_id);
-
-  if (err < 0)
-    return false;
-
-  return true;
+  return H5Dwrite(dataset.id(), H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL,
+                  H5P_DEFAULT, data) >= 0;
 }
 
 bool Hdf5DataFormat::writeDataset(const std::string& path,
@@ -378,8 +595,25 @@ bool Hdf5DataFormat::writeDataset(const std::string& path,
 {
   size_t dims[2] = { static_cast<size_t>(data.rows()),
                      static_cast<size_t>(data.cols()) };
-  // Transpose data -- Eigen uses column-major ordering.
-  return this->writeRawDataset(path, data.transpose().data(), 2, dims);
+  // Copy to row-major order -- Eigen uses column-major ordering.
+  const RowMajorMatrixX rowMajor = data;
+  if (!this->writeRawDataset(path, rowMajor.data(), 2, dims))
+    return false;
+
+  // mark the layout, so that it is not mistaken for that of older files
+  Handle dataset(H5Dopen(d->fileId, path.c_str(), H5P_DEFAULT), H5Dclose);
+  return dataset.valid() &&
+         writeAttribute(dataset.id(), LayoutAttribute, H5T_NATIVE_CHAR,
+                        RowMajorLayout.size(), RowMajorLayout.data());
+}
+
+bool Hdf5DataFormat::isRowMajor(const std::string& path) const
+{
+  if (!datasetExists(path))
+    return false;
+  Handle dataset(H5Dopen(d->fileId, path.c_str(), H5P_DEFAULT), H5Dclose);
+  return dataset.valid() &&
+         readStringAttribute(dataset.id(), LayoutAttribute) == RowMajorLayout;
 }
 
 bool Hdf5DataFormat::writeDataset(const std::string& path,
@@ -468,8 +702,18 @@ std::vector<int> Hdf5DataFormat::readRawDataset(
 
 bool Hdf5DataFormat::readDataset(const std::string& path, MatrixX& data) const
 {
-  ResizeMatrixX container(data);
-  return !readRawDataset(path, container).empty();
+  // older files hold the column-major buffer, which is read as it is
+  if (!isRowMajor(path)) {
+    ResizeMatrixX<MatrixX> container(data);
+    return !readRawDataset(path, container).empty();
+  }
+
+  RowMajorMatrixX rowMajor;
+  ResizeMatrixX<RowMajorMatrixX> container(rowMajor);
+  if (readRawDataset(path, container).empty())
+    return false;
+  data = rowMajor;
+  return true;
 }
 
 std::vector<int> Hdf5DataFormat::readDataset(const std::string& path,
@@ -486,6 +730,243 @@ std::vector<int> Hdf5DataFormat::readDataset(const std::string& path,
   return readRawDataset(path, container);
 }
 
+bool Hdf5DataFormat::readDatasetBlock(const std::string& path, size_t row,
+                                      size_t col, size_t rows, size_t cols,
+                                      MatrixX& data) const
+{
+  if (!datasetExists(path))
+    return false;
+
+  Handle dataset(H5Dopen(d->fileId, path.c_str(), H5P_DEFAULT), H5Dclose);
+  if (!dataset.valid())
+    return false;
+  Handle space(H5Dget_space(dataset.id()), H5Sclose);
+  if (!space.valid())
+    return false;
+  std::vector<hsize_t> dims = dimensions(space.id());
+  if (dims.size() != 2 || row + rows > dims[0] || col + cols > dims[1] ||
+      rows == 0 || cols == 0) {
+    return false;
+  }
+
+  // a block of an older, column-major dataset is not a hyperslab of it
+  if (!isRowMajor(path)) {
+    MatrixX matrix;
+    if (!readDataset(path, matrix))
+      return false;
+    data = matrix.block(row, col, rows, cols);
+    return true;
+  }
+
+  RowMajorMatrixX block(rows, cols);
+  if (!transferBlock(dataset.id(), H5T_NATIVE_DOUBLE, { row, col },
+                     { rows, cols }, block.data(), false)) {
+    return false;
+  }
+  data = block;
+  return true;
+}
+
+bool Hdf5DataFormat::writeFrame(const std::string& path, Index frame,
+                                const Core::Array<Vector3>& positions) const
+{
+  if (!isOpen() || positions.empty())
+    return false;
+
+  const auto atoms = static_cast<hsize_t>(positions.size());
+  const bool exists = datasetExists(path);
+  if (!exists && frame != 0)
+    return false;
+
+  hid_t id = H5I_INVALID_HID;
+  if (exists) {
+    id = H5Dopen(d->fileId, path.c_str(), H5P_DEFAULT);
+  } else {
+    // Put as many frames in a chunk as fit, or split large frames so that a
+    // single frame can be read without reading others.
+    const size_t elementSize =
+      d->singlePrecision ? sizeof(float) : sizeof(double);
+    const size_t frameBytes = static_cast<size_t>(atoms) * 3 * elementSize;
+    std::vector<hsize_t> chunk = { 1, atoms, 3 };
+    if (frameBytes <= d->chunkSize)
+      chunk[0] = d->chunkSize / frameBytes;
+    else
+      chunk[1] = std::max<hsize_t>(d->chunkSize / (3 * elementSize), 1);
+    id = createDataset(d->fileId, path,
+                       d->singlePrecision ? H5T_NATIVE_FLOAT
+                                          : H5T_NATIVE_DOUBLE,
+                       { 1, atoms, 3 }, chunk, d->compressionLevel, true);
+  }
+  Handle dataset(id, H5Dclose);
+  if (!dataset.valid())
+    return false;
+
+  if (exists) {
+    // Frames may be replaced or appended, and must all have the same atoms.
+    Handle space(H5Dget_space(dataset.id()), H5Sclose);
+    if (!space.valid())
+      return false;
+    std::vector<hsize_t> dims = dimensions(space.id());
+    if (dims.size() != 3 || dims[1] != atoms || dims[2] != 3 ||
+        frame > dims[0]) {
+      return false;
+    }
+    if (frame == dims[0]) {
+      dims[0] = frame + 1;
+      if (H5Dset_extent(dataset.id(), dims.data()) < 0)
+        return false;
+    }
+  }
+
+  return transferBlock(dataset.id(), H5T_NATIVE_DOUBLE, { frame, 0, 0 },
+                       { 1, atoms, 3 }, const_cast<Vector3*>(positions.data()),
+                       true);
+}
+
+bool Hdf5DataFormat::readFrame(const std::string& path, Index frame,
+                               Core::Array<Vector3>& positions) const
+{
+  if (!datasetExists(path))
+    return false;
+
+  Handle dataset(H5Dopen(d->fileId, path.c_str(), H5P_DEFAULT), H5Dclose);
+  if (!dataset.valid())
+    return false;
+  Handle space(H5Dget_space(dataset.id()), H5Sclose);
+  if (!space.valid())
+    return false;
+  std::vector<hsize_t> dims = dimensions(space.id());
+  if (dims.size() != 3 || dims[2] != 3 || frame >= dims[0])
+    return false;
+
+  positions.resize(static_cast<size_t>(dims[1]));
+  return transferBlock(dataset.id(), H5T_NATIVE_DOUBLE, { frame, 0, 0 },
+                       { 1, dims[1], 3 }, positions.data(), false);
+}
+
+Index Hdf5DataFormat::frameCount(const std::string& path) const
+{
+  std::vector<int> dims = datasetDimensions(path);
+  if (dims.size() != 3 || dims[2] != 3)
+    return 0;
+  return static_cast<Index>(dims[0]);
+}
+
+std::shared_ptr<Core::FrameSource> Hdf5DataFormat::frameSource(
+  const std::string& filename_, const std::string& path)
+{
+  auto source = std::make_shared<Hdf5FrameSource>(path);
+  if (!source->open(filename_))
+    return nullptr;
+  return source;
+}
+
+bool Hdf5DataFormat::writeCube(const std::string& path,
+                               const Core::Cube& cube) const
+{
+  const Vector3i points = cube.dimensions();
+  const std::vector<float>* values = cube.data();
+  if (!isOpen() || values->empty() ||
+      values->size() != static_cast<size_t>(points.prod())) {
+    return false;
+  }
+
+  if (datasetExists(path) && !removeDataset(path))
+    return false;
+
+  // The values are floats, whatever the precision set for other data.
+  std::vector<hsize_t> dims = { static_cast<hsize_t>(points.x()),
+                                static_cast<hsize_t>(points.y()),
+                                static_cast<hsize_t>(points.z()) };
+  Handle dataset(createDataset(d->fileId, path, H5T_NATIVE_FLOAT, dims,
+                               chunkDimensions(dims, sizeof(float),
+                                               d->chunkSize),
+                               d->compressionLevel, false),
+                 H5Dclose);
+  if (!dataset.valid() ||
+      H5Dwrite(dataset.id(), H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+               values->data()) < 0) {
+    return false;
+  }
+
+  const Vector3 min = cube.min();
+  const Vector3 spacing = cube.spacing();
+  const int type = cube.cubeType();
+  const std::string name = cube.name();
+  return writeAttribute(dataset.id(), "min", H5T_NATIVE_DOUBLE, 3,
+                        min.data()) &&
+         writeAttribute(dataset.id(), "spacing", H5T_NATIVE_DOUBLE, 3,
+                        spacing.data()) &&
+         writeAttribute(dataset.id(), "cubeType", H5T_NATIVE_INT, 1, &type) &&
+         (name.empty() || writeAttribute(dataset.id(), "name",
+                                         H5T_NATIVE_CHAR, name.size(),
+                                         name.data()));
+}
+
+bool Hdf5DataFormat::readCube(const std::string& path, Core::Cube& cube) const
+{
+  std::vector<int> dims = datasetDimensions(path);
+  if (dims.size() != 3)
+    return false;
+  return readCube(path, Vector3i::Zero(), Vector3i(dims[0], dims[1], dims[2]),
+                  cube);
+}
+
+bool Hdf5DataFormat::readCube(const std::string& path, const Vector3i& offset,
+                              const Vector3i& points, Core::Cube& cube) const
+{
+  if (!datasetExists(path))
+    return false;
+
+  Handle dataset(H5Dopen(d->fileId, path.c_str(), H5P_DEFAULT), H5Dclose);
+  if (!dataset.valid())
+    return false;
+  Handle space(H5Dget_space(dataset.id()), H5Sclose);
+  if (!space.valid())
+    return false;
+  std::vector<hsize_t> dims = dimensions(space.id());
+  if (dims.size() != 3)
+    return false;
+  for (int i = 0; i < 3; ++i) {
+    if (offset[i] < 0 || points[i] <= 0 ||
+        static_cast<hsize_t>(offset[i] + points[i]) > dims[i]) {
+      return false;
+    }
+  }
+
+  Vector3 min;
+  Vector3 spacing;
+  int type = Core::Cube::None;
+  if (!readAttribute(dataset.id(), "min", H5T_NATIVE_DOUBLE, 3, min.data()) ||
+      !readAttribute(dataset.id(), "spacing", H5T_NATIVE_DOUBLE, 3,
+                     spacing.data())) {
+    return false;
+  }
+  readAttribute(dataset.id(), "cubeType", H5T_NATIVE_INT, 1, &type);
+
+  std::vector<float> values(static_cast<size_t>(points.prod()));
+  if (!transferBlock(dataset.id(), H5T_NATIVE_FLOAT,
+                     { static_cast<hsize_t>(offset.x()),
+                       static_cast<hsize_t>(offset.y()),
+                       static_cast<hsize_t>(offset.z()) },
+                     { static_cast<hsize_t>(points.x()),
+                       static_cast<hsize_t>(points.y()),
+                       static_cast<hsize_t>(points.z()) },
+                     values.data(), false)) {
+    return false;
+  }
+
+  const std::string name = readStringAttribute(dataset.id(), "name");
+  if (!cube.setLimits(min + offset.cast<double>().cwiseProduct(spacing),
+                      points, spacing) ||
+      !cube.setData(values)) {
+    return false;
+  }
+  cube.setName(name);
+  cube.setCubeType(static_cast<Core::Cube::Type>(type));
+  return true;
+}
+
 std::vector<std::string> Hdf5DataFormat::datasets() const
 {
   if (!isOpen())
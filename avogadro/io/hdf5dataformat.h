@@ -10,7 +10,11 @@
 
 #include <avogadro/core/matrix.h> // can't forward declare eigen types
 
+#include <avogadro/core/avogadrocore.h>
+#include <avogadro/core/vector.h>
+
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -18,7 +22,9 @@ namespace Avogadro {
 namespace Core {
 template <typename T>
 class Array;
-}
+class Cube;
+class FrameSource;
+} // namespace Core
 namespace Io {
 
 /**
@@ -52,6 +58,16 @@ namespace Io {
  * If not, it should be serialized into the text file in a suitable format. The
  * thresholding operations are optional; the threshold size does not affect the
  * behavior of the read/write methods and are only for user convenience.
+ *
+ * Large results can also be kept in the file and read back piece by piece.
+ * Coordinate frames are appended to an extendible dataset with writeFrame()
+ * and read one at a time with readFrame(), volumetric data is written with
+ * writeCube() and read whole or as a sub-volume with readCube(), and blocks
+ * of a matrix, e.g. single orbitals of an MO coefficient matrix, are read
+ * with readDatasetBlock(). These datasets are stored in chunks of about
+ * chunkSize() bytes, compressed if a compressionLevel() is set. With
+ * setSinglePrecision(), floating point data is stored as 32-bit floats,
+ * halving the file size; it is converted back to double when read.
  */
 class AVOGADROIO_EXPORT Hdf5DataFormat
 {
@@ -160,6 +176,37 @@ public:
    */
   bool exceedsThreshold(const Core::Array<double>& data) const;
 
+  /**
+   * @brief setCompressionLevel Set the deflate (gzip) compression level used
+   * for new datasets, from 0 (no compression) to 9 (smallest file). Compressed
+   * datasets are always stored in chunks. Default: 0.
+   */
+  void setCompressionLevel(int level);
+
+  /** @return The deflate compression level for new datasets. Default: 0. */
+  int compressionLevel() const;
+
+  /**
+   * @brief setChunkSize Set the approximate size in bytes of the chunks of
+   * chunked datasets. Parts of a dataset are read and decompressed a chunk at
+   * a time, so smaller chunks make reading small slices cheaper at the cost
+   * of a larger index. Default: 1MB.
+   */
+  void setChunkSize(size_t bytes);
+
+  /** @return The approximate chunk size in bytes. Default: 1MB. */
+  size_t chunkSize() const;
+
+  /**
+   * @brief setSinglePrecision Store the floating point data of new datasets
+   * as 32-bit floats rather than 64-bit doubles. Data is still passed to and
+   * from the read and write methods as double. Default: false.
+   */
+  void setSinglePrecision(bool single);
+
+  /** @return True if new datasets are stored as 32-bit floats. */
+  bool singlePrecision() const;
+
   /**
    * @brief datasetExists Test if the currently open file contains a dataset at
    * the HDF5 absolute path @a path.
@@ -193,6 +240,9 @@ public:
    * specified absolute HDF5 path.
    * @param path An absolute path into the HDF5 data.
    * @param data The data container to serialize to HDF5.
+   * @note The matrix is stored in row-major order, marked by a "layout"
+   * attribute. readDataset() also reads matrices from older files, which
+   * have no such attribute and hold the column-major buffer instead.
    * @return true if the data is successfully written, false otherwise.
    */
   bool writeDataset(const std::string& path, const MatrixX& data) const;
@@ -266,6 +316,91 @@ public:
   std::vector<int> readDataset(const std::string& path,
                                Core::Array<double>& data) const;
 
+  /**
+   * @brief readDatasetBlock Read a block of a two dimensional dataset, such
+   * as one written from a MatrixX, without reading the rest of it.
+   * @param path An absolute path into the HDF5 data.
+   * @param row The first row of the block.
+   * @param col The first column of the block.
+   * @param rows The number of rows in the block.
+   * @param cols The number of columns in the block.
+   * @param data Resized to rows x cols and filled with the block.
+   * @return true if the block lies within the dataset and is read.
+   */
+  bool readDatasetBlock(const std::string& path, size_t row, size_t col,
+                        size_t rows, size_t cols, MatrixX& data) const;
+
+  /**
+   * @brief writeFrame Write the coordinates of one frame of a trajectory into
+   * the dataset of frames at @a path, which is created if needed.
+   * @param path An absolute path into the HDF5 data.
+   * @param frame The index of the frame. It may replace an existing frame or
+   * be appended right after the last one.
+   * @param positions The atom positions. Every frame in a dataset must have
+   * the same number of atoms.
+   * @return true if the frame is successfully written.
+   */
+  bool writeFrame(const std::string& path, Index frame,
+                  const Core::Array<Vector3>& positions) const;
+
+  /**
+   * @brief readFrame Read the coordinates of one frame of a trajectory from
+   * the dataset of frames at @a path. Only that frame is read from disk.
+   * @param path An absolute path into the HDF5 data.
+   * @param frame The index of the frame.
+   * @param positions Resized and filled with the atom positions.
+   * @return true if the frame exists and is read.
+   */
+  bool readFrame(const std::string& path, Index frame,
+                 Core::Array<Vector3>& positions) const;
+
+  /**
+   * @return The number of frames in the dataset of frames at @a path, or 0 if
+   * there is no such dataset.
+   */
+  Index frameCount(const std::string& path) const;
+
+  /**
+   * @brief frameSource Open the frames written with writeFrame() as the
+   * source of a trajectory, e.g. for Core::Molecule::setFrameSource(). The
+   * source opens @a filename_ again read-only, so it does not depend on this
+   * object, and frames are read from disk as they are requested.
+   * @return The source, or nullptr if the file or dataset cannot be opened.
+   */
+  static std::shared_ptr<Core::FrameSource> frameSource(
+    const std::string& filename_, const std::string& path);
+
+  /**
+   * @brief writeCube Write a volume as a chunked three dimensional dataset of
+   * 32-bit floats. The limits, name and type of the cube are kept as
+   * attributes of the dataset.
+   * @param path An absolute path into the HDF5 data.
+   * @param cube The cube to write.
+   * @return true if the cube is successfully written.
+   */
+  bool writeCube(const std::string& path, const Core::Cube& cube) const;
+
+  /**
+   * @brief readCube Read a volume written with writeCube().
+   * @param path An absolute path into the HDF5 data.
+   * @param cube Set to the limits and data of the stored cube.
+   * @return true if the cube is read.
+   */
+  bool readCube(const std::string& path, Core::Cube& cube) const;
+
+  /**
+   * @brief readCube Read part of a volume written with writeCube(). Only the
+   * chunks overlapping the sub-volume are read from disk.
+   * @param path An absolute path into the HDF5 data.
+   * @param offset The index of the first point of the sub-volume.
+   * @param points The number of points of the sub-volume in each direction.
+   * @param cube Set to the sub-volume, with limits matching its position in
+   * the stored cube.
+   * @return true if the sub-volume lies within the stored cube and is read.
+   */
+  bool readCube(const std::string& path, const Vector3i& offset,
+                const Vector3i& points, Core::Cube& cube) const;
+
   /**
    * @brief datasets Traverse the currently opened file and return a list of all
    * dataset objects in the file.
@@ -307,6 +442,13 @@ private:
   std::vector<int> readRawDataset(const std::string& path,
                                   ResizeContainer& container) const;
 
+  /**
+   * @return true if the matrix at @a path was stored in row-major order.
+   * Matrices written before the layout attribute was added hold the
+   * column-major buffer of the matrix.
+   */
+  bool isRowMajor(const std::string& path) const;
+
   class Private;
   /** Internal storage, used to encapsulate HDF5 data. */
   Private* const d;
@@ -14,9 +14,11 @@
 
 #include <iomanip>
 #include <istream>
+#include <limits>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 using std::endl;
 using std::getline;
@@ -41,22 +43,58 @@ using Core::UnitCell;
 #ifndef _WIN32
 #endif
 
+namespace {
+// The bounds of a simulation box. For triclinic boxes these are the bounds
+// of the cell itself, rather than those of the orthogonal box around it.
+struct Box
+{
+  double lo[3] = { 0., 0., 0. };
+  double hi[3] = { 0., 0., 0. };
+  double xy = 0., xz = 0., yz = 0.;
+
+  Matrix3 cellMatrix() const
+  {
+    Matrix3 matrix;
+    matrix.col(0) = Vector3(hi[0] - lo[0], 0, 0);
+    matrix.col(1) = Vector3(xy, hi[1] - lo[1], 0);
+    matrix.col(2) = Vector3(xz, yz, hi[2] - lo[2]);
+    return matrix;
+  }
+};
+
+// Reads the three lines of bounds following the "ITEM: BOX BOUNDS" line
+// @p item. Triclinic boxes add a tilt factor to each line.
+void readBox(std::istream& in, const string& item, Box& box)
+{
+  const bool triclinic = item.find("ITEM: BOX BOUNDS xy xz yz") == 0;
+  double* tilts[3] = { &box.xy, &box.xz, &box.yz };
+  string buffer;
+  for (int i = 0; i < 3; ++i) {
+    getline(in, buffer);
+    vector<string> bounds(split(buffer, ' '));
+    box.lo[i] = lexicalCast<double>(bounds.at(0));
+    box.hi[i] = lexicalCast<double>(bounds.at(1));
+    if (triclinic)
+      *tilts[i] = lexicalCast<double>(bounds.at(2));
+  }
+  if (!triclinic)
+    return;
+
+  box.lo[0] -= std::min(std::min(std::min(box.xy, box.xz), box.xy + box.xz),
+                        0.);
+  box.hi[0] -= std::max(std::max(std::max(box.xy, box.xz), box.xy + box.xz),
+                        0.);
+  box.lo[1] -= std::min(box.yz, 0.);
+  box.hi[1] -= std::max(box.yz, 0.);
+}
+} // namespace
+
 LammpsTrajectoryFormat::LammpsTrajectoryFormat() {}
 
 LammpsTrajectoryFormat::~LammpsTrajectoryFormat() {}
 
 bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
 {
-  size_t numAtoms = 0, timestep = 0, x_idx = -1, y_idx = -1, z_idx = -1,
-         type_idx = -1, id_idx = -1;
-  double x_min = 0, x_max = 0, y_min = 0, y_max = 0, z_min = 0, z_max = 0,
-         tilt_xy = 0, tilt_xz = 0, tilt_yz = 0, scale_x = 0., scale_y = 0.,
-         scale_z = 0.;
-
-  // This can likely be removed as it is clearly not used anywhere, suppress for
-  // now.
-  AVO_UNUSED(id_idx);
-
   string buffer;
   getline(inStream, buffer); // Finish the first line
   buffer = trimmed(buffer);
@@ -64,11 +102,83 @@ bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
     appendError("No timestep item found.");
     return false;
   }
-  getline(inStream, buffer);
-  if (!buffer.empty()) {
-    timestep = lexicalCast<size_t>(buffer);
-    mol.setTimeStep(timestep, 0);
+
+  size_t timestep = 0;
+  Array<Vector3> positions;
+  vector<short> types;
+  UnitCell* cell = nullptr;
+  if (!readSnapshot(inStream, timestep, positions, &types, &cell)) {
+    delete cell;
+    return false;
   }
+  mol.setTimeStep(timestep, 0);
+
+  typedef map<string, unsigned char> AtomTypeMap;
+  AtomTypeMap atomTypes;
+  unsigned char customElementCounter = CustomElementMin;
+
+  for (size_t i = 0; i < positions.size(); ++i) {
+    auto it = atomTypes.find(to_string(types[i]));
+    if (it == atomTypes.end()) {
+      atomTypes.insert(
+        std::make_pair(to_string(types[i]), customElementCounter++));
+      it = atomTypes.find(to_string(types[i]));
+      if (customElementCounter > CustomElementMax) {
+        appendError("Custom element type limit exceeded.");
+        delete cell;
+        return false;
+      }
+    }
+    Atom newAtom = mol.addAtom(it->second);
+    newAtom.setPosition3d(positions[i]);
+  }
+
+  // Set the custom element map if needed:
+  if (!atomTypes.empty()) {
+    Molecule::CustomElementMap elementMap;
+    for (const auto& atomType : atomTypes) {
+      elementMap.insert(std::make_pair(atomType.second, atomType.first));
+    }
+    mol.setCustomElementMap(elementMap);
+  }
+
+  mol.setCoordinate3d(mol.atomPositions3d(), 0);
+  mol.setFrameCell(cell->cellMatrix(), 0);
+  mol.setUnitCell(cell);
+
+  // Further snapshots are read on demand when the dump is a file, the box
+  // of each one is kept since it changes in constant pressure runs.
+  if (attachFrames(inStream, mol))
+    return true;
+
+  int coordSet = 1;
+  while (getline(inStream, buffer) && trimmed(buffer) == "ITEM: TIMESTEP") {
+    cell = nullptr;
+    if (!readSnapshot(inStream, timestep, positions, nullptr, &cell)) {
+      delete cell;
+      return false;
+    }
+    mol.setTimeStep(timestep, coordSet);
+    mol.setFrameCell(cell->cellMatrix(), coordSet);
+    delete cell;
+    mol.setCoordinate3d(positions, coordSet++);
+  }
+
+  return true;
+}
+
+bool LammpsTrajectoryFormat::readSnapshot(std::istream& inStream,
+                                          size_t& timestep,
+                                          Array<Vector3>& positions,
+                                          vector<short>* types,
+                                          UnitCell** cell)
+{
+  size_t numAtoms = 0, x_idx = -1, y_idx = -1, z_idx = -1, type_idx = -1;
+  double scale_x = 0., scale_y = 0., scale_z = 0.;
+
+  string buffer;
+  getline(inStream, buffer);
+  timestep = buffer.empty() ? 0 : lexicalCast<size_t>(buffer);
 
   getline(inStream, buffer);
   buffer = trimmed(buffer);
@@ -80,64 +190,17 @@ bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
   if (!buffer.empty())
     numAtoms = lexicalCast<size_t>(buffer);
 
-  // If unit cell is triclinic, tilt factors are needed to define the supercell
   getline(inStream, buffer);
-  if (buffer.find("ITEM: BOX BOUNDS xy xz yz") == 0) {
-    // Read x_min, x_max, tiltfactor_xy
-    getline(inStream, buffer);
-    vector<string> box_bounds_x(split(buffer, ' '));
-    x_min = lexicalCast<double>(box_bounds_x.at(0));
-    x_max = lexicalCast<double>(box_bounds_x.at(1));
-    tilt_xy = lexicalCast<double>(box_bounds_x.at(2));
-    // Read y_min, y_max, tiltfactor_xz
-    getline(inStream, buffer);
-    vector<string> box_bounds_y(split(buffer, ' '));
-    y_min = lexicalCast<double>(box_bounds_y.at(0));
-    y_max = lexicalCast<double>(box_bounds_y.at(1));
-    tilt_xz = lexicalCast<double>(box_bounds_y.at(2));
-    getline(inStream, buffer);
-    // Read z_min, z_max, tiltfactor_yz
-    vector<string> box_bounds_z(split(buffer, ' '));
-    z_min = lexicalCast<double>(box_bounds_z.at(0));
-    z_max = lexicalCast<double>(box_bounds_z.at(1));
-    tilt_yz = lexicalCast<double>(box_bounds_z.at(2));
-
-    x_min -= std::min(std::min(std::min(tilt_xy, tilt_xz), tilt_xy + tilt_xz),
-                      (double)0);
-    x_max -= std::max(std::max(std::max(tilt_xy, tilt_xz), tilt_xy + tilt_xz),
-                      (double)0);
-    y_min -= std::min(tilt_yz, (double)0);
-    y_max -= std::max(tilt_yz, (double)0);
-  }
-
-  // Else if unit cell is orthogonal, tilt factors are zero
-  else if (buffer.find("ITEM: BOX BOUNDS") == 0) {
-    // Read x_min, x_max
-    getline(inStream, buffer);
-    vector<string> box_bounds_x(split(buffer, ' '));
-    x_min = lexicalCast<double>(box_bounds_x.at(0));
-    x_max = lexicalCast<double>(box_bounds_x.at(1));
-    // Read y_min, y_max
-    getline(inStream, buffer);
-    vector<string> box_bounds_y(split(buffer, ' '));
-    y_min = lexicalCast<double>(box_bounds_y.at(0));
-    y_max = lexicalCast<double>(box_bounds_y.at(1));
-    // Read z_min, z_max
+  Box box;
+  if (buffer.find("ITEM: BOX BOUNDS") == 0) {
+    readBox(inStream, buffer, box);
     getline(inStream, buffer);
-    vector<string> box_bounds_z(split(buffer, ' '));
-    z_min = lexicalCast<double>(box_bounds_z.at(0));
-    z_max = lexicalCast<double>(box_bounds_z.at(1));
   }
 
-  typedef map<string, unsigned char> AtomTypeMap;
-  AtomTypeMap atomTypes;
-  unsigned char customElementCounter = CustomElementMin;
-
   // x,y,z stand for the coordinate axes
   // s stands for scaled coordinates
   // u stands for unwrapped coordinates
   // scale_x = 0. if coordinates are cartesian and 1 if fractional (scaled)
-  getline(inStream, buffer);
   vector<string> labels(split(buffer, ' '));
   for (size_t i = 0; i < labels.size(); i++) {
     if (labels[i] == "x" || labels[i] == "xu") {
@@ -160,229 +223,94 @@ bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
       scale_z = 1.;
     } else if (labels[i] == "type") {
       type_idx = i;
-    } else if (labels[i] == "id") {
-      id_idx = i;
     }
   }
 
   // Parse atoms
+  positions.clear();
+  positions.reserve(numAtoms);
+  vector<std::string_view> tokens;
   for (size_t i = 0; i < numAtoms; ++i) {
     getline(inStream, buffer);
-    vector<string> tokens(split(buffer, ' '));
+    split(buffer, ' ', tokens);
 
     if (tokens.size() < labels.size() - 2) {
-      appendError("Not enough tokens in this line: " + buffer);
+      std::ostringstream errorStream;
+      errorStream << "Error parsing atom at index " << i << ".\n"
+                  << "Not enough tokens in this line: " << buffer;
+      appendError(errorStream.str());
       return false;
     }
 
-    unsigned char atomicNum(0);
-    atomicNum = lexicalCast<short int>(tokens[type_idx - 2]);
+    if (types != nullptr)
+      types->push_back(lexicalCast<short int>(tokens[type_idx - 2]));
 
     // If parsed coordinates are fractional, the corresponding unscaling is
     // done. Else the positions are assigned as parsed.
-    Vector3 pos((1 - scale_x) * lexicalCast<double>(tokens[x_idx - 2]) +
-                  scale_x * (x_min + (x_max - x_min) *
-                                       lexicalCast<double>(tokens[x_idx - 2])),
-                (1 - scale_y) * lexicalCast<double>(tokens[y_idx - 2]) +
-                  scale_y * (y_min + (y_max - y_min) *
-                                       lexicalCast<double>(tokens[y_idx - 2])),
-                (1 - scale_z) * lexicalCast<double>(tokens[z_idx - 2]) +
-                  scale_z * (z_min + (z_max - z_min) *
-                                       lexicalCast<double>(tokens[z_idx - 2])));
-
-    auto it = atomTypes.find(to_string(atomicNum));
-    if (it == atomTypes.end()) {
-      atomTypes.insert(
-        std::make_pair(to_string(atomicNum), customElementCounter++));
-      it = atomTypes.find(to_string(atomicNum));
-      if (customElementCounter > CustomElementMax) {
-        appendError("Custom element type limit exceeded.");
-        return false;
-      }
-    }
-    Atom newAtom = mol.addAtom(it->second);
-    newAtom.setPosition3d(pos);
-  }
-
-  // Set the custom element map if needed:
-  if (!atomTypes.empty()) {
-    Molecule::CustomElementMap elementMap;
-    for (const auto& atomType : atomTypes) {
-      elementMap.insert(std::make_pair(atomType.second, atomType.first));
-    }
-    mol.setCustomElementMap(elementMap);
+    const double x = lexicalCast<double>(tokens[x_idx - 2]);
+    const double y = lexicalCast<double>(tokens[y_idx - 2]);
+    const double z = lexicalCast<double>(tokens[z_idx - 2]);
+    Vector3 pos(
+      (1 - scale_x) * x + scale_x * (box.lo[0] + (box.hi[0] - box.lo[0]) * x),
+      (1 - scale_y) * y + scale_y * (box.lo[1] + (box.hi[1] - box.lo[1]) * y),
+      (1 - scale_z) * z + scale_z * (box.lo[2] + (box.hi[2] - box.lo[2]) * z));
+    positions.push_back(pos);
   }
 
-  // Check that all atoms were handled.
-  if (mol.atomCount() != numAtoms) {
-    std::ostringstream errorStream;
-    errorStream << "Error parsing atom at index " << mol.atomCount()
-                << " (line " << 10 + mol.atomCount() << ").\n"
-                << buffer;
-    appendError(errorStream.str());
-    return false;
-  }
-  mol.setCoordinate3d(mol.atomPositions3d(), 0);
-  mol.setUnitCell(new UnitCell(Vector3(x_max - x_min, 0, 0),
-                               Vector3(tilt_xy, y_max - y_min, 0),
-                               Vector3(tilt_xz, tilt_yz, z_max - z_min)));
-
-  // Do we have an animation?
-  size_t numAtoms2;
-  int coordSet = 1;
-  while (getline(inStream, buffer) && trimmed(buffer) == "ITEM: TIMESTEP") {
-    x_idx = -1;
-    y_idx = -1;
-    z_idx = -1;
-    type_idx = -1;
-    id_idx = -1;
-    x_min = 0;
-    x_max = 0;
-    y_min = 0;
-    y_max = 0;
-    z_min = 0;
-    z_max = 0;
-    tilt_xy = 0;
-    tilt_xz = 0;
-    tilt_yz = 0;
-    scale_x = 0.;
-    scale_y = 0.;
-    scale_z = 0.;
-
-    getline(inStream, buffer);
-    if (!buffer.empty()) {
-      timestep = lexicalCast<size_t>(buffer);
-      mol.setTimeStep(timestep, coordSet);
-    }
-
-    getline(inStream, buffer);
-    buffer = trimmed(buffer);
-    if (buffer != "ITEM: NUMBER OF ATOMS") {
-      appendError("No number of atoms item found.");
-      return false;
-    }
-    getline(inStream, buffer);
-    if (!buffer.empty())
-      numAtoms2 = lexicalCast<size_t>(buffer);
-
-    if (numAtoms2 != numAtoms) {
-      appendError("Number of atoms isn't constant in the trajectory.");
-    }
-
-    // If unit cell is triclinic, tilt factors are needed to define the
-    // supercell
-    getline(inStream, buffer);
-    if (buffer.find("ITEM: BOX BOUNDS xy xz yz") == 0) {
-      // Read x_min, x_max, tiltfactor_xy
-      getline(inStream, buffer);
-      vector<string> box_bounds_x(split(buffer, ' '));
-      x_min = lexicalCast<double>(box_bounds_x.at(0));
-      x_max = lexicalCast<double>(box_bounds_x.at(1));
-      tilt_xy = lexicalCast<double>(box_bounds_x.at(2));
-      // Read y_min, y_max, tiltfactor_xz
-      getline(inStream, buffer);
-      vector<string> box_bounds_y(split(buffer, ' '));
-      y_min = lexicalCast<double>(box_bounds_y.at(0));
-      y_max = lexicalCast<double>(box_bounds_y.at(1));
-      tilt_xz = lexicalCast<double>(box_bounds_y.at(2));
-      getline(inStream, buffer);
-      // Read z_min, z_max, tiltfactor_yz
-      vector<string> box_bounds_z(split(buffer, ' '));
-      z_min = lexicalCast<double>(box_bounds_z.at(0));
-      z_max = lexicalCast<double>(box_bounds_z.at(1));
-      tilt_yz = lexicalCast<double>(box_bounds_z.at(2));
-
-      x_min -= std::min(std::min(std::min(tilt_xy, tilt_xz), tilt_xy + tilt_xz),
-                        (double)0);
-      x_max -= std::max(std::max(std::max(tilt_xy, tilt_xz), tilt_xy + tilt_xz),
-                        (double)0);
-      y_min -= std::min(tilt_yz, (double)0);
-      y_max -= std::max(tilt_yz, (double)0);
-    }
-
-    // Else if unit cell is orthogonal, tilt factors are zero
-    else if (buffer.find("ITEM: BOX BOUNDS") == 0) {
-      // Read x_min, x_max
-      getline(inStream, buffer);
-      vector<string> box_bounds_x(split(buffer, ' '));
-      x_min = lexicalCast<double>(box_bounds_x.at(0));
-      x_max = lexicalCast<double>(box_bounds_x.at(1));
-      // Read y_min, y_max
-      getline(inStream, buffer);
-      vector<string> box_bounds_y(split(buffer, ' '));
-      y_min = lexicalCast<double>(box_bounds_y.at(0));
-      y_max = lexicalCast<double>(box_bounds_y.at(1));
-      // Read z_min, z_max
-      getline(inStream, buffer);
-      vector<string> box_bounds_z(split(buffer, ' '));
-      z_min = lexicalCast<double>(box_bounds_z.at(0));
-      z_max = lexicalCast<double>(box_bounds_z.at(1));
-    }
-
-    // x,y,z stand for the coordinate axes
-    // s stands for scaled coordinates
-    // u stands for unwrapped coordinates
-    // scale_x = 0. if coordinates are cartesian and 1 if fractional (scaled)
-    getline(inStream, buffer);
-    labels = vector<string>(split(buffer, ' '));
-    for (size_t i = 0; i < labels.size(); ++i) {
-      if (labels[i] == "x" || labels[i] == "xu") {
-        x_idx = i;
-        scale_x = 0.;
-      } else if (labels[i] == "xs" || labels[i] == "xsu") {
-        x_idx = i;
-        scale_x = 1.;
-      } else if (labels[i] == "y" || labels[i] == "yu") {
-        y_idx = i;
-        scale_y = 0.;
-      } else if (labels[i] == "ys" || labels[i] == "ysu") {
-        y_idx = i;
-        scale_y = 1.;
-      } else if (labels[i] == "z" || labels[i] == "zu") {
-        z_idx = i;
-        scale_z = 0.;
-      } else if (labels[i] == "zs" || labels[i] == "zsu") {
-        z_idx = i;
-        scale_z = 1.;
-      } else if (labels[i] == "type") {
-        type_idx = i;
-      } else if (labels[i] == "id") {
-        id_idx = i;
-      }
-    }
-
-    Array<Vector3> positions;
-    positions.reserve(numAtoms);
+  if (cell != nullptr)
+    *cell = new UnitCell(box.cellMatrix());
+  return true;
+}
 
-    for (size_t i = 0; i < numAtoms; ++i) {
-      getline(inStream, buffer);
-      vector<string> tokens(split(buffer, ' '));
-      if (tokens.size() < 5) {
-        appendError("Not enough tokens in this line: " + buffer);
-        return false;
-      }
-      // If parsed coordinates are fractional, the corresponding unscaling is
-      // done. Else the positions are assigned as parsed.
-      Vector3 pos(
-        (1 - scale_x) * lexicalCast<double>(tokens[x_idx - 2]) +
-          scale_x *
-            (x_min + (x_max - x_min) * lexicalCast<double>(tokens[x_idx - 2])),
-        (1 - scale_y) * lexicalCast<double>(tokens[y_idx - 2]) +
-          scale_y *
-            (y_min + (y_max - y_min) * lexicalCast<double>(tokens[y_idx - 2])),
-        (1 - scale_z) * lexicalCast<double>(tokens[z_idx - 2]) +
-          scale_z *
-            (z_min + (z_max - z_min) * lexicalCast<double>(tokens[z_idx - 2])));
-      positions.push_back(pos);
+bool LammpsTrajectoryFormat::indexFrames(
+  std::istream& in, std::vector<std::streamoff>& offsets,
+  std::vector<double>& times, std::vector<Matrix3>& cells)
+{
+  string buffer;
+  for (;;) {
+    const std::streamoff start = in.tellg();
+    if (!getline(in, buffer) || trimmed(buffer) != "ITEM: TIMESTEP")
+      break;
+    getline(in, buffer);
+    const double timestep = lexicalCast<double>(trimmed(buffer));
+    getline(in, buffer);
+    if (trimmed(buffer) != "ITEM: NUMBER OF ATOMS")
+      break;
+    getline(in, buffer);
+    bool ok = false;
+    const auto numAtoms = lexicalCast<size_t>(trimmed(buffer), ok);
+    if (!ok)
+      break;
+
+    // keep the box, which may be missing, and skip the atoms
+    getline(in, buffer);
+    Matrix3 cell = Matrix3::Zero();
+    if (buffer.find("ITEM: BOX BOUNDS") == 0) {
+      Box box;
+      readBox(in, buffer, box);
+      cell = box.cellMatrix();
+      getline(in, buffer);
     }
-
-    mol.setCoordinate3d(positions, coordSet++);
-    mol.setUnitCell(new UnitCell(Vector3(x_max - x_min, 0, 0),
-                                 Vector3(tilt_xy, y_max - y_min, 0),
-                                 Vector3(tilt_xz, tilt_yz, z_max - z_min)));
+    if (buffer.find("ITEM: ATOMS") != 0)
+      break;
+    for (size_t i = 0; i < numAtoms; ++i)
+      in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    if (in.fail())
+      break;
+    offsets.push_back(start);
+    times.push_back(timestep);
+    cells.push_back(cell);
   }
+  return !offsets.empty();
+}
 
-  return true;
+bool LammpsTrajectoryFormat::readFramePositions(std::istream& in,
+                                                Array<Vector3>& positions)
+{
+  string buffer;
+  size_t timestep;
+  getline(in, buffer); // ITEM: TIMESTEP
+  return readSnapshot(in, timestep, positions, nullptr, nullptr);
 }
 
 bool LammpsTrajectoryFormat::write(std::ostream&, const Core::Molecule&)
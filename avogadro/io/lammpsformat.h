@@ -9,6 +9,9 @@
 #include "fileformat.h"
 
 namespace Avogadro {
+namespace Core {
+class UnitCell;
+}
 namespace Io {
 
 /**
@@ -52,6 +55,22 @@ public:
 
   bool read(std::istream& inStream, Core::Molecule& molecule) override;
   bool write(std::ostream& outStream, const Core::Molecule& molecule) override;
+
+protected:
+  bool indexFrames(std::istream& in, std::vector<std::streamoff>& offsets,
+                   std::vector<double>& times,
+                   std::vector<Matrix3>& cells) override;
+  bool readFramePositions(std::istream& in,
+                          Core::Array<Vector3>& positions) override;
+
+private:
+  /**
+   * Read the snapshot following an "ITEM: TIMESTEP" line. The atom types are
+   * returned in @p types and a new unit cell in @p cell, unless they are null.
+   */
+  bool readSnapshot(std::istream& inStream, size_t& timestep,
+                    Core::Array<Vector3>& positions, std::vector<short>* types,
+                    Core::UnitCell** cell);
 };
 
 class AVOGADROIO_EXPORT LammpsDataFormat : public FileFormat
@@ -0,0 +1,63 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "linereader.h"
+
+#include <algorithm>
+
+namespace Avogadro::Io {
+
+LineReader::LineReader(std::istream& in, size_t chunkSize)
+  : m_in(in), m_chunkSize(chunkSize > 0 ? chunkSize : 1),
+    m_readSize(std::min<size_t>(m_chunkSize, 64 << 10)), m_used(0),
+    m_end(false)
+{
+}
+
+bool LineReader::next(std::vector<std::string_view>& lines, size_t keep)
+{
+  size_t start = m_used;
+  if (keep < lines.size())
+    start = static_cast<size_t>(lines[keep].data() - m_buffer.data());
+  lines.clear();
+
+  // keep the unused lines and any partial line after them
+  m_buffer.erase(0, start);
+  const size_t kept = m_used - start;
+
+  // read until the new data completes at least one line
+  size_t end = kept;
+  while (!m_end) {
+    const size_t size = m_buffer.size();
+    m_buffer.resize(size + m_readSize);
+    m_in.read(&m_buffer[size], static_cast<std::streamsize>(m_readSize));
+    const auto count = static_cast<size_t>(m_in.gcount());
+    m_buffer.resize(size + count);
+    if (count < m_readSize)
+      m_end = true;
+    m_readSize = std::min(2 * m_readSize, m_chunkSize);
+
+    const size_t newline = m_buffer.rfind('\n');
+    if (newline != std::string::npos && newline >= kept) {
+      end = newline + 1;
+      break;
+    }
+  }
+  // the last line does not need a newline
+  if (m_end)
+    end = m_buffer.size();
+
+  for (size_t pos = 0; pos < end;) {
+    size_t newline = m_buffer.find('\n', pos);
+    if (newline == std::string::npos || newline >= end)
+      newline = end;
+    lines.emplace_back(m_buffer.data() + pos, newline - pos);
+    pos = newline + 1;
+  }
+  m_used = end;
+  return end > kept;
+}
+
+} // namespace Avogadro::Io
@@ -0,0 +1,65 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_IO_LINEREADER_H
+#define AVOGADRO_IO_LINEREADER_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Avogadro {
+namespace Io {
+
+/**
+ * @class LineReader linereader.h
+ * @brief Reads a text stream in large chunks of whole lines.
+ *
+ * The lines of a chunk are views into one buffer, so that they can be parsed
+ * by several threads at once instead of one std::getline call at a time.
+ * Lines are split exactly like std::getline does: the newline is removed,
+ * a carriage return is kept and the last line may lack a newline. This is an
+ * internal class of the IO library.
+ */
+class LineReader
+{
+public:
+  static const size_t DefaultChunkSize = 16 << 20;
+
+  /**
+   * Read from @p in in chunks of up to @p chunkSize bytes. Reads start small
+   * and grow, so that short inputs do not pay for a large buffer.
+   */
+  explicit LineReader(std::istream& in, size_t chunkSize = DefaultChunkSize);
+
+  /**
+   * Replace @p lines with the lines of the next chunk of the stream.
+   * @param keep Lines of the previous chunk from this index onwards were not
+   * used yet, e.g. an incomplete frame, and are returned again at the start
+   * of the new chunk.
+   * @return False if no new lines could be read, and then @p lines only
+   * holds the kept lines. The views are valid until the next call.
+   */
+  bool next(std::vector<std::string_view>& lines,
+            size_t keep = std::string::npos);
+
+  /** @return True once the whole stream has been read. */
+  bool atEnd() const { return m_end; }
+
+private:
+  std::istream& m_in;
+  size_t m_chunkSize;
+  size_t m_readSize;
+  std::string m_buffer;
+  size_t m_used;
+  bool m_end;
+};
+
+} // namespace Io
+} // namespace Avogadro
+
+#endif // AVOGADRO_IO_LINEREADER_H
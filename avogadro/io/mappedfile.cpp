@@ -0,0 +1,140 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Avogadro::Io {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+  : m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+{
+}
+
+bool MappedFile::open(const std::string& fileName)
+{
+  close();
+  m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                       nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+    close();
+    return false;
+  }
+  m_mapping =
+    CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping == nullptr) {
+    close();
+    return false;
+  }
+  m_data = static_cast<const char*>(
+    MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (m_data == nullptr) {
+    close();
+    return false;
+  }
+  m_size = static_cast<size_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (m_data != nullptr)
+    UnmapViewOfFile(m_data);
+  if (m_mapping != nullptr)
+    CloseHandle(m_mapping);
+  if (m_file != INVALID_HANDLE_VALUE)
+    CloseHandle(m_file);
+  m_data = nullptr;
+  m_size = 0;
+  m_mapping = nullptr;
+  m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0) {}
+
+bool MappedFile::open(const std::string& fileName)
+{
+  close();
+  const int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                    MAP_PRIVATE, fd, 0);
+  // the mapping stays valid once the descriptor is closed
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return false;
+
+  m_data = static_cast<const char*>(data);
+  m_size = static_cast<size_t>(info.st_size);
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (m_data != nullptr)
+    munmap(const_cast<char*>(m_data), m_size);
+  m_data = nullptr;
+  m_size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+MemoryBuffer::MemoryBuffer(const char* begin, const char* end)
+{
+  // the buffer is only ever read from
+  setg(const_cast<char*>(begin), const_cast<char*>(begin),
+       const_cast<char*>(end));
+}
+
+MemoryBuffer::pos_type MemoryBuffer::seekoff(off_type offset,
+                                             std::ios_base::seekdir dir,
+                                             std::ios_base::openmode)
+{
+  char* target = egptr() + offset;
+  if (dir == std::ios_base::beg)
+    target = eback() + offset;
+  else if (dir == std::ios_base::cur)
+    target = gptr() + offset;
+  if (target < eback() || target > egptr())
+    return pos_type(off_type(-1));
+  setg(eback(), target, egptr());
+  return pos_type(target - eback());
+}
+
+MemoryBuffer::pos_type MemoryBuffer::seekpos(pos_type position,
+                                             std::ios_base::openmode which)
+{
+  return seekoff(off_type(position), std::ios_base::beg, which);
+}
+
+} // namespace Avogadro::Io
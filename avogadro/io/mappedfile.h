@@ -0,0 +1,78 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_IO_MAPPEDFILE_H
+#define AVOGADRO_IO_MAPPEDFILE_H
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+
+namespace Avogadro {
+namespace Io {
+
+/**
+ * @class MappedFile mappedfile.h
+ * @brief A read-only memory mapping of a whole file.
+ *
+ * The operating system pages the file in as it is accessed, so large
+ * trajectories can be read at random without copying them into memory
+ * first. This is an internal class of the IO library.
+ */
+class MappedFile
+{
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * Map @p fileName, unmapping any previous file.
+   * @return False if the file could not be mapped, e.g. it is empty.
+   */
+  bool open(const std::string& fileName);
+
+  /** Unmap the file. */
+  void close();
+
+  bool isOpen() const { return m_data != nullptr; }
+
+  /** @return The start of the file contents, or null if not open. */
+  const char* data() const { return m_data; }
+
+  /** @return The size of the file in bytes. */
+  size_t size() const { return m_size; }
+
+private:
+  const char* m_data;
+  size_t m_size;
+#ifdef _WIN32
+  void* m_file;
+  void* m_mapping;
+#endif
+};
+
+/**
+ * @class MemoryBuffer mappedfile.h
+ * @brief A stream buffer reading from a range of memory in place, such as
+ * part of a MappedFile.
+ */
+class MemoryBuffer : public std::streambuf
+{
+public:
+  MemoryBuffer(const char* begin, const char* end);
+
+protected:
+  pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override;
+  pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+};
+
+} // namespace Io
+} // namespace Avogadro
+
+#endif // AVOGADRO_IO_MAPPEDFILE_H
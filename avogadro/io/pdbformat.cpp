@@ -5,18 +5,24 @@
 
 #include "pdbformat.h"
 
+#include "linereader.h"
+
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/parallel.h>
 #include <avogadro/core/residue.h>
 #include <avogadro/core/secondarystructure.h>
 #include <avogadro/core/unitcell.h>
 #include <avogadro/core/utilities.h>
 #include <avogadro/core/vector.h>
 
+#include <nlohmann/json.hpp>
+
 #include <cctype>
 #include <iostream>
 #include <istream>
 #include <string>
+#include <string_view>
 
 using Avogadro::Core::Array;
 using Avogadro::Core::Atom;
@@ -29,6 +35,8 @@ using Avogadro::Core::startsWith;
 using Avogadro::Core::trimmed;
 using Avogadro::Core::UnitCell;
 
+using json = nlohmann::json;
+
 using std::getline;
 using std::istringstream;
 using std::string;
@@ -36,12 +44,81 @@ using std::vector;
 
 namespace Avogadro::Io {
 
+namespace {
+// The fields of an ATOM or HETATM record that do not depend on the records
+// before it, so that they can be parsed in parallel.
+struct AtomRecord
+{
+  Vector3 position;
+  size_t residueId = 0;
+  bool residueIdOk = false;
+  int badCoordinate = -1;
+  bool badElementColumn = false;
+  unsigned char atomicNumber = 255;
+};
+
+bool isAtomRecord(std::string_view line)
+{
+  return line.substr(0, 4) == "ATOM" || line.substr(0, 6) == "HETATM";
+}
+
+// A fixed width field, empty if the line is too short.
+std::string_view column(std::string_view line, size_t start, size_t width)
+{
+  return start < line.size() ? line.substr(start, width) : std::string_view();
+}
+
+void parseAtomRecord(std::string_view line, AtomRecord& record)
+{
+  record.residueId =
+    lexicalCast<size_t>(column(line, 22, 4), record.residueIdOk);
+  record.badCoordinate = -1;
+  for (int i = 0; i < 3; ++i) {
+    bool ok = false;
+    record.position[i] = lexicalCast<Real>(column(line, 30 + 8 * i, 8), ok);
+    if (!ok && record.badCoordinate < 0)
+      record.badCoordinate = i;
+  }
+
+  string element; // Element symbol, right justified
+  record.atomicNumber = 255;
+  record.badElementColumn = false;
+  if (line.size() >= 78) {
+    element = trimmed(string(line.substr(76, 2)));
+    if (element == "SE") // For Sulphur
+      element = 'S';
+    if (element.length() == 2)
+      element[1] = std::tolower(element[1]);
+
+    record.atomicNumber = Elements::atomicNumberFromSymbol(element);
+    record.badElementColumn = record.atomicNumber == 255;
+  }
+
+  if (record.atomicNumber == 255) {
+    // non-standard or old-school PDB file - try to parse the atom name
+    element = lexicalCast<string>(column(line, 12, 4));
+    // remove any trailing digits
+    while (element.size() && std::isdigit(element.back()))
+      element.pop_back();
+
+    record.atomicNumber = Elements::atomicNumberFromSymbol(element);
+  }
+}
+} // namespace
+
 PdbFormat::PdbFormat() {}
 
 PdbFormat::~PdbFormat() {}
 
 bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
 {
+  json opts;
+  if (!options().empty())
+    opts = json::parse(options(), nullptr, false);
+  else
+    opts = json::object();
+  const bool parallel = opts.value("parallel", true);
+
   string buffer;
   std::vector<int> terList;
   Residue* r = nullptr;
@@ -56,7 +133,36 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
   std::set<char> altLocs;
   Array<Vector3> altAtomPositions;
 
-  while (getline(in, buffer)) { // Read Each line one by one
+  // The file is read in chunks of lines. The atom records of each chunk are
+  // parsed first, in parallel, and then its lines are processed in order.
+  LineReader reader(in);
+  vector<std::string_view> lines;
+  vector<AtomRecord> records;
+  size_t lineIndex = 0;
+  auto nextLine = [&]() {
+    if (++lineIndex < lines.size())
+      return true;
+    if (!reader.next(lines))
+      return false;
+    lineIndex = 0;
+    records.resize(lines.size());
+    auto parseRecords = [&](Index begin, Index end) {
+      for (Index i = begin; i < end; ++i) {
+        if (isAtomRecord(lines[i]))
+          parseAtomRecord(lines[i], records[i]);
+      }
+    };
+    if (parallel)
+      Core::parallelFor(0, lines.size(), 1024, parseRecords);
+    else
+      parseRecords(0, lines.size());
+    return true;
+  };
+
+  while (nextLine()) { // Read Each line one by one
+    buffer.assign(lines[lineIndex]);
+    // fields are parsed from views of the line rather than copies
+    const std::string_view line(buffer);
 
     if (startsWith(buffer, "ENDMDL")) {
       if (coordSet == 0) {
@@ -73,36 +179,38 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
     else if (startsWith(buffer, "CRYST1")) {
       // PDB reports in degrees and Angstroms
       //   Avogadro uses radians internally
-      Real a = lexicalCast<Real>(buffer.substr(6, 9), ok);
-      Real b = lexicalCast<Real>(buffer.substr(15, 9), ok);
-      Real c = lexicalCast<Real>(buffer.substr(24, 9), ok);
-      Real alpha = lexicalCast<Real>(buffer.substr(33, 7), ok) * DEG_TO_RAD;
-      Real beta = lexicalCast<Real>(buffer.substr(40, 7), ok) * DEG_TO_RAD;
-      Real gamma = lexicalCast<Real>(buffer.substr(47, 8), ok) * DEG_TO_RAD;
+      Real a = lexicalCast<Real>(line.substr(6, 9), ok);
+      Real b = lexicalCast<Real>(line.substr(15, 9), ok);
+      Real c = lexicalCast<Real>(line.substr(24, 9), ok);
+      Real alpha = lexicalCast<Real>(line.substr(33, 7), ok) * DEG_TO_RAD;
+      Real beta = lexicalCast<Real>(line.substr(40, 7), ok) * DEG_TO_RAD;
+      Real gamma = lexicalCast<Real>(line.substr(47, 8), ok) * DEG_TO_RAD;
 
       auto* cell = new Core::UnitCell(a, b, c, alpha, beta, gamma);
       mol.setUnitCell(cell);
     }
 
     else if (startsWith(buffer, "ATOM") || startsWith(buffer, "HETATM")) {
+      const AtomRecord& record = records[lineIndex];
       // First we initialize the residue instance
-      auto residueId = lexicalCast<size_t>(buffer.substr(22, 4), ok);
-      if (!ok) {
+      if (!record.residueIdOk) {
         appendError("Failed to parse residue sequence number: " +
-                    buffer.substr(22, 4));
+                    string(column(line, 22, 4)));
         return false;
       }
+      const size_t residueId = record.residueId;
 
       if (residueId != currentResidueId) {
         currentResidueId = residueId;
 
-        auto residueName = lexicalCast<string>(buffer.substr(17, 3), ok);
+        auto residueName = lexicalCast<string>(column(line, 17, 3), ok);
         if (!ok) {
-          appendError("Failed to parse residue name: " + buffer.substr(17, 3));
+          appendError("Failed to parse residue name: " +
+                      string(column(line, 17, 3)));
           return false;
         }
 
-        char chainId = lexicalCast<char>(buffer.substr(21, 1), ok);
+        char chainId = lexicalCast<char>(column(line, 21, 1), ok);
         if (!ok) {
           chainId = 'A'; // it's a non-standard "PDB"-like file
         }
@@ -112,60 +220,30 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
           r->setHeterogen(true);
       }
 
-      auto atomName = lexicalCast<string>(buffer.substr(12, 4), ok);
-      if (!ok) {
-        appendError("Failed to parse atom name: " + buffer.substr(12, 4));
-        return false;
-      }
-
-      Vector3 pos; // Coordinates
-      pos.x() = lexicalCast<Real>(buffer.substr(30, 8), ok);
+      auto atomName = lexicalCast<string>(column(line, 12, 4), ok);
       if (!ok) {
-        appendError("Failed to parse x coordinate: " + buffer.substr(30, 8));
+        appendError("Failed to parse atom name: " +
+                    string(column(line, 12, 4)));
         return false;
       }
 
-      pos.y() = lexicalCast<Real>(buffer.substr(38, 8), ok);
-      if (!ok) {
-        appendError("Failed to parse y coordinate: " + buffer.substr(38, 8));
-        return false;
-      }
-
-      pos.z() = lexicalCast<Real>(buffer.substr(46, 8), ok);
-      if (!ok) {
-        appendError("Failed to parse z coordinate: " + buffer.substr(46, 8));
+      // Coordinates and element were parsed with the rest of the chunk
+      if (record.badCoordinate >= 0) {
+        const char axis = static_cast<char>('x' + record.badCoordinate);
+        appendError(string("Failed to parse ") + axis + " coordinate: " +
+                    string(column(line, 30 + 8 * record.badCoordinate, 8)));
         return false;
       }
+      const Vector3 pos = record.position;
 
-      auto altLoc = lexicalCast<string>(buffer.substr(16, 1), ok);
-
-      string element; // Element symbol, right justified
-      unsigned char atomicNum = 255;
-      if (buffer.size() >= 78) {
-        element = buffer.substr(76, 2);
-        element = trimmed(element);
-        if (element == "SE") // For Sulphur
-          element = 'S';
-        if (element.length() == 2)
-          element[1] = std::tolower(element[1]);
-
-        atomicNum = Elements::atomicNumberFromSymbol(element);
-        if (atomicNum == 255)
-          appendError("Invalid element");
-      }
+      auto altLoc = lexicalCast<string>(column(line, 16, 1), ok);
 
+      if (record.badElementColumn)
+        appendError("Invalid element");
+      const unsigned char atomicNum = record.atomicNumber;
       if (atomicNum == 255) {
-        // non-standard or old-school PDB file - try to parse the atom name
-        element = trimmed(atomName);
-        // remove any trailing digits
-        while (element.size() && std::isdigit(element.back()))
-          element.pop_back();
-
-        atomicNum = Elements::atomicNumberFromSymbol(element);
-        if (atomicNum == 255) {
-          appendError("Invalid element");
-          continue; // skip this invalid record
-        }
+        appendError("Invalid element");
+        continue; // skip this invalid record
       }
 
       if (altLoc.compare("") && altLoc.compare("A")) {
@@ -194,7 +272,7 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
     else if (startsWith(buffer, "TER")) { //  This is very important, each TER
                                           //  record also counts in the serial.
       // Need to account for that when comparing with CONECT
-      terList.push_back(lexicalCast<int>(buffer.substr(6, 5), ok));
+      terList.push_back(lexicalCast<int>(line.substr(6, 5), ok));
 
       if (!ok) {
         appendError("Failed to parse TER serial");
@@ -203,7 +281,7 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
     }
 
     else if (startsWith(buffer, "CONECT")) {
-      int a = lexicalCast<int>(buffer.substr(6, 5), ok);
+      int a = lexicalCast<int>(line.substr(6, 5), ok);
       if (!ok) {
         appendError("Failed to parse bond connection a " + buffer.substr(6, 5));
         return false;
@@ -222,7 +300,7 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
           break;
 
         else {
-          int b = lexicalCast<int>(buffer.substr(bCoords[i], 5), ok) - 1;
+          int b = lexicalCast<int>(line.substr(bCoords[i], 5), ok) - 1;
           if (!ok) {
             appendError("Failed to parse bond connection b" +
                         std::to_string(i) + " " + buffer.substr(bCoords[i], 5));
@@ -262,14 +340,21 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
     }
   }
 
+  if (!deferDerivedData())
+    completeRead(mol);
+
+  return true;
+} // End read
+
+bool PdbFormat::completeRead(Core::Molecule& mol)
+{
   mol.perceiveBondsSimple();
   mol.perceiveBondsFromResidueData();
   perceiveSubstitutedCations(mol);
   SecondaryStructureAssigner ssa;
   ssa.assign(&mol);
-
   return true;
-} // End read
+}
 
 std::vector<std::string> PdbFormat::fileExtensions() const
 {
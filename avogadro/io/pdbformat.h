@@ -15,6 +15,8 @@ namespace Io {
  * @class PdbFormat pdbformat.h <avogadro/io/pdbformat.h>
  * @brief Parser for the PDB format.
  * @author Tanuj Kumar
+ *
+ * Atom records are parsed in parallel unless the "parallel" option is false.
  */
 
 class AVOGADROIO_EXPORT PdbFormat : public FileFormat
@@ -53,6 +55,12 @@ public:
     return false;
   }
 
+  /**
+   * Perceive bonds within and between residues, and assign the secondary
+   * structure.
+   */
+  bool completeRead(Core::Molecule& molecule) override;
+
   void perceiveSubstitutedCations(Core::Molecule& molecule);
 };
 
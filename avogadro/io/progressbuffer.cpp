@@ -0,0 +1,133 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "progressbuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Avogadro::Io {
+
+namespace {
+// Large enough to keep the overhead per refill negligible, small enough to
+// report progress and notice cancellation often.
+const size_t bufferSize = 64 << 10;
+// Characters kept from the previous refill, so that they can be put back.
+const size_t putbackSize = 8;
+} // namespace
+
+ProgressBuffer::ProgressBuffer(std::streambuf* source, const Callback& callback,
+                               const std::atomic<bool>& canceled)
+  : m_source(source), m_callback(callback), m_canceled(canceled),
+    m_buffer(putbackSize + bufferSize), m_start(0), m_size(-1), m_read(0)
+{
+  // find the size of the rest of the stream, if it can seek
+  const auto start = m_source->pubseekoff(0, std::ios_base::cur,
+                                          std::ios_base::in);
+  if (start != std::streampos(-1)) {
+    const auto end = m_source->pubseekoff(0, std::ios_base::end,
+                                          std::ios_base::in);
+    if (end != std::streampos(-1))
+      m_size = static_cast<std::streamoff>(end - start);
+    m_source->pubseekpos(start, std::ios_base::in);
+    m_start = static_cast<std::streamoff>(start);
+  }
+  discard();
+}
+
+ProgressBuffer::~ProgressBuffer()
+{
+  if (gptr() < egptr())
+    m_source->pubseekoff(gptr() - egptr(), std::ios_base::cur,
+                         std::ios_base::in);
+}
+
+ProgressBuffer::int_type ProgressBuffer::underflow()
+{
+  if (gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+  if (m_canceled)
+    return traits_type::eof();
+
+  char* const begin = m_buffer.data() + putbackSize;
+  const auto kept =
+    std::min<size_t>(putbackSize, static_cast<size_t>(gptr() - eback()));
+  if (kept > 0)
+    std::memmove(begin - kept, gptr() - kept, kept);
+
+  const std::streamsize count = m_source->sgetn(begin, bufferSize);
+  if (count <= 0)
+    return traits_type::eof();
+  setg(begin - kept, begin, begin + count);
+  report(count);
+  return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize ProgressBuffer::xsgetn(char_type* data, std::streamsize count)
+{
+  // large reads go straight to the source once the buffer is used up
+  const std::streamsize buffered = std::min<std::streamsize>(
+    count, static_cast<std::streamsize>(egptr() - gptr()));
+  std::memcpy(data, gptr(), static_cast<size_t>(buffered));
+  gbump(static_cast<int>(buffered));
+  if (count - buffered < static_cast<std::streamsize>(bufferSize))
+    return buffered + std::streambuf::xsgetn(data + buffered, count - buffered);
+
+  if (m_canceled)
+    return buffered;
+  const std::streamsize direct = m_source->sgetn(data + buffered,
+                                                 count - buffered);
+  discard();
+  if (direct <= 0)
+    return buffered;
+  report(direct);
+  return buffered + direct;
+}
+
+ProgressBuffer::pos_type ProgressBuffer::seekoff(off_type offset,
+                                                 std::ios_base::seekdir dir,
+                                                 std::ios_base::openmode which)
+{
+  if (dir == std::ios_base::cur) {
+    // tellg() should not throw the buffer away
+    if (offset == 0) {
+      const pos_type position = m_source->pubseekoff(0, dir, which);
+      if (position == pos_type(-1))
+        return position;
+      return position - static_cast<off_type>(egptr() - gptr());
+    }
+    offset -= egptr() - gptr();
+  }
+  discard();
+  const pos_type position = m_source->pubseekoff(offset, dir, which);
+  if (position != pos_type(-1))
+    m_read = static_cast<std::streamoff>(position) - m_start;
+  return position;
+}
+
+ProgressBuffer::pos_type ProgressBuffer::seekpos(pos_type position,
+                                                 std::ios_base::openmode which)
+{
+  discard();
+  const pos_type result = m_source->pubseekpos(position, which);
+  if (result != pos_type(-1))
+    m_read = static_cast<std::streamoff>(result) - m_start;
+  return result;
+}
+
+void ProgressBuffer::report(std::streamsize count)
+{
+  m_read += count;
+  if (m_callback)
+    m_callback(m_read, m_size);
+}
+
+void ProgressBuffer::discard()
+{
+  char* const begin = m_buffer.data() + putbackSize;
+  setg(begin, begin, begin);
+}
+
+} // namespace Avogadro::Io
@@ -0,0 +1,69 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_IO_PROGRESSBUFFER_H
+#define AVOGADRO_IO_PROGRESSBUFFER_H
+
+#include <atomic>
+#include <functional>
+#include <ios>
+#include <streambuf>
+#include <vector>
+
+namespace Avogadro {
+namespace Io {
+
+/**
+ * @class ProgressBuffer progressbuffer.h
+ * @brief A stream buffer that reads through another one, reporting how many
+ * bytes were read and stopping early once reading is canceled.
+ *
+ * Any reader can be tracked this way without being changed: a canceled read
+ * sees the end of the stream at the next refill of the buffer. Seeking is
+ * passed on to the source. This is an internal class of the IO library.
+ */
+class ProgressBuffer : public std::streambuf
+{
+public:
+  typedef std::function<void(std::streamoff, std::streamoff)> Callback;
+
+  /**
+   * Read from @p source, calling @p callback (if set) with the bytes read so
+   * far and the size of the stream, or -1 if it is unknown. Reading stops
+   * once @p canceled is set.
+   */
+  ProgressBuffer(std::streambuf* source, const Callback& callback,
+                 const std::atomic<bool>& canceled);
+
+  /**
+   * Move the source back to the first byte that was not used, so that it
+   * can be read on after this buffer is dropped.
+   */
+  ~ProgressBuffer() override;
+
+protected:
+  int_type underflow() override;
+  std::streamsize xsgetn(char_type* data, std::streamsize count) override;
+  pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override;
+  pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+
+private:
+  void report(std::streamsize count);
+  void discard();
+
+  std::streambuf* m_source;
+  const Callback& m_callback;
+  const std::atomic<bool>& m_canceled;
+  std::vector<char> m_buffer;
+  std::streamoff m_start;
+  std::streamoff m_size;
+  std::streamoff m_read;
+};
+
+} // namespace Io
+} // namespace Avogadro
+
+#endif // AVOGADRO_IO_PROGRESSBUFFER_H
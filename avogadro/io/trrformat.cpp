@@ -4,6 +4,7 @@
 ******************************************************************************/
 
 #include "trrformat.h"
+#include "mappedfile.h"
 #include "struct.h"
 
 #include <avogadro/core/elements.h>
@@ -12,11 +13,15 @@
 #include <avogadro/core/utilities.h>
 #include <avogadro/core/vector.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <istream>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <type_traits>
 
 using std::map;
 using std::pair;
@@ -31,9 +36,6 @@ using Core::Atom;
 using Core::Molecule;
 using Core::UnitCell;
 
-#ifndef _WIN32
-#endif
-
 constexpr int GROMACS_MAGIC = 1993;
 constexpr int DIM = 3;
 constexpr float NM_TO_ANGSTROM = 10.0;
@@ -68,7 +70,7 @@ int isDouble(map<string, int>& header)
   for (auto & headerKey : headerKeys) {
     if (header[headerKey] != 0) {
       if (headerKey == "box_size") {
-        size = (int)(header[headerKey] / DIM * DIM);
+        size = (int)(header[headerKey] / (DIM * DIM));
         break;
       } else {
         size = (int)(header[headerKey] / (header["natoms"] * DIM));
@@ -79,44 +81,103 @@ int isDouble(map<string, int>& header)
   return size == SIZE_DOUBLE;
 }
 
-TrrFormat::TrrFormat() {}
+namespace {
+inline uint32_t byteSwap(uint32_t word)
+{
+  return (word >> 24) | ((word >> 8) & 0x0000ff00u) |
+         ((word << 8) & 0x00ff0000u) | (word << 24);
+}
 
-TrrFormat::~TrrFormat() {}
+inline uint64_t byteSwap(uint64_t word)
+{
+  return (static_cast<uint64_t>(byteSwap(static_cast<uint32_t>(word))) << 32) |
+         byteSwap(static_cast<uint32_t>(word >> 32));
+}
 
-bool TrrFormat::read(std::istream& inStream, Core::Molecule& mol)
+// Real number stored at @p bytes, swapping the byte order if needed.
+template <typename Real, bool Swap>
+inline Real load(const char* bytes)
 {
-  bool doubleStatus;
-  char endian = '>', buff[BUFSIZ], fmt[BUFSIZ], raw[1000];
-  int magic, natoms, slen0, slen1, headval[13];
-  string subs, keyCheck[] = { "box_size", "vir_size", "pres_size" },
-               keyCheck2[] = { "x_size", "v_size", "f_size" };
-  map<string, int> header;
+  using Word = std::conditional_t<sizeof(Real) == 8, uint64_t, uint32_t>;
+  Word word;
+  memcpy(&word, bytes, sizeof(word));
+  if (Swap)
+    word = byteSwap(word);
+  Real value;
+  memcpy(&value, &word, sizeof(value));
+  return value;
+}
 
-  // Determining size of file
-  inStream.seekg(0, inStream.end);
-  int fileLen = inStream.tellg();
-  inStream.seekg(0, inStream.beg);
+// Converts interleaved x, y, z coordinates in nm to positions. The loop is
+// branch free, so that the compiler can vectorize the conversion.
+template <typename Real, bool Swap>
+void convert(const char* data, Index count, Vector3* positions)
+{
+  for (Index i = 0; i < count; ++i) {
+    const char* xyz = data + i * DIM * sizeof(Real);
+    positions[i] = Vector3(load<Real, Swap>(xyz),
+                           load<Real, Swap>(xyz + sizeof(Real)),
+                           load<Real, Swap>(xyz + 2 * sizeof(Real))) *
+                   NM_TO_ANGSTROM;
+  }
+}
 
-  // Binary file must start with 1993
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
+void convertCoordinates(const char* data, Index count, bool isDouble,
+                        char endian, Vector3* positions)
+{
+  const int one = 1;
+  const bool little = *reinterpret_cast<const char*>(&one) == 1;
+  if ((endian == '>') == little) {
+    if (isDouble)
+      convert<double, true>(data, count, positions);
+    else
+      convert<float, true>(data, count, positions);
+  } else {
+    if (isDouble)
+      convert<double, false>(data, count, positions);
+    else
+      convert<float, false>(data, count, positions);
+  }
+}
+} // namespace
+
+TrrFormat::TrrFormat() : m_endian('>') {}
+
+TrrFormat::~TrrFormat() {}
+
+bool TrrFormat::readFrameHeader(std::istream& inStream,
+                                map<string, int>& header, bool& doubleStatus,
+                                UnitCell** cell)
+{
+  char buff[BUFSIZ], fmt[BUFSIZ], raw[1000];
+  int magic, slen0, slen1, headval[13];
+  string subs, keyCheck[] = { "box_size", "vir_size", "pres_size" };
+
+  // Binary header must start with 1993
+  snprintf(fmt, sizeof(fmt), "%c1i", m_endian);
+  if (!inStream.read(buff, struct_calcsize(fmt)))
+    return false;
   struct_unpack(buff, fmt, &magic);
   if (magic != GROMACS_MAGIC) {
     // Endian conversion
     magic = swapInteger(magic);
-    endian = swapEndian(endian);
+    m_endian = swapEndian(m_endian);
     if (magic != GROMACS_MAGIC) {
       appendError("Frame does not start with magic number 1993.");
       return false;
     }
   }
 
-  snprintf(fmt, sizeof(fmt), "%c2i", endian);
+  snprintf(fmt, sizeof(fmt), "%c2i", m_endian);
   inStream.read(buff, struct_calcsize(fmt));
   struct_unpack(buff, fmt, &slen0, &slen1);
+  if (slen0 < 13 || slen0 > 1000) {
+    appendError("Gromacs version string mismatch.");
+    return false;
+  }
 
   // Reading trajectory version string
-  snprintf(fmt, sizeof(fmt), "%c%ds", endian, slen0 - 1);
+  snprintf(fmt, sizeof(fmt), "%c%ds", m_endian, slen0 - 1);
   inStream.read(buff, struct_calcsize(fmt));
   struct_unpack(buff, fmt, raw);
   subs = string(raw).substr(0, 12);
@@ -128,11 +189,12 @@ bool TrrFormat::read(std::istream& inStream, Core::Molecule& mol)
   // "ir_size", "e_size", "box_size", "vir_size", "pres_size",
   // "top_size", "sym_size", "x_size", "v_size", "f_size",
   // "natoms", "step", "nre"
-  snprintf(fmt, sizeof(fmt), "%c13i", endian);
+  snprintf(fmt, sizeof(fmt), "%c13i", m_endian);
   inStream.read(buff, struct_calcsize(fmt));
   struct_unpack(buff, fmt, &headval[0], &headval[1], &headval[2], &headval[3],
                 &headval[4], &headval[5], &headval[6], &headval[7], &headval[8],
                 &headval[9], &headval[10], &headval[11], &headval[12]);
+  header.clear();
   for (int i = 0; i < 13; ++i) {
     header.insert(pair<string, int>(HEADITEMS[i], headval[i]));
   }
@@ -141,14 +203,14 @@ bool TrrFormat::read(std::istream& inStream, Core::Molecule& mol)
   doubleStatus = isDouble(header);
   if (doubleStatus) {
     double header0, header1;
-    snprintf(fmt, sizeof(fmt), "%c2d", endian);
+    snprintf(fmt, sizeof(fmt), "%c2d", m_endian);
     inStream.read(buff, struct_calcsize(fmt));
     struct_unpack(buff, fmt, &header0, &header1);
     header.insert(pair<string, int>("time", header0));
     header.insert(pair<string, int>("lambda", header1));
   } else {
     float header0, header1;
-    snprintf(fmt, sizeof(fmt), "%c2f", endian);
+    snprintf(fmt, sizeof(fmt), "%c2f", m_endian);
     inStream.read(buff, struct_calcsize(fmt));
     struct_unpack(buff, fmt, &header0, &header1);
     header.insert(pair<string, int>("time", header0));
@@ -157,246 +219,200 @@ bool TrrFormat::read(std::istream& inStream, Core::Molecule& mol)
 
   // Reading matrices corresponding to "box_size", "vir_size", "pres_size"
   for (auto & _kid : keyCheck) {
-    if (header[_kid] != 0) {
-      if (doubleStatus) {
-        snprintf(fmt, sizeof(fmt), "%c%dd", endian, DIM * DIM);
-        double mat[DIM][DIM];
-        inStream.read(buff, struct_calcsize(fmt));
-        struct_unpack(buff, fmt, &mat[0][0], &mat[0][1], &mat[0][2], &mat[1][0],
-                      &mat[1][1], &mat[1][2], &mat[2][0], &mat[2][1],
-                      &mat[2][2]);
-        if (_kid == "box_size") {
-          mol.setUnitCell(new UnitCell(
-            Vector3(mat[0][0] * NM_TO_ANGSTROM, mat[0][1] * NM_TO_ANGSTROM,
-                    mat[0][2] * NM_TO_ANGSTROM),
-            Vector3(mat[1][0] * NM_TO_ANGSTROM, mat[1][1] * NM_TO_ANGSTROM,
-                    mat[1][2] * NM_TO_ANGSTROM),
-            Vector3(mat[2][0] * NM_TO_ANGSTROM, mat[2][1] * NM_TO_ANGSTROM,
-                    mat[2][2] * NM_TO_ANGSTROM)));
-        }
-      } else {
-        snprintf(fmt, sizeof(fmt), "%c%df", endian, DIM * DIM);
-        float mat[DIM][DIM];
-        inStream.read(buff, struct_calcsize(fmt));
-        struct_unpack(buff, fmt, &mat[0][0], &mat[0][1], &mat[0][2], &mat[1][0],
-                      &mat[1][1], &mat[1][2], &mat[2][0], &mat[2][1],
-                      &mat[2][2]);
-        if (_kid == "box_size") {
-          mol.setUnitCell(new UnitCell(
-            Vector3(mat[0][0] * NM_TO_ANGSTROM, mat[0][1] * NM_TO_ANGSTROM,
-                    mat[0][2] * NM_TO_ANGSTROM),
-            Vector3(mat[1][0] * NM_TO_ANGSTROM, mat[1][1] * NM_TO_ANGSTROM,
-                    mat[1][2] * NM_TO_ANGSTROM),
-            Vector3(mat[2][0] * NM_TO_ANGSTROM, mat[2][1] * NM_TO_ANGSTROM,
-                    mat[2][2] * NM_TO_ANGSTROM)));
-        }
-      }
+    if (header[_kid] == 0)
+      continue;
+    if (_kid != "box_size" || cell == nullptr) {
+      inStream.ignore(header[_kid]);
+      continue;
     }
+
+    double mat[DIM][DIM];
+    if (doubleStatus) {
+      snprintf(fmt, sizeof(fmt), "%c%dd", m_endian, DIM * DIM);
+      inStream.read(buff, struct_calcsize(fmt));
+      struct_unpack(buff, fmt, &mat[0][0], &mat[0][1], &mat[0][2], &mat[1][0],
+                    &mat[1][1], &mat[1][2], &mat[2][0], &mat[2][1],
+                    &mat[2][2]);
+    } else {
+      snprintf(fmt, sizeof(fmt), "%c%df", m_endian, DIM * DIM);
+      float matFloat[DIM][DIM];
+      inStream.read(buff, struct_calcsize(fmt));
+      struct_unpack(buff, fmt, &matFloat[0][0], &matFloat[0][1],
+                    &matFloat[0][2], &matFloat[1][0], &matFloat[1][1],
+                    &matFloat[1][2], &matFloat[2][0], &matFloat[2][1],
+                    &matFloat[2][2]);
+      for (int i = 0; i < DIM; ++i)
+        for (int j = 0; j < DIM; ++j)
+          mat[i][j] = matFloat[i][j];
+    }
+    *cell = new UnitCell(
+      Vector3(mat[0][0] * NM_TO_ANGSTROM, mat[0][1] * NM_TO_ANGSTROM,
+              mat[0][2] * NM_TO_ANGSTROM),
+      Vector3(mat[1][0] * NM_TO_ANGSTROM, mat[1][1] * NM_TO_ANGSTROM,
+              mat[1][2] * NM_TO_ANGSTROM),
+      Vector3(mat[2][0] * NM_TO_ANGSTROM, mat[2][1] * NM_TO_ANGSTROM,
+              mat[2][2] * NM_TO_ANGSTROM));
+  }
+  return static_cast<bool>(inStream);
+}
+
+bool TrrFormat::readCoordinates(std::istream& inStream,
+                                map<string, int>& header, bool doubleStatus,
+                                Array<Vector3>& positions)
+{
+  // Reading the coordinates of positions, skipping velocities and forces
+  const int natoms = header["natoms"];
+  positions.clear();
+  if (header["x_size"] != 0) {
+    const size_t realSize = doubleStatus ? sizeof(double) : sizeof(float);
+    vector<char> block(static_cast<size_t>(natoms) * DIM * realSize);
+    if (!inStream.read(block.data(), block.size()))
+      return false;
+    positions.resize(natoms);
+    convertCoordinates(block.data(), natoms, doubleStatus, m_endian,
+                       positions.data());
+  }
+  inStream.ignore(header["v_size"]);
+  inStream.ignore(header["f_size"]);
+  return static_cast<bool>(inStream);
+}
+
+bool TrrFormat::read(std::istream& inStream, Core::Molecule& mol)
+{
+  map<string, int> header;
+  bool doubleStatus;
+  Array<Vector3> positions;
+
+  UnitCell* cell = nullptr;
+  m_endian = '>';
+  if (!readFrameHeader(inStream, header, doubleStatus, &cell)) {
+    delete cell;
+    return false;
+  }
+  if (cell != nullptr) {
+    mol.setFrameCell(cell->cellMatrix(), 0);
+    mol.setUnitCell(cell);
+  }
+  if (!readCoordinates(inStream, header, doubleStatus, positions)) {
+    appendError("Error reading the first frame.");
+    return false;
   }
 
   typedef map<string, unsigned char> AtomTypeMap;
   AtomTypeMap atomTypes;
   unsigned char customElementCounter = CustomElementMin;
 
-  // Reading the coordinates of positions, velocities and forces
-  for (auto & _kid : keyCheck2) {
-    natoms = header["natoms"];
-    double coordsDouble[DIM];
-    float coordsFloat[DIM];
-    for (int i = 0; i < natoms; ++i) {
-      if (header[_kid] != 0) {
-        memset(coordsDouble, 0, sizeof(coordsDouble));
-        memset(coordsFloat, 0, sizeof(coordsFloat));
-        if (doubleStatus) {
-          snprintf(fmt, sizeof(fmt), "%c%dd", endian, DIM);
-          inStream.read(buff, struct_calcsize(fmt));
-          struct_unpack(buff, fmt, &coordsDouble[0], &coordsDouble[1],
-                        &coordsDouble[2]);
-        } else {
-          snprintf(fmt, sizeof(fmt), "%c%df", endian, DIM);
-          inStream.read(buff, struct_calcsize(fmt));
-          struct_unpack(buff, fmt, &coordsFloat[0], &coordsFloat[1],
-                        &coordsFloat[2]);
-        }
-
-        if (_kid == "x_size") {
-          // If parsed coordinates are fractional, the corresponding unscaling
-          // is done. Else the positions are assigned as parsed.
-          Vector3 pos(
-            coordsDouble[0] * NM_TO_ANGSTROM + coordsFloat[0] * NM_TO_ANGSTROM,
-            coordsDouble[1] * NM_TO_ANGSTROM + coordsFloat[1] * NM_TO_ANGSTROM,
-            coordsDouble[2] * NM_TO_ANGSTROM + coordsFloat[2] * NM_TO_ANGSTROM);
-
-          AtomTypeMap::const_iterator it;
-          // if (it == atomTypes.end()) {
-          atomTypes.insert(
-            std::make_pair(to_string(i), customElementCounter++));
-          it = atomTypes.find(to_string(i));
-          // if (customElementCounter > CustomElementMax) {
-          //   appendError("Custom element type limit exceeded.");
-          //   return false;
-          // }
-          Atom newAtom = mol.addAtom(it->second);
-          newAtom.setPosition3d(pos);
-        }
-      }
-    }
+  for (Index i = 0; i < positions.size(); ++i) {
+    AtomTypeMap::const_iterator it;
+    atomTypes.insert(std::make_pair(to_string(i), customElementCounter++));
+    it = atomTypes.find(to_string(i));
+    // if (customElementCounter > CustomElementMax) {
+    //   appendError("Custom element type limit exceeded.");
+    //   return false;
+    // }
+    Atom newAtom = mol.addAtom(it->second);
+    newAtom.setPosition3d(positions[i]);
+  }
 
-    // Set the custom element map if needed
-    if (!atomTypes.empty()) {
-      Molecule::CustomElementMap elementMap;
-      for (const auto & atomType : atomTypes) {
-        elementMap.insert(std::make_pair(atomType.second, "Atom " + atomType.first));
-      }
-      mol.setCustomElementMap(elementMap);
+  // Set the custom element map if needed
+  if (!atomTypes.empty()) {
+    Molecule::CustomElementMap elementMap;
+    for (const auto & atomType : atomTypes) {
+      elementMap.insert(std::make_pair(atomType.second, "Atom " + atomType.first));
     }
+    mol.setCustomElementMap(elementMap);
   }
   mol.setCoordinate3d(mol.atomPositions3d(), 0);
 
-  // Do we have an animation?
-  // EOF check
-  int coordSet = 1;
-  while (static_cast<int>(inStream.tellg()) != fileLen) {
-    // Binary header must start with 1993
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &magic);
-    if (magic != GROMACS_MAGIC) {
-      // Endian conversion
-      magic = swapInteger(magic);
-      endian = swapEndian(endian);
-      if (magic != GROMACS_MAGIC) {
-        appendError("Frame does not start with magic number 1993.");
-        return false;
-      }
-    }
+  // Frames of a file are read on demand, with the box of each one found
+  // while indexing the file.
+  if (attachFrames(inStream, mol))
+    return true;
 
-    snprintf(fmt, sizeof(fmt), "%c2i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &slen0, &slen1);
-
-    // Reading trajectory version string
-    snprintf(fmt, sizeof(fmt), "%c%ds", endian, slen0 - 1);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, raw);
-    subs = string(raw).substr(0, 12);
-    if (subs != TRRVERSION) {
-      appendError("Gromacs version string mismatch.");
+  int coordSet = 1;
+  while (inStream.peek() != std::char_traits<char>::eof()) {
+    cell = nullptr;
+    if (!readFrameHeader(inStream, header, doubleStatus, &cell)) {
+      delete cell;
       return false;
     }
-
-    // "ir_size", "e_size", "box_size", "vir_size", "pres_size",
-    // "top_size", "sym_size", "x_size", "v_size", "f_size",
-    // "natoms", "step", "nre"
-    snprintf(fmt, sizeof(fmt), "%c13i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &headval[0], &headval[1], &headval[2], &headval[3],
-                  &headval[4], &headval[5], &headval[6], &headval[7],
-                  &headval[8], &headval[9], &headval[10], &headval[11],
-                  &headval[12]);
-    for (int i = 0; i < 13; ++i) {
-      header.insert(pair<string, int>(HEADITEMS[i], headval[i]));
-    }
-
-    // Reading timestep and lambda
-    doubleStatus = isDouble(header);
-    if (doubleStatus) {
-      double header0, header1;
-      snprintf(fmt, sizeof(fmt), "%c2d", endian);
-      inStream.read(buff, struct_calcsize(fmt));
-      struct_unpack(buff, fmt, &header0, &header1);
-      header.insert(pair<string, int>("time", header0));
-      header.insert(pair<string, int>("lambda", header1));
-    } else {
-      float header0, header1;
-      snprintf(fmt, sizeof(fmt), "%c2f", endian);
-      inStream.read(buff, struct_calcsize(fmt));
-      struct_unpack(buff, fmt, &header0, &header1);
-      header.insert(pair<string, int>("time", header0));
-      header.insert(pair<string, int>("lambda", header1));
+    if (cell != nullptr) {
+      mol.setFrameCell(cell->cellMatrix(), coordSet);
+      delete cell;
     }
+    // stop at a truncated frame
+    if (!readCoordinates(inStream, header, doubleStatus, positions))
+      break;
+    mol.setCoordinate3d(positions, coordSet++);
+  }
+  return true;
+}
 
-    // Reading matrices corresponding to "box_size", "vir_size", "pres_size"
-    for (auto & _kid : keyCheck) {
-      if (header[_kid] != 0) {
-        natoms = header["natoms"];
-        if (doubleStatus) {
-          snprintf(fmt, sizeof(fmt), "%c%dd", endian, DIM * DIM);
-          double mat[DIM][DIM];
-          inStream.read(buff, struct_calcsize(fmt));
-          struct_unpack(buff, fmt, &mat[0][0], &mat[0][1], &mat[0][2],
-                        &mat[1][0], &mat[1][1], &mat[1][2], &mat[2][0],
-                        &mat[2][1], &mat[2][2]);
-          if (_kid == "box_size") {
-            mol.setUnitCell(new UnitCell(
-              Vector3(mat[0][0] * NM_TO_ANGSTROM, mat[0][1] * NM_TO_ANGSTROM,
-                      mat[0][2] * NM_TO_ANGSTROM),
-              Vector3(mat[1][0] * NM_TO_ANGSTROM, mat[1][1] * NM_TO_ANGSTROM,
-                      mat[1][2] * NM_TO_ANGSTROM),
-              Vector3(mat[2][0] * NM_TO_ANGSTROM, mat[2][1] * NM_TO_ANGSTROM,
-                      mat[2][2] * NM_TO_ANGSTROM)));
-          }
-        } else {
-          snprintf(fmt, sizeof(fmt), "%c%df", endian, DIM * DIM);
-          float mat[DIM][DIM];
-          inStream.read(buff, struct_calcsize(fmt));
-          struct_unpack(buff, fmt, &mat[0][0], &mat[0][1], &mat[0][2],
-                        &mat[1][0], &mat[1][1], &mat[1][2], &mat[2][0],
-                        &mat[2][1], &mat[2][2]);
-          if (_kid == "box_size") {
-            mol.setUnitCell(new UnitCell(
-              Vector3(mat[0][0] * NM_TO_ANGSTROM, mat[0][1] * NM_TO_ANGSTROM,
-                      mat[0][2] * NM_TO_ANGSTROM),
-              Vector3(mat[1][0] * NM_TO_ANGSTROM, mat[1][1] * NM_TO_ANGSTROM,
-                      mat[1][2] * NM_TO_ANGSTROM),
-              Vector3(mat[2][0] * NM_TO_ANGSTROM, mat[2][1] * NM_TO_ANGSTROM,
-                      mat[2][2] * NM_TO_ANGSTROM)));
-          }
-        }
-      }
-    }
+bool TrrFormat::indexFrames(std::istream& in,
+                            std::vector<std::streamoff>& offsets,
+                            std::vector<double>&, std::vector<Matrix3>& cells)
+{
+  in.seekg(0, std::ios_base::end);
+  const std::streamoff end = in.tellg();
+  in.seekg(0, std::ios_base::beg);
 
-    natoms = header["natoms"];
-    Array<Vector3> positions;
-    positions.reserve(natoms);
-
-    // Reading the coordinates of positions, velocities and forces
-    for (auto & _kid : keyCheck2) {
-      double coordsDouble[DIM];
-      float coordsFloat[DIM];
-      for (int i = 0; i < natoms; ++i) {
-        if (header[_kid] != 0) {
-          memset(coordsDouble, 0, sizeof(coordsDouble));
-          memset(coordsFloat, 0, sizeof(coordsFloat));
-          if (doubleStatus) {
-            snprintf(fmt, sizeof(fmt), "%c%dd", endian, DIM);
-            inStream.read(buff, struct_calcsize(fmt));
-            struct_unpack(buff, fmt, &coordsDouble[0], &coordsDouble[1],
-                          &coordsDouble[2]);
-          } else {
-            snprintf(fmt, sizeof(fmt), "%c%df", endian, DIM);
-            inStream.read(buff, struct_calcsize(fmt));
-            struct_unpack(buff, fmt, &coordsFloat[0], &coordsFloat[1],
-                          &coordsFloat[2]);
-          }
-
-          if (_kid == "x_size") {
-            // If parsed coordinates are fractional, the corresponding unscaling
-            // is done. Else the positions are assigned as parsed.
-            Vector3 pos(coordsDouble[0] * NM_TO_ANGSTROM +
-                          coordsFloat[0] * NM_TO_ANGSTROM,
-                        coordsDouble[1] * NM_TO_ANGSTROM +
-                          coordsFloat[1] * NM_TO_ANGSTROM,
-                        coordsDouble[2] * NM_TO_ANGSTROM +
-                          coordsFloat[2] * NM_TO_ANGSTROM);
-            positions.push_back(pos);
-          }
-        }
-      }
-    }
-    mol.setCoordinate3d(positions, coordSet++);
-    positions.clear();
+  map<string, int> header;
+  m_endian = '>';
+  bool doubleStatus;
+  while (in.peek() != std::char_traits<char>::eof()) {
+    const std::streamoff start = in.tellg();
+    UnitCell* cell = nullptr;
+    const bool ok = readFrameHeader(in, header, doubleStatus, &cell);
+    const Matrix3 cellMatrix = cell ? cell->cellMatrix() : Matrix3::Zero();
+    delete cell;
+    if (!ok)
+      break;
+    // jump over the coordinates, velocities and forces
+    const std::streamoff next = static_cast<std::streamoff>(in.tellg()) +
+                                header["x_size"] + header["v_size"] +
+                                header["f_size"];
+    if (next > end)
+      break;
+    offsets.push_back(start);
+    cells.push_back(cellMatrix);
+    in.seekg(next);
   }
+  return !offsets.empty();
+}
+
+bool TrrFormat::readFramePositions(std::istream& in,
+                                   Array<Vector3>& positions)
+{
+  map<string, int> header;
+  bool doubleStatus;
+  return readFrameHeader(in, header, doubleStatus, nullptr) &&
+         readCoordinates(in, header, doubleStatus, positions);
+}
+
+bool TrrFormat::readMappedFrame(const char* begin, const char* end,
+                                Array<Vector3>& positions)
+{
+  // only the header is parsed through a stream, the coordinates are
+  // converted where they lie in the mapping
+  MemoryBuffer buffer(begin, end);
+  std::istream in(&buffer);
+  map<string, int> header;
+  bool doubleStatus;
+  if (!readFrameHeader(in, header, doubleStatus, nullptr))
+    return false;
+
+  positions.clear();
+  if (header["x_size"] == 0)
+    return true;
+  const int natoms = header["natoms"];
+  const size_t realSize = doubleStatus ? sizeof(double) : sizeof(float);
+  const size_t bytes =
+    static_cast<size_t>(std::max(natoms, 0)) * DIM * realSize;
+  const char* data = begin + static_cast<std::streamoff>(in.tellg());
+  if (static_cast<size_t>(end - data) < bytes)
+    return false;
+  positions.resize(natoms);
+  convertCoordinates(data, natoms, doubleStatus, m_endian, positions.data());
   return true;
 }
 
@@ -8,7 +8,12 @@
 
 #include "fileformat.h"
 
+#include <map>
+
 namespace Avogadro {
+namespace Core {
+class UnitCell;
+}
 namespace Io {
 
 /**
@@ -46,6 +51,32 @@ public:
 
   bool read(std::istream& inStream, Core::Molecule& molecule) override;
   bool write(std::ostream& outStream, const Core::Molecule& molecule) override;
+
+protected:
+  bool indexFrames(std::istream& in, std::vector<std::streamoff>& offsets,
+                   std::vector<double>& times,
+                   std::vector<Matrix3>& cells) override;
+  bool readFramePositions(std::istream& in,
+                          Core::Array<Vector3>& positions) override;
+  bool readMappedFrame(const char* begin, const char* end,
+                       Core::Array<Vector3>& positions) override;
+
+private:
+  /**
+   * Read the header of the frame at the current position in @p inStream, up
+   * to the start of the coordinates. If @p cell is not null and the frame has
+   * a box, a new unit cell is returned in it.
+   */
+  bool readFrameHeader(std::istream& inStream,
+                       std::map<std::string, int>& header, bool& doubleStatus,
+                       Core::UnitCell** cell);
+
+  /** Read the positions following a frame header, skipping the rest. */
+  bool readCoordinates(std::istream& inStream,
+                       std::map<std::string, int>& header, bool doubleStatus,
+                       Core::Array<Vector3>& positions);
+
+  char m_endian; // byte order of the frames, as for the struct library
 };
 
 } // end Io namespace
@@ -177,6 +177,20 @@ bool TurbomoleFormat::read(std::istream& inStream, Core::Molecule& mol)
     }
   }
 
+  if (!deferDerivedData())
+    completeRead(mol);
+
+  return true;
+}
+
+bool TurbomoleFormat::completeRead(Core::Molecule& mol)
+{
+  json opts;
+  if (!options().empty())
+    opts = json::parse(options(), nullptr, false);
+  else
+    opts = json::object();
+
   // This format has no connectivity information, so perceive basics at least.
   if (opts.value("perceiveBonds", true)) {
     mol.perceiveBondsSimple();
@@ -46,6 +46,9 @@ public:
 
   bool read(std::istream& inStream, Core::Molecule& molecule) override;
   bool write(std::ostream& outStream, const Core::Molecule& molecule) override;
+
+  /** Perceive bonds, unless the "perceiveBonds" option is false. */
+  bool completeRead(Core::Molecule& molecule) override;
 };
 
 } // end Io namespace
@@ -5,19 +5,25 @@
 
 #include "xyzformat.h"
 
+#include "linereader.h"
+
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/parallel.h>
 #include <avogadro/core/unitcell.h>
 #include <avogadro/core/utilities.h>
 #include <avogadro/core/vector.h>
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <iomanip>
 #include <istream>
+#include <limits>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 using json = nlohmann::json;
 
@@ -40,6 +46,23 @@ using Core::trimmed;
 using std::isalpha;
 #endif
 
+namespace {
+// Parse the position from an atom line, ignoring the element.
+bool parsePosition(std::string_view line,
+                   vector<std::string_view>& tokens, Vector3& position)
+{
+  // check for tabs PR#1512
+  split(line, line.find('\t') != std::string_view::npos ? '\t' : ' ',
+        tokens);
+  if (tokens.size() < 4)
+    return false;
+  position = Vector3(lexicalCast<double>(tokens[1]),
+                     lexicalCast<double>(tokens[2]),
+                     lexicalCast<double>(tokens[3]));
+  return true;
+}
+} // namespace
+
 XyzFormat::XyzFormat() {}
 
 XyzFormat::~XyzFormat() {}
@@ -90,14 +113,14 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
   }
 
   // Parse atoms
+  vector<std::string_view> tokens;
   for (size_t i = 0; i < numAtoms; ++i) {
     getline(inStream, buffer);
-    vector<string> tokens;
     // check for tabs PR#1512
     if (buffer.find('\t') != std::string::npos)
-      tokens = split(buffer, '\t');
+      split(buffer, '\t', tokens);
     else
-      tokens = split(buffer, ' ');
+      split(buffer, ' ', tokens);
 
     if (tokens.size() < 4) {
       appendError("Not enough tokens in this line: " + buffer);
@@ -106,7 +129,7 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
 
     unsigned char atomicNum(0);
     if (isalpha(tokens[0][0]))
-      atomicNum = Elements::atomicNumberFromSymbol(tokens[0]);
+      atomicNum = Elements::atomicNumberFromSymbol(string(tokens[0]));
     else
       atomicNum = static_cast<unsigned char>(lexicalCast<short int>(tokens[0]));
 
@@ -127,43 +150,52 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
     return false;
   }
 
-  // Do we have an animation?
+  // Do we have an animation? A second block with the same atom count starts
+  // the next frame.
   size_t numAtoms2;
   if (getline(inStream, buffer) && (numAtoms2 = lexicalCast<int>(buffer)) &&
       numAtoms == numAtoms2) {
-    getline(inStream, buffer); // Skip the blank
     mol.setCoordinate3d(mol.atomPositions3d(), 0);
-    int coordSet = 1;
-    while (numAtoms == numAtoms2) {
-      Array<Vector3> positions;
-      positions.reserve(numAtoms);
-
-      for (size_t i = 0; i < numAtoms; ++i) {
-        getline(inStream, buffer);
-        vector<string> tokens(split(buffer, ' '));
-        if (tokens.size() < 4) {
-          appendError("Not enough tokens in this line: " + buffer);
+    if (attachFrames(inStream, mol)) {
+      // frames are read when they are needed
+    } else if (opts.value("parallel", true)) {
+      if (!readFrames(inStream, numAtoms, mol))
+        return false;
+    } else {
+      getline(inStream, buffer); // Skip the blank
+      int coordSet = 1;
+      while (numAtoms == numAtoms2) {
+        Array<Vector3> positions;
+        if (!readPositions(inStream, numAtoms, positions))
           return false;
-        }
-        Vector3 pos(lexicalCast<double>(tokens[1]),
-                    lexicalCast<double>(tokens[2]),
-                    lexicalCast<double>(tokens[3]));
-        positions.push_back(pos);
-      }
 
-      mol.setCoordinate3d(positions, coordSet++);
+        mol.setCoordinate3d(positions, coordSet++);
 
-      if (!getline(inStream, buffer)) {
-        numAtoms2 = lexicalCast<int>(buffer);
-        if (numAtoms == numAtoms2)
-          break;
-      }
+        if (!getline(inStream, buffer)) {
+          numAtoms2 = lexicalCast<int>(buffer);
+          if (numAtoms == numAtoms2)
+            break;
+        }
 
-      std::getline(inStream, buffer); // Skip the blank
-      positions.clear();
+        std::getline(inStream, buffer); // Skip the blank
+      }
     }
   }
 
+  if (!deferDerivedData())
+    completeRead(mol);
+
+  return true;
+}
+
+bool XyzFormat::completeRead(Core::Molecule& mol)
+{
+  json opts;
+  if (!options().empty())
+    opts = json::parse(options(), nullptr, false);
+  else
+    opts = json::object();
+
   // This format has no connectivity information, so perceive basics at least.
   if (opts.value("perceiveBonds", true)) {
     mol.perceiveBondsSimple();
@@ -173,6 +205,143 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
   return true;
 }
 
+bool XyzFormat::indexFrames(std::istream& in,
+                            std::vector<std::streamoff>& offsets,
+                            std::vector<double>&, std::vector<Matrix3>&)
+{
+  size_t numAtoms = 0;
+  string buffer;
+  for (;;) {
+    const std::streamoff start = in.tellg();
+    if (!getline(in, buffer))
+      break;
+    bool ok = false;
+    const auto count = lexicalCast<size_t>(trimmed(buffer), ok);
+    // every frame of a trajectory has the same atoms
+    if (!ok || count == 0 || (numAtoms != 0 && count != numAtoms))
+      break;
+    numAtoms = count;
+
+    // skip the comment and the atoms without parsing them, a truncated
+    // frame fails once it runs past the end of the file
+    for (size_t i = 0; i <= numAtoms; ++i)
+      in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    if (in.fail())
+      break;
+    offsets.push_back(start);
+    if (in.eof())
+      break;
+  }
+  return !offsets.empty();
+}
+
+bool XyzFormat::readFramePositions(std::istream& in, Array<Vector3>& positions)
+{
+  string buffer;
+  getline(in, buffer);
+  const auto numAtoms = lexicalCast<size_t>(trimmed(buffer));
+  getline(in, buffer); // Skip the comment
+  positions.clear();
+  return readPositions(in, numAtoms, positions);
+}
+
+bool XyzFormat::readPositions(std::istream& in, size_t numAtoms,
+                              Array<Vector3>& positions)
+{
+  string buffer;
+  vector<std::string_view> tokens;
+  positions.resize(numAtoms);
+  for (size_t i = 0; i < numAtoms; ++i) {
+    getline(in, buffer);
+    if (!parsePosition(buffer, tokens, positions[i])) {
+      positions.resize(i);
+      appendError("Not enough tokens in this line: " + buffer);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool XyzFormat::readFrames(std::istream& in, size_t numAtoms, Molecule& mol)
+{
+  // The atom count of the next frame has been read, so each frame is its
+  // comment line, the atoms and the atom count of the frame after it.
+  const size_t frameLines = numAtoms + 2;
+  const Index grainSize = 4096;
+  LineReader reader(in);
+  vector<std::string_view> lines;
+  vector<size_t> firstAtoms;
+  int coordSet = mol.coordinate3dCount();
+  bool more = true;
+  size_t keep = 0;
+  while (more && reader.next(lines, keep)) {
+    // find the complete frames in this chunk
+    firstAtoms.clear();
+    size_t line = 0;
+    while (more && line + frameLines - 1 <= lines.size()) {
+      const size_t countLine = line + frameLines - 1;
+      if (countLine == lines.size() && !reader.atEnd())
+        break; // the atom count is in the next chunk
+      firstAtoms.push_back(line + 1);
+      line = countLine + 1;
+      // every frame has the same atoms
+      more = countLine < lines.size() &&
+             lexicalCast<size_t>(lines[countLine]) == numAtoms;
+    }
+    keep = std::min(line, lines.size());
+
+    // parse the atoms of all the frames in parallel
+    const Index atomCount = firstAtoms.size() * numAtoms;
+    vector<Array<Vector3>> frames(firstAtoms.size());
+    vector<Vector3*> positions(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+      frames[i].resize(numAtoms);
+      positions[i] = frames[i].data();
+    }
+    vector<size_t> failures((atomCount + grainSize - 1) / grainSize,
+                            std::string::npos);
+    Core::parallelFor(0, atomCount, grainSize, [&](Index begin, Index end) {
+      vector<std::string_view> tokens;
+      for (Index i = begin; i < end; ++i) {
+        const size_t frame = i / numAtoms;
+        const size_t atom = i % numAtoms;
+        if (!parsePosition(lines[firstAtoms[frame] + atom], tokens,
+                           positions[frame][atom])) {
+          failures[begin / grainSize] = firstAtoms[frame] + atom;
+          return;
+        }
+      }
+    });
+
+    // frames before a bad line are kept, as when reading line by line
+    const size_t failure =
+      failures.empty() ? std::string::npos
+                       : *std::min_element(failures.begin(), failures.end());
+    for (size_t i = 0; i < frames.size(); ++i) {
+      if (failure < firstAtoms[i] + numAtoms) {
+        appendError("Not enough tokens in this line: " +
+                    string(lines[failure]));
+        return false;
+      }
+      mol.setCoordinate3d(frames[i], coordSet++);
+    }
+  }
+
+  // a truncated last frame, its lines are left over from the last chunk
+  if (more && !lines.empty()) {
+    vector<std::string_view> tokens;
+    Vector3 position;
+    string bad;
+    for (size_t i = 1; i < lines.size() && bad.empty(); ++i) {
+      if (!parsePosition(lines[i], tokens, position))
+        bad = lines[i];
+    }
+    appendError("Not enough tokens in this line: " + bad);
+    return false;
+  }
+  return true;
+}
+
 bool XyzFormat::write(std::ostream& outStream, const Core::Molecule& mol)
 {
   size_t numAtoms = mol.atomCount();
@@ -15,6 +15,9 @@ namespace Io {
  * @class XyzFormat xyzformat.h <avogadro/io/xyzformat.h>
  * @brief Implementation of the generic xyz format.
  * @author Allison Vacanti
+ *
+ * Trajectories in files are read frame by frame when needed, otherwise all
+ * frames are parsed in parallel unless the "parallel" option is false.
  */
 
 class AVOGADROIO_EXPORT XyzFormat : public FileFormat
@@ -46,6 +49,27 @@ public:
 
   bool read(std::istream& inStream, Core::Molecule& molecule) override;
   bool write(std::ostream& outStream, const Core::Molecule& molecule) override;
+
+  /** Perceive bonds, unless the "perceiveBonds" option is false. */
+  bool completeRead(Core::Molecule& molecule) override;
+
+protected:
+  bool indexFrames(std::istream& in, std::vector<std::streamoff>& offsets,
+                   std::vector<double>& times,
+                   std::vector<Matrix3>& cells) override;
+  bool readFramePositions(std::istream& in,
+                          Core::Array<Vector3>& positions) override;
+
+private:
+  bool readPositions(std::istream& in, size_t numAtoms,
+                     Core::Array<Vector3>& positions);
+
+  /**
+   * Read the remaining frames of a trajectory into coordinate sets, after the
+   * atom count of the second frame. The stream is read in large chunks whose
+   * atoms are parsed in parallel.
+   */
+  bool readFrames(std::istream& in, size_t numAtoms, Core::Molecule& mol);
 };
 
 } // end Io namespace
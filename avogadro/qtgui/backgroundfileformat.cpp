@@ -5,13 +5,17 @@
 
 #include "backgroundfileformat.h"
 
+#include <avogadro/core/molecule.h>
 #include <avogadro/io/fileformat.h>
 
+#include <QtCore/QMetaMethod>
+
 namespace Avogadro::QtGui {
 
 BackgroundFileFormat::BackgroundFileFormat(Io::FileFormat* format,
                                            QObject* parent)
-  : QObject(parent), m_format(format), m_molecule(nullptr), m_success(false)
+  : QObject(parent), m_format(format), m_molecule(nullptr), m_success(false),
+    m_canceled(false)
 {
 }
 
@@ -20,10 +24,18 @@ BackgroundFileFormat::~BackgroundFileFormat()
   delete m_format;
 }
 
+void BackgroundFileFormat::cancel()
+{
+  m_canceled = true;
+  if (m_format)
+    m_format->cancel();
+}
+
 void BackgroundFileFormat::read()
 {
   m_success = false;
   m_error.clear();
+  m_preview.reset();
 
   if (!m_molecule)
     m_error = tr("No molecule set in BackgroundFileFormat!");
@@ -35,13 +47,48 @@ void BackgroundFileFormat::read()
     m_error = tr("No file name set in BackgroundFileFormat!");
 
   if (m_error.isEmpty()) {
+    // withdraw a cancel() that came after the last read ended
+    m_format->clear();
+    if (m_canceled)
+      m_format->cancel();
+
+    // report whole percents, not every block that is read
+    int percent = -1;
+    m_format->setProgressCallback(
+      [this, &percent](std::streamoff bytesRead, std::streamoff bytesTotal) {
+        if (bytesTotal > 0) {
+          const auto current = static_cast<int>(100 * bytesRead / bytesTotal);
+          if (current == percent)
+            return;
+          percent = current;
+        }
+        emit progress(bytesRead, bytesTotal);
+      });
+
+    // show the atoms before the slower derived data is added
+    m_format->setDeferDerivedData(true);
     m_success =
       m_format->readFile(m_fileName.toLocal8Bit().data(), *m_molecule);
-
-    if (!m_success)
+    if (m_success && !m_canceled) {
+      if (isSignalConnected(
+            QMetaMethod::fromSignal(&BackgroundFileFormat::topologyReady))) {
+        m_preview = std::make_unique<Core::Molecule>(*m_molecule);
+        emit topologyReady();
+      }
+      m_success = m_format->completeRead(*m_molecule);
+    }
+    m_format->setDeferDerivedData(false);
+    m_format->setProgressCallback(nullptr);
+
+    if (m_canceled) {
+      m_success = false;
+      m_error = tr("Reading %1 was canceled.").arg(m_fileName);
+    } else if (!m_success) {
       m_error = QString::fromStdString(m_format->error());
+    }
   }
 
+  m_canceled = false;
   emit finished();
 }
 
@@ -11,6 +11,9 @@
 #include <QtCore/QObject>
 #include <QtCore/QString>
 
+#include <atomic>
+#include <memory>
+
 namespace Avogadro {
 
 namespace Core {
@@ -26,6 +29,12 @@ namespace QtGui {
 /**
  * @brief The BackgroundFileFormat class provides a thin QObject wrapper around
  * an instance of Io::FileFormat.
+ *
+ * It is meant to be moved to a worker thread. While reading, progress() is
+ * emitted as the file is read, and topologyReady() as soon as the atoms and
+ * the first frame are in place, with a copy in preview() that can be shown
+ * while derived data such as bonds is still being added to molecule(). The
+ * read can be stopped with cancel().
  */
 class AVOGADROQTGUI_EXPORT BackgroundFileFormat : public QObject
 {
@@ -69,6 +78,20 @@ public:
    */
   QString error() const { return m_error; }
 
+  /**
+   * A copy of molecule() taken when topologyReady() was emitted, with the
+   * atoms and first frame but not yet the derived data, or nullptr. It is
+   * kept until the next read().
+   */
+  const Core::Molecule* preview() const { return m_preview.get(); }
+
+  /**
+   * Stop the read in progress: it finishes early, with success() false.
+   * Unlike the slots, this is meant to be called directly from another
+   * thread while read() is running.
+   */
+  void cancel();
+
 signals:
 
   /**
@@ -76,6 +99,19 @@ signals:
    */
   void finished();
 
+  /**
+   * Emitted while reading, each time another percent of the file has been
+   * read. @p bytesTotal is -1 if the size is not known.
+   */
+  void progress(qint64 bytesRead, qint64 bytesTotal);
+
+  /**
+   * Emitted once the atoms and first frame are read, before derived data
+   * such as bonds. A copy of the molecule is in preview(). It is only made
+   * if this signal is connected.
+   */
+  void topologyReady();
+
 public slots:
 
   /**
@@ -94,6 +130,8 @@ private:
   QString m_fileName;
   QString m_error;
   bool m_success;
+  std::atomic<bool> m_canceled;
+  std::unique_ptr<Core::Molecule> m_preview;
 };
 
 } // namespace QtGui
@@ -8,29 +8,69 @@
 #include <avogadro/core/cube.h>
 #include <avogadro/core/mesh.h>
 #include <avogadro/core/mutex.h>
+#include <avogadro/core/parallel.h>
 
 #include <QDebug>
 #include <QReadWriteLock>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 namespace Avogadro::QtGui {
 
 using Core::Cube;
 using Core::Mesh;
 
+namespace {
+// The grid point an edge of a cube starts at, relative to vertex0, and the
+// axis the edge runs along, in the same order as a2iEdgeConnection.
+const int a2iEdgeStart[12][4] = { { 0, 0, 0, 0 }, { 1, 0, 0, 1 },
+                                  { 0, 1, 0, 0 }, { 0, 0, 0, 1 },
+                                  { 0, 0, 1, 0 }, { 1, 0, 1, 1 },
+                                  { 0, 1, 1, 0 }, { 0, 0, 1, 1 },
+                                  { 0, 0, 0, 2 }, { 1, 0, 0, 2 },
+                                  { 1, 1, 0, 2 }, { 0, 1, 0, 2 } };
+
+const unsigned int NoVertex = 0xffffffffu;
+// Marks a vertex index as a slot in Slab::foreignEdges.
+const unsigned int ForeignVertex = 0x80000000u;
+} // namespace
+
+/**
+ * The part of one surface found in a slab of x planes. Vertices on the edges
+ * of the lower face of the slab belong to it, while those on its upper face
+ * belong to the next slab and are referenced through foreignEdges until the
+ * slabs are merged.
+ */
+struct MeshGenerator::Slab
+{
+  std::vector<Vector3f> vertices;
+  std::vector<Vector3f> normals;
+  std::vector<unsigned int> triangles;
+  // Face edges, (j * nz + k) * 2 + axis - 1, on the upper face.
+  std::vector<size_t> foreignEdges;
+  // The vertex on each face edge of the lower face, or NoVertex.
+  std::vector<unsigned int> lowerFace;
+};
+
 MeshGenerator::MeshGenerator(QObject* p)
-  : QThread(p), m_iso(0.0), m_passes(6), m_reverseWinding(false), m_cube(nullptr),
-    m_mesh(nullptr), m_stepSize(0.0, 0.0, 0.0), m_min(0.0, 0.0, 0.0),
+  : QThread(p), m_iso(0.0), m_passes(6), m_reverseWinding(false),
+    m_cube(nullptr), m_mesh(nullptr), m_negativeMesh(nullptr),
+    m_data(nullptr), m_stepSize(0.0, 0.0, 0.0), m_min(0.0, 0.0, 0.0),
     m_dim(0, 0, 0), m_progmin(0), m_progmax(0)
 {
 }
 
 MeshGenerator::MeshGenerator(const Cube* cube_, Mesh* mesh_, float iso,
                              int passes, bool reverse, QObject* p)
-  : QThread(p), m_iso(0.0), m_passes(6), m_reverseWinding(reverse), m_cube(nullptr),
-    m_mesh(nullptr), m_stepSize(0.0, 0.0, 0.0), m_min(0.0, 0.0, 0.0),
+  : QThread(p), m_iso(0.0), m_passes(6), m_reverseWinding(reverse),
+    m_cube(nullptr), m_mesh(nullptr), m_negativeMesh(nullptr),
+    m_data(nullptr), m_stepSize(0.0, 0.0, 0.0), m_min(0.0, 0.0, 0.0),
     m_dim(0, 0, 0), m_progmin(0), m_progmax(0)
 {
-  initialize(cube_, mesh_, iso, passes);
+  initialize(cube_, mesh_, iso, passes, reverse);
 }
 
 MeshGenerator::~MeshGenerator()
@@ -44,6 +84,7 @@ bool MeshGenerator::initialize(const Cube* cube_, Mesh* mesh_, float iso,
     return false;
   m_cube = cube_;
   m_mesh = mesh_;
+  m_negativeMesh = nullptr;
   m_iso = iso;
   m_passes = passes;
   m_reverseWinding = reverse;
@@ -55,11 +96,21 @@ bool MeshGenerator::initialize(const Cube* cube_, Mesh* mesh_, float iso,
     m_stepSize[i] = static_cast<float>(m_cube->spacing()[i]);
   m_min = m_cube->min().cast<float>();
   m_dim = m_cube->dimensions();
-  m_progmax = m_dim.x();
+  // progress counts the x planes of cubes, one fewer than the grid planes
+  m_progmax = std::max(m_dim.x() - 1, 0);
   m_cube->lock()->unlock();
   return true;
 }
 
+bool MeshGenerator::initialize(const Cube* cube_, Mesh* mesh_,
+                               Mesh* negativeMesh_, float iso, int passes)
+{
+  if (!initialize(cube_, mesh_, iso, passes, false))
+    return false;
+  m_negativeMesh = negativeMesh_;
+  return true;
+}
+
 void MeshGenerator::run()
 {
   if (!m_cube || !m_mesh) {
@@ -71,40 +122,54 @@ void MeshGenerator::run()
   while (!m_cube->lock()->tryLock())
     sleep(1);
 
-  // Mark the mesh as being worked on and clear it
-  m_mesh->setStable(false);
-  m_mesh->clear();
-
-  m_vertices.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
-  m_normals.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
+  // Mark the meshes as being worked on and clear them
+  std::vector<Mesh*> meshes(1, m_mesh);
+  if (m_negativeMesh)
+    meshes.push_back(m_negativeMesh);
+  for (Mesh* mesh : meshes) {
+    mesh->setStable(false);
+    mesh->clear();
+  }
 
-  // Now to march the cube
-  for (int i = 0; i < m_dim.x() - 1; ++i) {
-    for (int j = 0; j < m_dim.y() - 1; ++j) {
-      for (int k = 0; k < m_dim.z() - 1; ++k) {
-        marchingCube(Vector3i(i, j, k));
-      }
-    }
-    if (m_vertices.capacity() < m_vertices.size() + m_dim.y() * m_dim.x() * 3) {
-      m_vertices.reserve(m_vertices.capacity() * 2);
-      m_normals.reserve(m_normals.capacity() * 2);
-    }
-    emit progressValueChanged(i);
+  // Now to march the cube, in slabs of x planes
+  const std::vector<float>& data = *m_cube->data();
+  const Index cells = m_dim.x() - 1;
+  const size_t points = static_cast<size_t>(std::max(m_dim.x(), 0)) *
+                        std::max(m_dim.y(), 0) * std::max(m_dim.z(), 0);
+  std::vector<Slab> slabs;
+  Index slabCount = 0;
+  if (cells > 0 && m_dim.y() > 1 && m_dim.z() > 1 && data.size() >= points) {
+    m_data = data.data();
+    const Index planes =
+      std::max<Index>(1, cells / (4 * Core::maxThreadCount()));
+    slabCount = (cells + planes - 1) / planes;
+    slabs.resize(slabCount * meshes.size());
+    // The workers only count finished planes. Progress is signaled from
+    // the thread running this function, which also takes slabs, so
+    // receivers are not called from the worker threads.
+    std::atomic<int> done(0);
+    const std::thread::id owner = std::this_thread::get_id();
+    Core::parallelFor(0, cells, planes, [&](Index begin, Index end) {
+      marchSlab(static_cast<int>(begin), static_cast<int>(end), end == cells,
+                &slabs[(begin / planes) * meshes.size()]);
+      const int progress = done += static_cast<int>(end - begin);
+      if (std::this_thread::get_id() == owner)
+        emit progressValueChanged(progress);
+    });
+    m_data = nullptr;
   }
+  emit progressValueChanged(m_progmax);
 
   m_cube->lock()->unlock();
 
-  // Copy the data across
-  m_mesh->setVertices(m_vertices);
-  m_mesh->setNormals(m_normals);
-  m_mesh->setStable(true);
-
-  // Now we are done give all that memory back
-  m_vertices.resize(0);
-  m_normals.resize(0);
-
-  // Smooth out the mesh
-  m_mesh->smooth(m_passes);
+  // Copy the data across, then smooth out the meshes
+  for (size_t s = 0; s < meshes.size(); ++s) {
+    mergeSlabs(slabs.data() + s, slabCount, meshes.size(), meshes[s]);
+    meshes[s]->setStable(true);
+  }
+  slabs.clear();
+  for (Mesh* mesh : meshes)
+    mesh->smooth(m_passes);
 }
 
 void MeshGenerator::clear()
@@ -113,6 +178,7 @@ void MeshGenerator::clear()
   m_passes = 6;
   m_cube = nullptr;
   m_mesh = nullptr;
+  m_negativeMesh = nullptr;
   m_stepSize.setZero();
   m_min.setZero();
   m_dim.setZero();
@@ -120,115 +186,201 @@ void MeshGenerator::clear()
   m_progmax = 0;
 }
 
-Vector3f MeshGenerator::normal(const Vector3f& pos)
-{
-  Vector3f norm(m_cube->valuef(pos - Vector3f(0.01f, 0.00f, 0.00f)) -
-                  m_cube->valuef(pos + Vector3f(0.01f, 0.00f, 0.00f)),
-                m_cube->valuef(pos - Vector3f(0.00f, 0.01f, 0.00f)) -
-                  m_cube->valuef(pos + Vector3f(0.00f, 0.01f, 0.00f)),
-                m_cube->valuef(pos - Vector3f(0.00f, 0.00f, 0.01f)) -
-                  m_cube->valuef(pos + Vector3f(0.00f, 0.00f, 0.01f)));
-  norm.normalize();
-  return norm;
-}
-
-inline float MeshGenerator::offset(float val1, float val2)
+void MeshGenerator::marchSlab(int begin, int end, bool last, Slab* slabs) const
 {
-  if (val2 - val1 < 1.0e-9f && val1 - val2 < 1.0e-9f)
-    return 0.5;
-  return (m_iso - val1) / (val2 - val1);
-}
-
-unsigned long MeshGenerator::duplicate(const Vector3i&, const Vector3f&)
-{
-  // FIXME Not implemented yet.
-  return 0;
-}
+  const int ny = m_dim.y();
+  const int nz = m_dim.z();
+  const size_t faceEdges = static_cast<size_t>(ny) * nz * 2;
+  const int surfaces = m_negativeMesh ? 2 : 1;
+  const float isos[2] = { m_iso, -m_iso };
+  const bool reverse[2] = { m_reverseWinding, !m_reverseWinding };
+
+  // The vertex on each grid edge touched by the current plane of cubes
+  struct Edges
+  {
+    std::vector<unsigned int> lower, upper, along;
+  };
+  Edges edges[2];
+  for (int s = 0; s < surfaces; ++s) {
+    edges[s].lower.assign(faceEdges, NoVertex);
+    edges[s].upper.resize(faceEdges);
+    edges[s].along.resize(faceEdges / 2);
+  }
 
-bool MeshGenerator::marchingCube(const Vector3i& pos)
-{
-  float afCubeValue[8];
-  Vector3f asEdgeVertex[12];
-  Vector3f asEdgeNorm[12];
+  auto index = [ny, nz](int i, int j, int k) {
+    return (static_cast<size_t>(i) * ny + j) * nz + k;
+  };
 
-  // Calculate the position in the Cube
-  Vector3f fPos;
-  for (unsigned int i = 0; i < 3; ++i)
-    fPos[i] = static_cast<float>(pos[i]) * m_stepSize[i] + m_min[i];
+  for (int i = begin; i < end; ++i) {
+    // edges on the upper face of the slab belong to the next slab
+    const bool foreign = !last && i == end - 1;
+    for (int s = 0; s < surfaces; ++s) {
+      std::fill(edges[s].upper.begin(), edges[s].upper.end(), NoVertex);
+      std::fill(edges[s].along.begin(), edges[s].along.end(), NoVertex);
+    }
 
-  // Make a local copy of the values at the cube's corners
-  for (int i = 0; i < 8; ++i) {
-    afCubeValue[i] = static_cast<float>(
-      m_cube->value(Vector3i(pos + Vector3i(a2iVertexOffset[i]))));
-  }
+    for (int j = 0; j < ny - 1; ++j) {
+      for (int k = 0; k < nz - 1; ++k) {
+        // Make a local copy of the values at the cube's corners
+        float afCubeValue[8];
+        for (int c = 0; c < 8; ++c) {
+          afCubeValue[c] = m_data[index(i + a2iVertexOffset[c][0],
+                                        j + a2iVertexOffset[c][1],
+                                        k + a2iVertexOffset[c][2])];
+        }
+
+        for (int s = 0; s < surfaces; ++s) {
+          // Find which vertices are inside of the surface
+          const float iso = isos[s];
+          int iFlagIndex = 0;
+          for (int c = 0; c < 8; ++c) {
+            if (afCubeValue[c] <= iso)
+              iFlagIndex |= 1 << c;
+          }
+
+          // No intersections if the cube is entirely inside or outside
+          const long iEdgeFlags = aiCubeEdgeFlags[iFlagIndex];
+          if (iEdgeFlags == 0)
+            continue;
+
+          // Find (or add) the vertex on each edge crossing the surface
+          Slab& slab = slabs[s];
+          unsigned int edgeVertex[12];
+          for (int e = 0; e < 12; ++e) {
+            if (!(iEdgeFlags & (1 << e)))
+              continue;
+            const int* start = a2iEdgeStart[e];
+            const int axis = start[3];
+            const size_t point =
+              static_cast<size_t>(j + start[1]) * nz + k + start[2];
+            unsigned int* slot;
+            if (axis == 0)
+              slot = &edges[s].along[point];
+            else if (start[0] == 0)
+              slot = &edges[s].lower[point * 2 + axis - 1];
+            else
+              slot = &edges[s].upper[point * 2 + axis - 1];
+
+            if (*slot == NoVertex) {
+              if (axis != 0 && start[0] == 1 && foreign) {
+                *slot = ForeignVertex |
+                        static_cast<unsigned int>(slab.foreignEdges.size());
+                slab.foreignEdges.push_back(point * 2 + axis - 1);
+              } else {
+                const Vector3i p0(i + start[0], j + start[1], k + start[2]);
+                Vector3i p1 = p0;
+                ++p1[axis];
+                const float val1 = m_data[index(p0.x(), p0.y(), p0.z())];
+                const float val2 = m_data[index(p1.x(), p1.y(), p1.z())];
+                float fOffset = 0.5f;
+                if (val2 - val1 >= 1.0e-9f || val1 - val2 >= 1.0e-9f)
+                  fOffset = (iso - val1) / (val2 - val1);
+
+                Vector3f vertex = p0.cast<float>();
+                vertex[axis] += fOffset;
+                vertex = m_min + vertex.cwiseProduct(m_stepSize);
+                const Vector3f norm = normal(p0, axis, fOffset);
+                *slot = static_cast<unsigned int>(slab.vertices.size());
+                slab.vertices.push_back(vertex);
+                slab.normals.push_back(reverse[s] ? Vector3f(-norm) : norm);
+              }
+            }
+            edgeVertex[e] = *slot;
+          }
+
+          // Store the triangles that were found, there can be up to five
+          const int* table = a2iTriangleConnectionTable[iFlagIndex];
+          for (int t = 0; t < 15 && table[t] >= 0; t += 3) {
+            // Make sure we get the triangle winding the right way around!
+            if (!reverse[s]) {
+              for (int c = 0; c < 3; ++c)
+                slab.triangles.push_back(edgeVertex[table[t + c]]);
+            } else {
+              for (int c = 2; c >= 0; --c)
+                slab.triangles.push_back(edgeVertex[table[t + c]]);
+            }
+          }
+        }
+      }
+    }
 
-  // Find which vertices are inside of the surface and which are outside
-  long iFlagIndex = 0;
-  for (int i = 0; i < 8; ++i) {
-    if (afCubeValue[i] <= m_iso) {
-      iFlagIndex |= 1 << i;
+    for (int s = 0; s < surfaces; ++s) {
+      // the previous slab looks up its foreign edges in the first face
+      if (i == begin && begin > 0)
+        slabs[s].lowerFace = edges[s].lower;
+      edges[s].lower.swap(edges[s].upper);
     }
   }
+}
 
-  // Find which edges are intersected by the surface
-  long iEdgeFlags = aiCubeEdgeFlags[iFlagIndex];
+Vector3f MeshGenerator::normal(const Vector3i& start, int axis, float t) const
+{
+  Vector3i end = start;
+  ++end[axis];
+  // The surface faces away from increasing values
+  Vector3f norm = -((1.0f - t) * gradient(start) + t * gradient(end));
+  norm.normalize();
+  return norm;
+}
 
-  // No intersections if the cube is entirely inside or outside of the surface
-  if (iEdgeFlags == 0) {
-    return false;
+Vector3f MeshGenerator::gradient(const Vector3i& pos) const
+{
+  const Vector3i strides(m_dim.y() * m_dim.z(), m_dim.z(), 1);
+  const float* value = m_data + pos.dot(strides);
+  Vector3f grad;
+  for (int c = 0; c < 3; ++c) {
+    // central differences inside the grid, one-sided at its faces
+    const int lower = pos[c] > 0 ? 1 : 0;
+    const int upper = pos[c] < m_dim[c] - 1 ? 1 : 0;
+    if (lower + upper == 0) {
+      grad[c] = 0.0f;
+      continue;
+    }
+    grad[c] = (value[upper * strides[c]] - value[-lower * strides[c]]) /
+              ((lower + upper) * m_stepSize[c]);
   }
+  return grad;
+}
 
-  // Find the point of intersection of the surface with each edge
-  // Then find the normal to the surface at those points
-  for (int i = 0; i < 12; ++i) {
-    // if there is an intersection on this edge
-    if (iEdgeFlags & (1 << i)) {
-      float fOffset = offset(afCubeValue[a2iEdgeConnection[i][0]],
-                             afCubeValue[a2iEdgeConnection[i][1]]);
-
-      asEdgeVertex[i] =
-        Vector3f(fPos.x() +
-                   (a2fVertexOffset[a2iEdgeConnection[i][0]][0] +
-                    fOffset * a2fEdgeDirection[i][0]) *
-                     m_stepSize[0],
-                 fPos.y() +
-                   (a2fVertexOffset[a2iEdgeConnection[i][0]][1] +
-                    fOffset * a2fEdgeDirection[i][1]) *
-                     m_stepSize[1],
-                 fPos.z() +
-                   (a2fVertexOffset[a2iEdgeConnection[i][0]][2] +
-                    fOffset * a2fEdgeDirection[i][2]) *
-                     m_stepSize[2]);
-
-      /// FIXME Optimize this to only calculate normals when required
-      asEdgeNorm[i] = normal(asEdgeVertex[i]);
-    }
+void MeshGenerator::mergeSlabs(const Slab* slabs, size_t count, size_t stride,
+                               Mesh* mesh)
+{
+  // The offset of the first vertex of each slab in the merged mesh
+  std::vector<unsigned int> offsets(count + 1, 0);
+  size_t triangleCount = 0;
+  for (size_t n = 0; n < count; ++n) {
+    const Slab& slab = slabs[n * stride];
+    offsets[n + 1] =
+      offsets[n] + static_cast<unsigned int>(slab.vertices.size());
+    triangleCount += slab.triangles.size();
   }
 
-  // Store the triangles that were found, there can be up to five per cube
-  for (int i = 0; i < 5; ++i) {
-    if (a2iTriangleConnectionTable[iFlagIndex][3 * i] < 0)
-      break;
-    int iVertex = 0;
-    iEdgeFlags = a2iTriangleConnectionTable[iFlagIndex][3 * i];
-    // Make sure we get the triangle winding the right way around!
-    if (!m_reverseWinding) {
-      for (int j = 0; j < 3; ++j) {
-        iVertex = a2iTriangleConnectionTable[iFlagIndex][3 * i + j];
-        m_indices.push_back(static_cast<unsigned int>(m_vertices.size()));
-        m_normals.push_back(asEdgeNorm[iVertex]);
-        m_vertices.push_back(asEdgeVertex[iVertex]);
-      }
-    } else {
-      for (int j = 2; j >= 0; --j) {
-        iVertex = a2iTriangleConnectionTable[iFlagIndex][3 * i + j];
-        m_indices.push_back(static_cast<unsigned int>(m_vertices.size()));
-        m_normals.push_back(-asEdgeNorm[iVertex]);
-        m_vertices.push_back(asEdgeVertex[iVertex]);
+  Core::Array<Vector3f> vertices;
+  Core::Array<Vector3f> normals;
+  Core::Array<unsigned int> triangles;
+  vertices.reserve(offsets.back());
+  normals.reserve(offsets.back());
+  triangles.reserve(triangleCount);
+  for (size_t n = 0; n < count; ++n) {
+    const Slab& slab = slabs[n * stride];
+    vertices.insert(vertices.end(), slab.vertices.begin(),
+                    slab.vertices.end());
+    normals.insert(normals.end(), slab.normals.begin(), slab.normals.end());
+    for (unsigned int vertex : slab.triangles) {
+      if (vertex & ForeignVertex) {
+        // the vertex on this edge was added by the next slab
+        const Slab& next = slabs[(n + 1) * stride];
+        const size_t edge = slab.foreignEdges[vertex & ~ForeignVertex];
+        triangles.push_back(offsets[n + 1] + next.lowerFace[edge]);
+      } else {
+        triangles.push_back(offsets[n] + vertex);
       }
     }
   }
-  return true;
+
+  mesh->setVertices(vertices);
+  mesh->setNormals(normals);
+  mesh->setTriangles(triangles);
 }
 
 // Lists the positions, relative to vertex0, of the 8 vertices of a cube
@@ -8,7 +8,6 @@
 
 #include "avogadroqtguiexport.h"
 
-#include <avogadro/core/array.h>
 #include <avogadro/core/vector.h>
 
 #include <QtCore/QThread>
@@ -34,6 +33,13 @@ namespace QtGui {
  * by Cory Bloyd (marchingsource.cpp) and available at,
  * http://local.wasp.uwa.edu.au/~pbourke/geometry/polygonise/
  *
+ * The cube is split into slabs of x planes that are polygonized in parallel.
+ * Vertices are placed on the edges of the grid, and each edge gets a single
+ * vertex that is shared by all of the triangles around it, so the resulting
+ * Mesh is indexed (see Core::Mesh::triangles()). Both the positive and the
+ * negative isosurface, e.g., the two lobes of an orbital, can be found in
+ * the same pass over the cube.
+ *
  * You must first initialize the class and then call run() to actually
  * polygonize the isosurface. Connect to the classes finished() signal to
  * do something once the polygonization is complete.
@@ -75,6 +81,19 @@ public:
   bool initialize(const Core::Cube* cube, Core::Mesh* mesh, float iso,
                   int passes = 6, bool reverse = false);
 
+  /**
+   * Initialization function, set up the MeshGenerator ready to find both the
+   * @p iso and the -@p iso isosurfaces of the supplied Cube in one pass.
+   * @param cube The source Cube with the volumetric data.
+   * @param mesh The Mesh that will hold the isosurface at @p iso.
+   * @param negativeMesh The Mesh that will hold the isosurface at -@p iso,
+   * with its winding and normals reversed.
+   * @param iso The iso value of the positive surface.
+   * @param passes Number of smoothing passes to perform.
+   */
+  bool initialize(const Core::Cube* cube, Core::Mesh* mesh,
+                  Core::Mesh* negativeMesh, float iso, int passes = 6);
+
   /**
    * Use this function to begin Mesh generation. Uses an asynchronous thread,
    * and so avoids locking the user interface while the isosurface is found.
@@ -91,6 +110,12 @@ public:
    */
   Core::Mesh* mesh() const { return m_mesh; }
 
+  /**
+   * @return The Mesh for the negative isosurface, or nullptr if only one
+   * surface is being generated.
+   */
+  Core::Mesh* negativeMesh() const { return m_negativeMesh; }
+
   /**
    * Clears the contents of the MeshGenerator.
    */
@@ -113,39 +138,46 @@ signals:
   void progressValueChanged(int);
 
 protected:
+  struct Slab;
+
   /**
-   * Get the normal to the supplied point. This operation is quite expensive
-   * and so should be avoided wherever possible.
-   * @param pos The position of the vertex whose normal is needed.
-   * @return The normal vector for the supplied point.
+   * Perform the marching cubes steps on the x planes [begin, end) of cubes.
+   * @param last True if this is the final slab of the cube.
+   * @param slabs The output, one Slab per surface.
    */
-  Vector3f normal(const Vector3f& pos);
+  void marchSlab(int begin, int end, bool last, Slab* slabs) const;
 
   /**
-   * Get the offset, i.e. the approximate point of intersection of the surface
-   * between two points.
-   * @param val1 The position of the vertex whose normal is needed.
-   * @return The normal vector for the supplied point.
+   * Get the normal to the surface at the supplied point along a grid edge,
+   * interpolated from the gradients at both ends of the edge.
+   * @param start The grid point at the start of the edge.
+   * @param axis The direction of the edge.
+   * @param t The fractional position along the edge.
    */
-  float offset(float val1, float val2);
-
-  unsigned long duplicate(const Vector3i& c, const Vector3f& pos);
+  Vector3f normal(const Vector3i& start, int axis, float t) const;
 
   /**
-   * Perform a marching cubes step on a single cube.
+   * @return The gradient of the cube at a grid point, by finite differences.
    */
-  bool marchingCube(const Vector3i& pos);
+  Vector3f gradient(const Vector3i& pos) const;
 
-  float m_iso;              /** The value of the isosurface. */
-  int m_passes;             /** Number of smoothing passes to perform. */
-  bool m_reverseWinding;    /** Whether the winding and normals are reversed. */
-  const Core::Cube* m_cube; /** The cube that we are generating a Mesh from. */
-  Core::Mesh* m_mesh;       /** The mesh that is being generated. */
-  Vector3f m_stepSize;      /** The step size vector for cube. */
-  Vector3f m_min;           /** The minimum point in the cube. */
-  Vector3i m_dim;           /** The dimensions of the cube. */
-  Core::Array<Vector3f> m_vertices, m_normals;
-  Core::Array<unsigned int> m_indices;
+  /**
+   * Stitch the slabs of one surface together and copy them to @p mesh.
+   * @param stride The distance between consecutive slabs of the surface.
+   */
+  static void mergeSlabs(const Slab* slabs, size_t count, size_t stride,
+                         Core::Mesh* mesh);
+
+  float m_iso;                /** The value of the isosurface. */
+  int m_passes;               /** Number of smoothing passes to perform. */
+  bool m_reverseWinding;      /** Whether the winding and normals are reversed. */
+  const Core::Cube* m_cube;   /** The cube that we are generating a Mesh from. */
+  Core::Mesh* m_mesh;         /** The mesh that is being generated. */
+  Core::Mesh* m_negativeMesh; /** The optional mesh for the -iso surface. */
+  const float* m_data;        /** The cube values, while generating. */
+  Vector3f m_stepSize;        /** The step size vector for cube. */
+  Vector3f m_min;             /** The minimum point in the cube. */
+  Vector3i m_dim;             /** The dimensions of the cube. */
   int m_progmin;
   int m_progmax;
 
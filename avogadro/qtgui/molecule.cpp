@@ -106,6 +106,15 @@ Molecule::AtomType Molecule::addAtom(unsigned char number, Vector3 position3d,
   }
 }
 
+void Molecule::addAtoms(const Core::Array<unsigned char>& atomicNumbers,
+                        const Core::Array<Vector3>& positions3d)
+{
+  Index previousCount = atomCount();
+  Core::Molecule::addAtoms(atomicNumbers, positions3d);
+  for (Index i = previousCount; i < atomCount(); ++i)
+    m_atomUniqueIds.push_back(i);
+}
+
 bool Molecule::removeAtom(Index index)
 {
   if (index >= atomCount())
@@ -179,9 +188,11 @@ void Molecule::addBonds(const Core::Array<std::pair<Index, Index>>& bonds,
                         const Core::Array<unsigned char>& orders)
 {
   assert(orders.size() == bonds.size());
-  for (Index i = 0; i < orders.size(); ++i) {
-    addBond(bonds[i].first, bonds[i].second, orders[i]);
-  }
+  // only bonds that did not exist yet get a new unique id
+  Index previousCount = bondCount();
+  Core::Molecule::addBonds(bonds, orders);
+  for (Index i = previousCount; i < bondCount(); ++i)
+    m_bondUniqueIds.push_back(i);
 }
 void Molecule::swapBond(Index a, Index b)
 {
@@ -97,6 +97,9 @@ public:
   AtomType addAtom(unsigned char number, Vector3 position3d,
                    Index uniqueId = MaxIndex);
 
+  void addAtoms(const Core::Array<unsigned char>& atomicNumbers,
+                const Core::Array<Vector3>& positions3d) override;
+
   /**
    * @brief Remove the specified atom from the molecule.
    * @param index The index of the atom to be removed.
@@ -155,7 +158,7 @@ public:
                    unsigned char bondOrder = 1) override;
 
   void addBonds(const Core::Array<std::pair<Index, Index>>& bonds,
-                const Core::Array<unsigned char>& orders);
+                const Core::Array<unsigned char>& orders) override;
   /**
    * @brief Add a bond between the specified atoms.
    * @param a The first atom in the bond.
@@ -82,7 +82,7 @@ void PluginLayerManager::setEnabled(bool enable)
   molecule->enable[m_name][activeLayer] = enable;
 }
 
-bool PluginLayerManager::atomEnabled(Index atom) const
+bool PluginLayerManager::layerEnabled(size_t layer) const
 {
   if (m_activeMolecule == nullptr || m_molToInfo[m_activeMolecule] == nullptr ||
       m_molToInfo[m_activeMolecule]->enable.find(m_name) ==
@@ -90,12 +90,20 @@ bool PluginLayerManager::atomEnabled(Index atom) const
     return false;
   }
   auto& molecule = m_molToInfo[m_activeMolecule];
-  size_t layer = molecule->layer.getLayerID(atom);
+  return layer < molecule->enable[m_name].size() &&
+         molecule->enable[m_name][layer] && molecule->visible[layer];
+}
+
+bool PluginLayerManager::atomEnabled(Index atom) const
+{
+  if (m_activeMolecule == nullptr || m_molToInfo[m_activeMolecule] == nullptr) {
+    return false;
+  }
+  size_t layer = m_molToInfo[m_activeMolecule]->layer.getLayerID(atom);
   if (layer == MaxIndex) {
     return false;
   }
-  return layer < molecule->enable[m_name].size() &&
-         molecule->enable[m_name][layer] && molecule->visible[layer];
+  return layerEnabled(layer);
 }
 
 size_t PluginLayerManager::getLayerID(Index atom) const
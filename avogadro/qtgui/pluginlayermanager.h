@@ -62,6 +62,9 @@ public:
   /** set active layer @p enable */
   void setEnabled(bool enable);
 
+  /** @return @p layer enabled globally and in plugin */
+  bool layerEnabled(size_t layer) const;
+
   /** @return @p atom layer enabled globally and in plugin */
   bool atomEnabled(Index atom) const;
 
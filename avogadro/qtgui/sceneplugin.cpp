@@ -17,6 +17,12 @@ void ScenePlugin::process(const QtGui::Molecule&,
 
 void ScenePlugin::processEditable(const RWMolecule&, Rendering::GroupNode&) {}
 
+bool ScenePlugin::processChanges(const QtGui::Molecule&, unsigned int,
+                                 Rendering::GroupNode&)
+{
+  return false;
+}
+
 QWidget* ScenePlugin::setupWidget()
 {
   return nullptr;
@@ -51,6 +51,17 @@ public:
   virtual void processEditable(const RWMolecule& molecule,
                                Rendering::GroupNode& node);
 
+  /**
+   * Update the primitives the last call to process() added to @p node for
+   * @p changes made to the molecule, a combination of
+   * Molecule::MoleculeChange flags, instead of adding them all again.
+   * @return True if the primitives were updated in place, false (the default)
+   * if the scene has to be built anew.
+   */
+  virtual bool processChanges(const QtGui::Molecule& molecule,
+                              unsigned int changes,
+                              Rendering::GroupNode& node);
+
   /**
    * The name of the scene plugin, will be displayed in the user interface.
    */
@@ -47,7 +47,8 @@ void GLWidget::setMolecule(QtGui::Molecule* mol)
   m_molecule = mol;
   foreach (QtGui::ToolPlugin* tool, m_tools)
     tool->setMolecule(m_molecule);
-  connect(m_molecule, SIGNAL(changed(unsigned int)), SLOT(updateScene()));
+  connect(m_molecule, SIGNAL(changed(unsigned int)),
+          SLOT(moleculeChanged(unsigned int)));
 }
 
 QtGui::Molecule* GLWidget::molecule()
@@ -69,6 +70,8 @@ void GLWidget::updateScene()
   if (mol) {
     Rendering::GroupNode& node = m_renderer.scene().rootNode();
     node.clear();
+    m_pluginNodes.clear();
+    m_toolNodes.clear();
     auto* moleculeNode = new Rendering::GroupNode(&node);
     QtGui::RWMolecule* rwmol = mol->undoMolecule();
 
@@ -77,17 +80,21 @@ void GLWidget::updateScene()
       auto* engineNode = new Rendering::GroupNode(moleculeNode);
       scenePlugin->process(*mol, *engineNode);
       scenePlugin->processEditable(*rwmol, *engineNode);
+      if (mol == m_molecule)
+        m_pluginNodes.append(qMakePair(scenePlugin, engineNode));
     }
 
     // Let the tools perform any drawing they need to do.
     if (m_activeTool) {
       auto* toolNode = new Rendering::GroupNode(moleculeNode);
       m_activeTool->draw(*toolNode);
+      m_toolNodes.append(qMakePair(m_activeTool, toolNode));
     }
 
     if (m_defaultTool) {
       auto* toolNode = new Rendering::GroupNode(moleculeNode);
       m_defaultTool->draw(*toolNode);
+      m_toolNodes.append(qMakePair(m_defaultTool, toolNode));
     }
 
     m_renderer.resetGeometry();
@@ -97,9 +104,60 @@ void GLWidget::updateScene()
     delete mol;
 }
 
+bool GLWidget::updateSceneInPlace(unsigned int changes)
+{
+  // The scene must have been built for this molecule with the same plugins.
+  const QList<QtGui::ScenePlugin*> plugins =
+    m_scenePlugins.activeScenePlugins();
+  if (!m_molecule || m_pluginNodes.isEmpty() ||
+      plugins.size() != m_pluginNodes.size()) {
+    return false;
+  }
+  for (int i = 0; i < plugins.size(); ++i) {
+    if (plugins[i] != m_pluginNodes[i].first)
+      return false;
+  }
+  QList<QtGui::ToolPlugin*> tools;
+  if (m_activeTool)
+    tools << m_activeTool;
+  if (m_defaultTool)
+    tools << m_defaultTool;
+  if (tools.size() != m_toolNodes.size())
+    return false;
+  for (int i = 0; i < tools.size(); ++i) {
+    if (tools[i] != m_toolNodes[i].first)
+      return false;
+  }
+
+  for (const auto& pluginNode : m_pluginNodes) {
+    if (!pluginNode.first->processChanges(*m_molecule, changes,
+                                          *pluginNode.second)) {
+      return false;
+    }
+  }
+
+  // The tools draw little, so they simply draw again.
+  for (const auto& toolNode : m_toolNodes) {
+    toolNode.second->clear();
+    toolNode.first->draw(*toolNode.second);
+  }
+
+  m_renderer.resetGeometry();
+  update();
+  return true;
+}
+
+void GLWidget::moleculeChanged(unsigned int changes)
+{
+  if (!updateSceneInPlace(changes))
+    updateScene();
+}
+
 void GLWidget::clearScene()
 {
   m_renderer.scene().clear();
+  m_pluginNodes.clear();
+  m_toolNodes.clear();
 }
 
 void GLWidget::resetCamera()
@@ -12,6 +12,7 @@
 #include <avogadro/qtgui/toolplugin.h>
 #include <avogadro/rendering/glrenderer.h>
 
+#include <QPair>
 #include <QPointer>
 #include <QOpenGLWidget>
 
@@ -165,6 +166,12 @@ protected slots:
    */
   void updateTimeout();
 
+  /**
+   * Let the scene plugins update their primitives in place for @p changes
+   * to the molecule, and only build the scene anew if one of them cannot.
+   */
+  void moleculeChanged(unsigned int changes);
+
 protected:
   /** This is where the GL context is initialized. */
   void initializeGL() override;
@@ -186,12 +193,17 @@ protected:
   /** @} */
 
 private:
+  bool updateSceneInPlace(unsigned int changes);
+
   QPointer<QtGui::Molecule> m_molecule;
   QList<QtGui::ToolPlugin*> m_tools;
   QtGui::ToolPlugin* m_activeTool;
   QtGui::ToolPlugin* m_defaultTool;
   Rendering::GLRenderer m_renderer;
   QtGui::ScenePluginModel m_scenePlugins;
+  // The nodes filled by the last updateScene(), in the order they were drawn.
+  QList<QPair<QtGui::ScenePlugin*, Rendering::GroupNode*>> m_pluginNodes;
+  QList<QPair<QtGui::ToolPlugin*, Rendering::GroupNode*>> m_toolNodes;
 
   QTimer* m_renderTimer;
 };
@@ -147,29 +147,16 @@ bool Apbs::loadOpenDxFile(const QString& fileName, QtGui::Molecule& molecule)
         m_progressDialog =
           new QProgressDialog(qobject_cast<QWidget*>(parent()));
 
-      // generate positive mesh
-      m_progressDialog->setLabelText("Generating Positive Potential Mesh");
+      // generate the positive and negative meshes in one pass
+      m_progressDialog->setLabelText("Generating Potential Meshes");
       m_progressDialog->setRange(0, 100);
       m_progressDialog->setValue(1);
       qApp->processEvents();
 
       Mesh* mesh = molecule.addMesh();
-      auto* meshGenerator =
-        new QtGui::MeshGenerator(cube, mesh, 0.1f);
-      connect(meshGenerator, SIGNAL(finished()), this,
-              SLOT(meshGeneratorFinished()));
-      connect(meshGenerator, SIGNAL(progressValueChanged(int)), this,
-              SLOT(onMeshGeneratorProgress(int)));
-      meshGenerator->run();
-
-      // generate negative mesh
-      m_progressDialog->setLabelText("Generating Negative Potential Mesh");
-      m_progressDialog->setRange(0, 100);
-      m_progressDialog->setValue(1);
-      qApp->processEvents();
-
-      mesh = molecule.addMesh();
-      meshGenerator = new QtGui::MeshGenerator(cube, mesh, -0.1f);
+      Mesh* negativeMesh = molecule.addMesh();
+      auto* meshGenerator = new QtGui::MeshGenerator;
+      meshGenerator->initialize(cube, mesh, negativeMesh, 0.1f);
       connect(meshGenerator, SIGNAL(finished()), this,
               SLOT(meshGeneratorFinished()));
       connect(meshGenerator, SIGNAL(progressValueChanged(int)), this,
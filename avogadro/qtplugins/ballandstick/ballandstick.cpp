@@ -131,6 +131,7 @@ void BallAndStick::process(const QtGui::Molecule& molecule,
   m_layerManager.load<LayerBallAndStick>();
   // Add a sphere node to contain all of the spheres.
   m_group = &node;
+  m_drawnLayers = drawnLayers();
   auto* geometry = new GeometryNode;
   node.addChild(geometry);
   auto* spheres = new SphereGeometry;
@@ -141,93 +142,91 @@ void BallAndStick::process(const QtGui::Molecule& molecule,
   geometry->addDrawable(spheres);
   geometry->addDrawable(selectedSpheres);
 
-  for (Index i = 0; i < molecule.atomCount(); ++i) {
-    Core::Atom atom = molecule.atom(i);
-    if (!m_layerManager.atomEnabled(i)) {
-      continue;
-    }
-    unsigned char atomicNumber = atom.atomicNumber();
-    auto& interface = m_layerManager.getSetting<LayerBallAndStick>(
-      m_layerManager.getLayerID(i));
-    if (atomicNumber == 1 && !interface.showHydrogens)
-      continue;
-
-    Vector3ub color = atom.color();
-    auto radius = static_cast<float>(Elements::radiusVDW(atomicNumber));
-    float scale = interface.atomScale;
-    spheres->addSphere(atom.position3d().cast<float>(), color, radius * scale,
-                       i);
-    if (atom.selected()) {
-      color = Vector3ub(0, 0, 255);
-      radius *= 1.2;
-      selectedSpheres->addSphere(atom.position3d().cast<float>(), color,
-                                 radius * scale, i);
-    }
-  }
-
   auto* cylinders = new CylinderGeometry;
   cylinders->identifier().molecule = &molecule;
   cylinders->identifier().type = Rendering::BondType;
   geometry->addDrawable(cylinders);
-  for (Index i = 0; i < molecule.bondCount(); ++i) {
-    Core::Bond bond = molecule.bond(i);
-    if (!m_layerManager.bondEnabled(bond.atom1().index(),
-                                    bond.atom2().index())) {
-      continue;
-    }
 
-    auto& interface1 = m_layerManager.getSetting<LayerBallAndStick>(
-      m_layerManager.getLayerID(bond.atom1().index()));
-    auto& interface2 = m_layerManager.getSetting<LayerBallAndStick>(
-      m_layerManager.getLayerID(bond.atom2().index()));
+  m_builder.reset(spheres, selectedSpheres, cylinders);
+  for (Index i = 0; i < molecule.atomCount(); ++i)
+    addAtom(molecule, i);
+  for (Index i = 0; i < molecule.bondCount(); ++i)
+    addBond(molecule, i);
+  m_builder.finish(molecule);
+}
 
-    if (!interface1.showHydrogens && !interface2.showHydrogens &&
-        (bond.atom1().atomicNumber() == 1 ||
-         bond.atom2().atomicNumber() == 1)) {
-      continue;
-    }
+bool BallAndStick::processChanges(const QtGui::Molecule& molecule,
+                                  unsigned int, Rendering::GroupNode& node)
+{
+  // The change flags overlap too much to tell moved atoms from atoms moved
+  // to another layer, so what was drawn is compared with the molecule.
+  if (&node != m_group || !m_builder.isValid() ||
+      drawnLayers() != m_drawnLayers || !m_builder.atomsMatch(molecule)) {
+    return false;
+  }
 
-    float bondRadius = (interface1.bondRadius + interface2.bondRadius) * 0.5f;
-
-    Vector3f pos1 = bond.atom1().position3d().cast<float>();
-    Vector3f pos2 = bond.atom2().position3d().cast<float>();
-    Vector3ub color1 = bond.atom1().color();
-    Vector3ub color2 = bond.atom2().color();
-    Vector3f bondVector = pos2 - pos1;
-    float bondLength = bondVector.norm();
-    bondVector /= bondLength;
-
-    switch (interface1.multiBonds || interface2.multiBonds ? bond.order() : 1) {
-      case 3: {
-        Vector3f delta = bondVector.unitOrthogonal();
-        // Rotate 45 degrees around the bond vector.
-        Eigen::Quaternionf q;
-        q = Eigen::AngleAxisf(45.0f * DEG_TO_RAD_F, bondVector);
-        delta = q * delta * 2.0f * bondRadius;
-        cylinders->addCylinder(pos1 + delta, pos2 + delta, bondRadius * 1.15,
-                               color1, color2, i);
-        cylinders->addCylinder(pos1 - delta, pos2 - delta, bondRadius * 1.15,
-                               color1, color2, i);
-        // This relies upon the single bond case below for the third cylinder.
-        [[fallthrough]];
-      }
-      default:
-      case 1:
-        cylinders->addCylinder(pos1, pos2, m_bondRadius, color1, color2, i);
-        break;
-      case 2: {
-        Vector3f delta = bondVector.unitOrthogonal();
-        // Rotate 45 degrees around the bond vector.
-        Eigen::Quaternionf q;
-        q = Eigen::AngleAxisf(45.0f * DEG_TO_RAD_F, bondVector);
-        delta = q * delta * bondRadius;
-        cylinders->addCylinder(pos1 + delta, pos2 + delta, bondRadius * 1.3,
-                               color1, color2, i);
-        cylinders->addCylinder(pos1 - delta, pos2 - delta, bondRadius * 1.3,
-                               color1, color2, i);
-      }
-    }
+  const bool sameBonds = m_builder.bondsMatch(molecule);
+  if (!sameBonds)
+    m_builder.clearBonds();
+  m_builder.update(molecule);
+  for (Index i = m_builder.atomCount(); i < molecule.atomCount(); ++i)
+    addAtom(molecule, i);
+  if (!sameBonds) {
+    for (Index i = 0; i < molecule.bondCount(); ++i)
+      addBond(molecule, i);
+  }
+  m_builder.finish(molecule);
+  return true;
+}
+
+std::vector<BallAndStick::DrawnLayer> BallAndStick::drawnLayers()
+{
+  std::vector<DrawnLayer> layers;
+  for (size_t i = 0; i < m_layerManager.layerCount(); ++i) {
+    auto& interface = m_layerManager.getSetting<LayerBallAndStick>(i);
+    layers.push_back({ m_layerManager.layerEnabled(i), interface.showHydrogens,
+                       interface.multiBonds, interface.atomScale,
+                       interface.bondRadius });
   }
+  return layers;
+}
+
+void BallAndStick::addAtom(const QtGui::Molecule& molecule, Index atom)
+{
+  if (!m_layerManager.atomEnabled(atom))
+    return;
+  unsigned char atomicNumber = molecule.atomicNumber(atom);
+  auto& interface = m_layerManager.getSetting<LayerBallAndStick>(
+    m_layerManager.getLayerID(atom));
+  if (atomicNumber == 1 && !interface.showHydrogens)
+    return;
+
+  auto radius = static_cast<float>(Elements::radiusVDW(atomicNumber));
+  m_builder.addAtom(molecule, atom, radius * interface.atomScale);
+}
+
+void BallAndStick::addBond(const QtGui::Molecule& molecule, Index bond)
+{
+  const std::pair<Index, Index>& atoms = molecule.bondPairs()[bond];
+  if (!m_layerManager.bondEnabled(atoms.first, atoms.second))
+    return;
+
+  auto& interface1 = m_layerManager.getSetting<LayerBallAndStick>(
+    m_layerManager.getLayerID(atoms.first));
+  auto& interface2 = m_layerManager.getSetting<LayerBallAndStick>(
+    m_layerManager.getLayerID(atoms.second));
+
+  if (!interface1.showHydrogens && !interface2.showHydrogens &&
+      (molecule.atomicNumber(atoms.first) == 1 ||
+       molecule.atomicNumber(atoms.second) == 1)) {
+    return;
+  }
+
+  float bondRadius = (interface1.bondRadius + interface2.bondRadius) * 0.5f;
+  const int order = interface1.multiBonds || interface2.multiBonds
+                      ? molecule.bondOrders()[bond]
+                      : 1;
+  m_builder.addBond(molecule, bond, order, bondRadius, m_bondRadius);
 }
 
 QWidget* BallAndStick::setupWidget()
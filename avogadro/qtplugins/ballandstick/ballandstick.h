@@ -7,6 +7,9 @@
 #define AVOGADRO_QTPLUGINS_BALLANDSTICK_H
 
 #include <avogadro/qtgui/sceneplugin.h>
+#include <avogadro/rendering/ballandstickbuilder.h>
+
+#include <vector>
 
 namespace Avogadro {
 namespace QtPlugins {
@@ -26,6 +29,14 @@ public:
   void process(const QtGui::Molecule& molecule,
                Rendering::GroupNode& node) override;
 
+  /**
+   * Move, recolor and (de)select the spheres and cylinders in place, and add
+   * new atoms and changed bonds, as long as the layers and the elements and
+   * layers of the atoms drawn before are unchanged.
+   */
+  bool processChanges(const QtGui::Molecule& molecule, unsigned int changes,
+                      Rendering::GroupNode& node) override;
+
   QString name() const override { return tr("Ball and Stick"); }
 
   QString description() const override
@@ -47,7 +58,32 @@ public slots:
   void showHydrogens(bool show);
 
 private:
+  // How the atoms in a layer are drawn.
+  struct DrawnLayer
+  {
+    bool enabled;
+    bool showHydrogens;
+    bool multiBonds;
+    float atomScale;
+    float bondRadius;
+
+    bool operator==(const DrawnLayer& other) const
+    {
+      return enabled == other.enabled &&
+             showHydrogens == other.showHydrogens &&
+             multiBonds == other.multiBonds && atomScale == other.atomScale &&
+             bondRadius == other.bondRadius;
+    }
+  };
+
+  std::vector<DrawnLayer> drawnLayers();
+  void addAtom(const QtGui::Molecule& molecule, Index atom);
+  void addBond(const QtGui::Molecule& molecule, Index bond);
+
   Rendering::GroupNode* m_group;
+  // What the last process() call drew, to update it in place.
+  Rendering::BallAndStickBuilder m_builder;
+  std::vector<DrawnLayer> m_drawnLayers;
   std::string m_name = "Ball and Stick";
   float m_atomScale = 0.3f;
   float m_bondRadius = 0.1f;
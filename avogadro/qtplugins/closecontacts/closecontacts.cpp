@@ -129,7 +129,8 @@ void CloseContacts::process(const Molecule &molecule, Rendering::GroupNode &node
     if (!isAtomEnabled[i])
       continue;
     Vector3 pos = molecule.atomPosition3d(i);
-    perceiver.getNeighborsInclusiveInPlace(neighbors, pos);
+    // only returns atoms closer than the maximum distance
+    perceiver.getNeighborsInPlace(neighbors, pos);
     for (Index n : neighbors) {
       if (n <= i) // check each pair only once
         continue;
@@ -139,9 +140,7 @@ void CloseContacts::process(const Molecule &molecule, Rendering::GroupNode &node
         continue;
 
       Vector3 npos = molecule.atomPosition3d(n);
-      double distance = (npos - pos).norm();
-      if (distance < m_maximumDistances[0])
-        lineGroups[0]->addDashedLine(pos.cast<float>(), npos.cast<float>(), m_lineColors[0], 8);
+      lineGroups[0]->addDashedLine(pos.cast<float>(), npos.cast<float>(), m_lineColors[0], 8);
     }
   }
 
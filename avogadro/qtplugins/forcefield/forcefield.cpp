@@ -27,6 +27,7 @@
 #include <avogadro/qtgui/scriptloader.h>
 
 #include <avogadro/calc/energymanager.h>
+#include <avogadro/calc/energyproblem.h>
 #include <avogadro/calc/lennardjones.h>
 
 #include <cppoptlib/meta.h>
@@ -219,8 +220,8 @@ void Forcefield::optimize()
   bool isInteractive = m_molecule->undoMolecule()->isInteractive();
   m_molecule->undoMolecule()->setInteractive(true);
 
-  cppoptlib::LbfgsSolver<EnergyCalculator> solver;
-  // cppoptlib::ConjugatedGradientDescentSolver<EnergyCalculator> solver;
+  cppoptlib::LbfgsSolver<Calc::EnergyProblem> solver;
+  // cppoptlib::ConjugatedGradientDescentSolver<Calc::EnergyProblem> solver;
 
   int n = m_molecule->atomCount();
 
@@ -257,22 +258,22 @@ void Forcefield::optimize()
   // .. these seem to be broken in the solver code
   // .. so we handle ourselves
   solver.setStopCriteria(crit);
+  // shares each energy and gradient evaluation in the line search
+  Calc::EnergyProblem problem(*m_method);
 
-  Real energy = m_method->value(positions);
-  m_method->gradient(positions, gradient);
+  Real energy = m_method->valueAndGradient(positions, gradient);
   qDebug() << " initial " << energy << " gradNorm: " << gradient.norm();
   qDebug() << " maxSteps" << m_maxSteps << " steps "
            << m_maxSteps / crit.iterations;
 
   Real currentEnergy = 0.0;
   for (unsigned int i = 0; i < m_maxSteps / crit.iterations; ++i) {
-    solver.minimize(*m_method, positions);
+    solver.minimize(problem, positions);
 
     qApp->processEvents(QEventLoop::AllEvents, 500);
 
-    currentEnergy = m_method->value(positions);
     // get the current gradient for force visualization
-    m_method->gradient(positions, gradient);
+    currentEnergy = m_method->valueAndGradient(positions, gradient);
     qDebug() << " optimize " << i << currentEnergy
              << " gradNorm: " << gradient.norm();
 
@@ -106,12 +106,9 @@ void ScriptEnergy::setMolecule(Core::Molecule* mol)
   m_interpreter->asyncExecute(options);
 }
 
-Real ScriptEnergy::value(const Eigen::VectorXd& x)
+QStringList ScriptEnergy::evaluate(const Eigen::VectorXd& x)
 {
-  if (m_molecule == nullptr || m_interpreter == nullptr)
-    return 0.0; // nothing to do
-
-  // write the new coordinates and read the energy
+  // write the new coordinates and read the response
   QByteArray input;
   for (Index i = 0; i < x.size(); i += 3) {
     // write as x y z (space separated)
@@ -120,10 +117,15 @@ Real ScriptEnergy::value(const Eigen::VectorXd& x)
   }
   QByteArray result = m_interpreter->asyncWriteAndResponse(input);
 
+  // split on newlines
+  return QString(result).remove('\r').split('\n');
+}
+
+Real ScriptEnergy::readEnergy(const QStringList& lines)
+{
   // go through lines in result until we see "AvogadroEnergy: "
-  QStringList lines = QString(result).remove('\r').split('\n');
   double energy = 0.0;
-  for (auto line : lines) {
+  for (const auto& line : lines) {
     if (line.startsWith("AvogadroEnergy:")) {
       QStringList items = line.split(" ", QString::SkipEmptyParts);
       if (items.size() > 1) {
@@ -136,29 +138,12 @@ Real ScriptEnergy::value(const Eigen::VectorXd& x)
   return energy; // if conversion fails, returns 0.0
 }
 
-void ScriptEnergy::gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad)
+void ScriptEnergy::readGradient(const QStringList& lines,
+                                Eigen::VectorXd& grad)
 {
-  if (!m_gradients) {
-    EnergyCalculator::gradient(x, grad);
-    return;
-  }
-
-  // Get the gradient from the script
-  // write the new coordinates and read the energy
-  QByteArray input;
-  for (Index i = 0; i < x.size(); i += 3) {
-    // write as x y z (space separated)
-    input += QString::number(x[i]) + " " + QString::number(x[i + 1]) + " " +
-             QString::number(x[i + 2]) + "\n";
-  }
-  QByteArray result = m_interpreter->asyncWriteAndResponse(input);
-
-  // parse the result
-  // first split on newlines
-  QStringList lines = QString(result).remove('\r').split('\n');
-  unsigned int i = 0;
+  Eigen::Index i = 0;
   bool readingGrad = false;
-  for (auto line : lines) {
+  for (const auto& line : lines) {
     if (line.startsWith("AvogadroGradient:")) {
       readingGrad = true;
       continue; // next line
@@ -166,14 +151,14 @@ void ScriptEnergy::gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad)
 
     if (readingGrad) {
       QStringList items = line.split(" ", QString::SkipEmptyParts);
-      if (items.size() == 3) {
+      if (items.size() == 3 && i + 2 < grad.size()) {
         grad[i] = items[0].toDouble();
         grad[i + 1] = items[1].toDouble();
         grad[i + 2] = items[2].toDouble();
         i += 3;
       }
 
-      if (i > x.size())
+      if (i >= grad.size())
         break;
     }
   }
@@ -181,6 +166,42 @@ void ScriptEnergy::gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad)
   cleanGradients(grad);
 }
 
+Real ScriptEnergy::value(const Eigen::VectorXd& x)
+{
+  if (m_molecule == nullptr || m_interpreter == nullptr)
+    return 0.0; // nothing to do
+
+  return readEnergy(evaluate(x));
+}
+
+void ScriptEnergy::gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad)
+{
+  if (!m_gradients) {
+    EnergyCalculator::gradient(x, grad);
+    return;
+  }
+
+  // Get the gradient from the script
+  grad.resize(x.size());
+  grad.setZero();
+  readGradient(evaluate(x), grad);
+}
+
+Real ScriptEnergy::valueAndGradient(const Eigen::VectorXd& x,
+                                    Eigen::VectorXd& grad)
+{
+  if (!m_gradients || m_molecule == nullptr || m_interpreter == nullptr)
+    return EnergyCalculator::valueAndGradient(x, grad);
+
+  // the script reports both the energy and the gradient for each geometry,
+  // so one round trip is enough
+  QStringList lines = evaluate(x);
+  grad.resize(x.size());
+  grad.setZero();
+  readGradient(lines, grad);
+  return readEnergy(lines);
+}
+
 ScriptEnergy::Format ScriptEnergy::stringToFormat(const std::string& str)
 {
   if (str == "cjson")
@@ -12,6 +12,7 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QTemporaryFile>
 
 class QJsonObject;
@@ -71,8 +72,15 @@ public:
   Real value(const Eigen::VectorXd& x) override;
   // gradient (which may be unsupported and fall back to numeric)
   void gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad) override;
+  // energy and gradient from a single call to the script
+  Real valueAndGradient(const Eigen::VectorXd& x,
+                        Eigen::VectorXd& grad) override;
 
 private:
+  // send the coordinates to the script, returning the lines of the response
+  QStringList evaluate(const Eigen::VectorXd& x);
+  Real readEnergy(const QStringList& lines);
+  void readGradient(const QStringList& lines, Eigen::VectorXd& grad);
   static Format stringToFormat(const std::string& str);
   static Io::FileFormat* createFileFormat(Format fmt);
   void resetMetaData();
@@ -68,12 +68,14 @@ void Meshes::process(const QtGui::Molecule& mol, GroupNode& node)
 
     const Mesh* mesh = mol.mesh(0);
 
-    /// @todo Allow use of MeshGeometry without an index array when all vertices
-    /// form explicit triangles.
-    // Create index array:
+    // Meshes without triangles list their vertices as explicit triangles,
+    // so create a sequential index array for them.
     Sequence indexGenerator;
-    Core::Array<unsigned int> indices(mesh->numVertices());
-    std::generate(indices.begin(), indices.end(), indexGenerator);
+    Core::Array<unsigned int> indices(mesh->triangles());
+    if (indices.empty()) {
+      indices.resize(mesh->numVertices());
+      std::generate(indices.begin(), indices.end(), indexGenerator);
+    }
 
     bool hasColors = (mesh->colors().size() != 0);
 
@@ -100,9 +102,8 @@ void Meshes::process(const QtGui::Molecule& mol, GroupNode& node)
       auto* mesh2 = new MeshGeometry;
       geometry->addDrawable(mesh2);
       mesh = mol.mesh(1);
-      if (mesh->numVertices() < indices.size()) {
-        indices.resize(mesh->numVertices());
-      } else if (mesh->numVertices() > indices.size()) {
+      indices = mesh->triangles();
+      if (indices.empty()) {
         indexGenerator.reset();
         indices.resize(mesh->numVertices());
         std::generate(indices.begin(), indices.end(), indexGenerator);
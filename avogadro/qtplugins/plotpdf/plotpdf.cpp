@@ -8,7 +8,7 @@
 #include <QMessageBox>
 #include <QString>
 
-#include <avogadro/core/crystaltools.h>
+#include <avogadro/core/pairdistribution.h>
 #include <avogadro/core/unitcell.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/vtk/chartdialog.h>
@@ -17,16 +17,12 @@
 #include "pdfoptionsdialog.h"
 #include "plotpdf.h"
 
-using Avogadro::Core::CrystalTools;
+using Avogadro::Core::PairDistribution;
 using Avogadro::Core::UnitCell;
 using Avogadro::QtGui::Molecule;
 
-using std::map;
-
 namespace Avogadro::QtPlugins {
 
-using Core::Array;
-
 PlotPdf::PlotPdf(QObject* parent_)
   : Avogadro::QtGui::ExtensionPlugin(parent_)
   , m_actions(QList<QAction*>())
@@ -150,57 +146,35 @@ void PlotPdf::displayDialog()
 bool PlotPdf::generatePdfPattern(QtGui::Molecule& mol, PdfData& results,
                                  QString& err, double maxRadius, double step)
 {
-  Array<Vector3> refAtomCoords = mol.atomPositions3d();
-
-  size_t i, j;
-
   UnitCell* uc = mol.unitCell();
   if (!uc) {
     err = "No unit cell found.";
     return false;
   }
 
-  size_t a = static_cast<size_t>(maxRadius / uc->a()) + 1;
-  size_t b = static_cast<size_t>(maxRadius / uc->b()) + 1;
-  size_t c = static_cast<size_t>(maxRadius / uc->c()) + 1;
-
-  Vector3 disp = a * uc->aVector() + b * uc->bVector() + c * uc->cVector();
-  for (i = 0; i < refAtomCoords.size(); ++i) {
-    refAtomCoords[i] += disp;
-  }
-
-  Molecule newMolecule = mol;
-  CrystalTools::buildSupercell(newMolecule, 2 * a + 1, 2 * b + 1, 2 * c + 1);
-
-  Array<Vector3> newAtomCoords = newMolecule.atomPositions3d();
-
-  map<size_t, size_t> pdfCount;
-  double dist, rStep = step;
-  size_t k, binIdx;
-
-  for (i = 0; i < refAtomCoords.size(); ++i) {
-    for (j = 0; j < newAtomCoords.size(); ++j) {
-      dist = (refAtomCoords.at(i) - newAtomCoords.at(j)).norm();
-      binIdx = static_cast<size_t>(dist / rStep);
-      if (pdfCount.find(binIdx) == pdfCount.end()) {
-        pdfCount.insert(std::make_pair(binIdx, 1));
+  // Average over the frames of a trajectory, if there is one. Frames with a
+  // cell of their own (e.g., constant pressure runs) are binned in it.
+  PairDistribution pdf(maxRadius, step);
+  const int frames = mol.coordinate3dCount();
+  if (frames > 1) {
+    for (int i = 0; i < frames; ++i) {
+      Matrix3 cellMatrix;
+      if (mol.frameCell(i, cellMatrix)) {
+        pdf.addFrame(mol.coordinate3d(i), mol.atomicNumbers(),
+                     UnitCell(cellMatrix));
       } else {
-        pdfCount[binIdx]++;
+        pdf.addFrame(mol.coordinate3d(i), mol.atomicNumbers(), *uc);
       }
     }
+  } else {
+    pdf.addFrame(mol.atomPositions3d(), mol.atomicNumbers(), *uc);
   }
-
-  for (k = 0; k < static_cast<size_t>(maxRadius / rStep); k++) {
-    if (pdfCount.find(k) == pdfCount.end()) {
-      results.push_back(std::make_pair(k * rStep, 0.0));
-    } else {
-      results.push_back(std::make_pair(
-        k * rStep, pdfCount[k] * newMolecule.unitCell()->volume() /
-                     (4 * M_PI * pow(k * rStep, 2) * rStep *
-                      refAtomCoords.size() * newAtomCoords.size())));
-    }
+  if (pdf.frameCount() == 0) {
+    err = "No atoms found.";
+    return false;
   }
 
+  results = pdf.distribution();
   return true;
 }
 
@@ -8,21 +8,18 @@
 #include <QAction>
 #include <QDialog>
 #include <QMessageBox>
-#include <QProcess>
 #include <QString>
 
-#include <avogadro/core/array.h>
-#include <avogadro/io/fileformatmanager.h>
+#include <avogadro/core/trajectoryanalysis.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/vtk/chartdialog.h>
 #include <avogadro/vtk/chartwidget.h>
 
+using Avogadro::Core::TrajectoryAnalysis;
 using Avogadro::QtGui::Molecule;
 
 namespace Avogadro::QtPlugins {
 
-using Core::Array;
-
 PlotRmsd::PlotRmsd(QObject* parent_)
   : Avogadro::QtGui::ExtensionPlugin(parent_), m_actions(QList<QAction*>()),
     m_molecule(nullptr), m_displayDialogAction(new QAction(this))
@@ -128,21 +125,10 @@ void PlotRmsd::displayDialog()
 
 void PlotRmsd::generateRmsdPattern(RmsdData& results)
 {
-  m_molecule->setCoordinate3d(0);
-  Array<Vector3> ref = m_molecule->atomPositions3d();
-
-  for (int i = 0; i < m_molecule->coordinate3dCount(); ++i) {
-    m_molecule->setCoordinate3d(i);
-    Array<Vector3> positions = m_molecule->atomPositions3d();
-    double sum = 0;
-    for (size_t j = 0; j < positions.size(); ++j) {
-      sum += (positions[j][0] - ref[j][0]) * (positions[j][0] - ref[j][0]) +
-             (positions[j][1] - ref[j][1]) * (positions[j][1] - ref[j][1]) +
-             (positions[j][2] - ref[j][2]) * (positions[j][2] - ref[j][2]);
-    }
-    sum = sqrt(sum / m_molecule->coordinate3dCount());
-    results.push_back(std::make_pair(static_cast<double>(i), sum));
-  }
+  // Each frame is superposed onto the first, without touching the molecule.
+  const std::vector<double> rmsd = TrajectoryAnalysis(*m_molecule).rmsd(0);
+  for (size_t i = 0; i < rmsd.size(); ++i)
+    results.push_back(std::make_pair(static_cast<double>(i), rmsd[i]));
 }
 
 } // namespace Avogadro::QtPlugins
@@ -4,17 +4,14 @@
 ******************************************************************************/
 
 #include <QAction>
-#include <QByteArray>
-#include <QCoreApplication>
 #include <QDebug>
 #include <QDialog>
-#include <QFile>
 #include <QMessageBox>
-#include <QProcess>
-#include <QRegularExpression>
 #include <QString>
 
-#include <avogadro/io/fileformatmanager.h>
+#include <avogadro/core/elements.h>
+#include <avogadro/core/unitcell.h>
+#include <avogadro/core/xrdpattern.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/vtk/chartdialog.h>
 #include <avogadro/vtk/chartwidget.h>
@@ -22,6 +19,10 @@
 #include "plotxrd.h"
 #include "xrdoptionsdialog.h"
 
+using Avogadro::Core::Array;
+using Avogadro::Core::Elements;
+using Avogadro::Core::UnitCell;
+using Avogadro::Core::XrdPattern;
 using Avogadro::QtGui::Molecule;
 
 namespace Avogadro::QtPlugins {
@@ -151,131 +152,34 @@ bool PlotXrd::generateXrdPattern(const QtGui::Molecule& mol, XrdData& results,
                                  double peakwidth, size_t numpoints,
                                  double max2theta)
 {
-  // Get the molecule as a cif file
-  std::string cifData;
-  if (!Io::FileFormatManager::instance().writeString(mol, cifData, "cif")) {
-    err = tr("Failed to convert molecule to CIF format.");
-    qDebug() << "Error in" << __FUNCTION__ << ":" << err;
-    return false;
-  }
-
-  // Now, execute genXrdPattern with the given inputs
-  QStringList args;
-  args << "--read-from-stdin"
-       << "--wavelength=" + QString::number(wavelength)
-       << "--peakwidth=" + QString::number(peakwidth)
-       << "--numpoints=" + QString::number(numpoints)
-       << "--max2theta=" + QString::number(max2theta);
-
-  QByteArray output;
-  if (!executeGenXrdPattern(args, cifData.c_str(), output, err)) {
-    qDebug() << "Error in" << __FUNCTION__ << ":" << err;
+  const UnitCell* cell = mol.unitCell();
+  if (!cell) {
+    err = tr("No unit cell found.");
     return false;
   }
 
-  // Store the results
-  results.clear();
-
-  // Find the section of data in the output
-  bool dataStarted = false;
-  QStringList lines =
-    QString(output).split(QRegularExpression("[\r\n]"), Qt::SkipEmptyParts);
-  for (const auto& line : lines) {
-    if (!dataStarted && line.contains("#    2Theta/TOF    ICalc")) {
-      dataStarted = true;
-      continue;
-    }
-
-    if (dataStarted) {
-      QStringList rowData = line.split(" ", Qt::SkipEmptyParts);
-      if (rowData.size() != 2) {
-        err = tr("Data read from genXrdPattern appears to be corrupt!");
-        qDebug() << "Error in" << __FUNCTION__ << err;
-        qDebug() << "Data is:";
-        for (const auto& lineTmp : lines)
-          qDebug() << lineTmp;
-        return false;
-      }
-      results.push_back(
-        std::make_pair(rowData[0].toDouble(), rowData[1].toDouble()));
-    }
-  }
-
-  return true;
-}
-
-bool PlotXrd::executeGenXrdPattern(const QStringList& args,
-                                   const QByteArray& input, QByteArray& output,
-                                   QString& err)
-{
-  QString program;
-  // If the GENXRDPATTERN_EXECUTABLE environment variable is set, then
-  // use that
-  QByteArray xrdExec = qgetenv("GENXRDPATTERN_EXECUTABLE");
-  if (!xrdExec.isEmpty()) {
-    program = xrdExec;
-  } else {
-// Otherwise, search in the current directory, and then ../bin
-#ifdef _WIN32
-    QString executable = "genXrdPattern.exe";
-#else
-    QString executable = "genXrdPattern";
-#endif
-    QString path = QCoreApplication::applicationDirPath();
-    if (QFile::exists(path + "/" + executable))
-      program = path + "/" + executable;
-    else if (QFile::exists(path + "/../bin/" + executable))
-      program = path + "/../bin/" + executable;
-    else {
-      err = tr("Error: could not find genXrdPattern executable!");
-      qDebug() << err;
+  Array<Vector3> fractional(mol.atomCount());
+  for (Index i = 0; i < mol.atomCount(); ++i) {
+    if (!XrdPattern::hasScatteringFactor(mol.atomicNumber(i))) {
+      err = tr("No X-ray scattering factors are available for %1.")
+              .arg(Elements::name(mol.atomicNumber(i)));
       return false;
     }
+    fractional[i] = cell->toFractional(mol.atomPosition3d(i));
   }
 
-  QProcess p;
-  p.start(program, args);
-
-  if (!p.waitForStarted()) {
-    err = tr("Error: " + program.toLocal8Bit() + " failed to start");
-    qDebug() << err;
-    return false;
-  }
-
-  // Give it the input!
-  p.write(input.data());
-
-  // Close the write channel
-  p.closeWriteChannel();
-
-  if (!p.waitForFinished()) {
-    err = tr("Error: " + program.toLocal8Bit() + " failed to finish");
-    qDebug() << err;
-    output = p.readAll();
-    qDebug() << "Output is as follows:\n" << output;
-    return false;
-  }
-
-  int exitStatus = p.exitStatus();
-  output = p.readAll();
-
-  if (exitStatus == QProcess::CrashExit) {
-    err = tr("Error: " + program.toLocal8Bit() + " crashed!");
-    qDebug() << err;
-    qDebug() << "Output is as follows:\n" << output;
-    return false;
-  }
-
-  if (exitStatus != QProcess::NormalExit) {
-    err = tr("Error: " + program.toLocal8Bit() +
-             " finished abnormally with exit code " +
-             QString::number(exitStatus).toLocal8Bit());
-    qDebug() << err;
-    qDebug() << "Output is as follows:\n" << output;
+  XrdPattern xrd;
+  xrd.setWavelength(wavelength);
+  xrd.setPeakWidth(peakwidth);
+  xrd.setPointCount(numpoints);
+  xrd.setMax2Theta(max2theta);
+  if (!xrd.compute(*cell, fractional, mol.atomicNumbers())) {
+    err = tr("Failed to compute the XRD pattern.");
+    qDebug() << "Error in" << __FUNCTION__ << ":" << err;
     return false;
   }
 
-  // We did it!
+  results = xrd.pattern();
   return true;
 }
 
@@ -10,9 +10,6 @@
 
 #include <memory>
 
-// Forward declarations
-class QByteArray;
-
 namespace VTK {
 class ChartDialog;
 }
@@ -26,7 +23,7 @@ class XrdOptionsDialog;
 typedef std::vector<std::pair<double, double>> XrdData;
 
 /**
- * @brief Generate and plot a theoretical XRD pattern using ObjCryst++
+ * @brief Generate and plot a theoretical XRD pattern
  */
 class PlotXrd : public Avogadro::QtGui::ExtensionPlugin
 {
@@ -65,14 +62,6 @@ private:
                                  size_t numpoints = 1000,
                                  double max2theta = 162.0);
 
-  // Use QProcess to execute genXrdPattern
-  // If the GENXRDPATTERN_EXECUTABLE environment variable is set, that will be
-  // used for the executable. Otherwise, it will search for the executable in
-  // some common places and use it if it can be found.
-  static bool executeGenXrdPattern(const QStringList& args,
-                                   const QByteArray& input, QByteArray& output,
-                                   QString& err);
-
   QList<QAction*> m_actions;
   QtGui::Molecule* m_molecule;
 
@@ -83,7 +72,7 @@ private:
 
 inline QString PlotXrd::description() const
 {
-  return tr("Generate and plot a theoretical XRD pattern using ObjCryst++.");
+  return tr("Generate and plot a theoretical XRD pattern.");
 }
 
 } // namespace QtPlugins
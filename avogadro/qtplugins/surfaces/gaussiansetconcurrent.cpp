@@ -12,7 +12,8 @@
 
 #include <avogadro/core/cube.h>
 
-#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QFutureInterface>
 
 namespace Avogadro::QtPlugins {
 
@@ -22,6 +23,11 @@ using Core::GaussianSet;
 using Core::GaussianSetTools;
 using Core::Molecule;
 
+namespace {
+// resolution of the progress reported to the watcher
+const int ProgressSteps = 1000;
+} // namespace
+
 template <typename Derived>
 class BasisSetConcurrent
 {
@@ -31,16 +37,8 @@ class BasisSetConcurrent
   }
 };
 
-struct GaussianShell
-{
-  GaussianSetTools* tools; // A pointer to the tools, can't write to member vars
-  Cube* tCube;             // The target cube, used to initialise temp cubes too
-  unsigned int pos;        // The index of the point to calculate the MO for
-  unsigned int state;      // The MO number to calculate
-};
-
 GaussianSetConcurrent::GaussianSetConcurrent(QObject* p)
-  : QObject(p), m_gaussianShells(nullptr), m_set(nullptr), m_tools(nullptr)
+  : QObject(p), m_set(nullptr), m_tools(nullptr)
 {
   // Watch for the future
   connect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
@@ -48,7 +46,8 @@ GaussianSetConcurrent::GaussianSetConcurrent(QObject* p)
 
 GaussianSetConcurrent::~GaussianSetConcurrent()
 {
-  delete m_gaussianShells;
+  m_future.waitForFinished();
+  delete m_tools;
 }
 
 void GaussianSetConcurrent::setMolecule(Core::Molecule* mol)
@@ -65,86 +64,103 @@ bool GaussianSetConcurrent::calculateMolecularOrbital(Core::Cube* cube,
                                                       unsigned int state,
                                                       bool beta)
 {
+  return calculateMolecularOrbitals(QVector<Cube*>(1, cube),
+                                    QVector<unsigned int>(1, state), beta);
+}
+
+bool GaussianSetConcurrent::calculateMolecularOrbitals(
+  const QVector<Core::Cube*>& cubes, const QVector<unsigned int>& states,
+  bool beta)
+{
+  if (!m_tools || cubes.isEmpty() || cubes.size() != states.size())
+    return false;
+
   // We can do some initial set up of the tools here to set electron type.
   if (!beta)
     m_tools->setElectronType(BasisSet::Alpha);
   else
     m_tools->setElectronType(BasisSet::Beta);
 
-  return setUpCalculation(cube, state, GaussianSetConcurrent::processOrbital);
+  // the basis functions are evaluated once for all of the orbitals
+  std::vector<Cube*> targets(cubes.begin(), cubes.end());
+  std::vector<int> orbitals(states.begin(), states.end());
+  GaussianSetTools* tools = m_tools;
+  return setUpCalculation(cubes, [tools, targets, orbitals]() {
+    return tools->calculateMolecularOrbitals(targets, orbitals);
+  });
 }
 
 bool GaussianSetConcurrent::calculateElectronDensity(Core::Cube* cube)
 {
+  if (!m_set)
+    return false;
+
   const MatrixX& matrix = m_set->densityMatrix();
   if (matrix.rows() == 0 || matrix.cols() == 0) {
     // we don't have a density matrix, so calculate one
     m_set->generateDensityMatrix();
   }
 
-  return setUpCalculation(cube, 0, GaussianSetConcurrent::processDensity);
+  GaussianSetTools* tools = m_tools;
+  return setUpCalculation(QVector<Cube*>(1, cube), [tools, cube]() {
+    return tools->calculateElectronDensity(*cube);
+  });
 }
 
 bool GaussianSetConcurrent::calculateSpinDensity(Core::Cube* cube)
 {
-  return setUpCalculation(cube, 0, GaussianSetConcurrent::processSpinDensity);
+  GaussianSetTools* tools = m_tools;
+  return setUpCalculation(QVector<Cube*>(1, cube), [tools, cube]() {
+    return tools->calculateSpinDensity(*cube);
+  });
 }
 
 void GaussianSetConcurrent::calculationComplete()
 {
-  (*m_gaussianShells)[0].tCube->lock()->unlock();
-  delete m_gaussianShells;
-  m_gaussianShells = nullptr;
+  for (auto* cube : m_cubes)
+    cube->lock()->unlock();
+  m_cubes.clear();
+
+  if (m_future.resultCount() == 0 || !m_future.result()) {
+    emit error(tr("The surface could not be calculated."));
+    return;
+  }
   emit finished();
 }
 
-bool GaussianSetConcurrent::setUpCalculation(Core::Cube* cube,
-                                             unsigned int state,
-                                             void (*func)(GaussianShell&))
+bool GaussianSetConcurrent::setUpCalculation(
+  const QVector<Core::Cube*>& cubes, const std::function<bool()>& calculate)
 {
   if (!m_set || !m_tools)
     return false;
 
   m_set->initCalculation();
 
-  // Set up the points we want to calculate the density at.
-  m_gaussianShells =
-    new QVector<GaussianShell>(static_cast<int>(cube->data()->size()));
-
-  for (int i = 0; i < m_gaussianShells->size(); ++i) {
-    (*m_gaussianShells)[i].tools = m_tools;
-    (*m_gaussianShells)[i].tCube = cube;
-    (*m_gaussianShells)[i].pos = i;
-    (*m_gaussianShells)[i].state = state;
-  }
-
-  // Lock the cube until we are done.
-  cube->lock()->lock();
-
-  // The main part of the mapped reduced function...
-  m_future = QtConcurrent::map(*m_gaussianShells, func);
+  // Lock the cubes until we are done.
+  m_cubes = cubes;
+  for (auto* cube : m_cubes)
+    cube->lock()->lock();
+
+  // The tools split the grid into slabs and fill them in parallel, so one
+  // background job is enough to keep the GUI responsive. Each finished slab
+  // is reported as progress on the future that the watcher follows.
+  QFutureInterface<bool> job;
+  job.setProgressRange(0, ProgressSteps);
+  job.reportStarted();
+  m_tools->setProgressCallback([job](Index done, Index total) mutable {
+    job.setProgressValue(static_cast<int>(ProgressSteps * done / total));
+  });
+  m_future = job.future();
   // Connect our watcher to our future
   m_watcher.setFuture(m_future);
 
-  return true;
-}
-
-void GaussianSetConcurrent::processOrbital(GaussianShell& shell)
-{
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(
-    shell.pos, shell.tools->calculateMolecularOrbital(pos, shell.state));
-}
+  QtConcurrent::run([job, calculate]() mutable {
+    const bool success = calculate();
+    job.setProgressValue(ProgressSteps);
+    job.reportResult(success);
+    job.reportFinished();
+  });
 
-void GaussianSetConcurrent::processDensity(GaussianShell& shell)
-{
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateElectronDensity(pos));
-}
-
-void GaussianSetConcurrent::processSpinDensity(GaussianShell& shell)
-{
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateSpinDensity(pos));
+  return true;
 }
 } // namespace Avogadro::QtPlugins
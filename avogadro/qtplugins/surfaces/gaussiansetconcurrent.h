@@ -9,6 +9,9 @@
 #include <QtCore/QFuture>
 #include <QtCore/QFutureWatcher>
 #include <QtCore/QObject>
+#include <QtCore/QVector>
+
+#include <functional>
 
 namespace Avogadro {
 
@@ -21,8 +24,6 @@ class GaussianSetTools;
 
 namespace QtPlugins {
 
-struct GaussianShell;
-
 /**
  * @brief The GaussianSetConcurrent class uses GaussianSetTools to calculate
  * values of electronic structure properties from quantum output read in.
@@ -41,10 +42,21 @@ public:
 
   bool calculateMolecularOrbital(Core::Cube* cube, unsigned int state,
                                  bool beta = false);
+  /**
+   * Calculate several molecular orbitals in one pass over the grid. The
+   * cubes must share the same limits and spacing.
+   */
+  bool calculateMolecularOrbitals(const QVector<Core::Cube*>& cubes,
+                                  const QVector<unsigned int>& states,
+                                  bool beta = false);
   bool calculateElectronDensity(Core::Cube* cube);
   bool calculateSpinDensity(Core::Cube* cube);
 
-  QFutureWatcher<void>& watcher() { return m_watcher; }
+  /**
+   * The watcher follows the calculation, with progress reported as each slab
+   * of the cube is filled.
+   */
+  QFutureWatcher<bool>& watcher() { return m_watcher; }
 
 signals:
   /**
@@ -52,6 +64,11 @@ signals:
    */
   void finished();
 
+  /**
+   * Emitted instead of finished() if the calculation failed.
+   */
+  void error(const QString& message);
+
 private slots:
   /**
    * Slot to set the cube data once Qt Concurrent is done
@@ -59,20 +76,15 @@ private slots:
   void calculationComplete();
 
 private:
-  QFuture<void> m_future;
-  QFutureWatcher<void> m_watcher;
-  Core::Cube* m_cube;
-  QVector<GaussianShell>* m_gaussianShells;
+  QFuture<bool> m_future;
+  QFutureWatcher<bool> m_watcher;
+  QVector<Core::Cube*> m_cubes; // locked until the calculation is done
 
   Core::GaussianSet* m_set;
   Core::GaussianSetTools* m_tools;
 
-  bool setUpCalculation(Core::Cube* cube, unsigned int state,
-                        void (*func)(GaussianShell&));
-
-  static void processOrbital(GaussianShell& shell);
-  static void processDensity(GaussianShell& shell);
-  static void processSpinDensity(GaussianShell& shell);
+  bool setUpCalculation(const QVector<Core::Cube*>& cubes,
+                        const std::function<bool()>& calculate);
 };
 }
 }
@@ -12,7 +12,8 @@
 #include <avogadro/core/cube.h>
 #include <avogadro/core/mutex.h>
 
-#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QFutureInterface>
 
 namespace Avogadro::QtPlugins {
 
@@ -20,16 +21,13 @@ using Core::SlaterSet;
 using Core::SlaterSetTools;
 using Core::Cube;
 
-struct SlaterShell
-{
-  SlaterSetTools* tools; // A pointer to the tools, cannot write to member vars
-  Cube* tCube;           // The target cube, used to initialise temp cubes too
-  unsigned int pos;      // The index of the point to calculate the MO for
-  unsigned int state;    // The MO number to calculate
-};
+namespace {
+// resolution of the progress reported to the watcher
+const int ProgressSteps = 1000;
+} // namespace
 
 SlaterSetConcurrent::SlaterSetConcurrent(QObject* p)
-  : QObject(p), m_shells(nullptr), m_set(nullptr), m_tools(nullptr)
+  : QObject(p), m_cube(nullptr), m_set(nullptr), m_tools(nullptr)
 {
   // Watch for the future
   connect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
@@ -37,7 +35,8 @@ SlaterSetConcurrent::SlaterSetConcurrent(QObject* p)
 
 SlaterSetConcurrent::~SlaterSetConcurrent()
 {
-  delete m_shells;
+  m_future.waitForFinished();
+  delete m_tools;
 }
 
 void SlaterSetConcurrent::setMolecule(Core::Molecule* mol)
@@ -45,80 +44,79 @@ void SlaterSetConcurrent::setMolecule(Core::Molecule* mol)
   if (!mol)
     return;
   m_set = dynamic_cast<SlaterSet*>(mol->basisSet());
-  
-    delete m_tools;
+
+  delete m_tools;
   m_tools = new SlaterSetTools(mol);
 }
 
 bool SlaterSetConcurrent::calculateMolecularOrbital(Core::Cube* cube,
                                                     unsigned int state)
 {
-  return setUpCalculation(cube, state, SlaterSetConcurrent::processOrbital);
+  SlaterSetTools* tools = m_tools;
+  return setUpCalculation(cube, [tools, cube, state]() {
+    return tools->calculateMolecularOrbital(*cube, static_cast<int>(state));
+  });
 }
 
 bool SlaterSetConcurrent::calculateElectronDensity(Core::Cube* cube)
 {
-  return setUpCalculation(cube, 0, SlaterSetConcurrent::processDensity);
+  SlaterSetTools* tools = m_tools;
+  return setUpCalculation(
+    cube, [tools, cube]() { return tools->calculateElectronDensity(*cube); });
 }
 
 bool SlaterSetConcurrent::calculateSpinDensity(Core::Cube* cube)
 {
-  return setUpCalculation(cube, 0, SlaterSetConcurrent::processSpinDensity);
+  SlaterSetTools* tools = m_tools;
+  return setUpCalculation(
+    cube, [tools, cube]() { return tools->calculateSpinDensity(*cube); });
 }
 
 void SlaterSetConcurrent::calculationComplete()
 {
-  (*m_shells)[0].tCube->lock()->unlock();
-  delete m_shells;
-  m_shells = nullptr;
+  if (m_cube)
+    m_cube->lock()->unlock();
+  m_cube = nullptr;
+
+  if (m_future.resultCount() == 0 || !m_future.result()) {
+    emit error(tr("The surface could not be calculated."));
+    return;
+  }
   emit finished();
 }
 
-bool SlaterSetConcurrent::setUpCalculation(Core::Cube* cube, unsigned int state,
-                                           void (*func)(SlaterShell&))
+bool SlaterSetConcurrent::setUpCalculation(
+  Core::Cube* cube, const std::function<bool()>& calculate)
 {
   if (!m_set || !m_tools)
     return false;
 
   m_set->initCalculation();
 
-  // Set up the points we want to calculate the density at.
-  m_shells = new QVector<SlaterShell>(static_cast<int>(cube->data()->size()));
-
-  for (int i = 0; i < m_shells->size(); ++i) {
-    (*m_shells)[i].tools = m_tools;
-    (*m_shells)[i].tCube = cube;
-    (*m_shells)[i].pos = i;
-    (*m_shells)[i].state = state;
-  }
-
   // Lock the cube until we are done.
+  m_cube = cube;
   cube->lock()->lock();
 
-  // The main part of the mapped reduced function...
-  m_future = QtConcurrent::map(*m_shells, func);
+  // The tools split the grid into slabs and fill them in parallel, so one
+  // background job is enough to keep the GUI responsive. Each finished slab
+  // is reported as progress on the future that the watcher follows.
+  QFutureInterface<bool> job;
+  job.setProgressRange(0, ProgressSteps);
+  job.reportStarted();
+  m_tools->setProgressCallback([job](Index done, Index total) mutable {
+    job.setProgressValue(static_cast<int>(ProgressSteps * done / total));
+  });
+  m_future = job.future();
   // Connect our watcher to our future
   m_watcher.setFuture(m_future);
 
-  return true;
-}
-
-void SlaterSetConcurrent::processOrbital(SlaterShell& shell)
-{
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(
-    shell.pos, shell.tools->calculateMolecularOrbital(pos, shell.state));
-}
+  QtConcurrent::run([job, calculate]() mutable {
+    const bool success = calculate();
+    job.setProgressValue(ProgressSteps);
+    job.reportResult(success);
+    job.reportFinished();
+  });
 
-void SlaterSetConcurrent::processDensity(SlaterShell& shell)
-{
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateElectronDensity(pos));
-}
-
-void SlaterSetConcurrent::processSpinDensity(SlaterShell& shell)
-{
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateSpinDensity(pos));
+  return true;
 }
 }
@@ -10,6 +10,8 @@
 #include <QtCore/QFutureWatcher>
 #include <QtCore/QObject>
 
+#include <functional>
+
 namespace Avogadro {
 
 namespace Core {
@@ -21,8 +23,6 @@ class SlaterSetTools;
 
 namespace QtPlugins {
 
-struct SlaterShell;
-
 /**
  * @brief The SlaterSetConcurrent class uses SlaterSetTools to calculate values
  * of electronic structure properties from quantum output read in.
@@ -43,7 +43,11 @@ public:
   bool calculateElectronDensity(Core::Cube* cube);
   bool calculateSpinDensity(Core::Cube* cube);
 
-  QFutureWatcher<void>& watcher() { return m_watcher; }
+  /**
+   * The watcher follows the calculation, with progress reported as each slab
+   * of the cube is filled.
+   */
+  QFutureWatcher<bool>& watcher() { return m_watcher; }
 
 signals:
   /**
@@ -51,6 +55,11 @@ signals:
    */
   void finished();
 
+  /**
+   * Emitted instead of finished() if the calculation failed.
+   */
+  void error(const QString& message);
+
 private slots:
   /**
    * Slot to set the cube data once Qt Concurrent is done
@@ -58,20 +67,15 @@ private slots:
   void calculationComplete();
 
 private:
-  QFuture<void> m_future;
-  QFutureWatcher<void> m_watcher;
-  Core::Cube* m_cube;
-  QVector<SlaterShell>* m_shells;
+  QFuture<bool> m_future;
+  QFutureWatcher<bool> m_watcher;
+  Core::Cube* m_cube; // locked until the calculation is done
 
   Core::SlaterSet* m_set;
   Core::SlaterSetTools* m_tools;
 
-  bool setUpCalculation(Core::Cube* cube, unsigned int state,
-                        void (*func)(SlaterShell&));
-
-  static void processOrbital(SlaterShell& shell);
-  static void processDensity(SlaterShell& shell);
-  static void processSpinDensity(SlaterShell& shell);
+  bool setUpCalculation(Core::Cube* cube,
+                        const std::function<bool()>& calculate);
 };
 }
 }
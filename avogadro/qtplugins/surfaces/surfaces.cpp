@@ -539,20 +539,15 @@ void Surfaces::calculateQM(Type type, int index, bool beta, float isoValue,
   m_mesh1 = nullptr;
   m_mesh2 = nullptr;
   m_molecule->emitChanged(Molecule::Atoms | Molecule::Added);
-  bool connectSlots = false;
 
   // set up QtConcurrent calculators for Gaussian or Slater basis sets
   if (dynamic_cast<GaussianSet*>(m_basis)) {
-    if (!m_gaussianConcurrent) {
+    if (!m_gaussianConcurrent)
       m_gaussianConcurrent = new GaussianSetConcurrent(this);
-      connectSlots = true;
-    }
     m_gaussianConcurrent->setMolecule(m_molecule);
   } else {
-    if (!m_slaterConcurrent) {
+    if (!m_slaterConcurrent)
       m_slaterConcurrent = new SlaterSetConcurrent(this);
-      connectSlots = true;
-    }
     m_slaterConcurrent->setMolecule(m_molecule);
   }
 
@@ -561,7 +556,6 @@ void Surfaces::calculateQM(Type type, int index, bool beta, float isoValue,
     m_progressDialog = new QProgressDialog(qobject_cast<QWidget*>(parent()));
     m_progressDialog->setCancelButtonText(nullptr);
     m_progressDialog->setWindowModality(Qt::NonModal);
-    connectSlots = true;
   }
 
   if (!m_cube)
@@ -582,36 +576,39 @@ void Surfaces::calculateQM(Type type, int index, bool beta, float isoValue,
   m_cube->setLimits(*m_molecule, cubeResolution, padding);
 
   QString progressText;
+  bool started = false;
   if (type == ElectronDensity) {
     progressText = tr("Calculating electron density");
     m_cube->setName("Electron Density");
     m_cube->setCubeType(Core::Cube::Type::ElectronDensity);
     if (dynamic_cast<GaussianSet*>(m_basis)) {
-      m_gaussianConcurrent->calculateElectronDensity(m_cube);
+      started = m_gaussianConcurrent->calculateElectronDensity(m_cube);
     } else {
-      m_slaterConcurrent->calculateElectronDensity(m_cube);
+      started = m_slaterConcurrent->calculateElectronDensity(m_cube);
     }
   } else if (type == SpinDensity) {
     progressText = tr("Calculating spin density");
     m_cube->setName("Spin Density");
     m_cube->setCubeType(Core::Cube::Type::SpinDensity);
     if (dynamic_cast<GaussianSet*>(m_basis)) {
-      m_gaussianConcurrent->calculateSpinDensity(m_cube);
+      started = m_gaussianConcurrent->calculateSpinDensity(m_cube);
     } else {
-      m_slaterConcurrent->calculateSpinDensity(m_cube);
+      started = m_slaterConcurrent->calculateSpinDensity(m_cube);
     }
   } else if (type == MolecularOrbital) {
     progressText = tr("Calculating molecular orbital %L1").arg(index);
     m_cube->setName("Molecular Orbital " + std::to_string(index + 1));
     m_cube->setCubeType(Core::Cube::Type::MO);
     if (dynamic_cast<GaussianSet*>(m_basis)) {
-      m_gaussianConcurrent->calculateMolecularOrbital(m_cube, index, beta);
+      started =
+        m_gaussianConcurrent->calculateMolecularOrbital(m_cube, index, beta);
     } else {
-      m_slaterConcurrent->calculateMolecularOrbital(m_cube, index);
+      started = m_slaterConcurrent->calculateMolecularOrbital(m_cube, index);
     }
   }
 
-  // Set up the progress dialog.
+  // Set up the progress dialog. This runs for every surface, so each
+  // connection is only made once.
   if (dynamic_cast<GaussianSet*>(m_basis)) {
     m_progressDialog->setWindowTitle(progressText);
     m_progressDialog->setRange(
@@ -620,15 +617,16 @@ void Surfaces::calculateQM(Type type, int index, bool beta, float isoValue,
     m_progressDialog->setValue(m_gaussianConcurrent->watcher().progressValue());
     m_progressDialog->show();
 
-    if (connectSlots) {
-      connect(&m_gaussianConcurrent->watcher(),
-              SIGNAL(progressValueChanged(int)), m_progressDialog,
-              SLOT(setValue(int)));
-      connect(&m_gaussianConcurrent->watcher(),
-              SIGNAL(progressRangeChanged(int, int)), m_progressDialog,
-              SLOT(setRange(int, int)));
-      connect(m_gaussianConcurrent, SIGNAL(finished()), SLOT(displayMesh()));
-    }
+    connect(&m_gaussianConcurrent->watcher(),
+            SIGNAL(progressValueChanged(int)), m_progressDialog,
+            SLOT(setValue(int)), Qt::UniqueConnection);
+    connect(&m_gaussianConcurrent->watcher(),
+            SIGNAL(progressRangeChanged(int, int)), m_progressDialog,
+            SLOT(setRange(int, int)), Qt::UniqueConnection);
+    connect(m_gaussianConcurrent, SIGNAL(finished()), SLOT(displayMesh()),
+            Qt::UniqueConnection);
+    connect(m_gaussianConcurrent, SIGNAL(error(const QString&)),
+            SLOT(calculationFailed(const QString&)), Qt::UniqueConnection);
   } else {
     // slaters
     m_progressDialog->setWindowTitle(progressText);
@@ -638,12 +636,27 @@ void Surfaces::calculateQM(Type type, int index, bool beta, float isoValue,
     m_progressDialog->show();
 
     connect(&m_slaterConcurrent->watcher(), SIGNAL(progressValueChanged(int)),
-            m_progressDialog, SLOT(setValue(int)));
+            m_progressDialog, SLOT(setValue(int)), Qt::UniqueConnection);
     connect(&m_slaterConcurrent->watcher(),
             SIGNAL(progressRangeChanged(int, int)), m_progressDialog,
-            SLOT(setRange(int, int)));
-    connect(m_slaterConcurrent, SIGNAL(finished()), SLOT(displayMesh()));
+            SLOT(setRange(int, int)), Qt::UniqueConnection);
+    connect(m_slaterConcurrent, SIGNAL(finished()), SLOT(displayMesh()),
+            Qt::UniqueConnection);
+    connect(m_slaterConcurrent, SIGNAL(error(const QString&)),
+            SLOT(calculationFailed(const QString&)), Qt::UniqueConnection);
   }
+
+  if (!started)
+    calculationFailed(tr("The surface could not be calculated."));
+}
+
+void Surfaces::calculationFailed(const QString& message)
+{
+  if (m_progressDialog)
+    m_progressDialog->hide();
+
+  QMessageBox::warning(qobject_cast<QWidget*>(parent()), tr("Avogadro"),
+                       message);
 }
 
 void Surfaces::calculateCube(int index, float isoValue)
@@ -698,11 +711,10 @@ void Surfaces::displayMesh()
 
   if (!m_mesh1)
     m_mesh1 = m_molecule->addMesh();
-  if (!m_meshGenerator1) {
-    m_meshGenerator1 = new QtGui::MeshGenerator;
-    connect(m_meshGenerator1, SIGNAL(finished()), SLOT(meshFinished()));
+  if (!m_meshGenerator) {
+    m_meshGenerator = new QtGui::MeshGenerator;
+    connect(m_meshGenerator, SIGNAL(finished()), SLOT(meshFinished()));
   }
-  m_meshGenerator1->initialize(m_cube, m_mesh1, m_isoValue, m_smoothingPasses);
 
   bool isMO = false;
   // if it's from a file we should "play it safe"
@@ -711,29 +723,22 @@ void Surfaces::displayMesh()
     isMO = true;
   }
 
+  // Orbitals have a negative lobe too, found in the same pass over the cube
   if (isMO) {
     if (!m_mesh2)
       m_mesh2 = m_molecule->addMesh();
-    if (!m_meshGenerator2) {
-      m_meshGenerator2 = new QtGui::MeshGenerator;
-      connect(m_meshGenerator2, SIGNAL(finished()), SLOT(meshFinished()));
-    }
-    m_meshGenerator2->initialize(m_cube, m_mesh2, -m_isoValue,
-                                 m_smoothingPasses, true);
+    m_meshGenerator->initialize(m_cube, m_mesh1, m_mesh2, m_isoValue,
+                                m_smoothingPasses);
+  } else {
+    m_meshGenerator->initialize(m_cube, m_mesh1, m_isoValue,
+                                m_smoothingPasses);
   }
 
   // Start the mesh generation - this needs an improved mutex with a read lock
   // to function as expected. Write locks are exclusive, read locks can have
   // many read locks but no write lock.
-  m_meshGenerator1->start();
-  if (isMO)
-    m_meshGenerator2->start();
-
-  // Track how many meshes are left to show.
-  if (isMO)
-    m_meshesLeft = 2;
-  else
-    m_meshesLeft = 1;
+  m_meshGenerator->start();
+  m_meshesLeft = 1;
 }
 
 Core::Color3f Surfaces::chargeGradient(double value, double clamp,
@@ -95,6 +95,7 @@ private slots:
   void calculateQM(Type type = Unknown, int index = -1, bool betaSpin = false,
                    float isoValue = 0.0, float defaultResolution = 0.0);
   void calculateCube(int index = -1, float isoValue = 0.0);
+  void calculationFailed(const QString& message);
 
   void stepChanged(int);
 
@@ -131,8 +132,7 @@ private:
   Core::Mesh* m_mesh1 = nullptr;
   Core::Mesh* m_mesh2 = nullptr;
   /* displayMesh() -> meshFinished() */
-  QtGui::MeshGenerator* m_meshGenerator1 = nullptr;
-  QtGui::MeshGenerator* m_meshGenerator2 = nullptr;
+  QtGui::MeshGenerator* m_meshGenerator = nullptr;
 
   float m_isoValue = 0.01;
   int m_smoothingPasses = 6;
@@ -516,6 +516,7 @@ const float ao_points[] = {
 
 #include "avogadrogl.h"
 
+#include <algorithm>
 #include <iostream>
 
 using std::cout;
@@ -1316,9 +1317,16 @@ std::multimap<float, Identifier> AmbientOcclusionSphereGeometry::hits(
   const Vector3f& rayDirection) const
 {
   std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  // Only the spheres with bounding boxes along the ray can be hit.
+  std::vector<Index> candidates;
+  hierarchy().intersect(rayOrigin, rayEnd, candidates);
+  std::sort(candidates.begin(), candidates.end());
 
   // Check for intersection.
-  for (size_t i = 0; i < m_spheres.size(); ++i) {
+  for (Index i : candidates) {
     const SphereColor& sphere = m_spheres[i];
 
     Vector3f distance = sphere.center - rayOrigin;
@@ -1338,20 +1346,47 @@ std::multimap<float, Identifier> AmbientOcclusionSphereGeometry::hits(
     id.molecule = m_identifier.molecule;
     id.type = m_identifier.type;
     id.index = i;
-    if (id.type != InvalidType) {
-      auto rootD = static_cast<float>(sqrt(D));
-      float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
-      result.insert(std::pair<float, Identifier>(depth, id));
-    }
+    auto rootD = static_cast<float>(sqrt(D));
+    float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
+    result.insert(std::pair<float, Identifier>(depth, id));
   }
   return result;
 }
 
+const BoundingVolumeHierarchy&
+AmbientOcclusionSphereGeometry::hierarchy() const
+{
+  if (m_hierarchy.isEmpty() && !m_spheres.empty()) {
+    std::vector<BoundingVolumeHierarchy::Box> boxes;
+    boxes.reserve(m_spheres.size());
+    for (const SphereColor& sphere : m_spheres) {
+      boxes.emplace_back(sphere.center.array() - sphere.radius,
+                         sphere.center.array() + sphere.radius);
+    }
+    m_hierarchy.build(boxes);
+  }
+  return m_hierarchy;
+}
+
+bool AmbientOcclusionSphereGeometry::bounds(Eigen::AlignedBox3f& box) const
+{
+  if (m_bounds.isEmpty()) {
+    for (const SphereColor& sphere : m_spheres) {
+      m_bounds.extend(Vector3f(sphere.center.array() - sphere.radius));
+      m_bounds.extend(Vector3f(sphere.center.array() + sphere.radius));
+    }
+  }
+  box = m_bounds;
+  return true;
+}
+
 void AmbientOcclusionSphereGeometry::addSphere(const Vector3f& position,
                                                const Vector3ub& color,
                                                float radius, size_t index)
 {
   m_dirty = true;
+  m_hierarchy.clear();
+  m_bounds.setEmpty();
   m_spheres.push_back(SphereColor(position, radius, color));
   m_indices.push_back(index == MaxIndex ? m_indices.size() : index);
 }
@@ -1360,6 +1395,8 @@ void AmbientOcclusionSphereGeometry::clear()
 {
   m_spheres.clear();
   m_indices.clear();
+  m_hierarchy.clear();
+  m_bounds.setEmpty();
 }
 
 } // End namespace Avogadro
@@ -6,6 +6,7 @@
 #ifndef AVOGADRO_RENDERING_AMBIENTOCCLUSIONSPHEREGEOMETRY_H
 #define AVOGADRO_RENDERING_AMBIENTOCCLUSIONSPHEREGEOMETRY_H
 
+#include "boundingvolumehierarchy.h"
 #include "drawable.h"
 
 #include <avogadro/core/array.h>
@@ -68,6 +69,17 @@ public:
     const Vector3f& rayOrigin, const Vector3f& rayEnd,
     const Vector3f& rayDirection) const override;
 
+  /**
+   * Get the bounding volume hierarchy over the spheres used for picking. It
+   * is built on first use and again after the spheres change.
+   */
+  const BoundingVolumeHierarchy& hierarchy() const;
+
+  /**
+   * Get the box enclosing the spheres, kept until the spheres change.
+   */
+  bool bounds(Eigen::AlignedBox3f& box) const override;
+
   /**
    * Add a sphere to the geometry object.
    */
@@ -77,7 +89,12 @@ public:
   /**
    * Get a reference to the spheres.
    */
-  Core::Array<SphereColor>& spheres() { return m_spheres; }
+  Core::Array<SphereColor>& spheres()
+  {
+    m_hierarchy.clear();
+    m_bounds.setEmpty();
+    return m_spheres;
+  }
   const Core::Array<SphereColor>& spheres() const { return m_spheres; }
 
   /**
@@ -93,6 +110,8 @@ public:
 private:
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
+  mutable BoundingVolumeHierarchy m_hierarchy;
+  mutable BoundingVolumeHierarchy::Box m_bounds;
 
   bool m_dirty;
 
@@ -115,6 +134,8 @@ inline void swap(AmbientOcclusionSphereGeometry& lhs,
   swap(static_cast<Drawable&>(lhs), static_cast<Drawable&>(rhs));
   swap(lhs.m_spheres, rhs.m_spheres);
   swap(lhs.m_indices, rhs.m_indices);
+  swap(lhs.m_hierarchy, rhs.m_hierarchy);
+  swap(lhs.m_bounds, rhs.m_bounds);
   lhs.m_dirty = rhs.m_dirty = true;
 }
 
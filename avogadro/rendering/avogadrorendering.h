@@ -52,6 +52,16 @@ enum RenderPass
   Overlay2DPass
 };
 
+/**
+ * @return True for the passes drawn over the scene rather than in it. Their
+ * drawables may use a camera of their own (e.g., the axes in a corner of the
+ * view), so they are never culled and are left out of the scene bounds.
+ */
+inline bool isOverlayPass(RenderPass pass)
+{
+  return pass == Overlay3DPass || pass == Overlay2DPass;
+}
+
 } // end namespace Rendering
 } // end namespace Avogadro
 
@@ -0,0 +1,192 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "ballandstickbuilder.h"
+
+#include "cylindergeometry.h"
+#include "spheregeometry.h"
+
+#include <avogadro/core/layer.h>
+#include <avogadro/core/molecule.h>
+
+#include <array>
+
+namespace Avogadro::Rendering {
+
+namespace {
+struct BondCylinder
+{
+  Vector3f pos1;
+  Vector3f pos2;
+  float radius;
+};
+
+// The cylinders a bond of @p order is drawn with, returning how many.
+int bondCylinders(const Vector3f& pos1, const Vector3f& pos2, int order,
+                  float bondRadius, float singleRadius,
+                  std::array<BondCylinder, 3>& cylinders)
+{
+  Vector3f bondVector = pos2 - pos1;
+  float bondLength = bondVector.norm();
+  bondVector /= bondLength;
+
+  int count = 0;
+  switch (order) {
+    case 3: {
+      Vector3f delta = bondVector.unitOrthogonal();
+      // Rotate 45 degrees around the bond vector.
+      Eigen::Quaternionf q;
+      q = Eigen::AngleAxisf(45.0f * DEG_TO_RAD_F, bondVector);
+      delta = q * delta * 2.0f * bondRadius;
+      cylinders[count++] = { pos1 + delta, pos2 + delta, bondRadius * 1.15f };
+      cylinders[count++] = { pos1 - delta, pos2 - delta, bondRadius * 1.15f };
+      // This relies upon the single bond case below for the third cylinder.
+      [[fallthrough]];
+    }
+    default:
+    case 1:
+      cylinders[count++] = { pos1, pos2, singleRadius };
+      break;
+    case 2: {
+      Vector3f delta = bondVector.unitOrthogonal();
+      // Rotate 45 degrees around the bond vector.
+      Eigen::Quaternionf q;
+      q = Eigen::AngleAxisf(45.0f * DEG_TO_RAD_F, bondVector);
+      delta = q * delta * bondRadius;
+      cylinders[count++] = { pos1 + delta, pos2 + delta, bondRadius * 1.3f };
+      cylinders[count++] = { pos1 - delta, pos2 - delta, bondRadius * 1.3f };
+    }
+  }
+  return count;
+}
+
+const Vector3ub selectionColor(0, 0, 255);
+} // namespace
+
+BallAndStickBuilder::BallAndStickBuilder() = default;
+
+void BallAndStickBuilder::reset(SphereGeometry* spheres,
+                                SphereGeometry* selectedSpheres,
+                                CylinderGeometry* cylinders)
+{
+  m_spheres = spheres;
+  m_selectedSpheres = selectedSpheres;
+  m_cylinders = cylinders;
+  m_sphereAtoms.clear();
+  m_drawnBonds.clear();
+  m_atomicNumbers.clear();
+  m_layers.clear();
+  m_bondPairs.clear();
+  m_bondOrders.clear();
+}
+
+void BallAndStickBuilder::addAtom(const Core::Molecule& molecule, Index atom,
+                                  float radius)
+{
+  const Vector3f position = molecule.atomPosition3d(atom).cast<float>();
+  m_spheres->addSphere(position, molecule.color(atom), radius, atom);
+  m_sphereAtoms.push_back(atom);
+  if (molecule.atomSelected(atom))
+    m_selectedSpheres->addSphere(position, selectionColor, radius * 1.2f, atom);
+}
+
+void BallAndStickBuilder::addBond(const Core::Molecule& molecule, Index bond,
+                                  int order, float radius, float singleRadius)
+{
+  const std::pair<Index, Index>& atoms = molecule.bondPairs()[bond];
+  const Vector3f pos1 = molecule.atomPosition3d(atoms.first).cast<float>();
+  const Vector3f pos2 = molecule.atomPosition3d(atoms.second).cast<float>();
+  const Vector3ub color1 = molecule.color(atoms.first);
+  const Vector3ub color2 = molecule.color(atoms.second);
+
+  std::array<BondCylinder, 3> parts;
+  const int count =
+    bondCylinders(pos1, pos2, order, radius, singleRadius, parts);
+  for (int j = 0; j < count; ++j) {
+    m_cylinders->addCylinder(parts[j].pos1, parts[j].pos2, parts[j].radius,
+                             color1, color2, bond);
+  }
+  m_drawnBonds.push_back({ bond, order, radius, singleRadius });
+}
+
+void BallAndStickBuilder::finish(const Core::Molecule& molecule)
+{
+  m_atomicNumbers = molecule.atomicNumbers();
+  const Core::Layer& layers = molecule.layer();
+  m_layers.resize(m_atomicNumbers.size());
+  for (Index i = 0; i < m_layers.size(); ++i)
+    m_layers[i] = layers.getLayerID(i);
+  m_bondPairs = molecule.bondPairs();
+  m_bondOrders = molecule.bondOrders();
+}
+
+bool BallAndStickBuilder::atomsMatch(const Core::Molecule& molecule) const
+{
+  if (molecule.atomCount() < m_atomicNumbers.size())
+    return false;
+  const Core::Array<unsigned char>& atomicNumbers = molecule.atomicNumbers();
+  const Core::Layer& layers = molecule.layer();
+  for (Index i = 0; i < m_atomicNumbers.size(); ++i) {
+    if (atomicNumbers[i] != m_atomicNumbers[i] ||
+        layers.getLayerID(i) != m_layers[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BallAndStickBuilder::bondsMatch(const Core::Molecule& molecule) const
+{
+  return molecule.bondPairs() == m_bondPairs &&
+         molecule.bondOrders() == m_bondOrders;
+}
+
+void BallAndStickBuilder::update(const Core::Molecule& molecule)
+{
+  const SphereGeometry& spheres = *m_spheres;
+  m_selectedSpheres->clear();
+  for (Index s = 0; s < m_sphereAtoms.size(); ++s) {
+    const Index i = m_sphereAtoms[s];
+    const SphereColor& sphere = spheres.spheres()[s];
+    const Vector3f position = molecule.atomPosition3d(i).cast<float>();
+    const Vector3ub color = molecule.color(i);
+    if (position != sphere.center || color != sphere.color)
+      m_spheres->setSphere(s, position, color, sphere.radius);
+    if (molecule.atomSelected(i)) {
+      m_selectedSpheres->addSphere(position, selectionColor,
+                                   sphere.radius * 1.2f, i);
+    }
+  }
+
+  const CylinderGeometry& cylinders = *m_cylinders;
+  Index next = 0;
+  for (const DrawnBond& drawn : m_drawnBonds) {
+    const std::pair<Index, Index>& atoms = molecule.bondPairs()[drawn.bond];
+    const Vector3f pos1 = molecule.atomPosition3d(atoms.first).cast<float>();
+    const Vector3f pos2 = molecule.atomPosition3d(atoms.second).cast<float>();
+    const Vector3ub color1 = molecule.color(atoms.first);
+    const Vector3ub color2 = molecule.color(atoms.second);
+
+    std::array<BondCylinder, 3> parts;
+    const int count = bondCylinders(pos1, pos2, drawn.order, drawn.radius,
+                                    drawn.singleRadius, parts);
+    for (int j = 0; j < count; ++j, ++next) {
+      const CylinderColor& cylinder = cylinders.cylinders()[next];
+      if (parts[j].pos1 != cylinder.end1 || parts[j].pos2 != cylinder.end2 ||
+          color1 != cylinder.color || color2 != cylinder.color2) {
+        m_cylinders->setCylinder(next, parts[j].pos1, parts[j].pos2,
+                                 parts[j].radius, color1, color2);
+      }
+    }
+  }
+}
+
+void BallAndStickBuilder::clearBonds()
+{
+  m_cylinders->clear();
+  m_drawnBonds.clear();
+}
+
+} // namespace Avogadro::Rendering
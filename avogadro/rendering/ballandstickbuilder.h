@@ -0,0 +1,125 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_BALLANDSTICKBUILDER_H
+#define AVOGADRO_RENDERING_BALLANDSTICKBUILDER_H
+
+#include "avogadrorenderingexport.h"
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/avogadrocore.h>
+
+#include <utility>
+#include <vector>
+
+namespace Avogadro {
+
+namespace Core {
+class Molecule;
+}
+
+namespace Rendering {
+
+class CylinderGeometry;
+class SphereGeometry;
+
+/**
+ * @class BallAndStickBuilder ballandstickbuilder.h
+ * <avogadro/rendering/ballandstickbuilder.h>
+ * @brief Fill sphere and cylinder geometry with a molecule in the ball and
+ * stick style, and update it in place after the molecule changed.
+ *
+ * The caller decides which atoms and bonds are drawn and how large, and adds
+ * them with addAtom() and addBond(), followed by finish(). The builder
+ * records what was drawn for which atom and bond, so that update() can later
+ * move, recolor and (de)select the primitives and only set those that
+ * changed. New atoms and all bonds can be added again on top of that.
+ *
+ * The geometry is owned by the scene, the builder only keeps pointers to it.
+ */
+class AVOGADRORENDERING_EXPORT BallAndStickBuilder
+{
+public:
+  BallAndStickBuilder();
+
+  /**
+   * Start over with empty @p spheres, @p selectedSpheres and @p cylinders,
+   * or with none at all if they are null.
+   */
+  void reset(SphereGeometry* spheres = nullptr,
+             SphereGeometry* selectedSpheres = nullptr,
+             CylinderGeometry* cylinders = nullptr);
+
+  /** @return True if there is geometry to update. */
+  bool isValid() const { return m_spheres != nullptr; }
+
+  /**
+   * Draw @p atom of @p molecule as a sphere of @p radius, and with a larger
+   * sphere around it if it is selected.
+   */
+  void addAtom(const Core::Molecule& molecule, Index atom, float radius);
+
+  /**
+   * Draw @p bond of @p molecule as one cylinder per @p order, up to three.
+   * Multiple cylinders are spaced by @p radius, a single one has
+   * @p singleRadius.
+   */
+  void addBond(const Core::Molecule& molecule, Index bond, int order,
+               float radius, float singleRadius);
+
+  /**
+   * Record the atoms and bonds of @p molecule after the primitives for it
+   * were added, to compare with later.
+   */
+  void finish(const Core::Molecule& molecule);
+
+  /** @return The number of atoms of the molecule when finish() was called. */
+  Index atomCount() const { return m_atomicNumbers.size(); }
+
+  /**
+   * @return True if the recorded atoms are still in @p molecule with the
+   * same elements and layers, so that the same of them are drawn. Atoms
+   * added after them are allowed.
+   */
+  bool atomsMatch(const Core::Molecule& molecule) const;
+
+  /** @return True if @p molecule has the recorded bonds and bond orders. */
+  bool bondsMatch(const Core::Molecule& molecule) const;
+
+  /**
+   * Move and recolor the spheres and cylinders drawn for @p molecule to the
+   * current positions and colors of their atoms, and draw the selected atoms
+   * anew. Only primitives that differ are set. The atoms must match.
+   */
+  void update(const Core::Molecule& molecule);
+
+  /** Remove the cylinders of all bonds, to add them again. */
+  void clearBonds();
+
+private:
+  // A bond as it was drawn, one to three cylinders from the first one.
+  struct DrawnBond
+  {
+    Index bond;
+    int order;
+    float radius;
+    float singleRadius;
+  };
+
+  SphereGeometry* m_spheres = nullptr;
+  SphereGeometry* m_selectedSpheres = nullptr;
+  CylinderGeometry* m_cylinders = nullptr;
+  std::vector<Index> m_sphereAtoms;
+  std::vector<DrawnBond> m_drawnBonds;
+  Core::Array<unsigned char> m_atomicNumbers;
+  std::vector<size_t> m_layers;
+  Core::Array<std::pair<Index, Index>> m_bondPairs;
+  Core::Array<unsigned char> m_bondOrders;
+};
+
+} // namespace Rendering
+} // namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_BALLANDSTICKBUILDER_H
@@ -0,0 +1,224 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "boundingvolumehierarchy.h"
+
+#include <algorithm>
+
+namespace Avogadro::Rendering {
+
+namespace {
+// Few enough to test exactly, enough to keep the tree shallow.
+const Index leafSize = 4;
+// The tree is balanced, so this is far deeper than any tree can get.
+const int maxDepth = 64;
+
+typedef BoundingVolumeHierarchy::Box Box;
+
+// Slab test of the segment origin + t * direction, 0 <= t <= 1, given the
+// inverse of the direction.
+bool segmentHitsBox(const Box& box, const Vector3f& origin,
+                    const Vector3f& inverse)
+{
+  float first = 0.0f;
+  float last = 1.0f;
+  for (int i = 0; i < 3; ++i) {
+    float t1 = (box.min()[i] - origin[i]) * inverse[i];
+    float t2 = (box.max()[i] - origin[i]) * inverse[i];
+    if (t1 > t2)
+      std::swap(t1, t2);
+    // NaN (the segment runs within a face) leaves the bounds unchanged
+    first = t1 > first ? t1 : first;
+    last = t2 < last ? t2 : last;
+    if (first > last)
+      return false;
+  }
+  return true;
+}
+
+bool sameBox(const Box& a, const Box& b)
+{
+  return a.min() == b.min() && a.max() == b.max();
+}
+
+enum Side
+{
+  Outside,
+  Crossing,
+  Inside
+};
+
+// Each plane passes through points[2 * i] with its normal facing outwards.
+Side frustrumSide(const Box& box, const Frustrum& frustrum)
+{
+  const Vector3f center = box.center();
+  const Vector3f half = 0.5f * box.sizes();
+  Side side = Inside;
+  for (int i = 0; i < 4; ++i) {
+    const Vector3f& normal = frustrum.planes[i];
+    const float distance = (center - frustrum.points[2 * i]).dot(normal);
+    const float radius = half.dot(normal.cwiseAbs());
+    if (distance - radius > 0.0f)
+      return Outside;
+    if (distance + radius > 0.0f)
+      side = Crossing;
+  }
+  return side;
+}
+} // namespace
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy() = default;
+
+void BoundingVolumeHierarchy::build(const std::vector<Box>& boxes)
+{
+  clear();
+  if (boxes.empty())
+    return;
+
+  std::vector<Vector3f> centers;
+  centers.reserve(boxes.size());
+  for (const auto& box : boxes)
+    centers.push_back(box.center());
+  m_boxes = boxes;
+  m_leaves.resize(boxes.size());
+  m_indices.resize(boxes.size());
+  for (Index i = 0; i < m_indices.size(); ++i)
+    m_indices[i] = i;
+  m_nodes.reserve(2 * boxes.size() / leafSize + 1);
+  buildNode(centers, 0, boxes.size(), 0);
+}
+
+void BoundingVolumeHierarchy::update(Index primitive, const Box& box)
+{
+  if (primitive >= m_boxes.size())
+    return;
+  m_boxes[primitive] = box;
+
+  Index current = m_leaves[primitive];
+  Box leafBox;
+  for (Index i = m_nodes[current].begin; i < m_nodes[current].end; ++i)
+    leafBox.extend(m_boxes[m_indices[i]]);
+  if (sameBox(leafBox, m_nodes[current].box))
+    return;
+  m_nodes[current].box = leafBox;
+
+  // The nodes above only change as long as their children did.
+  while (current != 0) {
+    current = m_nodes[current].parent;
+    Node& node = m_nodes[current];
+    const Box merged =
+      m_nodes[current + 1].box.merged(m_nodes[node.second].box);
+    if (sameBox(merged, node.box))
+      return;
+    node.box = merged;
+  }
+}
+
+void BoundingVolumeHierarchy::clear()
+{
+  m_nodes.clear();
+  m_indices.clear();
+  m_boxes.clear();
+  m_leaves.clear();
+}
+
+BoundingVolumeHierarchy::Box BoundingVolumeHierarchy::bounds() const
+{
+  return m_nodes.empty() ? Box() : m_nodes.front().box;
+}
+
+void BoundingVolumeHierarchy::buildNode(const std::vector<Vector3f>& centers,
+                                        Index begin, Index end, Index parent)
+{
+  const Index node = m_nodes.size();
+  Box box;
+  Box centerBox;
+  for (Index i = begin; i < end; ++i) {
+    box.extend(m_boxes[m_indices[i]]);
+    centerBox.extend(centers[m_indices[i]]);
+  }
+  m_nodes.push_back({ box, begin, end, 0, parent });
+  if (end - begin <= leafSize) {
+    for (Index i = begin; i < end; ++i)
+      m_leaves[m_indices[i]] = node;
+    return;
+  }
+
+  int axis;
+  centerBox.sizes().maxCoeff(&axis);
+  const Index middle = begin + (end - begin) / 2;
+  std::nth_element(m_indices.begin() + begin, m_indices.begin() + middle,
+                   m_indices.begin() + end, [&](Index a, Index b) {
+                     return centers[a][axis] < centers[b][axis];
+                   });
+  buildNode(centers, begin, middle, node);
+  m_nodes[node].second = m_nodes.size();
+  buildNode(centers, middle, end, node);
+}
+
+void BoundingVolumeHierarchy::intersect(const Vector3f& origin,
+                                        const Vector3f& end,
+                                        std::vector<Index>& candidates) const
+{
+  if (m_nodes.empty())
+    return;
+
+  // components of zero become infinite, which the slab test handles
+  const Vector3f inverse = (end - origin).cwiseInverse();
+
+  Index stack[maxDepth];
+  int depth = 0;
+  Index current = 0;
+  for (;;) {
+    const Node& node = m_nodes[current];
+    if (segmentHitsBox(node.box, origin, inverse)) {
+      if (node.second == 0) {
+        candidates.insert(candidates.end(), m_indices.begin() + node.begin,
+                          m_indices.begin() + node.end);
+      } else {
+        stack[depth++] = node.second;
+        current = current + 1;
+        continue;
+      }
+    }
+    if (depth == 0)
+      break;
+    current = stack[--depth];
+  }
+}
+
+void BoundingVolumeHierarchy::intersect(const Frustrum& frustrum,
+                                        std::vector<Index>& inside,
+                                        std::vector<Index>& candidates) const
+{
+  if (m_nodes.empty())
+    return;
+
+  Index stack[maxDepth];
+  int depth = 0;
+  Index current = 0;
+  for (;;) {
+    const Node& node = m_nodes[current];
+    const Side side = frustrumSide(node.box, frustrum);
+    if (side == Inside) {
+      inside.insert(inside.end(), m_indices.begin() + node.begin,
+                    m_indices.begin() + node.end);
+    } else if (side == Crossing) {
+      if (node.second == 0) {
+        candidates.insert(candidates.end(), m_indices.begin() + node.begin,
+                          m_indices.begin() + node.end);
+      } else {
+        stack[depth++] = node.second;
+        current = current + 1;
+        continue;
+      }
+    }
+    if (depth == 0)
+      break;
+    current = stack[--depth];
+  }
+}
+
+} // namespace Avogadro::Rendering
@@ -0,0 +1,111 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_BOUNDINGVOLUMEHIERARCHY_H
+#define AVOGADRO_RENDERING_BOUNDINGVOLUMEHIERARCHY_H
+
+#include "avogadrorenderingexport.h"
+
+#include <avogadro/core/avogadrocore.h>
+#include <avogadro/core/vector.h>
+
+#include <Eigen/Geometry>
+
+#include <vector>
+
+namespace Avogadro {
+namespace Rendering {
+
+/**
+ * @class BoundingVolumeHierarchy boundingvolumehierarchy.h
+ * <avogadro/rendering/boundingvolumehierarchy.h>
+ * @brief A tree of axis-aligned boxes used to find the primitives that a ray
+ * or a frustrum may touch without testing all of them.
+ *
+ * The hierarchy is built once from one box per primitive, by splitting the
+ * primitives at the median of the longest axis of their centers until at
+ * most a few are left in each leaf. The nodes are stored in one array in
+ * depth-first order. Queries only return candidates, the exact test is left
+ * to the caller.
+ *
+ * A primitive that moved can be given its new box with update(), which
+ * refits the boxes on the way to the root instead of building anew. The tree
+ * keeps its shape, so it gets looser as primitives move far.
+ */
+class AVOGADRORENDERING_EXPORT BoundingVolumeHierarchy
+{
+public:
+  typedef Eigen::AlignedBox3f Box;
+
+  BoundingVolumeHierarchy();
+
+  /**
+   * Build the hierarchy over @p boxes, replacing any previous one. Primitive
+   * i is bounded by boxes[i].
+   */
+  void build(const std::vector<Box>& boxes);
+
+  /**
+   * Replace the box of @p primitive with @p box and refit the boxes of its
+   * leaf and the nodes above it. Primitives out of range are ignored.
+   */
+  void update(Index primitive, const Box& box);
+
+  /** Remove all primitives. */
+  void clear();
+
+  /** @return True if the hierarchy holds no primitives. */
+  bool isEmpty() const { return m_indices.empty(); }
+
+  /** @return The number of primitives in the hierarchy. */
+  Index size() const { return m_indices.size(); }
+
+  /** @return The box around all primitives, empty if there are none. */
+  Box bounds() const;
+
+  /**
+   * Append the indices of all primitives whose boxes the segment from
+   * @p origin to @p end passes through to @p candidates.
+   */
+  void intersect(const Vector3f& origin, const Vector3f& end,
+                 std::vector<Index>& candidates) const;
+
+  /**
+   * Find the primitives whose boxes may be inside the four side planes of
+   * @p frustrum. Those with boxes entirely inside are appended to @p inside,
+   * those with boxes crossing a plane to @p candidates.
+   */
+  void intersect(const Frustrum& frustrum, std::vector<Index>& inside,
+                 std::vector<Index>& candidates) const;
+
+private:
+  /**
+   * The primitives below a node are m_indices[begin, end). Inner nodes have
+   * their first child right after them and their second child at @a second,
+   * which is zero for leaves. The root is its own parent.
+   */
+  struct Node
+  {
+    Box box;
+    Index begin;
+    Index end;
+    Index second;
+    Index parent;
+  };
+
+  void buildNode(const std::vector<Vector3f>& centers, Index begin, Index end,
+                 Index parent);
+
+  std::vector<Node> m_nodes;
+  std::vector<Index> m_indices;
+  // The box and the leaf of each primitive, for update().
+  std::vector<Box> m_boxes;
+  std::vector<Index> m_leaves;
+};
+
+} // namespace Rendering
+} // namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_BOUNDINGVOLUMEHIERARCHY_H
@@ -24,9 +24,10 @@ inline GLenum convertType(BufferObject::ObjectType type)
 
 struct BufferObject::Private
 {
-  Private() : handle(0) {}
+  Private() : handle(0), size(0) {}
   GLenum type;
   GLuint handle;
+  size_t size;
 };
 
 BufferObject::BufferObject(ObjectType type_) : d(new Private), m_dirty(true)
@@ -89,8 +90,27 @@ bool BufferObject::uploadInternal(const void* buffer, size_t size,
   glBindBuffer(d->type, d->handle);
   glBufferData(d->type, size, static_cast<const GLvoid*>(buffer),
                GL_STATIC_DRAW);
+  d->size = size;
   m_dirty = false;
   return true;
 }
 
+bool BufferObject::uploadRangeInternal(const void* buffer, size_t offset,
+                                       size_t size)
+{
+  if (d->handle == 0 || m_dirty) {
+    m_error = "Trying to update a buffer that was not uploaded.";
+    return false;
+  }
+  if (offset + size > d->size) {
+    m_error = "Trying to update data past the end of the buffer.";
+    return false;
+  }
+  glBindBuffer(d->type, d->handle);
+  glBufferSubData(d->type, static_cast<GLintptr>(offset),
+                  static_cast<GLsizeiptr>(size),
+                  static_cast<const GLvoid*>(buffer));
+  return true;
+}
+
 } // End Avogadro namespace
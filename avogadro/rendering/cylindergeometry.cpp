@@ -23,6 +23,7 @@ namespace {
 
 #include <avogadro/core/matrix.h>
 
+#include <algorithm>
 #include <iostream>
 
 using std::cout;
@@ -30,6 +31,48 @@ using std::endl;
 
 namespace Avogadro::Rendering {
 
+namespace {
+// Points per circle.
+const unsigned int resolution = 8;
+
+// The two circles of points the tube of the cylinder is stitched between.
+void addVertices(const CylinderColor& cylinder,
+                 std::vector<ColorNormalVertex>& vertices)
+{
+  const float resolutionRadians =
+    2.0f * static_cast<float>(M_PI) / static_cast<float>(resolution);
+
+  const Vector3f& position1 = cylinder.end1;
+  const Vector3f& position2 = cylinder.end2;
+  const Vector3f direction = (position2 - position1).normalized();
+  float radius = cylinder.radius;
+
+  // Generate the radial vectors
+  Vector3f radialVec = direction.unitOrthogonal() * radius;
+  Eigen::AngleAxisf transform(resolutionRadians, direction);
+
+  // Cylinder
+  ColorNormalVertex vert(cylinder.color, -direction, position1);
+  ColorNormalVertex vert2(cylinder.color2, -direction, position1);
+  for (unsigned int j = 0; j < resolution; ++j) {
+    vert.normal = radialVec;
+    vert.vertex = position1 + radialVec;
+    vertices.push_back(vert);
+    vert2.normal = vert.normal;
+    vert2.vertex = position2 + radialVec;
+    vertices.push_back(vert2);
+    radialVec = transform * radialVec;
+  }
+}
+
+BoundingVolumeHierarchy::Box cylinderBox(const CylinderColor& cylinder)
+{
+  return BoundingVolumeHierarchy::Box(
+    cylinder.end1.cwiseMin(cylinder.end2).array() - cylinder.radius,
+    cylinder.end1.cwiseMax(cylinder.end2).array() + cylinder.radius);
+}
+} // namespace
+
 class CylinderGeometry::Private
 {
 public:
@@ -73,15 +116,12 @@ void CylinderGeometry::update()
   if (m_indices.empty() || m_cylinders.empty())
     return;
 
+  // Past half of the cylinders, one upload is cheaper than many small ones.
+  if (2 * m_changed.count() > m_cylinders.size())
+    m_dirty = true;
+
   // Check if the VBOs are ready, if not get them ready.
   if (!d->vbo.ready() || m_dirty) {
-    // Set some defaults for our cylinders.
-    const unsigned int resolution = 8; // points per circle
-    const float resolutionRadians =
-      2.0f * static_cast<float>(M_PI) / static_cast<float>(resolution);
-    std::vector<Vector3f> radials;
-    radials.reserve(resolution);
-
     std::vector<unsigned int> cylinderIndices;
     std::vector<ColorNormalVertex> cylinderVertices;
     // cylinderIndices.reserve(m_indices.size() * 4);
@@ -93,34 +133,10 @@ void CylinderGeometry::update()
     for (unsigned int i = 0;
          itIndex != m_indices.end() && itCylinder != m_cylinders.end();
          ++i, ++itIndex, ++itCylinder) {
-
-      const Vector3f& position1 = itCylinder->end1;
-      const Vector3f& position2 = itCylinder->end2;
-      const Vector3f direction = (position2 - position1).normalized();
-      float radius = itCylinder->radius;
-
-      // Generate the radial vectors
-      Vector3f radialVec = direction.unitOrthogonal() * radius;
-      Eigen::AngleAxisf transform(resolutionRadians, direction);
-      radials.clear();
-      for (unsigned int j = 0; j < resolution; ++j) {
-        radials.push_back(radialVec);
-        radialVec = transform * radialVec;
-      }
-
-      // Cylinder
-      ColorNormalVertex vert(itCylinder->color, -direction, position1);
-      ColorNormalVertex vert2(itCylinder->color2, -direction, position1);
       const auto tubeStart =
         static_cast<unsigned int>(cylinderVertices.size());
-      for (auto & radial : radials) {
-        vert.normal = radial;
-        vert.vertex = position1 + radial;
-        cylinderVertices.push_back(vert);
-        vert2.normal = vert.normal;
-        vert2.vertex = position2 + radial;
-        cylinderVertices.push_back(vert2);
-      }
+      addVertices(*itCylinder, cylinderVertices);
+
       // Now to stitch it together.
       for (unsigned int j = 0; j < resolution; ++j) {
         unsigned int r1 = j + j;
@@ -141,6 +157,18 @@ void CylinderGeometry::update()
     d->numberOfIndices = cylinderIndices.size();
 
     m_dirty = false;
+    m_changed.clear();
+  } else if (!m_changed.isEmpty()) {
+    // Only send the cylinders that were changed in place.
+    std::vector<ColorNormalVertex> cylinderVertices;
+    for (const DirtyRanges::Range& range : m_changed.ranges()) {
+      cylinderVertices.clear();
+      for (Index i = range.first; i < range.second; ++i)
+        addVertices(m_cylinders[i], cylinderVertices);
+      if (!d->vbo.uploadRange(cylinderVertices, 2 * resolution * range.first))
+        cout << d->vbo.error() << endl;
+    }
+    m_changed.clear();
   }
 
   // Build and link the shader if it has not been used yet.
@@ -240,8 +268,15 @@ std::multimap<float, Identifier> CylinderGeometry::hits(
   const Vector3f& rayDirection) const
 {
   std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  // Only the cylinders with bounding boxes along the ray can be hit.
+  std::vector<Index> candidates;
+  hierarchy().intersect(rayOrigin, rayEnd, candidates);
+  std::sort(candidates.begin(), candidates.end());
 
-  for (size_t i = 0; i < m_cylinders.size(); ++i) {
+  for (Index i : candidates) {
     const CylinderColor& cylinder = m_cylinders[i];
 
     // Check for cylinder intersection with the ray.
@@ -283,15 +318,50 @@ std::multimap<float, Identifier> CylinderGeometry::hits(
     id.index = i;
     if (m_indexMap.size())
       id.index = m_indexMap.find(i)->second;
-    if (id.type != InvalidType) {
-      float depth = distance.norm();
-      result.insert(std::pair<float, Identifier>(depth, id));
-    }
+    float depth = distance.norm();
+    result.insert(std::pair<float, Identifier>(depth, id));
   }
 
   return result;
 }
 
+const BoundingVolumeHierarchy& CylinderGeometry::hierarchy() const
+{
+  if (m_hierarchy.isEmpty() && !m_cylinders.empty()) {
+    std::vector<BoundingVolumeHierarchy::Box> boxes;
+    boxes.reserve(m_cylinders.size());
+    for (const CylinderColor& cylinder : m_cylinders)
+      boxes.push_back(cylinderBox(cylinder));
+    m_hierarchy.build(boxes);
+  }
+  return m_hierarchy;
+}
+
+bool CylinderGeometry::bounds(Eigen::AlignedBox3f& box) const
+{
+  updateBounds();
+  box = m_bounds;
+  return true;
+}
+
+float CylinderGeometry::detailRadius() const
+{
+  updateBounds();
+  return m_maxRadius;
+}
+
+void CylinderGeometry::updateBounds() const
+{
+  if (!m_bounds.isEmpty())
+    return;
+  // the widest cylinder, for detailRadius(), is found in the same pass
+  m_maxRadius = 0.0f;
+  for (const CylinderColor& cylinder : m_cylinders) {
+    m_bounds.extend(cylinderBox(cylinder));
+    m_maxRadius = std::max(m_maxRadius, cylinder.radius);
+  }
+}
+
 void CylinderGeometry::addCylinder(const Vector3f& pos1, const Vector3f& pos2,
                                    float radius, const Vector3ub& color)
 {
@@ -303,6 +373,8 @@ void CylinderGeometry::addCylinder(const Vector3f& pos1, const Vector3f& pos2,
                                    const Vector3ub& colorEnd)
 {
   m_dirty = true;
+  m_hierarchy.clear();
+  m_bounds.setEmpty();
   m_cylinders.emplace_back(pos1, pos2, radius, colorStart, colorEnd);
   m_indices.push_back(m_indices.size());
 }
@@ -323,11 +395,35 @@ void CylinderGeometry::addCylinder(const Vector3f& pos1, const Vector3f& pos2,
   addCylinder(pos1, pos2, radius, colorStart, colorEnd);
 }
 
+void CylinderGeometry::setCylinder(size_t i, const Vector3f& pos1,
+                                   const Vector3f& pos2, float radius,
+                                   const Vector3ub& color1,
+                                   const Vector3ub& color2)
+{
+  if (i >= m_cylinders.size())
+    return;
+  const float oldRadius = m_cylinders[i].radius;
+  m_cylinders[i] = CylinderColor(pos1, pos2, radius, color1, color2);
+  if (!m_hierarchy.isEmpty())
+    m_hierarchy.update(i, cylinderBox(m_cylinders[i]));
+  // A narrower cylinder may have been the widest, so that is found again.
+  if (!m_bounds.isEmpty() && !m_hierarchy.isEmpty() && radius >= oldRadius) {
+    m_bounds = m_hierarchy.bounds();
+    m_maxRadius = std::max(m_maxRadius, radius);
+  } else {
+    m_bounds.setEmpty();
+  }
+  m_changed.add(i);
+}
+
 void CylinderGeometry::clear()
 {
   m_cylinders.clear();
   m_indices.clear();
   m_indexMap.clear();
+  m_hierarchy.clear();
+  m_bounds.setEmpty();
+  m_changed.clear();
 }
 
 } // End namespace Avogadro
@@ -6,8 +6,11 @@
 #ifndef AVOGADRO_RENDERING_CYLINDERGEOMETRY_H
 #define AVOGADRO_RENDERING_CYLINDERGEOMETRY_H
 
+#include "boundingvolumehierarchy.h"
+#include "dirtyranges.h"
 #include "drawable.h"
 
+
 #include <vector>
 
 namespace Avogadro {
@@ -75,6 +78,23 @@ public:
     const Vector3f& rayOrigin, const Vector3f& rayEnd,
     const Vector3f& rayDirection) const override;
 
+  /**
+   * Get the bounding volume hierarchy over the cylinders used for picking.
+   * It is built on first use and again after the cylinders change.
+   */
+  const BoundingVolumeHierarchy& hierarchy() const;
+
+  /**
+   * Get the box enclosing the cylinders, kept until the cylinders change.
+   */
+  bool bounds(Eigen::AlignedBox3f& box) const override;
+
+  /**
+   * Get the radius of the widest cylinder. Cylinders usually join spheres
+   * that hide them when the view is far enough away.
+   */
+  float detailRadius() const override;
+
   /**
    * @brief Add a cylinder to the geometry object.
    * @param pos1 Base of the cylinder axis.
@@ -120,10 +140,24 @@ public:
                    const Vector3ub& color, const Vector3ub& color2,
                    size_t index);
 
+  /**
+   * Change the cylinder at position @p i in place, keeping its index. Only the
+   * cylinders changed this way are sent to the GPU on the next render, and
+   * the hierarchy and bounds are refit rather than built again.
+   */
+  void setCylinder(size_t i, const Vector3f& pos1, const Vector3f& pos2,
+                   float radius, const Vector3ub& color1,
+                   const Vector3ub& color2);
+
   /**
    * Get a reference to the cylinders.
    */
-  std::vector<CylinderColor>& cylinders() { return m_cylinders; }
+  std::vector<CylinderColor>& cylinders()
+  {
+    m_hierarchy.clear();
+    m_bounds.setEmpty();
+    return m_cylinders;
+  }
   const std::vector<CylinderColor>& cylinders() const { return m_cylinders; }
 
   /**
@@ -137,11 +171,20 @@ public:
   size_t size() const { return m_cylinders.size(); }
 
 private:
+  /**
+   * Find the bounds and the widest cylinder again if the cylinders changed.
+   */
+  void updateBounds() const;
+
   std::vector<CylinderColor> m_cylinders;
   std::vector<size_t> m_indices;
   std::map<size_t, size_t> m_indexMap;
+  mutable BoundingVolumeHierarchy m_hierarchy;
+  mutable BoundingVolumeHierarchy::Box m_bounds;
+  mutable float m_maxRadius = 0.0f;
 
   bool m_dirty;
+  DirtyRanges m_changed;
 
   class Private;
   Private* d;
@@ -161,6 +204,9 @@ inline void swap(CylinderGeometry& lhs, CylinderGeometry& rhs)
   swap(lhs.m_cylinders, rhs.m_cylinders);
   swap(lhs.m_indices, rhs.m_indices);
   swap(lhs.m_indexMap, rhs.m_indexMap);
+  swap(lhs.m_hierarchy, rhs.m_hierarchy);
+  swap(lhs.m_bounds, rhs.m_bounds);
+  swap(lhs.m_maxRadius, rhs.m_maxRadius);
   lhs.m_dirty = rhs.m_dirty = true;
 }
 
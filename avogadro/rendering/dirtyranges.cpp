@@ -0,0 +1,69 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "dirtyranges.h"
+
+#include <algorithm>
+
+namespace Avogadro::Rendering {
+
+DirtyRanges::DirtyRanges(Index maxRanges)
+  : m_maxRanges(std::max<Index>(maxRanges, 1))
+{
+}
+
+void DirtyRanges::add(Index i)
+{
+  // the first range that ends at or after i
+  auto next = std::lower_bound(
+    m_ranges.begin(), m_ranges.end(), i,
+    [](const Range& range, Index value) { return range.second < value; });
+  if (next != m_ranges.end() && next->first <= i && i < next->second)
+    return;
+
+  ++m_count;
+  if (next != m_ranges.end() && next->second == i) {
+    // grows the range at its end, and may close the gap to the one after
+    ++next->second;
+    auto after = next + 1;
+    if (after != m_ranges.end() && after->first == next->second)
+      merge(next - m_ranges.begin());
+    return;
+  }
+  if (next != m_ranges.end() && next->first == i + 1) {
+    --next->first;
+    return;
+  }
+  m_ranges.insert(next, Range(i, i + 1));
+
+  if (m_ranges.size() > m_maxRanges) {
+    Index closest = 0;
+    for (Index j = 1; j + 1 < m_ranges.size(); ++j) {
+      if (m_ranges[j + 1].first - m_ranges[j].second <
+          m_ranges[closest + 1].first - m_ranges[closest].second) {
+        closest = j;
+      }
+    }
+    merge(closest);
+  }
+}
+
+void DirtyRanges::clear()
+{
+  m_ranges.clear();
+  m_count = 0;
+}
+
+void DirtyRanges::merge(Index first)
+{
+  Range& range = m_ranges[first];
+  const Range& after = m_ranges[first + 1];
+  // the primitives in the gap are sent too
+  m_count += after.first - range.second;
+  range.second = after.second;
+  m_ranges.erase(m_ranges.begin() + first + 1);
+}
+
+} // namespace Avogadro::Rendering
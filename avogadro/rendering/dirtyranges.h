@@ -0,0 +1,66 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_DIRTYRANGES_H
+#define AVOGADRO_RENDERING_DIRTYRANGES_H
+
+#include "avogadrorenderingexport.h"
+
+#include <avogadro/core/avogadrocore.h>
+
+#include <utility>
+#include <vector>
+
+namespace Avogadro {
+namespace Rendering {
+
+/**
+ * @class DirtyRanges dirtyranges.h <avogadro/rendering/dirtyranges.h>
+ * @brief The ranges of primitives changed since they were last sent to the
+ * GPU.
+ *
+ * The ranges are kept sorted and disjoint, so that primitives changed far
+ * apart are sent separately. Once there are more than maxRanges() of them,
+ * the two ranges with the smallest gap between them are merged, which bounds
+ * the number of uploads.
+ */
+class AVOGADRORENDERING_EXPORT DirtyRanges
+{
+public:
+  /** A range of primitives [first, second). */
+  typedef std::pair<Index, Index> Range;
+
+  explicit DirtyRanges(Index maxRanges = 8);
+
+  /** Mark primitive @p i as changed. */
+  void add(Index i);
+
+  /** Forget all changes, after they were sent. */
+  void clear();
+
+  /** @return True if nothing changed. */
+  bool isEmpty() const { return m_ranges.empty(); }
+
+  /** @return The number of primitives in the ranges. */
+  Index count() const { return m_count; }
+
+  /** @return The ranges, sorted and disjoint. */
+  const std::vector<Range>& ranges() const { return m_ranges; }
+
+  /** @return The most ranges that are kept apart. */
+  Index maxRanges() const { return m_maxRanges; }
+
+private:
+  void merge(Index first);
+
+  std::vector<Range> m_ranges;
+  Index m_count = 0;
+  Index m_maxRanges;
+};
+
+} // namespace Rendering
+} // namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_DIRTYRANGES_H
@@ -47,6 +47,11 @@ Array<Identifier> Drawable::areaHits(const Frustrum&) const
   return Array<Identifier>();
 }
 
+bool Drawable::bounds(Eigen::AlignedBox3f&) const
+{
+  return false;
+}
+
 void Drawable::clear()
 {
 }
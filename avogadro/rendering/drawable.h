@@ -14,6 +14,8 @@
 #include <avogadro/core/array.h>
 #include <avogadro/core/vector.h>
 
+#include <Eigen/Geometry>
+
 #include <map>
 
 namespace Avogadro {
@@ -107,6 +109,25 @@ public:
    */
   virtual Core::Array<Identifier> areaHits(const Frustrum& f) const;
 
+  /**
+   * Get the axis-aligned box enclosing everything the drawable renders, used
+   * to skip it when it is out of view and to frame the scene. It is asked for
+   * on every frame, so it should be cached; a scan of the primitives after an
+   * edit is much cheaper than rebuilding the picking hierarchy.
+   * @param box Set to the bounds, an empty box if there is nothing to render.
+   * @return False if the extent is not known, in which case the drawable is
+   * always rendered. The base implementation returns false.
+   */
+  virtual bool bounds(Eigen::AlignedBox3f& box) const;
+
+  /**
+   * Get the radius of the largest primitive for drawables that only add
+   * detail, such as bonds drawn between atoms, and can be left out when they
+   * would be too small on screen to see. Zero, the default, means that the
+   * drawable is always rendered.
+   */
+  virtual float detailRadius() const { return 0.0f; }
+
   /**
    * Clear the contents of the node.
    */
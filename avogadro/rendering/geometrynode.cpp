@@ -109,4 +109,18 @@ Array<Identifier> GeometryNode::areaHits(const Frustrum& f) const
   return result;
 }
 
+bool GeometryNode::bounds(Eigen::AlignedBox3f& box) const
+{
+  box.setEmpty();
+  for (auto m_drawable : m_drawables) {
+    Eigen::AlignedBox3f drawableBox;
+    if (!m_drawable->isVisible() || isOverlayPass(m_drawable->renderPass()))
+      continue;
+    if (!m_drawable->bounds(drawableBox))
+      return false;
+    box.extend(drawableBox);
+  }
+  return true;
+}
+
 } // End namespace Avogadro
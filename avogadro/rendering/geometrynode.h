@@ -13,6 +13,8 @@
 #include <avogadro/core/array.h>
 #include <avogadro/core/vector.h>
 
+#include <Eigen/Geometry>
+
 #include <map>
 #include <vector>
 
@@ -95,6 +97,14 @@ public:
    */
   Core::Array<Identifier> areaHits(const Frustrum& frustrum) const;
 
+  /**
+   * Get the box enclosing the visible drawables in the node, other than
+   * those drawn in an overlay pass.
+   * @return False if the extent of any of them is not known.
+   * @sa Drawable::bounds()
+   */
+  bool bounds(Eigen::AlignedBox3f& box) const;
+
 protected:
   std::vector<Drawable*> m_drawables;
 };
@@ -7,13 +7,15 @@
 
 #include "ambientocclusionspheregeometry.h"
 #include "curvegeometry.h"
+#include "geometrynode.h"
 #include "linestripgeometry.h"
 #include "spheregeometry.h"
 
 namespace Avogadro::Rendering {
 
 GeometryVisitor::GeometryVisitor()
-  : m_center(Vector3f::Zero()), m_radius(0.0f), m_dirty(false)
+  : m_center(Vector3f::Zero()), m_radius(0.0f), m_dirty(false),
+    m_bounded(true)
 {
 }
 
@@ -21,62 +23,23 @@ GeometryVisitor::~GeometryVisitor() {}
 
 void GeometryVisitor::visit(Drawable&) {}
 
-void GeometryVisitor::visit(SphereGeometry& geometry)
+void GeometryVisitor::visit(GeometryNode& node)
 {
-  const Core::Array<SphereColor>& spheres = geometry.spheres();
-  if (!spheres.size())
-    return;
-
-  m_dirty = true;
+  Eigen::AlignedBox3f box;
+  if (node.bounds(box))
+    m_bounds.extend(box);
+  else
+    m_bounded = false;
+}
 
-  Vector3f tmpCenter(Vector3f::Zero());
-  // First find the center of the sphere geometry.
-  auto it = spheres.begin();
-  for (; it != spheres.end(); ++it)
-    tmpCenter += it->center;
-  tmpCenter /= static_cast<float>(spheres.size());
-
-  // Now find its radius.
-  float tmpRadius(0.0f);
-  if (spheres.size() > 1) {
-    for (it = spheres.begin(); it != spheres.end(); ++it) {
-      float distance = (it->center - tmpCenter).squaredNorm();
-      if (distance > tmpRadius)
-        tmpRadius = distance;
-    }
-  }
-  tmpRadius = std::sqrt(tmpRadius);
-  m_centers.push_back(tmpCenter);
-  m_radii.push_back(tmpRadius);
+void GeometryVisitor::visit(SphereGeometry& geometry)
+{
+  addBounds(geometry);
 }
 
 void GeometryVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
 {
-  const Core::Array<SphereColor>& spheres = geometry.spheres();
-  if (!spheres.size())
-    return;
-
-  m_dirty = true;
-
-  Vector3f tmpCenter(Vector3f::Zero());
-  // First find the center of the sphere geometry.
-  auto it = spheres.begin();
-  for (; it != spheres.end(); ++it)
-    tmpCenter += it->center;
-  tmpCenter /= static_cast<float>(spheres.size());
-
-  // Now find its radius.
-  float tmpRadius(0.0f);
-  if (spheres.size() > 1) {
-    for (it = spheres.begin(); it != spheres.end(); ++it) {
-      float distance = (it->center - tmpCenter).squaredNorm();
-      if (distance > tmpRadius)
-        tmpRadius = distance;
-    }
-  }
-  tmpRadius = std::sqrt(tmpRadius);
-  m_centers.push_back(tmpCenter);
-  m_radii.push_back(tmpRadius);
+  addBounds(geometry);
 }
 
 void GeometryVisitor::visit(CurveGeometry& cg)
@@ -139,6 +102,8 @@ void GeometryVisitor::clear()
   m_center = Vector3f::Zero();
   m_radius = 0.0f;
   m_dirty = false;
+  m_bounds.setEmpty();
+  m_bounded = true;
   m_centers.clear();
   m_radii.clear();
 }
@@ -155,6 +120,23 @@ float GeometryVisitor::radius()
   return m_radius;
 }
 
+bool GeometryVisitor::bounds(Eigen::AlignedBox3f& box) const
+{
+  box = m_bounds;
+  return m_bounded;
+}
+
+void GeometryVisitor::addBounds(const Drawable& drawable)
+{
+  Eigen::AlignedBox3f box;
+  if (!drawable.bounds(box) || box.isEmpty())
+    return;
+
+  m_dirty = true;
+  m_centers.push_back(box.center());
+  m_radii.push_back(0.5f * box.diagonal().norm());
+}
+
 void GeometryVisitor::average()
 {
   if (!m_dirty)
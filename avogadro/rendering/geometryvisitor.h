@@ -10,6 +10,8 @@
 
 #include <avogadro/core/vector.h>
 
+#include <Eigen/Geometry>
+
 #include <vector>
 
 namespace Avogadro {
@@ -22,7 +24,8 @@ namespace Rendering {
  * @author Marcus D. Hanwell
  *
  * This visitor will attempt to determine the geometry of the scene, most
- * notably the center and radius of the bounding sphere.
+ * notably the center and radius of the bounding sphere, and of the box
+ * enclosing the geometry nodes.
  */
 
 class GeometryVisitor : public Visitor
@@ -36,7 +39,7 @@ public:
    */
   void visit(Node&) override { return; }
   void visit(GroupNode&) override { return; }
-  void visit(GeometryNode&) override { return; }
+  void visit(GeometryNode&) override;
   void visit(Drawable&) override;
   void visit(SphereGeometry&) override;
   void visit(AmbientOcclusionSphereGeometry&) override;
@@ -62,15 +65,30 @@ public:
    */
   float radius();
 
+  /**
+   * Get the box enclosing the geometry nodes visited.
+   * @return False if the extent of any of them is not known.
+   * @sa GeometryNode::bounds()
+   */
+  bool bounds(Eigen::AlignedBox3f& box) const;
+
 private:
   /**
    * Get the average of the accumulated spherical centers and minimal radius.
    */
   void average();
 
+  /**
+   * Add the sphere enclosing the bounds of the drawable, which are cached and
+   * so cheaper than a pass over its primitives.
+   */
+  void addBounds(const Drawable& drawable);
+
   Vector3f m_center;
   float m_radius;
   bool m_dirty;
+  Eigen::AlignedBox3f m_bounds;
+  bool m_bounded;
 
   std::vector<Vector3f> m_centers;
   std::vector<float> m_radii;
@@ -18,7 +18,9 @@
 
 #include <avogadro/core/matrix.h>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 namespace Avogadro::Rendering {
 
@@ -26,7 +28,7 @@ using Core::Array;
 
 GLRenderer::GLRenderer()
   : m_valid(false), m_textRenderStrategy(nullptr), m_center(Vector3f::Zero()),
-    m_radius(20.0)
+    m_radius(20.0), m_bounded(false)
 #ifdef _3DCONNEXION
     ,
     m_drawIcon(false), m_iconData(nullptr), m_iconWidth(0u), m_iconHeight(0u),
@@ -170,6 +172,7 @@ void GLRenderer::resetGeometry()
     m_camera.setFocus(m_scene.center());
   m_center = m_scene.center();
   m_radius = m_scene.radius();
+  m_bounded = m_scene.bounds(m_bounds) && !m_bounds.isEmpty();
 }
 
 void GLRenderer::setTextRenderStrategy(TextRenderStrategy* tren)
@@ -206,20 +209,42 @@ void GLRenderer::applyProjection()
   float distance = m_camera.distance(m_center);
   float aspectRatio = static_cast<float>(m_camera.width()) /
                       static_cast<float>(m_camera.height());
+  // The depths of the corners of the scene box, when every drawable has
+  // bounds, give closer planes than the sphere and so finer depth steps.
+  float first = 0.0f;
+  float last = distance + m_radius;
+  if (m_bounded) {
+    first = std::numeric_limits<float>::max();
+    last = std::numeric_limits<float>::lowest();
+    for (int i = 0; i < 8; ++i) {
+      const auto corner = static_cast<Eigen::AlignedBox3f::CornerType>(i);
+      const float depth = -(m_camera.modelView() * m_bounds.corner(corner)).z();
+      first = std::min(first, depth - 1.0f);
+      last = std::max(last, depth + 1.0f);
+    }
+  }
   if (m_camera.projectionType() == Perspective) {
     m_perspectiveFrustum[0] = m_perspectiveFrustum[2] * aspectRatio;
     m_perspectiveFrustum[1] = m_perspectiveFrustum[3] * aspectRatio;
-    m_perspectiveFrustum[5] = distance + m_radius;
+    // the sides are given at the near plane, so they move out along with it
+    const float zNear = std::max(m_perspectiveFrustum[4], first);
+    const float scale = zNear / m_perspectiveFrustum[4];
+    m_perspectiveFrustum[5] = std::max(last, zNear + 1.0f);
     m_camera.calculatePerspective(
-      m_perspectiveFrustum[0], m_perspectiveFrustum[1], m_perspectiveFrustum[2],
-      m_perspectiveFrustum[3], m_perspectiveFrustum[4],
+      scale * m_perspectiveFrustum[0], scale * m_perspectiveFrustum[1],
+      scale * m_perspectiveFrustum[2], scale * m_perspectiveFrustum[3], zNear,
       m_perspectiveFrustum[5]);
   } else {
     // Renders the orthographic projection of the molecule
     m_orthographicFrustum[0] = m_orthographicFrustum[2] * aspectRatio;
     m_orthographicFrustum[1] = m_orthographicFrustum[3] * aspectRatio;
-    m_orthographicFrustum[5] = distance + m_radius;
-    m_orthographicFrustum[4] = -m_orthographicFrustum[5];
+    if (m_bounded) {
+      m_orthographicFrustum[4] = first;
+      m_orthographicFrustum[5] = last;
+    } else {
+      m_orthographicFrustum[5] = distance + m_radius;
+      m_orthographicFrustum[4] = -m_orthographicFrustum[5];
+    }
     m_camera.calculateOrthographic(m_orthographicFrustum[0],  // L
                                    m_orthographicFrustum[1],  // R
                                    m_orthographicFrustum[2],  // B
@@ -154,6 +154,8 @@ private:
 
   Vector3f m_center;
   float m_radius;
+  Eigen::AlignedBox3f m_bounds;
+  bool m_bounded;
 };
 
 inline const Camera& GLRenderer::camera() const
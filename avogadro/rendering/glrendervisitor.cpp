@@ -14,11 +14,14 @@
 #include "textlabel2d.h"
 #include "textlabel3d.h"
 
+#include <algorithm>
+
 namespace Avogadro::Rendering {
 
 GLRenderVisitor::GLRenderVisitor(const Camera& camera_,
                                  const TextRenderStrategy* trs)
-  : m_camera(camera_), m_textRenderStrategy(trs), m_renderPass(NotRendering)
+  : m_camera(camera_), m_textRenderStrategy(trs), m_renderPass(NotRendering),
+    m_culling(true), m_detailThreshold(0.25f)
 {
 }
 
@@ -28,43 +31,43 @@ GLRenderVisitor::~GLRenderVisitor()
 
 void GLRenderVisitor::visit(Drawable& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && shouldRender(geometry))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(SphereGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && shouldRender(geometry))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && shouldRender(geometry))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(CurveGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && shouldRender(geometry))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(CylinderGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && shouldRender(geometry))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(MeshGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && shouldRender(geometry))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(TextLabel2D& geometry)
 {
-  if (geometry.renderPass() == m_renderPass) {
+  if (geometry.renderPass() == m_renderPass && shouldRender(geometry)) {
     if (m_textRenderStrategy)
       geometry.buildTexture(*m_textRenderStrategy);
     geometry.render(m_camera);
@@ -73,7 +76,7 @@ void GLRenderVisitor::visit(TextLabel2D& geometry)
 
 void GLRenderVisitor::visit(TextLabel3D& geometry)
 {
-  if (geometry.renderPass() == m_renderPass) {
+  if (geometry.renderPass() == m_renderPass && shouldRender(geometry)) {
     if (m_textRenderStrategy)
       geometry.buildTexture(*m_textRenderStrategy);
     geometry.render(m_camera);
@@ -82,8 +85,53 @@ void GLRenderVisitor::visit(TextLabel3D& geometry)
 
 void GLRenderVisitor::visit(LineStripGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && shouldRender(geometry))
     geometry.render(m_camera);
 }
 
+bool GLRenderVisitor::shouldRender(const Drawable& drawable) const
+{
+  if ((!m_culling && m_detailThreshold <= 0.0f) ||
+      isOverlayPass(drawable.renderPass()))
+    return true;
+  Eigen::AlignedBox3f box;
+  if (!drawable.bounds(box))
+    return true;
+  if (box.isEmpty())
+    return !m_culling;
+
+  const Eigen::Matrix4f matrix =
+    m_camera.projection().matrix() * m_camera.modelView().matrix();
+  const Vector3f center = box.center();
+  const Vector3f half = 0.5f * box.sizes();
+
+  // The clip planes are the sums and differences of the last row of the
+  // matrix with the others, a box is out when it is behind any of them.
+  if (m_culling) {
+    for (int i = 0; i < 3; ++i) {
+      for (float sign : { 1.0f, -1.0f }) {
+        const Eigen::Vector4f plane = matrix.row(3) + sign * matrix.row(i);
+        const Vector3f normal = plane.head<3>();
+        if (normal.dot(center) + plane[3] + normal.cwiseAbs().dot(half) < 0.0f)
+          return false;
+      }
+    }
+  }
+
+  const float radius = drawable.detailRadius();
+  if (m_detailThreshold <= 0.0f || radius <= 0.0f || m_camera.height() <= 0)
+    return true;
+  // w is the depth for a perspective projection and one for an orthographic
+  // one, the box is close enough if it reaches the plane of the eye
+  const Vector3f wRow = matrix.row(3).head<3>();
+  const float w = wRow.dot(center) + matrix(3, 3) - wRow.cwiseAbs().dot(half);
+  if (w <= 0.0f)
+    return true;
+  const float pixels =
+    radius / w *
+    std::max(0.5f * m_camera.width() * matrix.row(0).head<3>().norm(),
+             0.5f * m_camera.height() * matrix.row(1).head<3>().norm());
+  return pixels >= m_detailThreshold;
+}
+
 } // End namespace Avogadro
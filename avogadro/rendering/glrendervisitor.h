@@ -21,7 +21,9 @@ class TextRenderStrategy;
  * @brief Visitor that takes care of rendering the scene.
  * @author Marcus D. Hanwell
  *
- * This visitor will render elements in the scene.
+ * This visitor will render elements in the scene. Drawables that report their
+ * bounds are skipped when they lie outside the view of the camera, and those
+ * that only add detail are skipped when they would be too small to see.
  */
 
 class AVOGADRORENDERING_EXPORT GLRenderVisitor : public Visitor
@@ -59,6 +61,34 @@ public:
   void setCamera(const Camera& camera_) { m_camera = camera_; }
   Camera camera() const { return m_camera; }
 
+  /**
+   * Skip drawables whose bounds lie outside the view of the camera, true by
+   * default. Drawables in an overlay pass are always rendered.
+   * @sa Drawable::bounds()
+   * @{
+   */
+  void setCulling(bool enable) { m_culling = enable; }
+  bool culling() const { return m_culling; }
+  /** @} */
+
+  /**
+   * Skip drawables that only add detail, such as bond cylinders, when their
+   * widest primitive would be less than this many pixels in radius at the
+   * nearest point of their bounds. Zero turns this off, the default is a
+   * quarter of a pixel.
+   * @sa Drawable::detailRadius()
+   * @{
+   */
+  void setDetailThreshold(float pixels) { m_detailThreshold = pixels; }
+  float detailThreshold() const { return m_detailThreshold; }
+  /** @} */
+
+  /**
+   * @return True unless the drawable is out of view or too small on screen
+   * for the current camera.
+   */
+  bool shouldRender(const Drawable& drawable) const;
+
   /**
    * A TextRenderStrategy implementation used to render text for annotations.
    * If nullptr, no text will be produced.
@@ -78,6 +108,8 @@ private:
   Camera m_camera;
   const TextRenderStrategy* m_textRenderStrategy;
   RenderPass m_renderPass;
+  bool m_culling;
+  float m_detailThreshold;
 };
 
 } // End namespace Rendering
@@ -16,6 +16,7 @@
 #include <avogadro/core/matrix.h>
 #include <avogadro/core/vector.h>
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <limits>
@@ -199,6 +200,75 @@ void MeshGeometry::render(const Camera& camera)
   program->release();
 }
 
+std::multimap<float, Identifier> MeshGeometry::hits(
+  const Vector3f& rayOrigin, const Vector3f& rayEnd,
+  const Vector3f& rayDirection) const
+{
+  std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  // Only the triangles with bounding boxes along the ray can be hit.
+  std::vector<Index> candidates;
+  hierarchy().intersect(rayOrigin, rayEnd, candidates);
+  std::sort(candidates.begin(), candidates.end());
+
+  const float length = (rayEnd - rayOrigin).dot(rayDirection);
+  for (Index i : candidates) {
+    const Vector3f& a = m_vertices[m_indices[3 * i]].vertex;
+    const Vector3f edge1 = m_vertices[m_indices[3 * i + 1]].vertex - a;
+    const Vector3f edge2 = m_vertices[m_indices[3 * i + 2]].vertex - a;
+
+    // Moeller-Trumbore intersection, from either side of the triangle.
+    const Vector3f p = rayDirection.cross(edge2);
+    const float determinant = edge1.dot(p);
+    if (std::abs(determinant) < std::numeric_limits<float>::epsilon())
+      continue;
+    const Vector3f s = rayOrigin - a;
+    const float u = s.dot(p) / determinant;
+    if (u < 0.0f || u > 1.0f)
+      continue;
+    const Vector3f q = s.cross(edge1);
+    const float v = rayDirection.dot(q) / determinant;
+    if (v < 0.0f || u + v > 1.0f)
+      continue;
+
+    // Test for clipping
+    const float depth = edge2.dot(q) / determinant;
+    if (depth < 0.0f || depth > length)
+      continue;
+
+    Identifier id;
+    id.molecule = m_identifier.molecule;
+    id.type = m_identifier.type;
+    id.index = i;
+    result.insert(std::pair<float, Identifier>(depth, id));
+  }
+  return result;
+}
+
+const BoundingVolumeHierarchy& MeshGeometry::hierarchy() const
+{
+  if (m_hierarchy.isEmpty() && m_indices.size() >= 3) {
+    std::vector<BoundingVolumeHierarchy::Box> boxes;
+    boxes.reserve(m_indices.size() / 3);
+    for (size_t i = 0; i + 2 < m_indices.size(); i += 3) {
+      BoundingVolumeHierarchy::Box box;
+      for (size_t j = i; j < i + 3; ++j)
+        box.extend(m_vertices[m_indices[j]].vertex);
+      boxes.push_back(box);
+    }
+    m_hierarchy.build(boxes);
+  }
+  return m_hierarchy;
+}
+
+bool MeshGeometry::bounds(Eigen::AlignedBox3f& box) const
+{
+  box = hierarchy().bounds();
+  return true;
+}
+
 unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
                                        const Core::Array<Vector3f>& n,
                                        const Core::Array<Vector4ub>& c)
@@ -273,6 +343,7 @@ void MeshGeometry::addTriangle(unsigned int index1, unsigned int index2,
   m_indices.push_back(index1);
   m_indices.push_back(index2);
   m_indices.push_back(index3);
+  m_hierarchy.clear();
   m_dirty = true;
 }
 
@@ -281,6 +352,7 @@ void MeshGeometry::addTriangles(const Core::Array<unsigned int>& indiceArray)
   m_indices.reserve(m_indices.size() + indiceArray.size());
   std::copy(indiceArray.begin(), indiceArray.end(),
             std::back_inserter(m_indices));
+  m_hierarchy.clear();
   m_dirty = true;
 }
 
@@ -288,6 +360,7 @@ void MeshGeometry::clear()
 {
   m_vertices.clear();
   m_indices.clear();
+  m_hierarchy.clear();
   m_dirty = true;
 }
 
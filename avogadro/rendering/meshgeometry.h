@@ -6,6 +6,7 @@
 #ifndef AVOGADRO_RENDERING_MESHGEOMETRY_H
 #define AVOGADRO_RENDERING_MESHGEOMETRY_H
 
+#include "boundingvolumehierarchy.h"
 #include "drawable.h"
 
 #include <avogadro/core/array.h>
@@ -63,6 +64,29 @@ public:
    */
   void render(const Camera& camera) override;
 
+  /**
+   * Return the triangles that are hit by the ray, with the index of the
+   * triangle as the index of the identifier.
+   * @param rayOrigin Origin of the ray.
+   * @param rayEnd End point of the ray.
+   * @param rayDirection Normalized direction of the ray.
+   * @return Sorted collection of primitives that were hit.
+   */
+  std::multimap<float, Identifier> hits(
+    const Vector3f& rayOrigin, const Vector3f& rayEnd,
+    const Vector3f& rayDirection) const override;
+
+  /**
+   * Get the bounding volume hierarchy over the triangles used for picking.
+   * It is built on first use and again after triangles are added.
+   */
+  const BoundingVolumeHierarchy& hierarchy() const;
+
+  /**
+   * Get the box enclosing the triangles, taken from the hierarchy.
+   */
+  bool bounds(Eigen::AlignedBox3f& box) const override;
+
   /**
    * Add vertices to the object. Note that this just adds vertices to the
    * object. Use addTriangles with size_t indices to actually draw them.
@@ -146,6 +170,7 @@ private:
 
   Core::Array<PackedVertex> m_vertices;
   Core::Array<unsigned int> m_indices;
+  mutable BoundingVolumeHierarchy m_hierarchy;
   Vector3ub m_color;
   unsigned char m_opacity;
 
@@ -168,6 +193,7 @@ inline void swap(MeshGeometry& lhs, MeshGeometry& rhs)
   swap(static_cast<Drawable&>(lhs), static_cast<Drawable&>(rhs));
   swap(lhs.m_vertices, rhs.m_vertices);
   swap(lhs.m_indices, rhs.m_indices);
+  swap(lhs.m_hierarchy, rhs.m_hierarchy);
   swap(lhs.m_color, rhs.m_color);
   swap(lhs.m_opacity, rhs.m_opacity);
   lhs.m_dirty = rhs.m_dirty = true;
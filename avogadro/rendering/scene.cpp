@@ -13,7 +13,7 @@ namespace Avogadro::Rendering {
 
 Scene::Scene()
   : m_backgroundColor(0, 0, 0, 0), m_dirty(true), m_center(Vector3f::Zero()),
-    m_radius(4.0f)
+    m_radius(4.0f), m_bounded(false)
 {
 }
 
@@ -32,6 +32,7 @@ Vector3f Scene::center()
   // For an empty scene ensure that a minimum radius of 4.0 (gives space).
   m_center = visitor.center();
   m_radius = std::max(4.0f, visitor.radius()) + 2.0f;
+  m_bounded = visitor.bounds(m_bounds);
   m_dirty = false;
 
   return m_center;
@@ -47,6 +48,14 @@ float Scene::radius()
   return m_radius;
 }
 
+bool Scene::bounds(Eigen::AlignedBox3f& box)
+{
+  // The bounds are found along with the center
+  center();
+  box = m_bounds;
+  return m_bounded;
+}
+
 void Scene::clear()
 {
   m_rootNode.clear();
@@ -14,6 +14,8 @@
 #include <avogadro/core/avogadrocore.h>
 #include <avogadro/core/vector.h>
 
+#include <Eigen/Geometry>
+
 #include <map>    // For member variables.
 #include <string> // For member variables.
 #include <vector> // For member variables.
@@ -101,6 +103,13 @@ public:
    */
   float radius();
 
+  /**
+   * Get the box enclosing the geometry in this Scene, which is cached along
+   * with the center and radius.
+   * @return False if the extent of some of the geometry is not known.
+   */
+  bool bounds(Eigen::AlignedBox3f& box);
+
   /**
    * Get the root node of the scene.
    */
@@ -138,6 +147,8 @@ private:
   mutable bool m_dirty;
   mutable Vector3f m_center;
   mutable float m_radius;
+  mutable Eigen::AlignedBox3f m_bounds;
+  mutable bool m_bounded;
 };
 
 } // namespace Rendering
@@ -22,6 +22,7 @@ namespace {
 
 #include "avogadrogl.h"
 
+#include <algorithm>
 #include <iostream>
 
 using std::cout;
@@ -31,6 +32,29 @@ namespace Avogadro::Rendering {
 
 using Core::Array;
 
+namespace {
+// The four corners of the quad the sphere is drawn on.
+void addVertices(const SphereColor& sphere,
+                 std::vector<ColorTextureVertex>& vertices)
+{
+  float r = sphere.radius;
+  ColorTextureVertex vert(sphere.center, sphere.color, Vector2f(-r, -r));
+  vertices.push_back(vert);
+  vert.textureCoord = Vector2f(-r, r);
+  vertices.push_back(vert);
+  vert.textureCoord = Vector2f(r, -r);
+  vertices.push_back(vert);
+  vert.textureCoord = Vector2f(r, r);
+  vertices.push_back(vert);
+}
+
+BoundingVolumeHierarchy::Box sphereBox(const SphereColor& sphere)
+{
+  return BoundingVolumeHierarchy::Box(sphere.center.array() - sphere.radius,
+                                      sphere.center.array() + sphere.radius);
+}
+} // namespace
+
 class SphereGeometry::Private
 {
 public:
@@ -73,6 +97,10 @@ void SphereGeometry::update()
   if (m_indices.empty() || m_spheres.empty())
     return;
 
+  // Past half of the spheres, one upload is cheaper than many small ones.
+  if (2 * m_changed.count() > m_spheres.size())
+    m_dirty = true;
+
   // Check if the VBOs are ready, if not get them ready.
   if (!d->vbo.ready() || m_dirty) {
     std::vector<unsigned int> sphereIndices;
@@ -87,17 +115,8 @@ void SphereGeometry::update()
          itIndex != m_indices.end() && itSphere != m_spheres.end();
          ++i, ++itIndex, ++itSphere) {
       // Use our packed data structure...
-      float r = itSphere->radius;
       unsigned int index = 4 * static_cast<unsigned int>(i);
-      ColorTextureVertex vert(itSphere->center, itSphere->color,
-                              Vector2f(-r, -r));
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(-r, r);
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(r, -r);
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(r, r);
-      sphereVertices.push_back(vert);
+      addVertices(*itSphere, sphereVertices);
 
       // 6 indexed vertices to draw a quad...
       sphereIndices.push_back(index + 0);
@@ -120,6 +139,19 @@ void SphereGeometry::update()
     d->numberOfIndices = sphereIndices.size();
 
     m_dirty = false;
+    m_changed.clear();
+  } else if (!m_changed.isEmpty()) {
+    // Only send the spheres that were changed in place.
+    const Array<SphereColor>& spheres = m_spheres;
+    std::vector<ColorTextureVertex> sphereVertices;
+    for (const DirtyRanges::Range& range : m_changed.ranges()) {
+      sphereVertices.clear();
+      for (Index i = range.first; i < range.second; ++i)
+        addVertices(spheres[i], sphereVertices);
+      if (!d->vbo.uploadRange(sphereVertices, 4 * range.first))
+        cout << d->vbo.error() << endl;
+    }
+    m_changed.clear();
   }
 
   // Build and link the shader if it has not been used yet.
@@ -220,9 +252,16 @@ std::multimap<float, Identifier> SphereGeometry::hits(
   const Vector3f& rayDirection) const
 {
   std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  // Only the spheres with bounding boxes along the ray can be hit.
+  std::vector<Index> candidates;
+  hierarchy().intersect(rayOrigin, rayEnd, candidates);
+  std::sort(candidates.begin(), candidates.end());
 
   // Check for intersection.
-  for (size_t i = 0; i < m_spheres.size(); ++i) {
+  for (Index i : candidates) {
     const SphereColor& sphere = m_spheres[i];
 
     Vector3f distance = sphere.center - rayOrigin;
@@ -242,11 +281,9 @@ std::multimap<float, Identifier> SphereGeometry::hits(
     id.molecule = m_identifier.molecule;
     id.type = m_identifier.type;
     id.index = m_indices[i];
-    if (id.type != InvalidType) {
-      auto rootD = static_cast<float>(sqrt(D));
-      float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
-      result.insert(std::pair<float, Identifier>(depth, id));
-    }
+    auto rootD = static_cast<float>(sqrt(D));
+    float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
+    result.insert(std::pair<float, Identifier>(depth, id));
   }
   return result;
 }
@@ -254,8 +291,13 @@ std::multimap<float, Identifier> SphereGeometry::hits(
 Array<Identifier> SphereGeometry::areaHits(const Frustrum& f) const
 {
   Array<Identifier> result;
+  // Spheres in boxes entirely within the frustrum are hits without a test.
+  std::vector<Index> hits;
+  std::vector<Index> candidates;
+  hierarchy().intersect(f, hits, candidates);
+
   // Check for intersection.
-  for (size_t i = 0; i < m_spheres.size(); ++i) {
+  for (Index i : candidates) {
     const SphereColor& sphere = m_spheres[i];
 
     int in = 0;
@@ -268,28 +310,76 @@ Array<Identifier> SphereGeometry::areaHits(const Frustrum& f) const
     }
     if (in == 4) {
       // The center is within the four planes that make our frustrum - hit.
-      Identifier id;
-      id.molecule = m_identifier.molecule;
-      id.type = m_identifier.type;
-      id.index = m_indices[i];
-      result.push_back(id);
+      hits.push_back(i);
     }
   }
+
+  std::sort(hits.begin(), hits.end());
+  result.reserve(hits.size());
+  for (Index i : hits) {
+    Identifier id;
+    id.molecule = m_identifier.molecule;
+    id.type = m_identifier.type;
+    id.index = m_indices[i];
+    result.push_back(id);
+  }
   return result;
 }
 
+const BoundingVolumeHierarchy& SphereGeometry::hierarchy() const
+{
+  if (m_hierarchy.isEmpty() && !m_spheres.empty()) {
+    std::vector<BoundingVolumeHierarchy::Box> boxes;
+    boxes.reserve(m_spheres.size());
+    for (const SphereColor& sphere : m_spheres)
+      boxes.push_back(sphereBox(sphere));
+    m_hierarchy.build(boxes);
+  }
+  return m_hierarchy;
+}
+
+bool SphereGeometry::bounds(Eigen::AlignedBox3f& box) const
+{
+  if (m_bounds.isEmpty()) {
+    for (const SphereColor& sphere : m_spheres)
+      m_bounds.extend(sphereBox(sphere));
+  }
+  box = m_bounds;
+  return true;
+}
+
 void SphereGeometry::addSphere(const Vector3f& position, const Vector3ub& color,
                                float radius, size_t index)
 {
   m_dirty = true;
+  m_hierarchy.clear();
+  m_bounds.setEmpty();
   m_spheres.push_back(SphereColor(position, radius, color));
   m_indices.push_back(index == MaxIndex ? m_indices.size() : index);
 }
 
+void SphereGeometry::setSphere(size_t i, const Vector3f& position,
+                               const Vector3ub& color, float radius)
+{
+  if (i >= m_spheres.size())
+    return;
+  m_spheres[i] = SphereColor(position, radius, color);
+  if (!m_hierarchy.isEmpty()) {
+    m_hierarchy.update(i, sphereBox(m_spheres[i]));
+    m_bounds = m_hierarchy.bounds();
+  } else {
+    m_bounds.setEmpty();
+  }
+  m_changed.add(i);
+}
+
 void SphereGeometry::clear()
 {
   m_spheres.clear();
   m_indices.clear();
+  m_hierarchy.clear();
+  m_bounds.setEmpty();
+  m_changed.clear();
 }
 
 } // End namespace Avogadro
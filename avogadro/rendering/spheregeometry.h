@@ -6,6 +6,8 @@
 #ifndef AVOGADRO_RENDERING_SPHEREGEOMETRY_H
 #define AVOGADRO_RENDERING_SPHEREGEOMETRY_H
 
+#include "boundingvolumehierarchy.h"
+#include "dirtyranges.h"
 #include "drawable.h"
 
 #include <avogadro/core/array.h>
@@ -78,6 +80,17 @@ public:
    */
   Core::Array<Identifier> areaHits(const Frustrum& f) const override;
 
+  /**
+   * Get the bounding volume hierarchy over the spheres used for picking. It
+   * is built on first use and again after the spheres change.
+   */
+  const BoundingVolumeHierarchy& hierarchy() const;
+
+  /**
+   * Get the box enclosing the spheres, kept until the spheres change.
+   */
+  bool bounds(Eigen::AlignedBox3f& box) const override;
+
   /**
    * Set the opacity of the spheres in this group.
    */
@@ -94,10 +107,23 @@ public:
   void addSphere(const Vector3f& position, const Vector3ub& color, float radius,
                  size_t index = MaxIndex);
 
+  /**
+   * Change the sphere at position @p i in place, keeping its index. Only the
+   * spheres changed this way are sent to the GPU on the next render, and the
+   * hierarchy and bounds are refit rather than built again.
+   */
+  void setSphere(size_t i, const Vector3f& position, const Vector3ub& color,
+                 float radius);
+
   /**
    * Get a reference to the spheres.
    */
-  Core::Array<SphereColor>& spheres() { return m_spheres; }
+  Core::Array<SphereColor>& spheres()
+  {
+    m_hierarchy.clear();
+    m_bounds.setEmpty();
+    return m_spheres;
+  }
   const Core::Array<SphereColor>& spheres() const { return m_spheres; }
 
   /**
@@ -113,8 +139,11 @@ public:
 private:
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
+  mutable BoundingVolumeHierarchy m_hierarchy;
+  mutable BoundingVolumeHierarchy::Box m_bounds;
 
   bool m_dirty;
+  DirtyRanges m_changed;
 
   float m_opacity = 1.0f;
 
@@ -135,6 +164,8 @@ inline void swap(SphereGeometry& lhs, SphereGeometry& rhs)
   swap(static_cast<Drawable&>(lhs), static_cast<Drawable&>(rhs));
   swap(lhs.m_spheres, rhs.m_spheres);
   swap(lhs.m_indices, rhs.m_indices);
+  swap(lhs.m_hierarchy, rhs.m_hierarchy);
+  swap(lhs.m_bounds, rhs.m_bounds);
   lhs.m_dirty = rhs.m_dirty = true;
 }
 
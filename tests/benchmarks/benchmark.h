@@ -0,0 +1,60 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_BENCHMARKS_BENCHMARK_H
+#define AVOGADRO_BENCHMARKS_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace Avogadro {
+namespace Benchmarks {
+
+/**
+ * Run @a setup followed by a timed call to @a body @a repeats times, and
+ * return the best wall time in seconds. Taking the minimum filters out noise
+ * from other processes, which only ever makes a run slower.
+ */
+template <typename Setup, typename Body>
+double bestTime(int repeats, Setup&& setup, Body&& body)
+{
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < std::max(repeats, 1); ++i) {
+    setup();
+    auto start = std::chrono::steady_clock::now();
+    body();
+    std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+/** Print one result line: label, time and throughput in @a unit per second. */
+inline void report(const std::string& label, double seconds, double items,
+                   const std::string& unit)
+{
+  std::cout << std::left << std::setw(32) << label << std::right
+            << std::setw(12) << std::fixed << std::setprecision(4) << seconds
+            << " s" << std::setw(16) << std::setprecision(0)
+            << (seconds > 0.0 ? items / seconds : 0.0) << " " << unit << "/s"
+            << std::endl;
+}
+
+/** @return argv[index] as a number, or @a fallback if it is not given. */
+inline long argument(int argc, char* argv[], int index, long fallback)
+{
+  return index < argc ? std::atol(argv[index]) : fallback;
+}
+
+} // namespace Benchmarks
+} // namespace Avogadro
+
+#endif // AVOGADRO_BENCHMARKS_BENCHMARK_H
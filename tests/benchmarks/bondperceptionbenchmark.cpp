@@ -0,0 +1,75 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "benchmark.h"
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/parallel.h>
+#include <avogadro/core/vector.h>
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Molecule;
+using namespace Avogadro::Benchmarks;
+
+namespace {
+
+// A box of water molecules on a slightly perturbed grid, roughly at the
+// density of liquid water.
+Molecule waterBox(Index atoms)
+{
+  Molecule mol;
+  const Index waters = std::max<Index>(atoms / 3, 1);
+  const int side = static_cast<int>(std::ceil(std::cbrt(waters)));
+  const double spacing = 3.1;
+  Index added = 0;
+  for (int x = 0; x < side && added < waters; ++x) {
+    for (int y = 0; y < side && added < waters; ++y) {
+      for (int z = 0; z < side && added < waters; ++z, ++added) {
+        // deterministic jitter, so runs are comparable
+        const double jitter = 0.3 * std::sin(0.7 * x + 1.3 * y + 2.9 * z);
+        const Vector3 o(x * spacing + jitter, y * spacing - jitter,
+                        z * spacing + 0.5 * jitter);
+        mol.addAtom(8).setPosition3d(o);
+        mol.addAtom(1).setPosition3d(o + Vector3(0.96, 0.0, 0.0));
+        mol.addAtom(1).setPosition3d(o + Vector3(-0.24, 0.93, 0.0));
+      }
+    }
+  }
+  return mol;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const Index atoms = argument(argc, argv, 1, 300000);
+  const int repeats = static_cast<int>(argument(argc, argv, 2, 3));
+
+  const Molecule reference = waterBox(atoms);
+  std::cout << "Bond perception, " << reference.atomCount() << " atoms"
+            << std::endl;
+
+  const unsigned int threads = Avogadro::Core::maxThreadCount();
+  for (unsigned int count : { 1u, threads }) {
+    Avogadro::Core::setMaxThreadCount(count);
+    Molecule mol;
+    double seconds = bestTime(
+      repeats, [&]() { mol = reference; },
+      [&]() { mol.perceiveBondsSimple(); });
+    std::ostringstream label;
+    label << "perceiveBondsSimple (" << count << " threads)";
+    report(label.str(), seconds, static_cast<double>(mol.bondCount()),
+           "bonds");
+    if (count == threads)
+      break;
+  }
+  Avogadro::Core::setMaxThreadCount(0);
+  return 0;
+}
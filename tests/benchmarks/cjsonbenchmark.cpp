@@ -0,0 +1,99 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "benchmark.h"
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/io/cjsonformat.h>
+#include <avogadro/io/cmsgpackformat.h>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using Avogadro::Index;
+using Avogadro::MatrixX;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Io::CjsonFormat;
+using Avogadro::Io::CMsgPackFormat;
+using Avogadro::Io::FileFormat;
+using namespace Avogadro::Benchmarks;
+
+namespace {
+
+Vector3 position(Index atom, Index side)
+{
+  return Vector3(1.5 * (atom % side), 1.5 * (atom / side % side),
+                 1.5 * (atom / (side * side)) + 0.001 * (atom % 7));
+}
+
+// Pairs of bonded atoms on a lattice, with partial charges.
+Molecule lattice(Index atoms, Index side)
+{
+  Molecule molecule;
+  Array<Vector3> positions;
+  positions.reserve(atoms);
+  MatrixX charges(atoms, 1);
+  Array<std::pair<Index, Index>> bonds;
+  for (Index i = 0; i < atoms; ++i) {
+    molecule.addAtom(static_cast<unsigned char>(i % 2 ? 1 : 8));
+    positions.push_back(position(i, side));
+    charges(i, 0) = i % 2 ? 0.4 : -0.8;
+    if (i % 2)
+      bonds.push_back(std::make_pair(i - 1, i));
+  }
+  molecule.setAtomPositions3d(positions);
+  molecule.addBonds(bonds, Array<unsigned char>(bonds.size(), 1));
+  molecule.setPartialCharges("benchmark", charges);
+  return molecule;
+}
+
+// Write and read the molecule back, returning false if it did not survive.
+bool measure(FileFormat& format, const Molecule& molecule, Index side,
+             int repeats, const std::string& name)
+{
+  const Index atoms = molecule.atomCount();
+  std::string text;
+  double seconds = bestTime(
+    repeats, [&]() { text.clear(); },
+    [&]() { format.writeString(text, molecule); });
+  report(name + " write", seconds, static_cast<double>(atoms), "atoms");
+
+  Molecule read;
+  bool valid = true;
+  seconds = bestTime(
+    repeats, [&]() { read = Molecule(); },
+    [&]() { valid = format.readString(text, read) && valid; });
+  report(name + " read", seconds, static_cast<double>(atoms), "atoms");
+
+  return valid && read.atomCount() == atoms &&
+         read.bondCount() == molecule.bondCount() &&
+         (read.atomPosition3d(atoms - 1) - position(atoms - 1, side)).norm() <
+           1e-6;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const Index atoms = argument(argc, argv, 1, 300000);
+  const int repeats = static_cast<int>(argument(argc, argv, 2, 3));
+  const auto side =
+    static_cast<Index>(std::ceil(std::cbrt(static_cast<double>(atoms))));
+
+  std::cout << "Chemical JSON round trips, " << atoms << " atoms" << std::endl;
+
+  const Molecule molecule = lattice(atoms, side);
+  CjsonFormat cjson;
+  CMsgPackFormat msgpack;
+  bool valid = measure(cjson, molecule, side, repeats, "CJSON");
+  valid = measure(msgpack, molecule, side, repeats, "MessagePack") && valid;
+
+  if (!valid)
+    std::cerr << "The molecule did not survive the round trip." << std::endl;
+  return valid ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "benchmark.h"
+
+#include <avogadro/core/vector.h>
+#include <avogadro/rendering/cylindergeometry.h>
+#include <avogadro/rendering/spheregeometry.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Avogadro::Frustrum;
+using Avogadro::Index;
+using Avogadro::Vector3f;
+using Avogadro::Vector3ub;
+using Avogadro::Rendering::AtomType;
+using Avogadro::Rendering::BondType;
+using Avogadro::Rendering::CylinderGeometry;
+using Avogadro::Rendering::SphereGeometry;
+using namespace Avogadro::Benchmarks;
+
+namespace {
+
+const float spacing = 1.5f;
+
+// Ball and stick spheres on a lattice, with bonds along x.
+void lattice(Index atoms, Index side, SphereGeometry& spheres,
+             CylinderGeometry& cylinders)
+{
+  spheres.identifier().type = AtomType;
+  cylinders.identifier().type = BondType;
+  for (Index i = 0; i < atoms; ++i) {
+    const Vector3f position(spacing * (i % side), spacing * (i / side % side),
+                            spacing * (i / (side * side)));
+    spheres.addSphere(position, Vector3ub(200, 100, 50), 0.4f);
+    if (i % side) {
+      cylinders.addCylinder(position - Vector3f(spacing, 0.0f, 0.0f), position,
+                            0.1f, Vector3ub(100, 100, 100), i);
+    }
+  }
+}
+
+// The index of the nearest sphere hit by a full scan, as picking used to do.
+Index nearestByScan(const SphereGeometry& geometry, const Vector3f& origin,
+                    const Vector3f& end, const Vector3f& direction)
+{
+  Index nearest = Avogadro::MaxIndex;
+  float nearestDepth = 0.0f;
+  for (Index i = 0; i < geometry.size(); ++i) {
+    const auto& sphere = geometry.spheres()[i];
+    const Vector3f distance = sphere.center - origin;
+    const float B = distance.dot(direction);
+    const float D = B * B - distance.dot(distance) +
+                    sphere.radius * sphere.radius;
+    if (D < 0.0f || B < 0.0f || (sphere.center - end).dot(direction) > 0.0f)
+      continue;
+    const float rootD = std::sqrt(D);
+    const float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
+    if (nearest == Avogadro::MaxIndex || depth < nearestDepth) {
+      nearest = i;
+      nearestDepth = depth;
+    }
+  }
+  return nearest;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const Index atoms = argument(argc, argv, 1, 300000);
+  const Index picks = argument(argc, argv, 2, 10000);
+  const int repeats = static_cast<int>(argument(argc, argv, 3, 3));
+  const auto side =
+    static_cast<Index>(std::ceil(std::cbrt(static_cast<double>(atoms))));
+  const float size = spacing * side;
+
+  std::cout << "Picking, " << atoms << " atoms" << std::endl;
+
+  SphereGeometry spheres;
+  CylinderGeometry cylinders;
+  lattice(atoms, side, spheres, cylinders);
+
+  // the writable accessors drop the hierarchy
+  double seconds = bestTime(
+    repeats, [&]() { spheres.spheres(); }, [&]() { spheres.hierarchy(); });
+  report("Sphere hierarchy build", seconds, static_cast<double>(atoms),
+         "atoms");
+  seconds = bestTime(
+    repeats, [&]() { cylinders.cylinders(); },
+    [&]() { cylinders.hierarchy(); });
+  report("Cylinder hierarchy build", seconds,
+         static_cast<double>(cylinders.size()), "bonds");
+
+  // rays through the lattice along z, as seen by an orthographic camera
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> coordinate(0.0f, size);
+  std::vector<Vector3f> origins;
+  for (Index i = 0; i < picks; ++i)
+    origins.emplace_back(coordinate(generator), coordinate(generator), -10.0f);
+  const Vector3f direction(0.0f, 0.0f, 1.0f);
+  const Vector3f length(0.0f, 0.0f, size + 20.0f);
+
+  size_t hits = 0;
+  seconds = bestTime(
+    repeats, [&]() { hits = 0; },
+    [&]() {
+      for (const auto& origin : origins) {
+        hits += spheres.hits(origin, origin + length, direction).size();
+        hits += cylinders.hits(origin, origin + length, direction).size();
+      }
+    });
+  report("Point picks", seconds, static_cast<double>(picks), "picks");
+
+  // a rubber band around a tenth of the lattice in x and y
+  Frustrum frustrum;
+  const float low = 0.3f * size;
+  const float high = 0.6f * size;
+  const Vector3f normals[4] = { Vector3f(1, 0, 0), Vector3f(-1, 0, 0),
+                                Vector3f(0, 1, 0), Vector3f(0, -1, 0) };
+  const Vector3f points[4] = { Vector3f(high, 0, 0), Vector3f(low, 0, 0),
+                               Vector3f(0, high, 0), Vector3f(0, low, 0) };
+  for (int i = 0; i < 4; ++i) {
+    frustrum.planes[i] = normals[i];
+    frustrum.points[2 * i] = points[i];
+    frustrum.points[2 * i + 1] = points[i] + direction;
+  }
+  size_t selected = 0;
+  seconds = bestTime(
+    repeats, [&]() {},
+    [&]() { selected = spheres.areaHits(frustrum).size(); });
+  report("Area selection", seconds, static_cast<double>(atoms), "atoms");
+
+  // the nearest hit must match a full scan, which is also timed
+  const Index scans = std::min<Index>(picks, 100);
+  std::vector<Index> expected(scans);
+  seconds = bestTime(
+    repeats, [&]() {},
+    [&]() {
+      for (Index i = 0; i < scans; ++i) {
+        expected[i] = nearestByScan(spheres, origins[i], origins[i] + length,
+                                    direction);
+      }
+    });
+  report("Full scan (reference)", seconds, static_cast<double>(scans),
+         "picks");
+
+  bool valid = hits > 0 && selected > 0;
+  for (Index i = 0; i < scans; ++i) {
+    const auto result =
+      spheres.hits(origins[i], origins[i] + length, direction);
+    valid = valid && (result.empty() ? expected[i] == Avogadro::MaxIndex
+                                     : result.begin()->second.index ==
+                                         expected[i]);
+  }
+
+  if (!valid)
+    std::cerr << "Picking did not match a full scan." << std::endl;
+  return valid ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "benchmark.h"
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/ringperceiver.h>
+
+#include <iostream>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::RingPerceiver;
+using namespace Avogadro::Benchmarks;
+
+namespace {
+
+// Add a ring of carbon atoms through the given atoms, adding atoms as needed.
+void addRing(Molecule& mol, std::vector<Index> atoms, Index size)
+{
+  while (atoms.size() < size)
+    atoms.push_back(mol.addAtom(6).index());
+  for (Index i = 0; i < size; ++i)
+    mol.addBond(atoms[i], atoms[(i + 1) % size], 1);
+}
+
+// A protein-like chain: a backbone with short side chains, a phenyl ring on
+// every fifth residue and a fused indole-like pair on every twentieth.
+Molecule protein(Index atoms, Index& expectedRings)
+{
+  Molecule mol;
+  expectedRings = 0;
+  Index previous = mol.addAtom(7).index();
+  for (Index residue = 0; mol.atomCount() < atoms; ++residue) {
+    const Index alpha = mol.addAtom(6).index();
+    const Index carbonyl = mol.addAtom(6).index();
+    const Index next = mol.addAtom(7).index();
+    mol.addBond(previous, alpha, 1);
+    mol.addBond(alpha, carbonyl, 1);
+    mol.addBond(carbonyl, mol.addAtom(8).index(), 2);
+    mol.addBond(carbonyl, next, 1);
+    previous = next;
+
+    const Index beta = mol.addAtom(6).index();
+    mol.addBond(alpha, beta, 1);
+    if (residue % 20 == 0) {
+      addRing(mol, { beta }, 5);
+      addRing(mol, { beta + 1, beta + 2 }, 6);
+      expectedRings += 2;
+    } else if (residue % 5 == 0) {
+      const Index ring = mol.addAtom(6).index();
+      mol.addBond(beta, ring, 1);
+      addRing(mol, { ring }, 6);
+      ++expectedRings;
+    } else {
+      mol.addBond(beta, mol.addAtom(6).index(), 1);
+    }
+  }
+  return mol;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const Index atoms = argument(argc, argv, 1, 20000);
+  const int repeats = static_cast<int>(argument(argc, argv, 2, 3));
+
+  Index expectedRings = 0;
+  const Molecule mol = protein(atoms, expectedRings);
+  std::cout << "Ring perception, " << mol.atomCount() << " atoms" << std::endl;
+
+  size_t rings = 0;
+  double seconds = bestTime(
+    repeats, []() {},
+    [&]() { rings = RingPerceiver(&mol).rings().size(); });
+  report("RingPerceiver", seconds, static_cast<double>(mol.atomCount()),
+         "atoms");
+
+  // the rings are kept on the molecule until the bonds change
+  mol.rings();
+  seconds = bestTime(
+    repeats, []() {}, [&]() { rings = mol.rings().size(); });
+  report("Molecule::rings (cached)", seconds,
+         static_cast<double>(mol.atomCount()), "atoms");
+
+  if (rings != expectedRings) {
+    std::cerr << "Found " << rings << " rings, expected " << expectedRings
+              << "." << std::endl;
+    return 1;
+  }
+  return 0;
+}
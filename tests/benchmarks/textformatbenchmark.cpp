@@ -0,0 +1,135 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "benchmark.h"
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/io/lammpsformat.h>
+#include <avogadro/io/pdbformat.h>
+#include <avogadro/io/xyzformat.h>
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Molecule;
+using Avogadro::Io::FileFormat;
+using Avogadro::Io::LammpsTrajectoryFormat;
+using Avogadro::Io::PdbFormat;
+using Avogadro::Io::XyzFormat;
+using namespace Avogadro::Benchmarks;
+
+namespace {
+
+const char* const symbols[3] = { "O", "C", "N" };
+
+// Atoms on a simple cubic lattice 3 A apart, so that no bonds are perceived
+// and the time is dominated by parsing.
+Vector3 position(Index atom, Index side)
+{
+  return Vector3(3.0 * (atom % side), 3.0 * (atom / side % side),
+                 3.0 * (atom / (side * side)) + 0.001 * (atom % 7));
+}
+
+std::string pdbText(Index atoms, Index side)
+{
+  std::string text;
+  text.reserve(atoms * 81);
+  char line[96];
+  for (Index i = 0; i < atoms; ++i) {
+    const Vector3 pos = position(i, side);
+    const int residue = static_cast<int>(i / 3 % 9999 + 1);
+    // unknown ligands have no residue templates or secondary structure
+    std::snprintf(line, sizeof(line),
+                  "HETATM%5d %-4s UNL A%4d    %8.3f%8.3f%8.3f  1.00  0.00"
+                  "          %2s\n",
+                  static_cast<int>(i % 99999 + 1), symbols[i % 3], residue,
+                  pos.x(), pos.y(), pos.z(), symbols[i % 3]);
+    text += line;
+  }
+  text += "END\n";
+  return text;
+}
+
+std::string xyzText(Index atoms, Index side)
+{
+  std::string text = std::to_string(atoms) + "\nbenchmark\n";
+  text.reserve(atoms * 48);
+  char line[96];
+  for (Index i = 0; i < atoms; ++i) {
+    const Vector3 pos = position(i, side);
+    std::snprintf(line, sizeof(line), "%-2s %12.6f %12.6f %12.6f\n",
+                  symbols[i % 3], pos.x(), pos.y(), pos.z());
+    text += line;
+  }
+  return text;
+}
+
+std::string lammpsText(Index atoms, Index side)
+{
+  const double length = 3.0 * side;
+  std::string text = "ITEM: TIMESTEP\n0\nITEM: NUMBER OF ATOMS\n" +
+                     std::to_string(atoms) + "\nITEM: BOX BOUNDS pp pp pp\n";
+  for (int axis = 0; axis < 3; ++axis)
+    text += "0 " + std::to_string(length) + "\n";
+  text += "ITEM: ATOMS id type x y z\n";
+  text.reserve(text.size() + atoms * 48);
+  char line[96];
+  for (Index i = 0; i < atoms; ++i) {
+    const Vector3 pos = position(i, side);
+    std::snprintf(line, sizeof(line), "%d %d %.6f %.6f %.6f\n",
+                  static_cast<int>(i + 1), static_cast<int>(i % 3 + 1),
+                  pos.x(), pos.y(), pos.z());
+    text += line;
+  }
+  return text;
+}
+
+// Read the text, returning false if the last atom was not read correctly.
+bool measure(FileFormat& format, const std::string& text, Index atoms,
+             Index side, int repeats, const std::string& name)
+{
+  bool valid = true;
+  Molecule molecule;
+  double seconds = bestTime(
+    repeats, [&]() { molecule = Molecule(); },
+    [&]() { valid = format.readString(text, molecule) && valid; });
+  valid = valid && molecule.atomCount() == atoms &&
+          (molecule.atomPosition3d(atoms - 1) - position(atoms - 1, side))
+              .norm() < 1e-3;
+  report(name, seconds, static_cast<double>(atoms), "atoms");
+  return valid;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const Index atoms = argument(argc, argv, 1, 1000000);
+  const int repeats = static_cast<int>(argument(argc, argv, 2, 3));
+  const auto side =
+    static_cast<Index>(std::ceil(std::cbrt(static_cast<double>(atoms))));
+
+  std::cout << "Text format reading, " << atoms << " atoms" << std::endl;
+
+  PdbFormat pdb;
+  XyzFormat xyz;
+  xyz.setOptions("{\"perceiveBonds\": false}");
+  LammpsTrajectoryFormat lammps;
+  bool valid =
+    measure(pdb, pdbText(atoms, side), atoms, side, repeats, "PDB");
+  valid =
+    measure(xyz, xyzText(atoms, side), atoms, side, repeats, "XYZ") && valid;
+  valid = measure(lammps, lammpsText(atoms, side), atoms, side, repeats,
+                  "LAMMPS") &&
+          valid;
+
+  if (!valid)
+    std::cerr << "Atoms were not read correctly." << std::endl;
+  return valid ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "benchmark.h"
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/vector.h>
+#include <avogadro/io/dcdformat.h>
+#include <avogadro/io/trrformat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Io::DcdFormat;
+using Avogadro::Io::FileFormat;
+using Avogadro::Io::TrrFormat;
+using namespace Avogadro::Benchmarks;
+
+namespace {
+
+float coordinate(Index frame, Index atom, int axis)
+{
+  return static_cast<float>(std::sin(0.001 * atom + 0.1 * frame + axis));
+}
+
+template <typename T>
+void put(std::ostream& out, T value, bool bigEndian)
+{
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  const int one = 1;
+  if (bigEndian == (*reinterpret_cast<const char*>(&one) == 1))
+    std::reverse(bytes, bytes + sizeof(T));
+  out.write(bytes, sizeof(T));
+}
+
+// Fortran record in native byte order, as written by CHARMM and NAMD.
+void record(std::ostream& out, const std::string& data)
+{
+  put<int>(out, static_cast<int>(data.size()), false);
+  out << data;
+  put<int>(out, static_cast<int>(data.size()), false);
+}
+
+template <typename T>
+std::string bytes(const T& value)
+{
+  return std::string(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeDcd(const std::string& fileName, Index atoms, Index frames)
+{
+  std::ofstream out(fileName, std::ios::binary);
+  std::string header(84, '\0');
+  header.replace(0, 4, "CORD");
+  header.replace(4, 4, bytes(static_cast<int>(frames)));
+  header.replace(40, 4, bytes(0.002f));
+  header.replace(80, 4, bytes(24)); // CHARMM version
+  record(out, header);
+  record(out, bytes(1) + std::string(80, ' '));
+  record(out, bytes(static_cast<int>(atoms)));
+
+  std::vector<float> block(atoms);
+  for (Index frame = 0; frame < frames; ++frame) {
+    for (int axis = 0; axis < 3; ++axis) {
+      for (Index i = 0; i < atoms; ++i)
+        block[i] = coordinate(frame, i, axis);
+      record(out, std::string(reinterpret_cast<const char*>(block.data()),
+                              block.size() * sizeof(float)));
+    }
+  }
+}
+
+// GROMACS writes big endian (XDR) single precision by default.
+void writeTrr(const std::string& fileName, Index atoms, Index frames)
+{
+  std::ofstream out(fileName, std::ios::binary);
+  const int real = sizeof(float);
+  for (Index frame = 0; frame < frames; ++frame) {
+    put<int>(out, 1993, true);
+    put<int>(out, 13, true);
+    put<int>(out, 12, true);
+    out << "GMX_trn_file";
+    const int sizes[13] = { 0, 0, 9 * real, 0, 0, 0, 0,
+                            static_cast<int>(3 * atoms * real), 0, 0,
+                            static_cast<int>(atoms), static_cast<int>(frame),
+                            0 };
+    for (int size : sizes)
+      put<int>(out, size, true);
+    put<float>(out, 0.002f * frame, true);
+    put<float>(out, 0.0f, true);
+    for (int i = 0; i < 9; ++i)
+      put<float>(out, i % 4 == 0 ? 10.0f : 0.0f, true);
+    for (Index i = 0; i < atoms; ++i)
+      for (int axis = 0; axis < 3; ++axis)
+        put<float>(out, coordinate(frame, i, axis), true);
+  }
+}
+
+// Read every frame, returning false if any of them is wrong.
+bool readAll(FileFormat& format, Index frames, double scale)
+{
+  Array<Vector3> positions;
+  bool valid = format.frameCount() == frames;
+  for (Index frame = 0; frame < format.frameCount(); ++frame) {
+    valid = format.readFrame(frame, positions) && valid;
+    const Index last = positions.size() - 1;
+    valid = valid && std::abs(positions[last].y() -
+                              scale * coordinate(frame, last, 1)) < 1e-4;
+  }
+  return valid;
+}
+
+bool compare(FileFormat& format, const std::string& fileName, Index frames,
+             double scale, int repeats, const std::string& name)
+{
+  bool valid = true;
+  for (bool mapFile : { false, true }) {
+    double seconds = bestTime(
+      repeats, [&]() { format.openTrajectory(fileName, mapFile); },
+      [&]() { valid = readAll(format, frames, scale) && valid; });
+    format.close();
+    report(name + (mapFile ? " mapped" : " stream"), seconds,
+           static_cast<double>(frames), "frames");
+  }
+  return valid;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const Index atoms = argument(argc, argv, 1, 100000);
+  const Index frames = argument(argc, argv, 2, 100);
+  const int repeats = static_cast<int>(argument(argc, argv, 3, 3));
+
+  std::cout << "Trajectory frame reading, " << atoms << " atoms, " << frames
+            << " frames" << std::endl;
+
+  const std::string dcdFile = "trajectorybenchmark.dcd";
+  const std::string trrFile = "trajectorybenchmark.trr";
+  writeDcd(dcdFile, atoms, frames);
+  writeTrr(trrFile, atoms, frames);
+
+  DcdFormat dcd;
+  TrrFormat trr;
+  bool valid = compare(dcd, dcdFile, frames, 1.0, repeats, "DCD");
+  // TRR coordinates are in nm
+  valid = compare(trr, trrFile, frames, 10.0, repeats, "TRR") && valid;
+
+  std::remove(dcdFile.c_str());
+  std::remove(trrFile.c_str());
+  if (!valid)
+    std::cerr << "Frames were not read correctly." << std::endl;
+  return valid ? 0 : 1;
+}
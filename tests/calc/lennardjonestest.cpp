@@ -0,0 +1,259 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/calc/energyproblem.h>
+#include <avogadro/calc/lennardjones.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/unitcell.h>
+
+#include <cppoptlib/solver/lbfgssolver.h>
+
+using Avogadro::Index;
+using Avogadro::Matrix3;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Calc::EnergyProblem;
+using Avogadro::Calc::LennardJones;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::UnitCell;
+
+namespace {
+
+// A small cluster of carbon and oxygen atoms, none of them too close.
+void addCluster(Molecule& molecule)
+{
+  molecule.addAtom(6, Vector3(0.0, 0.0, 0.0));
+  molecule.addAtom(6, Vector3(3.6, 0.2, 0.1));
+  molecule.addAtom(8, Vector3(1.5, 3.3, -0.4));
+  molecule.addAtom(8, Vector3(-0.8, 1.9, 3.0));
+  molecule.addAtom(6, Vector3(2.9, 2.4, 3.5));
+}
+
+Eigen::VectorXd coordinates(const Molecule& molecule)
+{
+  Eigen::VectorXd x(3 * molecule.atomCount());
+  for (Index i = 0; i < molecule.atomCount(); ++i)
+    x.segment<3>(3 * i) = molecule.atomPosition3d(i);
+  return x;
+}
+
+Eigen::VectorXd centralDifference(LennardJones& lj, const Eigen::VectorXd& x)
+{
+  const Real step = 1e-5;
+  Eigen::VectorXd grad(x.rows());
+  Eigen::VectorXd displaced = x;
+  for (Eigen::Index i = 0; i < x.rows(); ++i) {
+    displaced[i] = x[i] + step;
+    const Real forward = lj.value(displaced);
+    displaced[i] = x[i] - step;
+    const Real backward = lj.value(displaced);
+    displaced[i] = x[i];
+    grad[i] = (forward - backward) / (2.0 * step);
+  }
+  return grad;
+}
+
+// Counts the calls an optimizer makes into the calculator.
+class CountingLennardJones : public LennardJones
+{
+public:
+  Real value(const Eigen::VectorXd& x) override
+  {
+    ++values;
+    return LennardJones::value(x);
+  }
+  void gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad) override
+  {
+    ++gradients;
+    LennardJones::gradient(x, grad);
+  }
+  Real valueAndGradient(const Eigen::VectorXd& x,
+                        Eigen::VectorXd& grad) override
+  {
+    ++fused;
+    return LennardJones::valueAndGradient(x, grad);
+  }
+
+  int values = 0;
+  int gradients = 0;
+  int fused = 0;
+};
+
+} // namespace
+
+TEST(LennardJonesTest, gradient)
+{
+  Molecule molecule;
+  addCluster(molecule);
+  const Eigen::VectorXd x = coordinates(molecule);
+
+  for (Real cutoff : { 0.0, 4.0 }) {
+    LennardJones lj;
+    lj.setCutoff(cutoff);
+    lj.setMolecule(&molecule);
+
+    Eigen::VectorXd grad;
+    lj.gradient(x, grad);
+    const Eigen::VectorXd numerical = centralDifference(lj, x);
+    EXPECT_LT((grad - numerical).norm(), 1e-4 * (1.0 + numerical.norm()))
+      << "cutoff " << cutoff;
+  }
+}
+
+TEST(LennardJonesTest, valueAndGradient)
+{
+  Molecule molecule;
+  addCluster(molecule);
+  const Eigen::VectorXd x = coordinates(molecule);
+
+  for (Real cutoff : { 0.0, 4.0 }) {
+    LennardJones lj;
+    lj.setCutoff(cutoff);
+    lj.setMolecule(&molecule);
+
+    Eigen::VectorXd grad;
+    lj.gradient(x, grad);
+    Eigen::VectorXd fused;
+    EXPECT_EQ(lj.valueAndGradient(x, fused), lj.value(x));
+    EXPECT_EQ(fused, grad);
+  }
+}
+
+TEST(LennardJonesTest, numericalGradient)
+{
+  Molecule molecule;
+  addCluster(molecule);
+  const Eigen::VectorXd x = coordinates(molecule);
+
+  // the displaced geometries are evaluated in parallel without a cutoff
+  LennardJones lj;
+  lj.setMolecule(&molecule);
+  EXPECT_TRUE(lj.isThreadSafe());
+  Eigen::VectorXd grad;
+  lj.gradient(x, grad);
+  Eigen::VectorXd numerical;
+  lj.numericalGradient(x, numerical);
+  EXPECT_LT((numerical - grad).norm(), 1e-4 * (1.0 + grad.norm()));
+
+  // while the neighbor list is updated from a single thread
+  lj.setCutoff(4.0);
+  EXPECT_FALSE(lj.isThreadSafe());
+  lj.gradient(x, grad);
+  lj.numericalGradient(x, numerical);
+  EXPECT_LT((numerical - grad).norm(), 1e-4 * (1.0 + grad.norm()));
+}
+
+TEST(LennardJonesTest, cutoff)
+{
+  Molecule molecule;
+  addCluster(molecule);
+  const Eigen::VectorXd x = coordinates(molecule);
+
+  // no cutoff by default, whatever the size of the molecule
+  LennardJones full;
+  full.setMolecule(&molecule);
+  EXPECT_EQ(full.cutoff(), 0.0);
+
+  // beyond every distance, the cutoff only shifts the energy slightly
+  LennardJones far;
+  far.setCutoff(40.0);
+  far.setMolecule(&molecule);
+  EXPECT_NEAR(far.value(x), full.value(x), 1e-2);
+
+  // the shifted pair energy and force vanish at the cutoff
+  Molecule pair;
+  pair.addAtom(6, Vector3::Zero());
+  pair.addAtom(6, Vector3(5.0, 0.0, 0.0));
+  LennardJones lj;
+  lj.setCutoff(5.0);
+  lj.setMolecule(&pair);
+  Eigen::VectorXd inside = coordinates(pair);
+  inside[3] = 5.0 - 1e-6;
+  Eigen::VectorXd outside = coordinates(pair);
+  outside[3] = 5.0 + 1e-6;
+  EXPECT_NEAR(lj.value(inside), 0.0, 1e-6);
+  EXPECT_EQ(lj.value(outside), 0.0);
+  Eigen::VectorXd grad;
+  lj.gradient(inside, grad);
+  EXPECT_NEAR(grad.norm(), 0.0, 1e-3);
+}
+
+TEST(LennardJonesTest, periodic)
+{
+  // two carbons, 2.0 apart through the boundary of a 9 Angstrom cell
+  Molecule crystal;
+  crystal.setUnitCell(new UnitCell(Matrix3(Matrix3::Identity() * 9.0)));
+  crystal.addAtom(6, Vector3(0.5, 1.0, 1.0));
+  crystal.addAtom(6, Vector3(7.5, 1.0, 1.0));
+  const Eigen::VectorXd x = coordinates(crystal);
+
+  // the same pair without a cell, at the minimum image distance
+  Molecule molecule;
+  molecule.addAtom(6, Vector3(0.5, 1.0, 1.0));
+  molecule.addAtom(6, Vector3(-1.5, 1.0, 1.0));
+  const Eigen::VectorXd y = coordinates(molecule);
+
+  for (Real cutoff : { 0.0, 4.0, 12.0 }) {
+    LennardJones periodic;
+    periodic.setCutoff(cutoff);
+    periodic.setMolecule(&crystal);
+    LennardJones isolated;
+    isolated.setCutoff(cutoff);
+    isolated.setMolecule(&molecule);
+    // only the minimum image counts, and never the atoms' own images
+    EXPECT_NEAR(periodic.value(x), isolated.value(y), 1e-9)
+      << "cutoff " << cutoff;
+
+    Eigen::VectorXd grad;
+    periodic.gradient(x, grad);
+    EXPECT_LT((grad - centralDifference(periodic, x)).norm(), 1e-3)
+      << "cutoff " << cutoff;
+  }
+
+  // a lone atom does not interact with itself
+  Molecule single;
+  single.setUnitCell(new UnitCell(Matrix3(Matrix3::Identity() * 3.0)));
+  single.addAtom(6, Vector3(1.0, 1.0, 1.0));
+  for (Real cutoff : { 0.0, 8.0 }) {
+    LennardJones lj;
+    lj.setCutoff(cutoff);
+    lj.setMolecule(&single);
+    EXPECT_EQ(lj.value(coordinates(single)), 0.0);
+  }
+}
+
+TEST(LennardJonesTest, energyProblem)
+{
+  Molecule molecule;
+  addCluster(molecule);
+  const Eigen::VectorXd start = coordinates(molecule);
+  auto criteria = cppoptlib::Criteria<Real>::defaults();
+  criteria.iterations = 20;
+
+  LennardJones lj;
+  lj.setMolecule(&molecule);
+  Eigen::VectorXd direct = start;
+  cppoptlib::LbfgsSolver<LennardJones> directSolver;
+  directSolver.setStopCriteria(criteria);
+  directSolver.minimize(lj, direct);
+
+  // the line search gets each energy and gradient from one fused call, and
+  // the solver reuses the gradient at the accepted step
+  CountingLennardJones counting;
+  counting.setMolecule(&molecule);
+  EnergyProblem problem(counting);
+  Eigen::VectorXd x = start;
+  cppoptlib::LbfgsSolver<EnergyProblem> solver;
+  solver.setStopCriteria(criteria);
+  solver.minimize(problem, x);
+  EXPECT_EQ(counting.values, 0);
+  EXPECT_EQ(counting.gradients, 1); // at the starting geometry
+  EXPECT_GT(counting.fused, 0);
+
+  EXPECT_LT((x - direct).norm(), 1e-9);
+  EXPECT_LT(lj.value(x), lj.value(start));
+}
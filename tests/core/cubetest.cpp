@@ -17,6 +17,11 @@
 #include <gtest/gtest.h>
 
 #include <avogadro/core/cube.h>
+#include <avogadro/core/parallel.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
 
 using Avogadro::Core::Cube;
 using Avogadro::Vector3;
@@ -103,3 +108,71 @@ TEST(CubeTest, position)
   for (int i = 0; i < 3; ++i)
     EXPECT_DOUBLE_EQ(cube.position(999)[i], 1.0);
 }
+
+TEST(CubeTest, fillParallel)
+{
+  Avogadro::Core::setMaxThreadCount(4);
+
+  // large enough to be split into several slabs
+  Cube cube;
+  cube.setLimits(Vector3(0.0, 0.0, 0.0), Vector3i(40, 30, 20), 0.1);
+  cube.fillParallel([&cube](Avogadro::Index first, Avogadro::Index count,
+                            float* values) {
+    for (Avogadro::Index i = 0; i < count; ++i) {
+      Vector3 pos = cube.position(static_cast<unsigned int>(first + i));
+      values[i] = static_cast<float>(pos.x() - 2.0 * pos.y() + pos.z());
+    }
+  });
+
+  for (unsigned int i = 0; i < cube.data()->size(); ++i) {
+    Vector3 pos = cube.position(i);
+    EXPECT_FLOAT_EQ((*cube.data())[i],
+                    static_cast<float>(pos.x() - 2.0 * pos.y() + pos.z()));
+  }
+  EXPECT_FLOAT_EQ(cube.minValue(), -5.8f);
+  EXPECT_FLOAT_EQ(cube.maxValue(), 5.8f);
+
+  // several cubes on the same grid
+  Cube other;
+  other.setLimits(cube);
+  std::vector<Cube*> cubes = { &cube, &other };
+  EXPECT_TRUE(Cube::fillParallel(
+    cubes, [](Avogadro::Index first, Avogadro::Index count,
+              float* const* values) {
+      for (Avogadro::Index i = 0; i < count; ++i) {
+        values[0][i] = 1.0f;
+        values[1][i] = static_cast<float>(first + i);
+      }
+    }));
+  EXPECT_FLOAT_EQ(cube.minValue(), 1.0f);
+  EXPECT_FLOAT_EQ(cube.maxValue(), 1.0f);
+  EXPECT_FLOAT_EQ(other.minValue(), 0.0f);
+  EXPECT_FLOAT_EQ(other.maxValue(), 40 * 30 * 20 - 1.0f);
+  EXPECT_FLOAT_EQ((*other.data())[1234], 1234.0f);
+
+  // progress is reported once per slab, up to the total
+  std::mutex mutex;
+  std::vector<Avogadro::Index> reported;
+  Avogadro::Index total = 0;
+  cube.fillParallel(
+    [](Avogadro::Index, Avogadro::Index count, float* values) {
+      std::fill_n(values, count, 0.0f);
+    },
+    [&](Avogadro::Index done, Avogadro::Index slabs) {
+      std::lock_guard<std::mutex> guard(mutex);
+      reported.push_back(done);
+      total = slabs;
+    });
+  ASSERT_GT(total, 1);
+  ASSERT_EQ(reported.size(), static_cast<size_t>(total));
+  std::sort(reported.begin(), reported.end());
+  for (size_t i = 0; i < reported.size(); ++i)
+    EXPECT_EQ(reported[i], static_cast<Avogadro::Index>(i + 1));
+
+  // different grids cannot be filled together
+  other.setLimits(Vector3(0.0, 0.0, 0.0), Vector3i(40, 30, 21), 0.1);
+  EXPECT_FALSE(Cube::fillParallel(
+    cubes, [](Avogadro::Index, Avogadro::Index, float* const*) {}));
+
+  Avogadro::Core::setMaxThreadCount(0);
+}
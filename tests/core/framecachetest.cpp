@@ -0,0 +1,114 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/framecache.h>
+#include <avogadro/core/molecule.h>
+
+#include <memory>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::FrameCache;
+using Avogadro::Core::FrameSource;
+using Avogadro::Core::Molecule;
+
+namespace {
+// Frame i has every atom at (i, atom, 0), and reads are counted.
+class CountingSource : public FrameSource
+{
+public:
+  CountingSource(Index frames, Index atoms) : m_frames(frames), m_atoms(atoms)
+  {
+  }
+
+  Index frameCount() const override { return m_frames; }
+
+  bool readFrame(Index index, Array<Vector3>& positions) override
+  {
+    ++reads;
+    positions.resize(m_atoms);
+    for (Index i = 0; i < m_atoms; ++i)
+      positions[i] = Vector3(index, i, 0.0);
+    return true;
+  }
+
+  int reads = 0;
+
+private:
+  Index m_frames;
+  Index m_atoms;
+};
+} // namespace
+
+TEST(FrameCacheTest, leastRecentlyUsed)
+{
+  auto source = std::make_shared<CountingSource>(10, 3);
+  FrameCache cache(source, 2);
+  EXPECT_EQ(cache.frameCount(), 10u);
+
+  EXPECT_EQ(cache.frame(1)[2], Vector3(1.0, 2.0, 0.0));
+  EXPECT_EQ(cache.frame(2)[0], Vector3(2.0, 0.0, 0.0));
+  EXPECT_EQ(source->reads, 2);
+  EXPECT_EQ(cache.size(), 2u);
+
+  // a cached frame is not read again, and becomes the most recent one
+  cache.frame(1);
+  EXPECT_EQ(source->reads, 2);
+
+  // so frame 2 is dropped to make room for frame 3
+  cache.frame(3);
+  EXPECT_EQ(cache.size(), 2u);
+  cache.frame(1);
+  EXPECT_EQ(source->reads, 3);
+  cache.frame(2);
+  EXPECT_EQ(source->reads, 4);
+
+  // frames past the end are empty
+  EXPECT_TRUE(cache.frame(10).empty());
+
+  cache.setCapacity(1);
+  EXPECT_EQ(cache.size(), 1u);
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(FrameCacheTest, molecule)
+{
+  Molecule molecule;
+  for (int i = 0; i < 3; ++i)
+    molecule.addAtom(6).setPosition3d(Vector3(-1.0, -1.0, -1.0));
+  molecule.setCoordinate3d(molecule.atomPositions3d(), 0);
+
+  auto source = std::make_shared<CountingSource>(1000, 3);
+  molecule.setFrameSource(source, 4);
+  EXPECT_EQ(molecule.coordinate3dCount(), 1000);
+
+  // stored sets take precedence over the source
+  EXPECT_EQ(molecule.coordinate3d(0)[0], Vector3(-1.0, -1.0, -1.0));
+  EXPECT_EQ(source->reads, 0);
+
+  // scrub through the whole trajectory with a bounded cache
+  for (int i = 1; i < molecule.coordinate3dCount(); ++i) {
+    ASSERT_TRUE(molecule.setCoordinate3d(i));
+    EXPECT_EQ(molecule.atomPosition3d(1), Vector3(i, 1.0, 0.0));
+  }
+  EXPECT_EQ(source->reads, 999);
+  EXPECT_LE(molecule.frameCache()->size(), 4u);
+
+  // copies share the frames
+  Molecule copy(molecule);
+  EXPECT_EQ(copy.coordinate3dCount(), 1000);
+  EXPECT_EQ(copy.coordinate3d(999)[0], Vector3(999.0, 0.0, 0.0));
+  EXPECT_EQ(source->reads, 999);
+
+  molecule.clearCoordinate3d();
+  EXPECT_EQ(molecule.coordinate3dCount(), 0);
+  EXPECT_FALSE(molecule.frameCache());
+  EXPECT_TRUE(molecule.coordinate3d(5).empty());
+}
@@ -0,0 +1,284 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/gaussianset.h>
+#include <avogadro/core/gaussiansettools.h>
+#include <avogadro/core/molecule.h>
+
+#include <cmath>
+
+using Avogadro::ANGSTROM_TO_BOHR;
+using Avogadro::MatrixX;
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
+using Avogadro::Core::Cube;
+using Avogadro::Core::GaussianSet;
+using Avogadro::Core::GaussianSetTools;
+using Avogadro::Core::Molecule;
+
+namespace {
+
+// Two atoms with a mix of shell types, and (arbitrary) MO coefficients.
+void makeMolecule(Molecule& mol)
+{
+  mol.addAtom(6).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  mol.addAtom(8).setPosition3d(Vector3(1.2, 0.3, -0.4));
+
+  auto* basis = new GaussianSet;
+  const GaussianSet::orbital types[] = { GaussianSet::S, GaussianSet::P,
+                                         GaussianSet::D5, GaussianSet::F7 };
+  const unsigned int components[] = { 1, 3, 5, 7 };
+  unsigned int count = 0;
+  for (unsigned int atom = 0; atom < 2; ++atom) {
+    for (unsigned int t = 0; t < 4; ++t) {
+      unsigned int shell = basis->addBasis(atom, types[t]);
+      basis->addGto(shell, 0.4, 3.0 + atom);
+      basis->addGto(shell, 0.7, 0.4 + t * 0.1);
+      count += components[t];
+    }
+  }
+
+  std::vector<double> coefficients(count * count);
+  for (size_t i = 0; i < coefficients.size(); ++i)
+    coefficients[i] = std::sin(0.37 * i);
+  basis->setMolecularOrbitals(coefficients);
+  basis->setElectronCount(4);
+
+  MatrixX density(count, count);
+  for (unsigned int i = 0; i < count; ++i)
+    for (unsigned int j = 0; j < count; ++j)
+      density(i, j) = 0.1 * std::cos(0.3 * (i + j)) + (i == j ? 0.5 : 0.0);
+  basis->setDensityMatrix(density);
+  basis->setSpinDensityMatrix(0.5 * density);
+
+  mol.setBasisSet(basis);
+}
+
+// One shell of a single primitive (exponent 0.8) on an atom away from the
+// origin, with each molecular orbital equal to one basis function.
+void makeShell(Molecule& mol, GaussianSet::orbital type, unsigned int count)
+{
+  mol.addAtom(6).setPosition3d(Vector3(0.1, -0.3, 0.2));
+  auto* basis = new GaussianSet;
+  unsigned int shell = basis->addBasis(0, type);
+  basis->addGto(shell, 1.0, 0.8);
+  std::vector<double> coefficients(count * count, 0.0);
+  for (unsigned int i = 0; i < count; ++i)
+    coefficients[i * count + i] = 1.0;
+  basis->setMolecularOrbitals(coefficients);
+  mol.setBasisSet(basis);
+}
+
+// Checks each basis function of a shell at two off-axis points against
+// values from the point-by-point formulas, e.g., for the P shell
+// (2a/pi)^3/4 sqrt(4a) x exp(-a r^2) with x and r in Bohr.
+void checkShell(GaussianSet::orbital type,
+                const std::vector<std::vector<double>>& expected)
+{
+  Molecule mol;
+  const unsigned int count = expected[0].size();
+  makeShell(mol, type, count);
+  GaussianSetTools tools(&mol);
+  ASSERT_TRUE(tools.isValid());
+
+  const Vector3 points[] = { Vector3(0.3, -0.4, 0.5),
+                             Vector3(-0.6, 0.2, 0.35) };
+  Cube cube;
+  for (size_t p = 0; p < 2; ++p) {
+    cube.setLimits(points[p], Vector3i(1, 1, 1), 0.1);
+    for (unsigned int i = 0; i < count; ++i) {
+      EXPECT_NEAR(tools.calculateMolecularOrbital(points[p], i),
+                  expected[p][i], 1e-9)
+        << "point " << p << " function " << i;
+      ASSERT_TRUE(tools.calculateMolecularOrbital(cube, i));
+      EXPECT_NEAR((*cube.data())[0], expected[p][i], 1e-6);
+    }
+  }
+}
+
+} // namespace
+
+TEST(GaussianSetToolsTest, sOrbital)
+{
+  Molecule mol;
+  mol.addAtom(1).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  auto* basis = new GaussianSet;
+  unsigned int shell = basis->addBasis(0, GaussianSet::S);
+  basis->addGto(shell, 1.0, 0.5);
+  basis->setMolecularOrbitals(std::vector<double>(1, 1.0));
+  mol.setBasisSet(basis);
+
+  GaussianSetTools tools(&mol);
+  ASSERT_TRUE(tools.isValid());
+
+  // normalized s function: (2 alpha / pi)^0.75 exp(-alpha r^2)
+  const Vector3 point(0.3, -0.2, 0.5);
+  const double r2 = point.squaredNorm() * ANGSTROM_TO_BOHR * ANGSTROM_TO_BOHR;
+  const double expected =
+    std::pow(0.5, 0.75) * 0.71270547 * std::exp(-0.5 * r2);
+  EXPECT_NEAR(tools.calculateMolecularOrbital(point, 0), expected, 1e-8);
+
+  // out of range orbitals
+  EXPECT_EQ(tools.calculateMolecularOrbital(point, 1), 0.0);
+  EXPECT_EQ(tools.calculateMolecularOrbital(point, -1), 0.0);
+}
+
+TEST(GaussianSetToolsTest, pShell)
+{
+  checkShell(GaussianSet::P,
+             { { 2.7323185751e-01, -1.3661592875e-01, 4.0984778626e-01 },
+               { -1.6153040882e-01, 1.1537886344e-01, 3.4613659033e-02 } });
+}
+
+TEST(GaussianSetToolsTest, dShell)
+{
+  checkShell(GaussianSet::D,
+             { { 1.0665336420e-01, 2.6663341050e-02, 2.3997006945e-01,
+                 -9.2364522762e-02, 2.7709356829e-01, -1.3854678414e-01 },
+               { 2.2068131394e-01, 1.1259250711e-01, 1.0133325640e-02,
+                 -2.7302231992e-01, -8.1906695975e-02, 5.8504782839e-02 } });
+}
+
+TEST(GaussianSetToolsTest, d5Shell)
+{
+  checkShell(GaussianSet::D5,
+             { { -1.3331670522e-01, 2.7709356833e-01, -1.3854678416e-01,
+                 6.9273392082e-02, -9.2364522776e-02 },
+               { -3.3327382098e-01, -8.1906695987e-02, 5.8504782848e-02,
+                 9.3607652557e-02, -2.7302231996e-01 } });
+}
+
+TEST(GaussianSetToolsTest, fShell)
+{
+  checkShell(GaussianSet::F,
+             { { 3.2247303769e-02, -9.0133954149e-03, 2.4336167620e-01,
+                 1.8026790830e-02, -6.2446635229e-02, 1.0816074498e-01,
+                 7.2556433481e-02, -8.1120558734e-02, 2.7040186245e-02,
+                 -2.4185477827e-02 },
+               { -2.3353525668e-01, 1.9030638086e-01, 5.1382722831e-03,
+                 -2.6642893320e-01, 6.4605582847e-01, 1.1190015194e-01,
+                 -1.0723557704e-02, 1.7127574277e-02, 5.7091914257e-02,
+                 -3.5745192348e-02 } });
+}
+
+TEST(GaussianSetToolsTest, f7Shell)
+{
+  checkShell(GaussianSet::F7,
+             { { 1.8139108370e-02, 1.5304203964e-01, -7.6521019821e-02,
+                 7.0252464633e-02, -9.3669952844e-02, 6.3734330194e-03,
+                 -3.5053881607e-02 },
+               { -1.1106541908e-01, 1.8970787769e-01, -1.3550562692e-01,
+                 4.7465326173e-02, -1.3844053467e-01, 9.7964726792e-02,
+                 3.2834331507e-01 } });
+}
+
+TEST(GaussianSetToolsTest, cubeMatchesPoints)
+{
+  Molecule mol;
+  makeMolecule(mol);
+  GaussianSetTools tools(&mol);
+
+  // not a multiple of the block size, to check the last partial block
+  Cube cube;
+  cube.setLimits(Vector3(-2.0, -2.0, -2.0), Vector3i(9, 7, 11), 0.45);
+
+  for (int mo = 0; mo < 3; ++mo) {
+    ASSERT_TRUE(tools.calculateMolecularOrbital(cube, mo));
+    for (unsigned int i = 0; i < cube.data()->size(); ++i) {
+      EXPECT_NEAR((*cube.data())[i],
+                  tools.calculateMolecularOrbital(cube.position(i), mo),
+                  1e-5);
+    }
+  }
+
+  ASSERT_TRUE(tools.calculateElectronDensity(cube));
+  for (unsigned int i = 0; i < cube.data()->size(); ++i) {
+    EXPECT_NEAR((*cube.data())[i],
+                tools.calculateElectronDensity(cube.position(i)), 1e-5);
+  }
+
+  ASSERT_TRUE(tools.calculateSpinDensity(cube));
+  for (unsigned int i = 0; i < cube.data()->size(); ++i) {
+    EXPECT_NEAR((*cube.data())[i],
+                tools.calculateSpinDensity(cube.position(i)), 1e-5);
+  }
+}
+
+TEST(GaussianSetToolsTest, lowerTriangleDensity)
+{
+  Molecule mol;
+  makeMolecule(mol);
+  auto* basis = dynamic_cast<GaussianSet*>(mol.basisSet());
+  ASSERT_TRUE(basis != nullptr);
+
+  // each orbital is one basis function, so the orbitals give their values
+  const unsigned int count = basis->moMatrix().rows();
+  std::vector<double> identity(count * count, 0.0);
+  for (unsigned int i = 0; i < count; ++i)
+    identity[i * count + i] = 1.0;
+  basis->setMolecularOrbitals(identity);
+
+  // only the lower triangle is set, as the fchk reader does
+  MatrixX density(count, count);
+  density.setConstant(std::nan(""));
+  for (unsigned int i = 0; i < count; ++i)
+    for (unsigned int j = 0; j <= i; ++j)
+      density(i, j) = 0.1 * std::cos(0.3 * (i + 2 * j)) + (i == j ? 0.5 : 0.0);
+  basis->setDensityMatrix(density);
+
+  GaussianSetTools tools(&mol);
+  Cube cube;
+  cube.setLimits(Vector3(-1.0, -0.5, -1.5), Vector3i(4, 3, 5), 0.6);
+  ASSERT_TRUE(tools.calculateElectronDensity(cube));
+  for (unsigned int p = 0; p < cube.data()->size(); ++p) {
+    const Vector3 point = cube.position(p);
+    std::vector<double> phi(count);
+    for (unsigned int i = 0; i < count; ++i)
+      phi[i] = tools.calculateMolecularOrbital(point, i);
+    // rho = sum_i D_ii phi_i^2 + 2 sum_{j < i} D_ij phi_i phi_j
+    double expected = 0.0;
+    for (unsigned int i = 0; i < count; ++i) {
+      expected += density(i, i) * phi[i] * phi[i];
+      for (unsigned int j = 0; j < i; ++j)
+        expected += 2.0 * density(i, j) * phi[i] * phi[j];
+    }
+    EXPECT_NEAR(tools.calculateElectronDensity(point), expected, 1e-9);
+    EXPECT_NEAR((*cube.data())[p], expected, 1e-5);
+  }
+}
+
+TEST(GaussianSetToolsTest, multipleOrbitals)
+{
+  Molecule mol;
+  makeMolecule(mol);
+  GaussianSetTools tools(&mol);
+
+  std::vector<Cube> single(4);
+  std::vector<Cube> batch(4);
+  std::vector<Cube*> cubes;
+  const std::vector<int> orbitals = { 3, 0, 7, 3 };
+  for (size_t i = 0; i < orbitals.size(); ++i) {
+    single[i].setLimits(Vector3(-2.0, -1.5, -2.5), Vector3i(10, 6, 9), 0.5);
+    batch[i].setLimits(Vector3(-2.0, -1.5, -2.5), Vector3i(10, 6, 9), 0.5);
+    ASSERT_TRUE(tools.calculateMolecularOrbital(single[i], orbitals[i]));
+    cubes.push_back(&batch[i]);
+  }
+  ASSERT_TRUE(tools.calculateMolecularOrbitals(cubes, orbitals));
+
+  for (size_t i = 0; i < orbitals.size(); ++i) {
+    for (size_t j = 0; j < single[i].data()->size(); ++j)
+      EXPECT_NEAR((*batch[i].data())[j], (*single[i].data())[j], 1e-5);
+  }
+
+  // mismatched grids or orbital numbers are rejected
+  batch[1].setLimits(Vector3(-2.0, -1.5, -2.5), Vector3i(10, 6, 8), 0.5);
+  EXPECT_FALSE(tools.calculateMolecularOrbitals(cubes, orbitals));
+  batch[1].setLimits(Vector3(-2.0, -1.5, -2.5), Vector3i(10, 6, 9), 0.5);
+  EXPECT_FALSE(tools.calculateMolecularOrbitals(cubes, { 0, 1, 2, 1000 }));
+  EXPECT_FALSE(tools.calculateMolecularOrbitals(cubes, { 0, 1 }));
+}
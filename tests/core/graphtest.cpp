@@ -16,8 +16,10 @@
 
 #include <gtest/gtest.h>
 
+#include <avogadro/core/array.h>
 #include <avogadro/core/graph.h>
 
+using Avogadro::Core::Array;
 using Avogadro::Core::Graph;
 
 TEST(GraphTest, size)
@@ -115,6 +117,32 @@ TEST(GraphTest, addEdge)
   EXPECT_EQ(graph.containsEdge(1, 4), true);
 }
 
+TEST(GraphTest, addEdges)
+{
+  Graph graph(6);
+  graph.addEdge(0, 1);
+
+  Array<std::pair<size_t, size_t>> pairs;
+  pairs.push_back(std::make_pair(1, 0)); // existing
+  pairs.push_back(std::make_pair(2, 3));
+  pairs.push_back(std::make_pair(3, 2)); // repeated
+  pairs.push_back(std::make_pair(1, 2));
+  std::vector<size_t> edges = graph.addEdges(pairs);
+
+  ASSERT_EQ(edges.size(), static_cast<size_t>(4));
+  EXPECT_EQ(graph.edgeCount(), static_cast<size_t>(3));
+  EXPECT_EQ(edges[0], static_cast<size_t>(0));
+  EXPECT_EQ(edges[1], static_cast<size_t>(1));
+  EXPECT_EQ(edges[2], static_cast<size_t>(1));
+  EXPECT_EQ(edges[3], static_cast<size_t>(2));
+  EXPECT_TRUE(graph.containsEdge(2, 3));
+  EXPECT_TRUE(graph.containsEdge(2, 1));
+
+  // {0, 1, 2, 3}, {4}, {5}
+  EXPECT_EQ(graph.connectedComponents().size(), static_cast<size_t>(3));
+  EXPECT_EQ(graph.subgraphCount(3), static_cast<size_t>(4));
+}
+
 TEST(GraphTest, removeEdge)
 {
   Graph graph(5);
@@ -168,3 +196,33 @@ TEST(GraphTest, connectedComponents)
   graph.removeEdges(4);
   EXPECT_EQ(graph.connectedComponents().size(), static_cast<size_t>(4));
 }
+
+TEST(GraphTest, revision)
+{
+  Graph graph(3);
+  const size_t initial = graph.revision();
+
+  // queries leave the revision alone
+  graph.connectedComponents();
+  graph.neighbors(0);
+  EXPECT_EQ(graph.revision(), initial);
+
+  graph.addEdge(0, 1);
+  const size_t bonded = graph.revision();
+  EXPECT_NE(bonded, initial);
+
+  // copies share it until they change
+  Graph copy(graph);
+  EXPECT_EQ(copy.revision(), bonded);
+  copy.addEdge(1, 2);
+  EXPECT_NE(copy.revision(), bonded);
+  EXPECT_EQ(graph.revision(), bonded);
+
+  // the same number of changes to another graph gives another revision
+  Graph other(3);
+  other.addEdge(0, 1);
+  EXPECT_NE(other.revision(), bonded);
+
+  graph.removeEdge(0, 1);
+  EXPECT_NE(graph.revision(), bonded);
+}
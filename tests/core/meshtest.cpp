@@ -97,3 +97,63 @@ TEST_F(MeshTest, assigment)
   assertEquals(m_testMesh, assign);
   EXPECT_NE(m_testMesh.lock(), assign.lock());
 }
+
+TEST_F(MeshTest, triangles)
+{
+  Mesh mesh;
+  Array<Vector3f> vertices;
+  vertices.push_back(Vector3f(0.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(1.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(0.0f, 1.0f, 0.0f));
+  vertices.push_back(Vector3f(1.0f, 1.0f, 0.0f));
+  mesh.setVertices(vertices);
+  mesh.setNormals(Array<Vector3f>(4, Vector3f(0.0f, 0.0f, 1.0f)));
+  EXPECT_EQ(mesh.numTriangles(), 1u);
+
+  Array<unsigned int> triangles;
+  for (unsigned int index : { 0, 1, 2, 2, 1, 3 })
+    triangles.push_back(index);
+  EXPECT_FALSE(mesh.setTriangles(Array<unsigned int>(2, 0u)));
+  EXPECT_TRUE(mesh.setTriangles(triangles));
+  EXPECT_EQ(mesh.numTriangles(), 2u);
+
+  Mesh copy(mesh);
+  EXPECT_TRUE(copy.triangles() == triangles);
+  Mesh assign;
+  assign = mesh;
+  EXPECT_TRUE(assign.triangles() == triangles);
+  EXPECT_TRUE(assign.normals() == mesh.normals());
+
+  mesh.clear();
+  EXPECT_EQ(mesh.triangles().size(), 0u);
+}
+
+TEST_F(MeshTest, smoothIndexed)
+{
+  // an octahedron, stretched along z
+  const Vector3f corners[6] = { Vector3f(1.0f, 0.0f, 0.0f),
+                                Vector3f(0.0f, 1.0f, 0.0f),
+                                Vector3f(-1.0f, 0.0f, 0.0f),
+                                Vector3f(0.0f, -1.0f, 0.0f),
+                                Vector3f(0.0f, 0.0f, 2.0f),
+                                Vector3f(0.0f, 0.0f, -2.0f) };
+  const unsigned int faces[24] = { 0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4,
+                                   1, 0, 5, 2, 1, 5, 3, 2, 5, 0, 3, 5 };
+
+  Mesh mesh;
+  Array<Vector3f> vertices(corners, corners + 6);
+  mesh.setVertices(vertices);
+  mesh.setNormals(Array<Vector3f>(6, Vector3f(1.0f, 0.0f, 0.0f)));
+  mesh.setTriangles(Array<unsigned int>(faces, faces + 24));
+
+  // each vertex has four neighbors, each shared by two triangles, that sum
+  // to zero, so a pass shrinks the octahedron by a factor of 1 + 2 * 4
+  mesh.smooth(1);
+  ASSERT_EQ(mesh.numVertices(), 6u);
+  ASSERT_EQ(mesh.numNormals(), 6u);
+  for (size_t i = 0; i < 6; ++i) {
+    EXPECT_NEAR((mesh.vertices()[i] - corners[i] / 9.0f).norm(), 0.0f, 1e-6f);
+    // and the normals point outwards
+    EXPECT_NEAR(mesh.normals()[i].dot(corners[i].normalized()), 1.0f, 1e-5f);
+  }
+}
@@ -22,6 +22,8 @@
 #include <avogadro/core/color3f.h>
 #include <avogadro/core/mesh.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/parallel.h>
+#include <avogadro/core/unitcell.h>
 #include <avogadro/core/vector.h>
 
 using Avogadro::Index;
@@ -34,6 +36,7 @@ using Avogadro::Core::Bond;
 using Avogadro::Core::Color3f;
 using Avogadro::Core::Mesh;
 using Avogadro::Core::Molecule;
+using Avogadro::Core::UnitCell;
 using Avogadro::Core::Variant;
 using Avogadro::Core::VariantMap;
 
@@ -109,6 +112,29 @@ TEST_F(MoleculeTest, addAtom)
   EXPECT_EQ(atom2.atomicNumber(), static_cast<unsigned char>(1));
 }
 
+TEST_F(MoleculeTest, addAtoms)
+{
+  Molecule molecule;
+  molecule.addAtom(6, Vector3(0.0, 0.0, 0.0));
+
+  Array<unsigned char> numbers;
+  Array<Vector3> positions;
+  numbers.push_back(1);
+  positions.push_back(Vector3(1.0, 0.0, 0.0));
+  numbers.push_back(8);
+  positions.push_back(Vector3(0.0, 1.0, 0.0));
+  molecule.addAtoms(numbers, positions);
+
+  EXPECT_EQ(molecule.atomCount(), static_cast<Index>(3));
+  EXPECT_EQ(molecule.atomicNumber(2), static_cast<unsigned char>(8));
+  EXPECT_EQ(molecule.atomPosition3d(1), Vector3(1.0, 0.0, 0.0));
+  EXPECT_TRUE(molecule.elements().test(8));
+
+  // the new atoms can be bonded like any other
+  EXPECT_TRUE(molecule.addBond(0, 2).isValid());
+  EXPECT_EQ(molecule.graph().size(), static_cast<size_t>(3));
+}
+
 TEST_F(MoleculeTest, removeAtom)
 {
   Molecule molecule;
@@ -268,6 +294,72 @@ TEST_F(MoleculeTest, perceiveBondsSimple)
   EXPECT_FALSE(molecule.bond(h2, h3).isValid());
 }
 
+TEST_F(MoleculeTest, perceiveBondsSimplePeriodic)
+{
+  // a water molecule split by the cell boundary along x
+  Molecule molecule;
+  Atom o1 = molecule.addAtom(8);
+  Atom h2 = molecule.addAtom(1);
+  Atom h3 = molecule.addAtom(1);
+  o1.setPosition3d(Vector3(0.3, 2.0, 2.0));
+  h2.setPosition3d(Vector3(4.34, 2.0, 2.0));
+  h3.setPosition3d(Vector3(0.54, 2.93, 2.0));
+
+  molecule.perceiveBondsSimple();
+  EXPECT_EQ(molecule.bondCount(), 1);
+  EXPECT_FALSE(molecule.bond(o1, h2).isValid());
+
+  molecule.clearBonds();
+  molecule.setUnitCell(new UnitCell(5.0, 5.0, 5.0, 90.0, 90.0, 90.0));
+  molecule.perceiveBondsSimple();
+  EXPECT_EQ(molecule.bondCount(), 2);
+  EXPECT_TRUE(molecule.bond(o1, h2).isValid());
+  EXPECT_TRUE(molecule.bond(o1, h3).isValid());
+  EXPECT_FALSE(molecule.bond(h2, h3).isValid());
+
+  // in a narrow cell the same neighbor is in range on both sides, which is
+  // still one bond, and no atom bonds to its own image
+  Molecule chain;
+  Atom o4 = chain.addAtom(8);
+  Atom h5 = chain.addAtom(1);
+  o4.setPosition3d(Vector3(0.0, 0.0, 0.0));
+  h5.setPosition3d(Vector3(1.0, 0.0, 0.0));
+  chain.setUnitCell(new UnitCell(2.0, 10.0, 10.0, 90.0, 90.0, 90.0));
+  chain.perceiveBondsSimple();
+  EXPECT_EQ(chain.bondCount(), 1);
+  EXPECT_TRUE(chain.bond(o4, h5).isValid());
+}
+
+TEST_F(MoleculeTest, perceiveBondsSimpleThreaded)
+{
+  // large enough to be split between threads
+  Molecule reference;
+  for (int x = 0; x < 20; ++x) {
+    for (int y = 0; y < 20; ++y) {
+      for (int z = 0; z < 5; ++z) {
+        Vector3 pos(x * 3.0, y * 3.0 + 0.1 * x, z * 3.0);
+        reference.addAtom(8).setPosition3d(pos);
+        reference.addAtom(1).setPosition3d(pos + Vector3(0.96, 0.0, 0.0));
+        reference.addAtom(1).setPosition3d(pos + Vector3(-0.24, 0.93, 0.0));
+      }
+    }
+  }
+
+  Avogadro::Core::setMaxThreadCount(1);
+  Molecule serial = reference;
+  serial.perceiveBondsSimple();
+  Avogadro::Core::setMaxThreadCount(4);
+  Molecule threaded = reference;
+  threaded.perceiveBondsSimple();
+  Avogadro::Core::setMaxThreadCount(0);
+
+  EXPECT_EQ(serial.bondCount(), static_cast<Index>(2 * 2000));
+  EXPECT_TRUE(serial.bondPairs() == threaded.bondPairs());
+  EXPECT_TRUE(serial.bondOrders() == threaded.bondOrders());
+  EXPECT_EQ(threaded.graph().connectedComponents().size(),
+            static_cast<size_t>(2000));
+}
+
 TEST_F(MoleculeTest, copy)
 {
   Molecule copy(m_testMolecule);
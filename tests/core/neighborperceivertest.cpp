@@ -7,10 +7,18 @@
 
 #include <avogadro/core/array.h>
 #include <avogadro/core/neighborperceiver.h>
+#include <avogadro/core/unitcell.h>
 #include <avogadro/core/vector.h>
 
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+using Avogadro::Index;
 using Avogadro::Core::Array;
 using Avogadro::Core::NeighborPerceiver;
+using Avogadro::Core::UnitCell;
 using Avogadro::Vector3;
 
 TEST(NeighborPerceiverTest, positive)
@@ -59,3 +67,159 @@ TEST(NeighborPerceiverTest, bounds)
   perceiver.getNeighborsInclusiveInPlace(neighbors, Vector3(-1.5, 0.0, 0.0));
   EXPECT_EQ(neighbors.size(), static_cast<size_t>(0));
 }
+
+namespace {
+Array<Vector3> makeLattice(int n, double spacing)
+{
+  Array<Vector3> points;
+  for (int x = 0; x < n; ++x)
+    for (int y = 0; y < n; ++y)
+      for (int z = 0; z < n; ++z)
+        points.push_back(Vector3(x * spacing + 0.01 * y, y * spacing + 0.02 * z,
+                                 z * spacing + 0.03 * x));
+  return points;
+}
+} // namespace
+
+TEST(NeighborPerceiverTest, radius)
+{
+  Array<Vector3> points = makeLattice(6, 0.7);
+  NeighborPerceiver perceiver(points, 1.0f);
+
+  Array<Index> neighbors;
+  for (const double radius : { 0.5, 1.0, 2.5 }) {
+    for (Index i = 0; i < points.size(); i += 7) {
+      perceiver.getNeighborsInPlace(neighbors, points[i], radius);
+      std::sort(neighbors.begin(), neighbors.end());
+      Array<Index> expected;
+      for (Index j = 0; j < points.size(); ++j)
+        if ((points[j] - points[i]).squaredNorm() < radius * radius)
+          expected.push_back(j);
+      ASSERT_EQ(neighbors.size(), expected.size());
+      for (Index k = 0; k < expected.size(); ++k)
+        EXPECT_EQ(neighbors[k], expected[k]);
+    }
+  }
+
+  // a query far away from every point finds nothing
+  perceiver.getNeighborsInPlace(neighbors, Vector3(100.0, 0.0, 0.0));
+  EXPECT_EQ(neighbors.size(), static_cast<size_t>(0));
+}
+
+TEST(NeighborPerceiverTest, pairs)
+{
+  Array<Vector3> points = makeLattice(7, 0.6);
+  // a far outlier must not blow up the grid
+  points.push_back(Vector3(1.0e4, -1.0e4, 1.0e4));
+  const float cutoff = 1.1f;
+  NeighborPerceiver perceiver(points, cutoff);
+
+  std::vector<std::pair<Index, Index>> pairs;
+  perceiver.visitPairs([&](Index i, Index j, const Vector3& diff,
+                           double distSq) {
+    EXPECT_LT(i, j);
+    EXPECT_NEAR(distSq, (points[j] - points[i]).squaredNorm(), 1e-12);
+    EXPECT_NEAR((diff - (points[j] - points[i])).norm(), 0.0, 1e-12);
+    pairs.emplace_back(i, j);
+  });
+  std::sort(pairs.begin(), pairs.end());
+
+  std::vector<std::pair<Index, Index>> expected;
+  for (Index i = 0; i < points.size(); ++i)
+    for (Index j = i + 1; j < points.size(); ++j)
+      if ((points[j] - points[i]).squaredNorm() < cutoff * cutoff)
+        expected.emplace_back(i, j);
+  EXPECT_EQ(pairs, expected);
+  EXPECT_LE(perceiver.cellCount(), 8 * points.size() + 4096);
+}
+
+namespace {
+// All (i <= j, image) pairs closer than cutoff, by brute force over images.
+std::vector<std::pair<Index, Index>> periodicPairs(const Array<Vector3>& points,
+                                                   const UnitCell& cell,
+                                                   double cutoff,
+                                                   int images)
+{
+  std::vector<std::pair<Index, Index>> pairs;
+  for (Index i = 0; i < points.size(); ++i) {
+    for (Index j = i; j < points.size(); ++j) {
+      for (int a = -images; a <= images; ++a) {
+        for (int b = -images; b <= images; ++b) {
+          for (int c = -images; c <= images; ++c) {
+            if (i == j && (a < 0 || (a == 0 && (b < 0 || (b == 0 && c <= 0)))))
+              continue;
+            Vector3 diff = points[j] + cell.imageOffset(a, b, c) - points[i];
+            if (diff.squaredNorm() < cutoff * cutoff)
+              pairs.emplace_back(i, j);
+          }
+        }
+      }
+    }
+  }
+  std::sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+} // namespace
+
+TEST(NeighborPerceiverTest, periodic)
+{
+  // a skewed triclinic cell, with points outside of it
+  const double deg = M_PI / 180.0;
+  UnitCell cell(9.0, 10.0, 11.0, 70.0 * deg, 80.0 * deg, 105.0 * deg);
+  Array<Vector3> points;
+  for (int i = 0; i < 40; ++i) {
+    Vector3 frac(std::fmod(0.37 * i, 1.0), std::fmod(0.61 * i + 0.1, 1.0),
+                 std::fmod(0.83 * i + 0.2, 1.0));
+    points.push_back(cell.toCartesian(frac) + cell.imageOffset(i % 3 - 1, 0, 1));
+  }
+
+  const float cutoff = 3.0f;
+  NeighborPerceiver perceiver(points, cutoff, cell);
+  EXPECT_TRUE(perceiver.isPeriodic());
+
+  std::vector<std::pair<Index, Index>> pairs;
+  perceiver.visitPairs([&](Index i, Index j, const Vector3& diff,
+                           double distSq) {
+    EXPECT_LT(i, j);
+    EXPECT_NEAR(diff.squaredNorm(), distSq, 1e-9);
+    // the displacement is the minimum image for a short cutoff
+    EXPECT_NEAR(std::sqrt(distSq), cell.distance(points[i], points[j]), 1e-9);
+    pairs.emplace_back(i, j);
+  });
+  std::sort(pairs.begin(), pairs.end());
+  EXPECT_FALSE(pairs.empty());
+  EXPECT_EQ(pairs, periodicPairs(points, cell, cutoff, 3));
+
+  // neighbors across the boundary are found from any image of the point
+  Array<Index> neighbors;
+  perceiver.getNeighborsInPlace(neighbors, points[0] + cell.imageOffset(2, -1, 0));
+  for (Index j : neighbors)
+    EXPECT_LT(cell.distance(points[0], points[j]), cutoff);
+  Index expected = 0;
+  for (Index j = 0; j < points.size(); ++j)
+    if (cell.distance(points[0], points[j]) < cutoff)
+      ++expected;
+  EXPECT_EQ(neighbors.size(), expected);
+}
+
+TEST(NeighborPerceiverTest, periodicSmallCell)
+{
+  // the cutoff is larger than the cell, so several images are in range
+  UnitCell cell(Vector3(2.0, 0.0, 0.0), Vector3(0.5, 2.5, 0.0),
+                Vector3(0.0, 0.3, 3.0));
+  Array<Vector3> points;
+  points.push_back(Vector3(0.1, 0.2, 0.3));
+  points.push_back(Vector3(1.2, 1.4, 2.0));
+  points.push_back(Vector3(-0.7, 2.2, 0.9));
+
+  const float cutoff = 4.0f;
+  NeighborPerceiver perceiver(points, cutoff, cell);
+  std::vector<std::pair<Index, Index>> pairs;
+  perceiver.visitPairs([&](Index i, Index j, const Vector3& diff, double) {
+    EXPECT_LE(i, j);
+    EXPECT_LT(diff.norm(), cutoff);
+    pairs.emplace_back(i, j);
+  });
+  std::sort(pairs.begin(), pairs.end());
+  EXPECT_EQ(pairs, periodicPairs(points, cell, cutoff, 3));
+}
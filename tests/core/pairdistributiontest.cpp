@@ -0,0 +1,138 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/pairdistribution.h>
+#include <avogadro/core/unitcell.h>
+#include <avogadro/core/vector.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::PairDistribution;
+using Avogadro::Core::UnitCell;
+
+TEST(PairDistributionTest, simpleCubic)
+{
+  UnitCell cell(3.0, 3.0, 3.0, M_PI / 2, M_PI / 2, M_PI / 2);
+  Array<Vector3> positions;
+  positions.push_back(Vector3(0.5, 0.5, 0.5));
+
+  // the cutoff is more than twice the cell, so images of images count too
+  PairDistribution pdf(6.5, 0.25);
+  EXPECT_EQ(pdf.binCount(), static_cast<size_t>(26));
+  EXPECT_TRUE(pdf.addFrame(positions, Array<unsigned char>(), cell));
+
+  const std::vector<size_t>& counts = pdf.counts();
+  EXPECT_EQ(counts[12], static_cast<size_t>(6));  // 3
+  EXPECT_EQ(counts[16], static_cast<size_t>(12)); // 3 sqrt(2)
+  EXPECT_EQ(counts[20], static_cast<size_t>(8));  // 3 sqrt(3)
+  EXPECT_EQ(counts[24], static_cast<size_t>(6));  // 6
+  size_t total = 0;
+  for (size_t count : counts)
+    total += count;
+  EXPECT_EQ(total, static_cast<size_t>(32));
+
+  const auto g = pdf.distribution();
+  ASSERT_EQ(g.size(), counts.size());
+  EXPECT_DOUBLE_EQ(g[12].first, 3.125);
+  const double shell = 4.0 / 3.0 * M_PI * (std::pow(3.25, 3) - 27.0);
+  EXPECT_NEAR(g[12].second, 6.0 * 27.0 / shell, 1e-9);
+  EXPECT_EQ(g[0].second, 0.0);
+}
+
+TEST(PairDistributionTest, matchesSupercell)
+{
+  UnitCell cell(5.0, 6.0, 7.0, 1.4, 1.6, 1.7);
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<double> fraction(0.0, 1.0);
+  Array<Vector3> positions;
+  Array<unsigned char> numbers;
+  for (int i = 0; i < 40; ++i) {
+    positions.push_back(cell.toCartesian(
+      Vector3(fraction(generator), fraction(generator), fraction(generator))));
+    numbers.push_back(i % 3 == 0 ? 8 : 14);
+  }
+
+  const double maxRadius = 9.0;
+  // keeps the lattice vector lengths, where each atom meets its own images,
+  // away from the edges of the bins
+  const double binWidth = 0.45;
+  PairDistribution pdf(maxRadius, binWidth);
+  EXPECT_TRUE(pdf.addFrame(positions, numbers, cell));
+  PairDistribution partial(maxRadius, binWidth);
+  partial.setElements(14, 8);
+  EXPECT_TRUE(partial.addFrame(positions, numbers, cell));
+
+  // every atom against every image in a supercell large enough to hold the
+  // cutoff sphere
+  std::vector<size_t> expected(pdf.binCount(), 0);
+  std::vector<size_t> expectedPartial(pdf.binCount(), 0);
+  const int range = 6;
+  for (Index i = 0; i < positions.size(); ++i) {
+    for (Index j = 0; j < positions.size(); ++j) {
+      for (int a = -range; a <= range; ++a) {
+        for (int b = -range; b <= range; ++b) {
+          for (int c = -range; c <= range; ++c) {
+            if (i == j && a == 0 && b == 0 && c == 0)
+              continue;
+            const Vector3 image = positions[j] + a * cell.aVector() +
+                                  b * cell.bVector() + c * cell.cVector();
+            const double distance = (image - positions[i]).norm();
+            if (distance >= maxRadius)
+              continue;
+            const auto bin = static_cast<size_t>(distance / binWidth);
+            ++expected[bin];
+            if (numbers[i] == 14 && numbers[j] == 8)
+              ++expectedPartial[bin];
+          }
+        }
+      }
+    }
+  }
+  EXPECT_EQ(pdf.counts(), expected);
+  EXPECT_EQ(partial.counts(), expectedPartial);
+}
+
+TEST(PairDistributionTest, frames)
+{
+  UnitCell cell(4.0, 4.0, 4.0, M_PI / 2, M_PI / 2, M_PI / 2);
+  Array<Vector3> positions;
+  positions.push_back(Vector3(0.0, 0.0, 0.0));
+  positions.push_back(Vector3(2.0, 2.0, 2.0));
+  Array<unsigned char> numbers;
+  numbers.push_back(55);
+  numbers.push_back(17);
+
+  PairDistribution pdf(5.0, 0.25);
+  pdf.setElements(55, 17);
+  EXPECT_TRUE(pdf.addFrame(positions, numbers, cell));
+  const auto single = pdf.distribution();
+  // CsCl: eight chloride ions around each cesium at 2 sqrt(3)
+  EXPECT_EQ(pdf.counts()[13], static_cast<size_t>(8));
+
+  // the average of identical frames is the same distribution
+  EXPECT_TRUE(pdf.addFrame(positions, numbers, cell));
+  EXPECT_EQ(pdf.frameCount(), static_cast<size_t>(2));
+  EXPECT_EQ(pdf.counts()[13], static_cast<size_t>(16));
+  const auto averaged = pdf.distribution();
+  for (size_t k = 0; k < single.size(); ++k)
+    EXPECT_NEAR(averaged[k].second, single[k].second, 1e-12);
+
+  // mismatched or empty frames are rejected
+  EXPECT_FALSE(pdf.addFrame(positions, Array<unsigned char>(), cell));
+  EXPECT_FALSE(pdf.addFrame(Array<Vector3>(), numbers, cell));
+  EXPECT_EQ(pdf.frameCount(), static_cast<size_t>(2));
+
+  pdf.clear();
+  EXPECT_EQ(pdf.frameCount(), static_cast<size_t>(0));
+  EXPECT_EQ(pdf.counts()[13], static_cast<size_t>(0));
+}
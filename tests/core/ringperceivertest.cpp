@@ -22,6 +22,27 @@
 using Avogadro::Core::Molecule;
 using Avogadro::Core::RingPerceiver;
 
+namespace {
+
+// Add a ring of carbon atoms through the given atoms, adding atoms as needed.
+void addRing(Molecule& molecule, std::vector<size_t> atoms, size_t size)
+{
+  while (atoms.size() < size)
+    atoms.push_back(molecule.addAtom(6).index());
+  for (size_t i = 0; i < size; ++i)
+    molecule.addBond(atoms[i], atoms[(i + 1) % size], 1);
+}
+
+std::vector<size_t> ringSizes(const std::vector<std::vector<size_t>>& rings)
+{
+  std::vector<size_t> sizes;
+  for (const auto& ring : rings)
+    sizes.push_back(ring.size());
+  return sizes;
+}
+
+} // namespace
+
 TEST(RingPerceiverTest, benzene)
 {
   Molecule molecule;
@@ -57,3 +78,77 @@ TEST(RingPerceiverTest, ethanol)
   std::vector<std::vector<size_t>> rings = perceiver.rings();
   EXPECT_EQ(rings.size(), static_cast<size_t>(0));
 }
+
+TEST(RingPerceiverTest, fusedRings)
+{
+  // naphthalene, two rings sharing a bond
+  Molecule molecule;
+  addRing(molecule, {}, 6);
+  addRing(molecule, { 0, 1 }, 6);
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(10));
+
+  RingPerceiver perceiver(&molecule);
+  EXPECT_EQ(ringSizes(perceiver.rings()), std::vector<size_t>({ 6, 6 }));
+
+  // cubane, where the six faces have one ring too many for the basis
+  Molecule cubane;
+  addRing(cubane, {}, 4);
+  addRing(cubane, {}, 4);
+  for (size_t i = 0; i < 4; ++i)
+    cubane.addBond(i, i + 4, 1);
+  RingPerceiver cubanePerceiver(&cubane);
+  EXPECT_EQ(ringSizes(cubanePerceiver.rings()),
+            std::vector<size_t>({ 4, 4, 4, 4, 4 }));
+}
+
+TEST(RingPerceiverTest, ringSystems)
+{
+  Molecule molecule;
+  // a benzene ring on a long chain
+  size_t last = molecule.addAtom(6).index();
+  for (int i = 0; i < 200; ++i) {
+    const size_t next = molecule.addAtom(6).index();
+    molecule.addBond(last, next, 1);
+    last = next;
+  }
+  addRing(molecule, { last }, 6);
+  // joined to a cyclopentane, and a cyclobutane on the same atom (spiro)
+  const size_t link = molecule.addAtom(6).index();
+  molecule.addBond(last, link, 1);
+  addRing(molecule, { link }, 5);
+  addRing(molecule, { link }, 4);
+  // and a separate cyclopropane
+  addRing(molecule, {}, 3);
+
+  RingPerceiver perceiver(&molecule);
+  const std::vector<std::vector<size_t>>& rings = perceiver.rings();
+  EXPECT_EQ(ringSizes(rings), std::vector<size_t>({ 3, 4, 5, 6 }));
+
+  // each ring is closed by bonds between consecutive atoms
+  for (const auto& ring : rings) {
+    for (size_t i = 0; i < ring.size(); ++i) {
+      EXPECT_TRUE(
+        molecule.bond(ring[i], ring[(i + 1) % ring.size()]).isValid());
+    }
+  }
+}
+
+TEST(RingPerceiverTest, cachedOnMolecule)
+{
+  Molecule molecule;
+  addRing(molecule, {}, 6);
+  EXPECT_EQ(molecule.rings().size(), static_cast<size_t>(1));
+  const auto* rings = &molecule.rings();
+  EXPECT_EQ(&molecule.rings(), rings);
+
+  // copies and new bonds perceive again
+  Molecule copy(molecule);
+  EXPECT_EQ(copy.rings().size(), static_cast<size_t>(1));
+  addRing(molecule, { 0, 1 }, 5);
+  EXPECT_EQ(ringSizes(molecule.rings()), std::vector<size_t>({ 5, 6 }));
+  molecule.removeBond(0, 1);
+  EXPECT_EQ(ringSizes(molecule.rings()), std::vector<size_t>({ 9 }));
+  molecule.clearBonds();
+  EXPECT_TRUE(molecule.rings().empty());
+  EXPECT_EQ(copy.rings().size(), static_cast<size_t>(1));
+}
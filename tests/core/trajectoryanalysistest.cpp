@@ -0,0 +1,215 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/parallel.h>
+#include <avogadro/core/trajectoryanalysis.h>
+#include <avogadro/core/vector.h>
+
+#include <Eigen/Geometry>
+
+#include <cmath>
+
+using Avogadro::Index;
+using Avogadro::Matrix3;
+using Avogadro::MatrixX;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::TrajectoryAnalysis;
+
+namespace {
+
+Array<Vector3> referencePositions()
+{
+  Array<Vector3> positions;
+  positions.push_back(Vector3(0.0, 0.0, 0.0));
+  positions.push_back(Vector3(1.5, 0.0, 0.0));
+  positions.push_back(Vector3(1.5, 1.2, 0.3));
+  positions.push_back(Vector3(-0.4, 0.8, 1.1));
+  positions.push_back(Vector3(0.7, -1.0, 0.9));
+  return positions;
+}
+
+Array<Vector3> moved(const Array<Vector3>& positions, const Matrix3& rotation,
+                     const Vector3& translation)
+{
+  Array<Vector3> result;
+  for (const auto& position : positions)
+    result.push_back(rotation * position + translation);
+  return result;
+}
+
+Matrix3 rotation(double angle, const Vector3& axis)
+{
+  return Eigen::AngleAxis<double>(angle, axis.normalized()).toRotationMatrix();
+}
+
+} // namespace
+
+TEST(TrajectoryAnalysisTest, superposition)
+{
+  const Array<Vector3> a = referencePositions();
+  const Matrix3 r = rotation(1.1, Vector3(1.0, 2.0, -0.5));
+  const Array<Vector3> b = moved(a, r, Vector3(3.0, -2.0, 5.0));
+
+  // a rigid motion leaves nothing after superposition
+  EXPECT_NEAR(TrajectoryAnalysis::rmsd(a, b), 0.0, 1e-6);
+  EXPECT_GT(TrajectoryAnalysis::rmsd(a, b, false), 1.0);
+  EXPECT_TRUE((TrajectoryAnalysis::kabschRotation(a, b) - r).norm() < 1e-9);
+
+  // a mirror image cannot be superposed by a rotation
+  Array<Vector3> mirrored = a;
+  for (auto& position : mirrored)
+    position.z() = -position.z();
+  EXPECT_GT(TrajectoryAnalysis::rmsd(a, mirrored), 0.1);
+
+  EXPECT_TRUE(std::isnan(TrajectoryAnalysis::rmsd(a, Array<Vector3>())));
+}
+
+TEST(TrajectoryAnalysisTest, frames)
+{
+  Molecule molecule;
+  const Array<Vector3> reference = referencePositions();
+  for (Index i = 0; i < reference.size(); ++i)
+    molecule.addAtom(6).setPosition3d(reference[i]);
+
+  // frame 1 is the reference moved rigidly, frame 2 also moves atom 4
+  molecule.setCoordinate3d(reference, 0);
+  molecule.setCoordinate3d(
+    moved(reference, rotation(0.7, Vector3(0.0, 1.0, 1.0)),
+          Vector3(1.0, 2.0, 3.0)),
+    1);
+  Array<Vector3> distorted = reference;
+  distorted[4] += Vector3(0.0, 0.0, 1.0);
+  molecule.setCoordinate3d(distorted, 2);
+  molecule.setCoordinate3d(Array<Vector3>(2), 3);
+
+  const Array<Vector3> displayed = molecule.atomPositions3d();
+  TrajectoryAnalysis analysis(molecule);
+  EXPECT_EQ(analysis.frameCount(), static_cast<Index>(4));
+
+  const std::vector<double> rmsd = analysis.rmsd();
+  ASSERT_EQ(rmsd.size(), static_cast<size_t>(4));
+  EXPECT_NEAR(rmsd[0], 0.0, 1e-6);
+  EXPECT_NEAR(rmsd[1], 0.0, 1e-6);
+  EXPECT_GT(rmsd[2], 0.0);
+  EXPECT_LT(rmsd[2], std::sqrt(1.0 / 5.0) + 1e-9);
+  // frames of the wrong size have no RMSD
+  EXPECT_TRUE(std::isnan(rmsd[3]));
+
+  // without superposition the rigid motion counts
+  analysis.setAligned(false);
+  EXPECT_GT(analysis.rmsd()[1], 1.0);
+  EXPECT_NEAR(analysis.rmsd()[2], std::sqrt(1.0 / 5.0), 1e-9);
+  analysis.setAligned(true);
+
+  // only atoms 0 to 3, which do not change shape
+  analysis.setAtoms({ 0, 1, 2, 3 });
+  EXPECT_NEAR(analysis.rmsd()[2], 0.0, 1e-6);
+  const std::vector<double> rmsf = analysis.rmsf();
+  ASSERT_EQ(rmsf.size(), static_cast<size_t>(4));
+  for (double value : rmsf)
+    EXPECT_NEAR(value, 0.0, 1e-6);
+  analysis.setAtoms({});
+
+  // the matrix agrees with the RMSD to each reference
+  const MatrixX matrix = analysis.rmsdMatrix({ 0, 1, 2 });
+  ASSERT_EQ(matrix.rows(), 3);
+  EXPECT_TRUE(matrix.isApprox(matrix.transpose()));
+  EXPECT_NEAR(matrix(0, 2), rmsd[2], 1e-9);
+  EXPECT_NEAR(matrix(1, 2), analysis.rmsd(1)[2], 1e-9);
+  EXPECT_EQ(matrix(1, 1), 0.0);
+  EXPECT_TRUE(std::isnan(analysis.rmsdMatrix()(3, 0)));
+
+  // the molecule is left as it was
+  EXPECT_EQ(molecule.atomPositions3d(), displayed);
+}
+
+TEST(TrajectoryAnalysisTest, rmsf)
+{
+  Molecule molecule;
+  const Array<Vector3> reference = referencePositions();
+  for (Index i = 0; i < reference.size(); ++i)
+    molecule.addAtom(6).setPosition3d(reference[i]);
+
+  // the first atom moves by +-0.1 along x, without any superposition
+  for (int i = 0; i < 40; ++i) {
+    Array<Vector3> frame = reference;
+    frame[0].x() += (i % 2 == 0) ? 0.1 : -0.1;
+    molecule.setCoordinate3d(frame, i);
+  }
+
+  TrajectoryAnalysis analysis(molecule);
+  analysis.setAligned(false);
+  const std::vector<double> rmsf = analysis.rmsf();
+  ASSERT_EQ(rmsf.size(), reference.size());
+  EXPECT_NEAR(rmsf[0], 0.1, 1e-9);
+  for (size_t i = 1; i < rmsf.size(); ++i)
+    EXPECT_NEAR(rmsf[i], 0.0, 1e-6);
+}
+
+TEST(TrajectoryAnalysisTest, batches)
+{
+  Molecule molecule;
+  const Array<Vector3> reference = referencePositions();
+  for (Index i = 0; i < reference.size(); ++i)
+    molecule.addAtom(6).setPosition3d(reference[i]);
+
+  // more frames than fit in one batch of copied frames
+  const int frames = 300;
+  for (int i = 0; i < frames; ++i) {
+    Array<Vector3> frame = moved(reference, rotation(0.1 * i, Vector3(1, 2, 3)),
+                                 Vector3(0.01 * i, 0.0, 0.0));
+    frame[i % reference.size()].y() += 0.05 * std::sin(0.3 * i);
+    molecule.setCoordinate3d(frame, i);
+  }
+
+  Avogadro::Core::setMaxThreadCount(2);
+  TrajectoryAnalysis analysis(molecule);
+  const std::vector<double> rmsd = analysis.rmsd(0);
+  ASSERT_EQ(rmsd.size(), static_cast<size_t>(frames));
+  for (int i = 0; i < frames; ++i) {
+    EXPECT_NEAR(rmsd[i],
+                TrajectoryAnalysis::rmsd(molecule.coordinate3d(i),
+                                         molecule.coordinate3d(0)),
+                1e-9)
+      << "frame " << i;
+  }
+
+  // without superposition the RMSF is the spread of the raw positions
+  analysis.setAligned(false);
+  const std::vector<double> rmsf = analysis.rmsf();
+  ASSERT_EQ(rmsf.size(), reference.size());
+  for (Index j = 0; j < reference.size(); ++j) {
+    Vector3 mean = Vector3::Zero();
+    for (int i = 0; i < frames; ++i)
+      mean += molecule.coordinate3d(i)[j];
+    mean /= frames;
+    double sum = 0.0;
+    for (int i = 0; i < frames; ++i)
+      sum += (molecule.coordinate3d(i)[j] - mean).squaredNorm();
+    EXPECT_NEAR(rmsf[j], std::sqrt(sum / frames), 1e-9) << "atom " << j;
+  }
+
+  // the same few frames many times over, which share their data
+  const Index n = 256;
+  std::vector<Index> indices;
+  for (Index i = 0; i < n; ++i)
+    indices.push_back(i % 3);
+  const MatrixX matrix = analysis.rmsdMatrix(indices);
+  ASSERT_EQ(matrix.rows(), static_cast<int>(n));
+  for (Index i = 0; i < n; ++i) {
+    for (Index j = 0; j < n; ++j) {
+      const double expected = TrajectoryAnalysis::rmsd(
+        molecule.coordinate3d(i % 3), molecule.coordinate3d(j % 3), false);
+      EXPECT_NEAR(matrix(i, j), expected, 1e-9) << i << ", " << j;
+    }
+  }
+  Avogadro::Core::setMaxThreadCount(0);
+}
@@ -37,6 +37,22 @@ TEST(UtilitiesTest, splitEmpty)
   EXPECT_EQ(split(test, ' ', false).size(), 7);
 }
 
+TEST(UtilitiesTest, splitView)
+{
+  string test(" trim white space    ");
+  std::vector<std::string_view> tokens;
+  EXPECT_EQ(split(test, ' ', tokens), 3);
+  ASSERT_EQ(tokens.size(), 3);
+  EXPECT_EQ(tokens[0], "trim");
+  EXPECT_EQ(tokens[2], "space");
+
+  // empty items match the copying split, and the vector is reused
+  EXPECT_EQ(split(test, ' ', tokens, false), split(test, ' ', false).size());
+  EXPECT_EQ(split("a,,b,", ',', tokens, false), 3);
+  EXPECT_EQ(tokens[1], "");
+  EXPECT_EQ(split("", ',', tokens, false), 0);
+}
+
 TEST(UtilitiesTest, trimmed)
 {
   string test(" trim white space \n\t\r");
@@ -65,6 +81,45 @@ TEST(UtilitiesTest, lexicalCastCheck)
   // Pass something in that should fail.
   lexicalCast<int>("five", ok);
   EXPECT_EQ(ok, false);
+  lexicalCast<double>("   ", ok);
+  EXPECT_EQ(ok, false);
+  lexicalCast<int>("99999999999", ok);
+  EXPECT_EQ(ok, false);
+  lexicalCast<std::string>(" \t", ok);
+  EXPECT_EQ(ok, false);
+}
+
+TEST(UtilitiesTest, lexicalCastStream)
+{
+  // follows the rules of reading from a stream
+  bool ok(false);
+  EXPECT_EQ(lexicalCast<int>("  +42", ok), 42);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(lexicalCast<int>("-7 trailing", ok), -7);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(lexicalCast<int>("3.9", ok), 3);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(lexicalCast<unsigned int>("-1", ok), 4294967295u);
+  EXPECT_TRUE(ok);
+  EXPECT_DOUBLE_EQ(lexicalCast<double>("\t-1.25e2\n", ok), -125.0);
+  EXPECT_TRUE(ok);
+  EXPECT_FLOAT_EQ(lexicalCast<float>("  12.5  ", ok), 12.5f);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(lexicalCast<std::string>("  ALA B", ok), "ALA");
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(lexicalCast<char>("  B", ok), 'B');
+  EXPECT_TRUE(ok);
+  lexicalCast<int>("+-1", ok);
+  EXPECT_FALSE(ok);
+
+  // fixed columns can be parsed from a view without copying
+  string line("ATOM      1  N   ALA A   1      11.104   6.134  -6.504");
+  std::string_view view(line);
+  EXPECT_EQ(lexicalCast<size_t>(view.substr(22, 4), ok), 1);
+  EXPECT_TRUE(ok);
+  EXPECT_DOUBLE_EQ(lexicalCast<double>(view.substr(30, 8), ok), 11.104);
+  EXPECT_DOUBLE_EQ(lexicalCast<double>(view.substr(46, 8), ok), -6.504);
+  EXPECT_TRUE(ok);
 }
 
 TEST(UtilitiesTest, contains)
@@ -0,0 +1,154 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/unitcell.h>
+#include <avogadro/core/vector.h>
+#include <avogadro/core/xrdpattern.h>
+
+#include <algorithm>
+#include <cmath>
+
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::UnitCell;
+using Avogadro::Core::XrdPattern;
+using Avogadro::Core::XrdReflection;
+
+namespace {
+
+UnitCell cubic(double a)
+{
+  return UnitCell(a, a, a, M_PI / 2, M_PI / 2, M_PI / 2);
+}
+
+} // namespace
+
+TEST(XrdPatternTest, scatteringFactor)
+{
+  // the factors start at the number of electrons
+  EXPECT_NEAR(XrdPattern::scatteringFactor(1, 0.0), 1.0, 1e-3);
+  EXPECT_NEAR(XrdPattern::scatteringFactor(6, 0.0), 6.0, 1e-3);
+  EXPECT_NEAR(XrdPattern::scatteringFactor(29, 0.0), 29.0, 2e-2);
+  // and fall off with angle
+  EXPECT_LT(XrdPattern::scatteringFactor(6, 0.5),
+            XrdPattern::scatteringFactor(6, 0.1));
+  EXPECT_EQ(XrdPattern::scatteringFactor(0, 0.0), 0.0);
+
+  // every element up to californium is tabulated
+  for (unsigned char z = 1; z <= 98; ++z) {
+    EXPECT_TRUE(XrdPattern::hasScatteringFactor(z));
+    EXPECT_NEAR(XrdPattern::scatteringFactor(z, 0.0), z, 0.06)
+      << static_cast<int>(z);
+  }
+  EXPECT_FALSE(XrdPattern::hasScatteringFactor(99));
+  EXPECT_TRUE(std::isnan(XrdPattern::scatteringFactor(99, 0.5)));
+
+  // heavy elements away from s = 0, from the International Tables
+  // coefficients
+  EXPECT_NEAR(XrdPattern::scatteringFactor(73, 0.25), 58.1993, 1e-3);
+  EXPECT_NEAR(XrdPattern::scatteringFactor(80, 0.3), 60.1902, 1e-3);
+  EXPECT_NEAR(XrdPattern::scatteringFactor(92, 0.5), 55.4177, 1e-3);
+  EXPECT_NEAR(XrdPattern::scatteringFactor(92, 1.0), 35.4566, 1e-3);
+}
+
+TEST(XrdPatternTest, untabulatedElement)
+{
+  Array<Vector3> fractional;
+  fractional.push_back(Vector3(0.0, 0.0, 0.0));
+  Array<unsigned char> numbers;
+  numbers.push_back(99);
+
+  XrdPattern xrd;
+  EXPECT_FALSE(xrd.compute(cubic(4.0), fractional, numbers));
+  EXPECT_TRUE(xrd.reflections().empty());
+}
+
+TEST(XrdPatternTest, simpleCubic)
+{
+  Array<Vector3> fractional;
+  fractional.push_back(Vector3(0.0, 0.0, 0.0));
+  Array<unsigned char> numbers;
+  numbers.push_back(84);
+
+  XrdPattern xrd;
+  xrd.setWavelength(1.5406);
+  xrd.setMax2Theta(60.0);
+  ASSERT_TRUE(xrd.compute(cubic(3.35), fractional, numbers));
+
+  // {100}, {110}, {111}, {200}, {210}, {211} all lie below 60 degrees
+  const auto& lines = xrd.reflections();
+  ASSERT_GE(lines.size(), static_cast<size_t>(3));
+  EXPECT_EQ(lines[0].h, 1);
+  EXPECT_EQ(lines[0].k, 0);
+  EXPECT_EQ(lines[0].l, 0);
+  EXPECT_EQ(lines[0].multiplicity, 6u);
+  EXPECT_NEAR(lines[0].dSpacing, 3.35, 1e-9);
+  EXPECT_NEAR(lines[0].twoTheta,
+              2.0 * std::asin(1.5406 / (2.0 * 3.35)) * 180.0 / M_PI, 1e-9);
+  EXPECT_EQ(lines[1].multiplicity, 12u);
+  EXPECT_EQ(lines[2].multiplicity, 8u);
+  for (size_t i = 1; i < lines.size(); ++i)
+    EXPECT_LT(lines[i - 1].twoTheta, lines[i].twoTheta);
+
+  // the profile is scaled to 100, with the largest peak at a line
+  xrd.setPointCount(601);
+  const auto profile = xrd.pattern();
+  ASSERT_EQ(profile.size(), static_cast<size_t>(601));
+  EXPECT_DOUBLE_EQ(profile.back().first, 60.0);
+  const auto highest = std::max_element(
+    profile.begin(), profile.end(),
+    [](const auto& a, const auto& b) { return a.second < b.second; });
+  EXPECT_DOUBLE_EQ(highest->second, 100.0);
+  const bool nearLine =
+    std::any_of(lines.begin(), lines.end(), [&](const XrdReflection& line) {
+      return std::abs(line.twoTheta - highest->first) < 0.1;
+    });
+  EXPECT_TRUE(nearLine);
+}
+
+TEST(XrdPatternTest, extinctions)
+{
+  // copper, face-centered cubic: h, k, l all odd or all even
+  Array<Vector3> fractional;
+  fractional.push_back(Vector3(0.0, 0.0, 0.0));
+  fractional.push_back(Vector3(0.5, 0.5, 0.0));
+  fractional.push_back(Vector3(0.5, 0.0, 0.5));
+  fractional.push_back(Vector3(0.0, 0.5, 0.5));
+  Array<unsigned char> numbers(4, 29);
+
+  XrdPattern xrd;
+  xrd.setWavelength(1.5406);
+  xrd.setMax2Theta(100.0);
+  ASSERT_TRUE(xrd.compute(cubic(3.615), fractional, numbers));
+
+  const auto& lines = xrd.reflections();
+  ASSERT_GE(lines.size(), static_cast<size_t>(4));
+  for (const auto& line : lines) {
+    const bool allOdd = (line.h % 2 != 0) && (line.k % 2 != 0) &&
+                        (line.l % 2 != 0);
+    const bool allEven = (line.h % 2 == 0) && (line.k % 2 == 0) &&
+                         (line.l % 2 == 0);
+    EXPECT_TRUE(allOdd || allEven);
+  }
+  // (111) at 43.3 degrees, with four atoms scattering in phase
+  EXPECT_EQ(lines[0].h, 1);
+  EXPECT_EQ(lines[0].k, 1);
+  EXPECT_EQ(lines[0].l, 1);
+  EXPECT_EQ(lines[0].multiplicity, 8u);
+  EXPECT_NEAR(lines[0].twoTheta, 43.3, 0.05);
+  const double f = XrdPattern::scatteringFactor(29, 0.5 / lines[0].dSpacing);
+  EXPECT_NEAR(lines[0].structureFactorSq, 16.0 * f * f, 1e-6);
+  EXPECT_EQ(lines[1].h, 2);
+  EXPECT_EQ(lines[1].k, 0);
+  EXPECT_EQ(lines[1].l, 0);
+  EXPECT_EQ(lines[1].multiplicity, 6u);
+
+  // invalid input
+  EXPECT_FALSE(xrd.compute(cubic(3.615), fractional, Array<unsigned char>()));
+  EXPECT_TRUE(xrd.reflections().empty());
+}
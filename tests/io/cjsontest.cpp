@@ -23,15 +23,22 @@
 #include <avogadro/core/unitcell.h>
 
 #include <avogadro/io/cjsonformat.h>
+#include <avogadro/io/cmsgpackformat.h>
 
+using Avogadro::Index;
 using Avogadro::PI_F;
 using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Vector3ub;
+using Avogadro::Core::Array;
 using Avogadro::Core::Atom;
 using Avogadro::Core::Bond;
 using Avogadro::Core::Molecule;
 using Avogadro::Core::UnitCell;
 using Avogadro::Core::Variant;
 using Avogadro::Io::CjsonFormat;
+using Avogadro::Io::CMsgPackFormat;
+using Avogadro::Io::FileFormat;
 using Avogadro::MatrixX;
 
 TEST(CjsonTest, readFile)
@@ -177,3 +184,100 @@ TEST(CjsonTest, saveFile)
   EXPECT_EQ(bond.atom2().index(), static_cast<size_t>(1));
   EXPECT_EQ(bond.order(), static_cast<unsigned char>(1));
 }
+
+namespace {
+
+Molecule streamedMolecule()
+{
+  Molecule molecule;
+  MatrixX charges(4, 1);
+  Array<Array<Vector3>> modes(2);
+  for (Index i = 0; i < 4; ++i) {
+    Atom atom = molecule.addAtom(static_cast<unsigned char>(6 + i),
+                                 Vector3(0.1 * i, -1.5 * i, 1e-5 * i));
+    atom.setFormalCharge(static_cast<signed char>(i % 2 ? -1 : 1));
+    charges(i, 0) = 0.25 * i - 0.5;
+    modes[0].push_back(Vector3(i, 0.5, -0.5));
+    modes[1].push_back(Vector3(0.0, 1.0 / 3.0, i));
+  }
+  molecule.addBond(0, 1, 2);
+  molecule.addBond(2, 3, 3);
+  molecule.setAtomSelected(2, true);
+  molecule.setColor(1, Vector3ub(10, 20, 30));
+  molecule.setAtomLabel(3, "label \"3\"");
+  molecule.setPartialCharges("test", charges);
+  Array<double> frequencies(2, 100.0);
+  frequencies[1] = 200.0;
+  molecule.setVibrationFrequencies(frequencies);
+  molecule.setVibrationIRIntensities(Array<double>(2, 1.0));
+  molecule.setVibrationLx(modes);
+  return molecule;
+}
+
+void compareStreamed(const Molecule& molecule, const Molecule& other)
+{
+  ASSERT_EQ(other.atomCount(), molecule.atomCount());
+  ASSERT_EQ(other.bondCount(), molecule.bondCount());
+  for (Index i = 0; i < molecule.atomCount(); ++i) {
+    EXPECT_EQ(other.atomicNumber(i), molecule.atomicNumber(i));
+    EXPECT_EQ(other.atomPosition3d(i), molecule.atomPosition3d(i));
+    EXPECT_EQ(other.formalCharge(i), molecule.formalCharge(i));
+    EXPECT_EQ(other.atomSelected(i), molecule.atomSelected(i));
+    EXPECT_EQ(other.color(i), molecule.color(i));
+    EXPECT_EQ(other.atomLabel(i), molecule.atomLabel(i));
+  }
+  for (Index i = 0; i < molecule.bondCount(); ++i) {
+    EXPECT_EQ(other.bondPair(i), molecule.bondPair(i));
+    EXPECT_EQ(other.bondOrder(i), molecule.bondOrder(i));
+  }
+  EXPECT_EQ(other.partialCharges("test"), molecule.partialCharges("test"));
+  ASSERT_EQ(other.vibrationFrequencies().size(), static_cast<size_t>(2));
+  for (int mode = 0; mode < 2; ++mode) {
+    ASSERT_EQ(other.vibrationLx(mode).size(), molecule.atomCount());
+    for (Index i = 0; i < molecule.atomCount(); ++i)
+      EXPECT_EQ(other.vibrationLx(mode)[i], molecule.vibrationLx(mode)[i]);
+  }
+}
+
+} // namespace
+
+TEST(CjsonTest, streamedArrays)
+{
+  const Molecule molecule = streamedMolecule();
+  CjsonFormat cjson;
+  CMsgPackFormat msgpack;
+  for (FileFormat* format : { static_cast<FileFormat*>(&cjson),
+                              static_cast<FileFormat*>(&msgpack) }) {
+    std::string text;
+    EXPECT_TRUE(format->writeString(text, molecule));
+    Molecule other;
+    EXPECT_TRUE(format->readString(text, other));
+    EXPECT_EQ(format->error(), "");
+    compareStreamed(molecule, other);
+  }
+}
+
+TEST(CjsonTest, invalidArrays)
+{
+  CjsonFormat cjson;
+  Molecule molecule;
+  // atomic numbers must all be numbers
+  EXPECT_TRUE(cjson.readString(
+    R"({"chemicalJson": 1, "atoms": {"elements": {"number": [6, "C"]}}})",
+    molecule));
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(0));
+
+  // nested arrays are not coordinates, bonds to missing atoms are skipped
+  EXPECT_TRUE(cjson.readString(
+    R"({"chemicalJson": 1, "atoms": {"elements": {"number": [6, 8]},
+        "coords": {"3d": [[0, 0, 0], [1, 1, 1]]}},
+        "bonds": {"connections": {"index": [0, 1, 1, 2]}, "order": [2, 1]}})",
+    molecule));
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(2));
+  EXPECT_EQ(molecule.atomPositions3d().size(), static_cast<size_t>(0));
+  ASSERT_EQ(molecule.bondCount(), static_cast<size_t>(1));
+  EXPECT_EQ(molecule.bondOrder(0), static_cast<unsigned char>(2));
+
+  EXPECT_FALSE(cjson.readString(R"({"chemicalJson": 1, "atoms": {)", molecule));
+  EXPECT_EQ(cjson.error(), "Error reading CJSON file.\n");
+}
@@ -18,10 +18,18 @@
 
 #include <gtest/gtest.h>
 
+#include <avogadro/core/array.h>
+#include <avogadro/core/cube.h>
+#include <avogadro/core/framecache.h>
 #include <avogadro/io/hdf5dataformat.h>
 
 #include <cstdio>
 
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
+using Avogadro::Core::Array;
+using Avogadro::Core::Cube;
 using Avogadro::Io::Hdf5DataFormat;
 
 namespace {
@@ -275,3 +283,202 @@ TEST(Hdf5Test, datasetInteraction)
 
   remove(tmpFileName.c_str());
 }
+
+TEST(Hdf5Test, compressedMatrixBlocks)
+{
+  std::string tmpFileName("Hdf5Test_compressedMatrixBlocks.hdf");
+
+  Hdf5DataFormat hdf5;
+  hdf5.setCompressionLevel(6);
+  hdf5.setChunkSize(512);
+  hdf5.setSinglePrecision(true);
+  EXPECT_EQ(hdf5.compressionLevel(), 6);
+  EXPECT_EQ(hdf5.chunkSize(), static_cast<size_t>(512));
+  EXPECT_TRUE(hdf5.singlePrecision());
+  ASSERT_TRUE(hdf5.openFile(tmpFileName, Hdf5DataFormat::ReadWriteTruncate))
+    << "Opening test file '" << tmpFileName << "' failed.";
+
+  Eigen::MatrixXd mat(40, 30);
+  for (int row = 0; row < 40; ++row) {
+    for (int col = 0; col < 30; ++col)
+      mat(row, col) = row * 0.25 - col * 0.5;
+  }
+  EXPECT_TRUE(hdf5.writeDataset("/orbitals/mo", mat))
+    << "Writing compressed Eigen::MatrixXd failed.";
+
+  Eigen::MatrixXd matRead;
+  EXPECT_TRUE(hdf5.readDataset("/orbitals/mo", matRead));
+  EXPECT_TRUE(mat.isApprox(matRead, 1e-6));
+
+  // a single orbital, i.e. one column
+  Eigen::MatrixXd block;
+  EXPECT_TRUE(hdf5.readDatasetBlock("/orbitals/mo", 0, 7, 40, 1, block));
+  ASSERT_EQ(block.rows(), 40);
+  ASSERT_EQ(block.cols(), 1);
+  EXPECT_TRUE(block.isApprox(mat.block(0, 7, 40, 1), 1e-6));
+  EXPECT_TRUE(hdf5.readDatasetBlock("/orbitals/mo", 35, 20, 5, 10, block));
+  EXPECT_TRUE(block.isApprox(mat.block(35, 20, 5, 10), 1e-6));
+  EXPECT_FALSE(hdf5.readDatasetBlock("/orbitals/mo", 35, 20, 6, 10, block))
+    << "Reading a block outside of the dataset succeeded.";
+
+  ASSERT_TRUE(hdf5.closeFile()) << "Closing test file '" << tmpFileName
+                                << "' failed.";
+
+  remove(tmpFileName.c_str());
+}
+
+TEST(Hdf5Test, matrixLayout)
+{
+  std::string tmpFileName("Hdf5Test_matrixLayout.hdf");
+
+  Hdf5DataFormat hdf5;
+  ASSERT_TRUE(hdf5.openFile(tmpFileName, Hdf5DataFormat::ReadWriteTruncate))
+    << "Opening test file '" << tmpFileName << "' failed.";
+
+  Eigen::MatrixXd mat(4, 3);
+  for (int row = 0; row < 4; ++row) {
+    for (int col = 0; col < 3; ++col)
+      mat(row, col) = 10 * row + col;
+  }
+
+  // Older files hold the column-major buffer under row x column dimensions,
+  // with no layout attribute.
+  std::vector<double> buffer(mat.data(), mat.data() + mat.size());
+  size_t dims[2] = { 4, 3 };
+  EXPECT_TRUE(hdf5.writeDataset("/old", buffer, 2, dims));
+  Eigen::MatrixXd matRead;
+  EXPECT_TRUE(hdf5.readDataset("/old", matRead));
+  EXPECT_EQ(matRead, mat);
+  Eigen::MatrixXd block;
+  EXPECT_TRUE(hdf5.readDatasetBlock("/old", 1, 1, 3, 2, block));
+  EXPECT_EQ(block, mat.block(1, 1, 3, 2));
+
+  // new files are row-major
+  EXPECT_TRUE(hdf5.writeDataset("/new", mat));
+  std::vector<double> values;
+  EXPECT_EQ(hdf5.readDataset("/new", values), std::vector<int>({ 4, 3 }));
+  ASSERT_EQ(values.size(), static_cast<size_t>(12));
+  EXPECT_EQ(values[1], mat(0, 1));
+  EXPECT_EQ(values[3], mat(1, 0));
+  EXPECT_TRUE(hdf5.readDataset("/new", matRead));
+  EXPECT_EQ(matRead, mat);
+  EXPECT_TRUE(hdf5.readDatasetBlock("/new", 1, 1, 3, 2, block));
+  EXPECT_EQ(block, mat.block(1, 1, 3, 2));
+
+  ASSERT_TRUE(hdf5.closeFile()) << "Closing test file '" << tmpFileName
+                                << "' failed.";
+
+  remove(tmpFileName.c_str());
+}
+
+TEST(Hdf5Test, frames)
+{
+  std::string tmpFileName("Hdf5Test_frames.hdf");
+
+  Hdf5DataFormat hdf5;
+  hdf5.setCompressionLevel(1);
+  hdf5.setChunkSize(100);
+  ASSERT_TRUE(hdf5.openFile(tmpFileName, Hdf5DataFormat::ReadWriteTruncate))
+    << "Opening test file '" << tmpFileName << "' failed.";
+
+  const Index atoms = 10;
+  std::vector<Array<Vector3>> frames(3);
+  for (Index frame = 0; frame < frames.size(); ++frame) {
+    for (Index i = 0; i < atoms; ++i)
+      frames[frame].push_back(Vector3(frame, i, 0.5 * i + frame));
+  }
+
+  EXPECT_FALSE(hdf5.writeFrame("/trajectory/frames", 1, frames[1]))
+    << "A frame was written before the first one.";
+  for (Index frame = 0; frame < frames.size(); ++frame) {
+    EXPECT_TRUE(hdf5.writeFrame("/trajectory/frames", frame, frames[frame]))
+      << "Writing frame " << frame << " failed.";
+  }
+  EXPECT_EQ(hdf5.frameCount("/trajectory/frames"), frames.size());
+  EXPECT_FALSE(hdf5.writeFrame("/trajectory/frames", 4, frames[0]))
+    << "A frame was written after a gap.";
+  Array<Vector3> tooFew(atoms - 1, Vector3::Zero());
+  EXPECT_FALSE(hdf5.writeFrame("/trajectory/frames", 3, tooFew))
+    << "A frame was written with the wrong number of atoms.";
+
+  // replace a frame in the middle
+  frames[1][4] = Vector3(-1.0, -2.0, -3.0);
+  EXPECT_TRUE(hdf5.writeFrame("/trajectory/frames", 1, frames[1]));
+  EXPECT_EQ(hdf5.frameCount("/trajectory/frames"), frames.size());
+
+  Array<Vector3> positions;
+  for (Index frame = frames.size(); frame-- > 0;) {
+    ASSERT_TRUE(hdf5.readFrame("/trajectory/frames", frame, positions));
+    ASSERT_EQ(positions.size(), atoms);
+    for (Index i = 0; i < atoms; ++i)
+      EXPECT_EQ(positions[i], frames[frame][i]);
+  }
+  EXPECT_FALSE(hdf5.readFrame("/trajectory/frames", 3, positions));
+  EXPECT_EQ(hdf5.frameCount("/IShouldNotExist"), static_cast<Index>(0));
+
+  ASSERT_TRUE(hdf5.closeFile()) << "Closing test file '" << tmpFileName
+                                << "' failed.";
+
+  auto source = Hdf5DataFormat::frameSource(tmpFileName, "/trajectory/frames");
+  ASSERT_TRUE(source != nullptr);
+  EXPECT_EQ(source->frameCount(), frames.size());
+  ASSERT_TRUE(source->readFrame(2, positions));
+  EXPECT_EQ(positions[atoms - 1], frames[2][atoms - 1]);
+  EXPECT_TRUE(Hdf5DataFormat::frameSource(tmpFileName, "/missing") == nullptr);
+  source.reset();
+
+  remove(tmpFileName.c_str());
+}
+
+TEST(Hdf5Test, cubes)
+{
+  std::string tmpFileName("Hdf5Test_cubes.hdf");
+
+  Hdf5DataFormat hdf5;
+  hdf5.setCompressionLevel(4);
+  hdf5.setChunkSize(1024);
+  ASSERT_TRUE(hdf5.openFile(tmpFileName, Hdf5DataFormat::ReadWriteTruncate))
+    << "Opening test file '" << tmpFileName << "' failed.";
+
+  Cube cube;
+  cube.setLimits(Vector3(-1.0, -2.0, -3.0), Vector3i(12, 10, 8),
+                 Vector3(0.5, 0.25, 0.125));
+  for (int i = 0; i < 12; ++i) {
+    for (int j = 0; j < 10; ++j) {
+      for (int k = 0; k < 8; ++k)
+        cube.setValue(i, j, k, i * 100.0f + j * 10.0f + k);
+    }
+  }
+  cube.setName("density");
+  cube.setCubeType(Cube::ElectronDensity);
+  EXPECT_TRUE(hdf5.writeCube("/cubes/0", cube)) << "Writing the cube failed.";
+
+  Cube read;
+  ASSERT_TRUE(hdf5.readCube("/cubes/0", read)) << "Reading the cube failed.";
+  EXPECT_EQ(read.dimensions(), cube.dimensions());
+  EXPECT_TRUE(read.min().isApprox(cube.min()));
+  EXPECT_TRUE(read.spacing().isApprox(cube.spacing()));
+  EXPECT_EQ(read.name(), "density");
+  EXPECT_EQ(read.cubeType(), Cube::ElectronDensity);
+  EXPECT_EQ(*read.data(), *cube.data());
+
+  // a sub-volume keeps its position in space
+  Cube slab;
+  ASSERT_TRUE(hdf5.readCube("/cubes/0", Vector3i(2, 3, 4), Vector3i(5, 1, 4),
+                            slab))
+    << "Reading a sub-volume failed.";
+  EXPECT_EQ(slab.dimensions(), Vector3i(5, 1, 4));
+  EXPECT_TRUE(slab.min().isApprox(Vector3(0.0, -1.25, -2.5)));
+  for (int i = 0; i < 5; ++i) {
+    for (int k = 0; k < 4; ++k)
+      EXPECT_EQ(slab.value(i, 0, k), cube.value(i + 2, 3, k + 4));
+  }
+  EXPECT_FALSE(hdf5.readCube("/cubes/0", Vector3i(8, 0, 0),
+                             Vector3i(5, 1, 1), slab))
+    << "Reading a sub-volume outside of the cube succeeded.";
+
+  ASSERT_TRUE(hdf5.closeFile()) << "Closing test file '" << tmpFileName
+                                << "' failed.";
+
+  remove(tmpFileName.c_str());
+}
@@ -18,6 +18,7 @@
 
 #include <gtest/gtest.h>
 
+#include <avogadro/core/array.h>
 #include <avogadro/core/atom.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/unitcell.h>
@@ -25,11 +26,14 @@
 
 #include <avogadro/io/lammpsformat.h>
 
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <string>
 
+using Avogadro::Matrix3;
 using Avogadro::Vector3;
+using Avogadro::Core::Array;
 using Avogadro::Core::Atom;
 using Avogadro::Core::Molecule;
 using Avogadro::Core::UnitCell;
@@ -115,3 +119,70 @@ TEST(LammpsTest, modes)
   EXPECT_TRUE(format.isMode(FileFormat::Read | FileFormat::MultiMolecule));
   EXPECT_TRUE(format.isMode(FileFormat::MultiMolecule));
 }
+
+TEST(LammpsTest, readTrajectory)
+{
+  // a constant pressure run, the box of frame i is 10 + i wide and the atoms
+  // are given in scaled coordinates
+  std::ostringstream dump;
+  for (int i = 0; i < 3; ++i) {
+    const double length = 10.0 + i;
+    dump << "ITEM: TIMESTEP\n"
+         << 100 * i << "\n"
+         << "ITEM: NUMBER OF ATOMS\n2\n"
+         << "ITEM: BOX BOUNDS pp pp pp\n"
+         << "0.0 " << length << "\n0.0 " << length << "\n0.0 " << length
+         << "\n"
+         << "ITEM: ATOMS id type xs ys zs\n"
+         << "1 1 0.5 0.5 0.5\n"
+         << "2 2 0.25 0.0 0.75\n";
+  }
+  const std::string fileName = ::testing::TempDir() + "lammpstmp.dump";
+  std::ofstream(fileName) << dump.str();
+
+  LammpsTrajectoryFormat lammps;
+  Molecule molecule;
+  ASSERT_TRUE(lammps.readFile(fileName, molecule));
+  ASSERT_EQ(molecule.atomCount(), 2);
+  ASSERT_EQ(molecule.coordinate3dCount(), 3);
+  // later frames are read on demand
+  EXPECT_NE(molecule.frameCache(), nullptr);
+
+  bool status = false;
+  EXPECT_EQ(molecule.timeStep(2, status), 200);
+  EXPECT_TRUE(molecule.setCoordinate3d(2));
+  EXPECT_EQ(molecule.atomPosition3d(0), Vector3(6.0, 6.0, 6.0));
+  EXPECT_EQ(molecule.atomPosition3d(1), Vector3(3.0, 0.0, 9.0));
+  ASSERT_NE(molecule.unitCell(), nullptr);
+  EXPECT_EQ(molecule.unitCell()->aVector(), Vector3(12.0, 0.0, 0.0));
+  EXPECT_EQ(molecule.unitCell()->cVector(), Vector3(0.0, 0.0, 12.0));
+
+  // going back restores the box of the first frame
+  EXPECT_TRUE(molecule.setCoordinate3d(0));
+  EXPECT_EQ(molecule.atomPosition3d(0), Vector3(5.0, 5.0, 5.0));
+  EXPECT_EQ(molecule.unitCell()->bVector(), Vector3(0.0, 10.0, 0.0));
+
+  // the same frames, read up front
+  Molecule fromString;
+  ASSERT_TRUE(lammps.readString(dump.str(), fromString));
+  EXPECT_EQ(fromString.frameCache(), nullptr);
+  ASSERT_EQ(fromString.coordinate3dCount(), 3);
+  for (int i = 0; i < 3; ++i) {
+    Matrix3 streamed, cached;
+    ASSERT_TRUE(fromString.frameCell(i, streamed));
+    ASSERT_TRUE(molecule.frameCell(i, cached));
+    EXPECT_EQ(streamed, cached);
+    EXPECT_EQ(fromString.coordinate3d(i)[1], molecule.coordinate3d(i)[1]);
+  }
+
+  // random access without a molecule
+  EXPECT_TRUE(lammps.openTrajectory(fileName));
+  EXPECT_EQ(lammps.frameCount(), 3);
+  Array<Vector3> positions;
+  EXPECT_TRUE(lammps.readFrame(1, positions));
+  ASSERT_EQ(positions.size(), 2);
+  EXPECT_EQ(positions[0], Vector3(5.5, 5.5, 5.5));
+  EXPECT_FALSE(lammps.readFrame(3, positions));
+  lammps.close();
+  std::remove(fileName.c_str());
+}
@@ -32,3 +32,47 @@ TEST(PdbTest, altLoc)
     molecule.atomPosition3d(265).z() != molecule.coordinate3d(1)[265].z()
   );
 }
+
+TEST(PdbTest, readParallel)
+{
+  // two models of a small peptide, with an alternate location in each
+  std::string models;
+  for (int model = 1; model <= 2; ++model) {
+    models += "MODEL        " + std::to_string(model) + "\n";
+    models += "ATOM      1  N   ALA A   1      11.104   6.134  -6.504  1.00  "
+              "0.00           N\n"
+              "ATOM      2  CA  ALA A   1      11.639   6.071  -5.147  1.00  "
+              "0.00           C\n"
+              "ATOM      3  C   ALA A   1      13.149   5.877  -5.172  1.00  "
+              "0.00           C\n"
+              "ATOM      4  O  AALA A   1      13.743   5.407  -6.141  0.50  "
+              "0.00           O\n"
+              "ATOM      5  O  BALA A   1      13.843   5.307  -6.241  0.50  "
+              "0.00           O\n"
+              "ATOM      6  N   GLY A   2      13.763   6.242  -4.054  1.00  "
+              "0.00           N\n"
+              "ATOM      7  CA  GLY A   2      15.21"
+            + std::to_string(model) + "   6.122  -3.975  1.00  0.00"
+              "           C\n";
+    models += "ENDMDL\n";
+  }
+  models += "END\n";
+
+  PdbFormat serial;
+  serial.setOptions("{\"parallel\": false}");
+  Molecule expected;
+  EXPECT_TRUE(serial.readString(models, expected));
+
+  PdbFormat pdb;
+  Molecule molecule;
+  EXPECT_TRUE(pdb.readString(models, molecule));
+  ASSERT_EQ(molecule.atomCount(), 6);
+  EXPECT_EQ(molecule.atomCount(), expected.atomCount());
+  EXPECT_EQ(molecule.bondCount(), expected.bondCount());
+  EXPECT_EQ(molecule.residueCount(), expected.residueCount());
+  ASSERT_EQ(molecule.coordinate3dCount(), expected.coordinate3dCount());
+  for (int c = 0; c < molecule.coordinate3dCount(); ++c)
+    for (Avogadro::Index i = 0; i < molecule.atomCount(); ++i)
+      EXPECT_EQ(molecule.coordinate3d(c)[i], expected.coordinate3d(c)[i]);
+  EXPECT_FLOAT_EQ(molecule.coordinate3d(1)[5].x(), 15.212);
+}
@@ -0,0 +1,205 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/vector.h>
+
+#include <avogadro/io/dcdformat.h>
+#include <avogadro/io/trrformat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Io::DcdFormat;
+using Avogadro::Io::FileFormat;
+using Avogadro::Io::TrrFormat;
+
+namespace {
+
+const Index atomCount = 7;
+const Index frameCount = 4;
+
+float coordinate(Index frame, Index atom, int axis)
+{
+  return static_cast<float>(std::sin(0.3 * atom + 0.7 * frame + axis));
+}
+
+template <typename T>
+void put(std::ostream& out, T value, bool bigEndian)
+{
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  const int one = 1;
+  if (bigEndian == (*reinterpret_cast<const char*>(&one) == 1))
+    std::reverse(bytes, bytes + sizeof(T));
+  out.write(bytes, sizeof(T));
+}
+
+// Fortran record, with its length before and after the data.
+void record(std::ostream& out, const std::string& data, bool bigEndian)
+{
+  put<int>(out, static_cast<int>(data.size()), bigEndian);
+  out << data;
+  put<int>(out, static_cast<int>(data.size()), bigEndian);
+}
+
+template <typename T>
+std::string bytes(T value, bool bigEndian)
+{
+  std::ostringstream out;
+  put<T>(out, value, bigEndian);
+  return out.str();
+}
+
+// A CHARMM DCD with frames + 1 frames, optionally with unit cell blocks.
+std::string dcdFile(bool bigEndian, bool unitCell)
+{
+  std::ostringstream out;
+  std::string header(84, '\0');
+  header.replace(0, 4, "CORD");
+  header.replace(4, 4, bytes<int>(frameCount + 1, bigEndian));
+  header.replace(40, 4, bytes<float>(0.002f, bigEndian));
+  header.replace(44, 4, bytes<int>(unitCell ? 1 : 0, bigEndian));
+  header.replace(80, 4, bytes<int>(24, bigEndian)); // CHARMM version
+  record(out, header, bigEndian);
+  record(out, bytes<int>(1, bigEndian) + std::string(80, ' '), bigEndian);
+  record(out, bytes<int>(atomCount, bigEndian), bigEndian);
+
+  for (Index frame = 0; frame <= frameCount; ++frame) {
+    if (unitCell) {
+      std::string cell;
+      for (double value : { 12.0, 0.0, 13.0, 0.0, 0.0, 14.0 })
+        cell += bytes<double>(value, bigEndian);
+      record(out, cell, bigEndian);
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+      std::string block;
+      for (Index i = 0; i < atomCount; ++i)
+        block += bytes<float>(coordinate(frame, i, axis), bigEndian);
+      record(out, block, bigEndian);
+    }
+  }
+  return out.str();
+}
+
+// A GROMACS TRR with frames + 1 frames, in nm.
+template <typename Real>
+std::string trrFile(bool bigEndian)
+{
+  std::ostringstream out;
+  const int real = sizeof(Real);
+  for (Index frame = 0; frame <= frameCount; ++frame) {
+    put<int>(out, 1993, bigEndian);
+    put<int>(out, 13, bigEndian);
+    put<int>(out, 12, bigEndian);
+    out << "GMX_trn_file";
+    const int sizes[13] = { 0, 0, 9 * real, 0, 0, 0, 0,
+                            static_cast<int>(3 * atomCount * real), 0, 0,
+                            static_cast<int>(atomCount),
+                            static_cast<int>(frame), 0 };
+    for (int size : sizes)
+      put<int>(out, size, bigEndian);
+    put<Real>(out, static_cast<Real>(0.002 * frame), bigEndian);
+    put<Real>(out, 0, bigEndian);
+    for (int i = 0; i < 9; ++i)
+      put<Real>(out, i % 4 == 0 ? 1 : 0, bigEndian);
+    for (Index i = 0; i < atomCount; ++i)
+      for (int axis = 0; axis < 3; ++axis)
+        put<Real>(out, coordinate(frame, i, axis) / 10, bigEndian);
+  }
+  return out.str();
+}
+
+// Writes @p contents without the last @p truncate bytes, which cuts the
+// final frame short.
+void writeFile(const std::string& fileName, const std::string& contents,
+               size_t truncate)
+{
+  std::ofstream out(fileName, std::ios::binary);
+  out.write(contents.data(),
+            static_cast<std::streamsize>(contents.size() - truncate));
+}
+
+// Reads every frame both through the stream and from the memory mapping,
+// which must agree with each other and with the coordinates written.
+void compareFrames(FileFormat& format, const std::string& fileName)
+{
+  std::vector<Array<Vector3>> frames[2];
+  for (bool mapFile : { false, true }) {
+    ASSERT_TRUE(format.openTrajectory(fileName, mapFile)) << format.error();
+    // the truncated frame is never listed
+    ASSERT_EQ(format.frameCount(), frameCount);
+    for (Index frame = 0; frame < frameCount; ++frame) {
+      Array<Vector3> positions;
+      ASSERT_TRUE(format.readFrame(frame, positions))
+        << "frame " << frame << (mapFile ? " mapped" : " stream");
+      frames[mapFile].push_back(positions);
+    }
+    Array<Vector3> positions;
+    EXPECT_FALSE(format.readFrame(frameCount, positions));
+    format.close();
+  }
+
+  for (Index frame = 0; frame < frameCount; ++frame) {
+    const Array<Vector3>& stream = frames[0][frame];
+    const Array<Vector3>& mapped = frames[1][frame];
+    ASSERT_EQ(stream.size(), atomCount);
+    ASSERT_EQ(mapped.size(), atomCount);
+    for (Index i = 0; i < atomCount; ++i) {
+      EXPECT_EQ(stream[i], mapped[i]) << "frame " << frame << " atom " << i;
+      for (int axis = 0; axis < 3; ++axis)
+        EXPECT_NEAR(mapped[i][axis], coordinate(frame, i, axis), 1e-5);
+    }
+  }
+}
+
+} // namespace
+
+TEST(TrajectoryTest, dcdLittleEndian)
+{
+  const std::string fileName =
+    ::testing::TempDir() + "trajectorytest-little.dcd";
+  writeFile(fileName, dcdFile(false, false), 5);
+  DcdFormat dcd;
+  compareFrames(dcd, fileName);
+  std::remove(fileName.c_str());
+}
+
+TEST(TrajectoryTest, dcdBigEndian)
+{
+  const std::string fileName =
+    ::testing::TempDir() + "trajectorytest-big.dcd";
+  writeFile(fileName, dcdFile(true, true), 5);
+  DcdFormat dcd;
+  compareFrames(dcd, fileName);
+  std::remove(fileName.c_str());
+}
+
+TEST(TrajectoryTest, trr)
+{
+  const std::string fileName =
+    ::testing::TempDir() + "trajectorytest.trr";
+  writeFile(fileName, trrFile<float>(true), 5);
+  TrrFormat trr;
+  compareFrames(trr, fileName);
+
+  writeFile(fileName, trrFile<float>(false), 5);
+  compareFrames(trr, fileName);
+
+  writeFile(fileName, trrFile<double>(true), 5);
+  compareFrames(trr, fileName);
+  std::remove(fileName.c_str());
+}
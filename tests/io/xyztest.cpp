@@ -19,14 +19,18 @@
 #include <gtest/gtest.h>
 
 #include <avogadro/core/atom.h>
+#include <avogadro/core/framecache.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/vector.h>
 
 #include <avogadro/io/xyzformat.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 using Avogadro::Core::Atom;
 using Avogadro::Core::Molecule;
@@ -152,6 +156,134 @@ TEST(XyzTest, modes)
   EXPECT_TRUE(format.isMode(FileFormat::MultiMolecule));
 }
 
+TEST(XyzTest, readTrajectory)
+{
+  // frame i has atom j at (i, j, 0)
+  std::ostringstream trajectory;
+  for (int i = 0; i < 50; ++i) {
+    trajectory << "3\nframe " << i << "\n";
+    for (int j = 0; j < 3; ++j)
+      trajectory << "Ar " << i << " " << j << " 0.0\n";
+  }
+  const std::string fileName = ::testing::TempDir() + "trajectorytmp.xyz";
+  std::ofstream(fileName) << trajectory.str();
+
+  XyzFormat xyz;
+  Molecule molecule;
+  EXPECT_TRUE(xyz.readFile(fileName, molecule));
+  ASSERT_EQ(molecule.atomCount(), 3);
+  EXPECT_EQ(molecule.coordinate3dCount(), 50);
+  // later frames are read on demand
+  EXPECT_NE(molecule.frameCache(), nullptr);
+  EXPECT_TRUE(molecule.setCoordinate3d(37));
+  EXPECT_EQ(molecule.atomPosition3d(2), Vector3(37.0, 2.0, 0.0));
+
+  // the same frames, read up front
+  Molecule fromString;
+  EXPECT_TRUE(xyz.readString(trajectory.str(), fromString));
+  EXPECT_EQ(fromString.frameCache(), nullptr);
+  ASSERT_EQ(fromString.coordinate3dCount(), 50);
+  for (int i = 0; i < 50; ++i)
+    EXPECT_EQ(fromString.coordinate3d(i)[1], molecule.coordinate3d(i)[1]);
+
+  // random access without a molecule
+  EXPECT_TRUE(xyz.openTrajectory(fileName));
+  EXPECT_EQ(xyz.frameCount(), 50);
+  Avogadro::Core::Array<Vector3> positions;
+  EXPECT_TRUE(xyz.readFrame(49, positions));
+  EXPECT_EQ(positions[0], Vector3(49.0, 0.0, 0.0));
+  EXPECT_TRUE(xyz.readFrame(3, positions));
+  EXPECT_EQ(positions[2], Vector3(3.0, 2.0, 0.0));
+  EXPECT_FALSE(xyz.readFrame(50, positions));
+  xyz.close();
+  std::remove(fileName.c_str());
+}
+
+TEST(XyzTest, readParallel)
+{
+  // frame i has atom j at (i, j, 0)
+  std::ostringstream trajectory;
+  for (int i = 0; i < 200; ++i) {
+    trajectory << "4\nframe " << i << "\n";
+    for (int j = 0; j < 4; ++j)
+      trajectory << "Ar\t" << i << "\t" << j << "\t0.0\n";
+  }
+
+  XyzFormat serial;
+  serial.setOptions("{\"parallel\": false}");
+  Molecule expected;
+  EXPECT_TRUE(serial.readString(trajectory.str(), expected));
+
+  XyzFormat xyz;
+  Molecule molecule;
+  EXPECT_TRUE(xyz.readString(trajectory.str(), molecule));
+  ASSERT_EQ(molecule.coordinate3dCount(), expected.coordinate3dCount());
+  ASSERT_EQ(molecule.coordinate3dCount(), 200);
+  for (int i = 0; i < 200; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_EQ(molecule.coordinate3d(i)[j], expected.coordinate3d(i)[j]);
+  EXPECT_EQ(molecule.coordinate3d(123)[3], Vector3(123.0, 3.0, 0.0));
+
+  // a truncated last frame is an error, the frames before it are kept
+  std::string truncated = trajectory.str();
+  truncated.resize(truncated.size() - 12);
+  molecule = Molecule();
+  EXPECT_FALSE(xyz.readString(truncated, molecule));
+  EXPECT_EQ(molecule.coordinate3dCount(), 199);
+}
+
+TEST(XyzTest, progressAndCancel)
+{
+  // water molecules 5 A apart, large enough to be read in several blocks
+  std::ostringstream text;
+  text << 3 * 1000 << "\nwater\n" << std::fixed;
+  for (int i = 0; i < 1000; ++i) {
+    text << "O " << 5.0 * i << " 0.0 0.0\n"
+         << "H " << 5.0 * i + 0.96 << " 0.0 0.0\n"
+         << "H " << 5.0 * i - 0.24 << " 0.93 0.0\n";
+  }
+  const std::string water = text.str();
+
+  XyzFormat xyz;
+  std::vector<std::streamoff> read;
+  xyz.setProgressCallback([&read, &water](std::streamoff done,
+                                          std::streamoff total) {
+    EXPECT_EQ(total, static_cast<std::streamoff>(water.size()));
+    read.push_back(done);
+  });
+  Molecule molecule;
+  EXPECT_TRUE(xyz.readString(water, molecule));
+  EXPECT_EQ(molecule.atomCount(), 3000);
+  EXPECT_EQ(molecule.bondCount(), 2000);
+  ASSERT_GT(read.size(), 1);
+  EXPECT_TRUE(std::is_sorted(read.begin(), read.end()));
+  EXPECT_EQ(read.back(), static_cast<std::streamoff>(water.size()));
+
+  // derived data can be added later
+  xyz.setDeferDerivedData(true);
+  molecule = Molecule();
+  EXPECT_TRUE(xyz.readString(water, molecule));
+  EXPECT_EQ(molecule.atomCount(), 3000);
+  EXPECT_EQ(molecule.bondCount(), 0);
+  EXPECT_TRUE(xyz.completeRead(molecule));
+  EXPECT_EQ(molecule.bondCount(), 2000);
+  xyz.setDeferDerivedData(false);
+
+  // cancel on the first block
+  xyz.setProgressCallback(
+    [&xyz](std::streamoff, std::streamoff) { xyz.cancel(); });
+  molecule = Molecule();
+  EXPECT_FALSE(xyz.readString(water, molecule));
+  EXPECT_NE(xyz.error().find("canceled"), std::string::npos);
+  EXPECT_FALSE(xyz.isCanceled());
+
+  // the next read is not affected
+  xyz.setProgressCallback(nullptr);
+  molecule = Molecule();
+  EXPECT_TRUE(xyz.readString(water, molecule));
+  EXPECT_EQ(molecule.atomCount(), 3000);
+}
+
 TEST(DISABLED_XyzTest, readMulti)
 {
   XyzFormat multi;
@@ -0,0 +1,169 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/layer.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/vector.h>
+#include <avogadro/rendering/ballandstickbuilder.h>
+#include <avogadro/rendering/cylindergeometry.h>
+#include <avogadro/rendering/spheregeometry.h>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Vector3f;
+using Avogadro::Vector3ub;
+using Avogadro::Core::Molecule;
+using Avogadro::Rendering::BallAndStickBuilder;
+using Avogadro::Rendering::CylinderGeometry;
+using Avogadro::Rendering::SphereGeometry;
+
+namespace {
+
+// Formaldehyde, with a double bond.
+void addFormaldehyde(Molecule& molecule)
+{
+  molecule.addAtom(6).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  molecule.addAtom(8).setPosition3d(Vector3(0.0, 0.0, 1.2));
+  molecule.addAtom(1).setPosition3d(Vector3(0.9, 0.0, -0.5));
+  molecule.addAtom(1).setPosition3d(Vector3(-0.9, 0.0, -0.5));
+  molecule.addBond(0, 1, 2);
+  molecule.addBond(0, 2, 1);
+  molecule.addBond(0, 3, 1);
+}
+
+class BallAndStickBuilderTest : public ::testing::Test
+{
+protected:
+  void build()
+  {
+    spheres.clear();
+    selectedSpheres.clear();
+    cylinders.clear();
+    builder.reset(&spheres, &selectedSpheres, &cylinders);
+    for (Index i = 0; i < molecule.atomCount(); ++i)
+      builder.addAtom(molecule, i, 0.5f);
+    for (Index i = 0; i < molecule.bondCount(); ++i)
+      addBond(i);
+    builder.finish(molecule);
+  }
+
+  void addBond(Index i)
+  {
+    builder.addBond(molecule, i, molecule.bond(i).order(), 0.1f, 0.1f);
+  }
+
+  Molecule molecule;
+  SphereGeometry spheres;
+  SphereGeometry selectedSpheres;
+  CylinderGeometry cylinders;
+  BallAndStickBuilder builder;
+};
+
+} // namespace
+
+TEST_F(BallAndStickBuilderTest, build)
+{
+  EXPECT_FALSE(builder.isValid());
+  addFormaldehyde(molecule);
+  molecule.setAtomSelected(1, true);
+  build();
+  EXPECT_TRUE(builder.isValid());
+  EXPECT_EQ(builder.atomCount(), static_cast<Index>(4));
+  EXPECT_EQ(spheres.size(), static_cast<size_t>(4));
+  ASSERT_EQ(selectedSpheres.size(), static_cast<size_t>(1));
+  EXPECT_FLOAT_EQ(selectedSpheres.spheres()[0].radius, 0.6f);
+  // two cylinders for the double bond
+  EXPECT_EQ(cylinders.size(), static_cast<size_t>(4));
+  EXPECT_TRUE(builder.atomsMatch(molecule));
+  EXPECT_TRUE(builder.bondsMatch(molecule));
+}
+
+TEST_F(BallAndStickBuilderTest, update)
+{
+  addFormaldehyde(molecule);
+  build();
+  const CylinderGeometry& constCylinders = cylinders;
+  const Vector3f hydrogenEnd = constCylinders.cylinders()[3].end2;
+
+  molecule.setAtomPosition3d(2, Vector3(1.0, 1.0, -0.5));
+  molecule.setAtomSelected(0, true);
+  ASSERT_TRUE(builder.atomsMatch(molecule));
+  ASSERT_TRUE(builder.bondsMatch(molecule));
+  builder.update(molecule);
+
+  const SphereGeometry& constSpheres = spheres;
+  EXPECT_EQ(spheres.size(), static_cast<size_t>(4));
+  EXPECT_EQ(constSpheres.spheres()[2].center, Vector3f(1.0f, 1.0f, -0.5f));
+  ASSERT_EQ(selectedSpheres.size(), static_cast<size_t>(1));
+  EXPECT_EQ(selectedSpheres.spheres()[0].center, Vector3f::Zero());
+  ASSERT_EQ(cylinders.size(), static_cast<size_t>(4));
+  EXPECT_EQ(constCylinders.cylinders()[2].end2, Vector3f(1.0f, 1.0f, -0.5f));
+  EXPECT_EQ(constCylinders.cylinders()[3].end2, hydrogenEnd);
+
+  // deselecting removes the selection sphere
+  molecule.setAtomSelected(0, false);
+  builder.update(molecule);
+  EXPECT_EQ(selectedSpheres.size(), static_cast<size_t>(0));
+}
+
+TEST_F(BallAndStickBuilderTest, addAtomsAndBonds)
+{
+  addFormaldehyde(molecule);
+  build();
+
+  // as the editor does, an atom bonded to an existing one
+  molecule.addAtom(9).setPosition3d(Vector3(0.0, 2.0, 0.0));
+  molecule.addBond(0, 4, 1);
+  molecule.setAtomPosition3d(0, Vector3(0.0, 0.1, 0.0));
+  ASSERT_TRUE(builder.atomsMatch(molecule));
+  ASSERT_FALSE(builder.bondsMatch(molecule));
+  builder.clearBonds();
+  builder.update(molecule);
+  for (Index i = builder.atomCount(); i < molecule.atomCount(); ++i)
+    builder.addAtom(molecule, i, 0.5f);
+  for (Index i = 0; i < molecule.bondCount(); ++i)
+    addBond(i);
+  builder.finish(molecule);
+
+  const SphereGeometry& constSpheres = spheres;
+  const CylinderGeometry& constCylinders = cylinders;
+  EXPECT_EQ(builder.atomCount(), static_cast<Index>(5));
+  ASSERT_EQ(spheres.size(), static_cast<size_t>(5));
+  EXPECT_EQ(constSpheres.spheres()[0].center, Vector3f(0.0f, 0.1f, 0.0f));
+  EXPECT_EQ(constSpheres.spheres()[4].center, Vector3f(0.0f, 2.0f, 0.0f));
+  ASSERT_EQ(cylinders.size(), static_cast<size_t>(5));
+  EXPECT_EQ(constCylinders.cylinders()[4].end2, Vector3f(0.0f, 2.0f, 0.0f));
+  EXPECT_TRUE(builder.atomsMatch(molecule));
+  EXPECT_TRUE(builder.bondsMatch(molecule));
+
+  // a changed bond order is a bond change too
+  molecule.bond(1).setOrder(2);
+  EXPECT_TRUE(builder.atomsMatch(molecule));
+  EXPECT_FALSE(builder.bondsMatch(molecule));
+}
+
+TEST_F(BallAndStickBuilderTest, atomsMismatch)
+{
+  addFormaldehyde(molecule);
+  build();
+
+  // another element may be drawn differently, e.g. hidden hydrogens
+  molecule.setAtomicNumber(3, 6);
+  EXPECT_FALSE(builder.atomsMatch(molecule));
+  molecule.setAtomicNumber(3, 1);
+  EXPECT_TRUE(builder.atomsMatch(molecule));
+
+  // so may an atom moved to another layer
+  molecule.layer().addLayer();
+  molecule.layer().addAtom(1, 2);
+  EXPECT_FALSE(builder.atomsMatch(molecule));
+  molecule.layer().addAtom(0, 2);
+  EXPECT_TRUE(builder.atomsMatch(molecule));
+
+  molecule.removeAtom(3);
+  EXPECT_FALSE(builder.atomsMatch(molecule));
+}
@@ -0,0 +1,174 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/vector.h>
+#include <avogadro/rendering/boundingvolumehierarchy.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using Avogadro::Frustrum;
+using Avogadro::Index;
+using Avogadro::Vector3f;
+using Avogadro::Rendering::BoundingVolumeHierarchy;
+
+typedef BoundingVolumeHierarchy::Box Box;
+
+namespace {
+
+std::vector<Box> randomBoxes(size_t count)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+  std::uniform_real_distribution<float> size(0.1f, 1.0f);
+  std::vector<Box> boxes;
+  for (size_t i = 0; i < count; ++i) {
+    const Vector3f center(position(generator), position(generator),
+                          position(generator));
+    boxes.emplace_back(center.array() - size(generator),
+                       center.array() + size(generator));
+  }
+  return boxes;
+}
+
+// The column -limit < x, y < limit, as GLRenderer::hits builds it.
+Frustrum column(float limit)
+{
+  Frustrum frustrum;
+  const Vector3f normals[4] = { Vector3f(1, 0, 0), Vector3f(-1, 0, 0),
+                                Vector3f(0, 1, 0), Vector3f(0, -1, 0) };
+  for (int i = 0; i < 4; ++i) {
+    frustrum.planes[i] = normals[i];
+    frustrum.points[2 * i] = limit * normals[i];
+    frustrum.points[2 * i + 1] = limit * normals[i] + Vector3f(0, 0, 1);
+  }
+  return frustrum;
+}
+
+} // namespace
+
+TEST(BoundingVolumeHierarchyTest, empty)
+{
+  BoundingVolumeHierarchy bvh;
+  EXPECT_TRUE(bvh.isEmpty());
+  std::vector<Index> candidates;
+  bvh.intersect(Vector3f::Zero(), Vector3f::Ones(), candidates);
+  EXPECT_TRUE(candidates.empty());
+
+  bvh.build(randomBoxes(10));
+  EXPECT_FALSE(bvh.isEmpty());
+  EXPECT_EQ(bvh.size(), static_cast<Index>(10));
+  bvh.clear();
+  EXPECT_TRUE(bvh.isEmpty());
+  EXPECT_TRUE(bvh.bounds().isEmpty());
+}
+
+TEST(BoundingVolumeHierarchyTest, segments)
+{
+  const std::vector<Box> boxes = randomBoxes(1000);
+  BoundingVolumeHierarchy bvh;
+  bvh.build(boxes);
+
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> position(-12.0f, 12.0f);
+  for (int ray = 0; ray < 20; ++ray) {
+    Vector3f origin(position(generator), position(generator), -20.0f);
+    Vector3f end(position(generator), position(generator), 20.0f);
+    // also axis-aligned segments, which have infinite inverse directions
+    if (ray % 5 == 0)
+      end.head<2>() = origin.head<2>();
+
+    std::vector<Index> candidates;
+    bvh.intersect(origin, end, candidates);
+    std::sort(candidates.begin(), candidates.end());
+
+    // every box the segment passes through must be a candidate
+    for (Index i = 0; i < boxes.size(); ++i) {
+      bool hit = false;
+      for (int step = 0; step <= 400 && !hit; ++step)
+        hit = boxes[i].contains(origin + (end - origin) * (step / 400.0f));
+      if (hit) {
+        EXPECT_TRUE(
+          std::binary_search(candidates.begin(), candidates.end(), i));
+      }
+    }
+    EXPECT_LT(candidates.size(), boxes.size() / 4);
+  }
+
+  // a segment that stops short of all boxes
+  std::vector<Index> candidates;
+  bvh.intersect(Vector3f(0, 0, -20), Vector3f(0, 0, -15), candidates);
+  EXPECT_TRUE(candidates.empty());
+}
+
+TEST(BoundingVolumeHierarchyTest, frustrum)
+{
+  const std::vector<Box> boxes = randomBoxes(1000);
+  BoundingVolumeHierarchy bvh;
+  bvh.build(boxes);
+
+  const float limit = 4.0f;
+  std::vector<Index> inside;
+  std::vector<Index> candidates;
+  bvh.intersect(column(limit), inside, candidates);
+
+  std::vector<Index> all(inside);
+  all.insert(all.end(), candidates.begin(), candidates.end());
+  std::sort(all.begin(), all.end());
+  EXPECT_TRUE(std::adjacent_find(all.begin(), all.end()) == all.end());
+
+  EXPECT_FALSE(inside.empty());
+  EXPECT_LT(all.size(), boxes.size() / 2);
+  for (Index i = 0; i < boxes.size(); ++i) {
+    const Vector3f& min = boxes[i].min();
+    const Vector3f& max = boxes[i].max();
+    const bool contained = min.x() > -limit && max.x() < limit &&
+                           min.y() > -limit && max.y() < limit;
+    const bool disjoint = min.x() > limit || max.x() < -limit ||
+                          min.y() > limit || max.y() < -limit;
+    if (!disjoint) {
+      EXPECT_TRUE(std::binary_search(all.begin(), all.end(), i));
+    }
+    if (std::find(inside.begin(), inside.end(), i) != inside.end()) {
+      EXPECT_TRUE(contained);
+    }
+  }
+}
+
+TEST(BoundingVolumeHierarchyTest, update)
+{
+  std::vector<Box> boxes = randomBoxes(1000);
+  BoundingVolumeHierarchy bvh;
+  bvh.build(boxes);
+
+  // move a few boxes far out, then one back inside
+  const Vector3f offset(100, 0, 0);
+  for (Index i : { 3, 500, 999 }) {
+    boxes[i].translate(offset);
+    bvh.update(i, boxes[i]);
+  }
+  boxes[500].translate(-2 * offset);
+  bvh.update(500, boxes[500]);
+  bvh.update(boxes.size(), Box(Vector3f::Zero(), Vector3f::Ones()));
+
+  Box all;
+  for (const Box& box : boxes)
+    all.extend(box);
+  EXPECT_EQ(bvh.bounds().min(), all.min());
+  EXPECT_EQ(bvh.bounds().max(), all.max());
+
+  // segments through the moved boxes find them where they are now
+  for (Index i : { 3, 500, 999 }) {
+    const Vector3f center = boxes[i].center();
+    std::vector<Index> candidates;
+    bvh.intersect(center - Vector3f(0, 0, 50), center + Vector3f(0, 0, 50),
+                  candidates);
+    EXPECT_TRUE(std::find(candidates.begin(), candidates.end(), i) !=
+                candidates.end());
+  }
+}
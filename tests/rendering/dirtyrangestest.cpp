@@ -0,0 +1,65 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/rendering/dirtyranges.h>
+
+using Avogadro::Index;
+using Avogadro::Rendering::DirtyRanges;
+
+typedef DirtyRanges::Range Range;
+
+TEST(DirtyRangesTest, empty)
+{
+  DirtyRanges ranges;
+  EXPECT_TRUE(ranges.isEmpty());
+  EXPECT_EQ(ranges.count(), static_cast<Index>(0));
+  ranges.add(5);
+  EXPECT_FALSE(ranges.isEmpty());
+  ranges.clear();
+  EXPECT_TRUE(ranges.isEmpty());
+  EXPECT_EQ(ranges.count(), static_cast<Index>(0));
+}
+
+TEST(DirtyRangesTest, disjoint)
+{
+  DirtyRanges ranges;
+  ranges.add(1000);
+  ranges.add(2);
+  ranges.add(2);
+  ranges.add(3);
+  ranges.add(1);
+  ranges.add(999);
+  ASSERT_EQ(ranges.ranges().size(), static_cast<size_t>(2));
+  EXPECT_EQ(ranges.ranges()[0], Range(1, 4));
+  EXPECT_EQ(ranges.ranges()[1], Range(999, 1001));
+  EXPECT_EQ(ranges.count(), static_cast<Index>(5));
+
+  // filling the gap joins the ranges on both sides
+  ranges.add(5);
+  ranges.add(4);
+  ASSERT_EQ(ranges.ranges().size(), static_cast<size_t>(2));
+  EXPECT_EQ(ranges.ranges()[0], Range(1, 6));
+  EXPECT_EQ(ranges.count(), static_cast<Index>(7));
+}
+
+TEST(DirtyRangesTest, maxRanges)
+{
+  DirtyRanges ranges(3);
+  ranges.add(0);
+  ranges.add(100);
+  ranges.add(200);
+  ranges.add(205);
+  // 200 and 205 are closest, so they are merged along with the gap
+  ASSERT_EQ(ranges.ranges().size(), static_cast<size_t>(3));
+  EXPECT_EQ(ranges.ranges()[0], Range(0, 1));
+  EXPECT_EQ(ranges.ranges()[1], Range(100, 101));
+  EXPECT_EQ(ranges.ranges()[2], Range(200, 206));
+  EXPECT_EQ(ranges.count(), static_cast<Index>(8));
+
+  ranges.add(203);
+  EXPECT_EQ(ranges.count(), static_cast<Index>(8));
+}
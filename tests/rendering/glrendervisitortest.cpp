@@ -0,0 +1,219 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/vector.h>
+#include <avogadro/rendering/camera.h>
+#include <avogadro/rendering/cylindergeometry.h>
+#include <avogadro/rendering/geometrynode.h>
+#include <avogadro/rendering/glrendervisitor.h>
+#include <avogadro/rendering/linestripgeometry.h>
+#include <avogadro/rendering/meshgeometry.h>
+#include <avogadro/rendering/scene.h>
+#include <avogadro/rendering/spheregeometry.h>
+
+using Avogadro::Vector3f;
+using Avogadro::Vector3ub;
+using Avogadro::Core::Array;
+using Avogadro::Rendering::Camera;
+using Avogadro::Rendering::CylinderGeometry;
+using Avogadro::Rendering::Drawable;
+using Avogadro::Rendering::GeometryNode;
+using Avogadro::Rendering::GLRenderVisitor;
+using Avogadro::Rendering::LineStripGeometry;
+using Avogadro::Rendering::MeshGeometry;
+using Avogadro::Rendering::Scene;
+using Avogadro::Rendering::SphereGeometry;
+
+namespace {
+
+// A 400x300 view with a 45 degree field of view, looking down -z from the
+// origin at a scene pushed back by the given distance.
+Camera camera(float distance)
+{
+  Camera result;
+  result.setViewport(400, 300);
+  result.calculatePerspective(45.0f, 1.0f, 2.0f * distance);
+  result.translate(Vector3f(0.0f, 0.0f, -distance));
+  return result;
+}
+
+} // namespace
+
+TEST(GLRenderVisitorTest, culling)
+{
+  GLRenderVisitor visitor(camera(10.0f));
+  SphereGeometry spheres;
+
+  // nothing to draw
+  EXPECT_FALSE(visitor.shouldRender(spheres));
+
+  spheres.addSphere(Vector3f(0.0f, 0.0f, 0.0f), Vector3ub(255, 0, 0), 1.0f);
+  EXPECT_TRUE(visitor.shouldRender(spheres));
+
+  // off to the side, and behind the eye
+  spheres.setSphere(0, Vector3f(100.0f, 0.0f, 0.0f), Vector3ub(255, 0, 0),
+                    1.0f);
+  EXPECT_FALSE(visitor.shouldRender(spheres));
+  spheres.setSphere(0, Vector3f(0.0f, 0.0f, 20.0f), Vector3ub(255, 0, 0), 1.0f);
+  EXPECT_FALSE(visitor.shouldRender(spheres));
+
+  // a sphere reaching into the view from the side
+  spheres.setSphere(0, Vector3f(5.0f, 0.0f, 0.0f), Vector3ub(255, 0, 0), 1.5f);
+  EXPECT_TRUE(visitor.shouldRender(spheres));
+
+  // a box over the whole view, with spheres well out of it at each end
+  spheres.addSphere(Vector3f(-100.0f, 0.0f, 0.0f), Vector3ub(255, 0, 0), 1.0f);
+  spheres.setSphere(0, Vector3f(100.0f, 0.0f, 0.0f), Vector3ub(255, 0, 0),
+                    1.0f);
+  EXPECT_TRUE(visitor.shouldRender(spheres));
+
+  spheres.clear();
+  spheres.addSphere(Vector3f(100.0f, 0.0f, 0.0f), Vector3ub(255, 0, 0), 1.0f);
+  visitor.setCulling(false);
+  EXPECT_TRUE(visitor.shouldRender(spheres));
+
+  // drawables without bounds are always rendered
+  visitor.setCulling(true);
+  Drawable drawable;
+  EXPECT_TRUE(visitor.shouldRender(drawable));
+}
+
+TEST(GLRenderVisitorTest, levelOfDetail)
+{
+  SphereGeometry spheres;
+  CylinderGeometry cylinders;
+  spheres.addSphere(Vector3f(0.0f, 0.0f, 0.0f), Vector3ub(255, 0, 0), 0.5f);
+  spheres.addSphere(Vector3f(1.5f, 0.0f, 0.0f), Vector3ub(255, 0, 0), 0.5f);
+  cylinders.addCylinder(Vector3f(0.0f, 0.0f, 0.0f), Vector3f(1.5f, 0.0f, 0.0f),
+                        0.1f, Vector3ub(100, 100, 100));
+  EXPECT_FLOAT_EQ(spheres.detailRadius(), 0.0f);
+  EXPECT_FLOAT_EQ(cylinders.detailRadius(), 0.1f);
+
+  // a few pixels across up close
+  GLRenderVisitor visitor(camera(10.0f));
+  EXPECT_TRUE(visitor.shouldRender(spheres));
+  EXPECT_TRUE(visitor.shouldRender(cylinders));
+
+  // the bonds are a small fraction of a pixel far away, the atoms still show
+  visitor.setCamera(camera(5000.0f));
+  EXPECT_TRUE(visitor.shouldRender(spheres));
+  EXPECT_FALSE(visitor.shouldRender(cylinders));
+
+  visitor.setDetailThreshold(0.0f);
+  EXPECT_TRUE(visitor.shouldRender(cylinders));
+
+  // zooming an orthographic view in brings them back
+  visitor.setDetailThreshold(0.25f);
+  Camera orthographic;
+  orthographic.setViewport(400, 300);
+  orthographic.calculateOrthographic(-2000.0f, 2000.0f, -1500.0f, 1500.0f,
+                                     -10.0f, 10.0f);
+  visitor.setCamera(orthographic);
+  EXPECT_FALSE(visitor.shouldRender(cylinders));
+  orthographic.calculateOrthographic(-20.0f, 20.0f, -15.0f, 15.0f, -10.0f,
+                                     10.0f);
+  visitor.setCamera(orthographic);
+  EXPECT_TRUE(visitor.shouldRender(cylinders));
+}
+
+TEST(GLRenderVisitorTest, bounds)
+{
+  Scene scene;
+  auto* node = new GeometryNode;
+  scene.rootNode().addChild(node);
+  auto* spheres = new SphereGeometry;
+  spheres->addSphere(Vector3f(1.0f, 2.0f, 3.0f), Vector3ub(255, 0, 0), 1.0f);
+  spheres->addSphere(Vector3f(-1.0f, 0.0f, 1.0f), Vector3ub(255, 0, 0), 0.5f);
+  node->addDrawable(spheres);
+  auto* cylinders = new CylinderGeometry;
+  cylinders->addCylinder(Vector3f(0.0f, 0.0f, 0.0f),
+                         Vector3f(0.0f, 0.0f, -4.0f), 0.25f,
+                         Vector3ub(100, 100, 100));
+  node->addDrawable(cylinders);
+
+  Eigen::AlignedBox3f box;
+  ASSERT_TRUE(spheres->bounds(box));
+  EXPECT_TRUE(box.min().isApprox(Vector3f(-1.5f, -0.5f, 0.5f)));
+  EXPECT_TRUE(box.max().isApprox(Vector3f(2.0f, 3.0f, 4.0f)));
+
+  // the cached bounds follow changes made in place
+  spheres->setSphere(1, Vector3f(-3.0f, 0.0f, 1.0f), Vector3ub(255, 0, 0),
+                     0.5f);
+  ASSERT_TRUE(spheres->bounds(box));
+  EXPECT_TRUE(box.min().isApprox(Vector3f(-3.5f, -0.5f, 0.5f)));
+
+  ASSERT_TRUE(scene.bounds(box));
+  EXPECT_TRUE(box.min().isApprox(Vector3f(-3.5f, -0.5f, -4.25f)));
+  EXPECT_TRUE(box.max().isApprox(Vector3f(2.0f, 3.0f, 4.0f)));
+
+  // hidden drawables are left out of the node
+  cylinders->setVisible(false);
+  ASSERT_TRUE(node->bounds(box));
+  EXPECT_FLOAT_EQ(box.min().z(), 0.5f);
+  cylinders->setVisible(true);
+
+  // one drawable without bounds makes those of the scene unknown
+  auto* lines = new LineStripGeometry;
+  Array<Vector3f> points;
+  points.push_back(Vector3f(0.0f, 0.0f, 0.0f));
+  points.push_back(Vector3f(50.0f, 0.0f, 0.0f));
+  lines->addLineStrip(points, 1.0f);
+  node->addDrawable(lines);
+  EXPECT_FALSE(node->bounds(box));
+  scene.setDirty(true);
+  EXPECT_FALSE(scene.bounds(box));
+}
+
+TEST(GLRenderVisitorTest, overlayFarFromOrigin)
+{
+  // a molecule far from the origin, with axes drawn in the corner of the view
+  // by a mesh placed at the origin
+  Scene scene;
+  auto* node = new GeometryNode;
+  scene.rootNode().addChild(node);
+  auto* spheres = new SphereGeometry;
+  spheres->addSphere(Vector3f(1000.0f, 1000.0f, 1000.0f),
+                     Vector3ub(255, 0, 0), 1.0f);
+  spheres->addSphere(Vector3f(1002.0f, 1000.0f, 1000.0f),
+                     Vector3ub(255, 0, 0), 1.0f);
+  node->addDrawable(spheres);
+  auto* axes = new MeshGeometry;
+  Array<Vector3f> vertices;
+  vertices.push_back(Vector3f(0.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(1.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(0.0f, 1.0f, 0.0f));
+  Array<Vector3f> normals(3, Vector3f(0.0f, 0.0f, 1.0f));
+  axes->addVertices(vertices, normals);
+  Array<unsigned int> triangle;
+  for (unsigned int i = 0; i < 3; ++i)
+    triangle.push_back(i);
+  axes->addTriangles(triangle);
+  axes->setRenderPass(Avogadro::Rendering::Overlay3DPass);
+  node->addDrawable(axes);
+
+  // the origin is left out of the scene
+  Eigen::AlignedBox3f box;
+  ASSERT_TRUE(scene.bounds(box));
+  EXPECT_TRUE(box.min().isApprox(Vector3f(999.0f, 999.0f, 999.0f)));
+  EXPECT_TRUE(box.max().isApprox(Vector3f(1003.0f, 1001.0f, 1001.0f)));
+
+  // looking at the molecule, the origin is well out of view but the axes
+  // are still drawn
+  Camera view = camera(10.0f);
+  view.translate(Vector3f(-1001.0f, -1000.0f, -1000.0f));
+  GLRenderVisitor visitor(view);
+  EXPECT_TRUE(visitor.shouldRender(*spheres));
+  ASSERT_TRUE(axes->bounds(box));
+  EXPECT_TRUE(visitor.shouldRender(*axes));
+
+  // the same mesh in the scene would be culled
+  axes->setRenderPass(Avogadro::Rendering::OpaquePass);
+  EXPECT_FALSE(visitor.shouldRender(*axes));
+  scene.setDirty(true);
+  ASSERT_TRUE(scene.bounds(box));
+  EXPECT_TRUE(box.min().isApprox(Vector3f(0.0f, 0.0f, 0.0f)));
+}
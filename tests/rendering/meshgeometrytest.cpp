@@ -0,0 +1,73 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/vector.h>
+#include <avogadro/rendering/meshgeometry.h>
+
+using Avogadro::Vector3f;
+using Avogadro::Core::Array;
+using Avogadro::Rendering::AtomType;
+using Avogadro::Rendering::MeshGeometry;
+
+namespace {
+
+// A strip of unit squares along x in the plane z = 0, two triangles each.
+void addStrip(MeshGeometry& mesh, unsigned int squares)
+{
+  Array<Vector3f> vertices;
+  Array<Vector3f> normals;
+  for (unsigned int i = 0; i <= squares; ++i) {
+    vertices.push_back(Vector3f(static_cast<float>(i), 0.0f, 0.0f));
+    vertices.push_back(Vector3f(static_cast<float>(i), 1.0f, 0.0f));
+    normals.push_back(Vector3f(0.0f, 0.0f, 1.0f));
+    normals.push_back(Vector3f(0.0f, 0.0f, 1.0f));
+  }
+  const unsigned int first = mesh.addVertices(vertices, normals);
+  for (unsigned int i = 0; i < squares; ++i) {
+    const unsigned int corner = first + 2 * i;
+    mesh.addTriangle(corner, corner + 2, corner + 1);
+    mesh.addTriangle(corner + 1, corner + 2, corner + 3);
+  }
+}
+
+} // namespace
+
+TEST(MeshGeometryTest, hits)
+{
+  MeshGeometry mesh;
+  addStrip(mesh, 100);
+  EXPECT_EQ(mesh.triangleCount(), static_cast<size_t>(200));
+
+  // nothing is picked without an identifier
+  const Vector3f origin(10.2f, 0.1f, 5.0f);
+  const Vector3f end(10.2f, 0.1f, -5.0f);
+  const Vector3f direction(0.0f, 0.0f, -1.0f);
+  EXPECT_TRUE(mesh.hits(origin, end, direction).empty());
+
+  mesh.identifier().type = AtomType;
+  auto hits = mesh.hits(origin, end, direction);
+  ASSERT_EQ(hits.size(), static_cast<size_t>(1));
+  EXPECT_EQ(hits.begin()->second.index, static_cast<size_t>(20));
+  EXPECT_NEAR(hits.begin()->first, 5.0f, 1e-5f);
+
+  // from behind, clipped before reaching the mesh, and beside it
+  EXPECT_EQ(mesh.hits(end, origin, -direction).size(), static_cast<size_t>(1));
+  EXPECT_TRUE(mesh.hits(origin, Vector3f(10.2f, 0.1f, 1.0f), direction).empty());
+  EXPECT_TRUE(mesh.hits(Vector3f(10.2f, 1.5f, 5.0f),
+                        Vector3f(10.2f, 1.5f, -5.0f), direction)
+                .empty());
+
+  // triangles added after picking are found
+  addStrip(mesh, 1);
+  mesh.clear();
+  EXPECT_TRUE(mesh.hits(origin, end, direction).empty());
+  addStrip(mesh, 20);
+  hits = mesh.hits(origin, end, direction);
+  ASSERT_EQ(hits.size(), static_cast<size_t>(1));
+  EXPECT_EQ(hits.begin()->second.index, static_cast<size_t>(20));
+}
@@ -20,11 +20,31 @@
 #include <avogadro/rendering/geometrynode.h>
 #include <avogadro/rendering/spheregeometry.h>
 
+#include <cmath>
+
+using Avogadro::Frustrum;
+using Avogadro::Rendering::AtomType;
 using Avogadro::Rendering::GeometryNode;
+using Avogadro::Rendering::Identifier;
 using Avogadro::Rendering::SphereGeometry;
 using Avogadro::Vector3f;
 using Avogadro::Vector3ub;
 
+namespace {
+
+// A 10x10x10 grid of spheres 2 apart, with the identifier set for picking.
+void addGrid(SphereGeometry& geometry)
+{
+  geometry.identifier().type = AtomType;
+  for (int i = 0; i < 1000; ++i) {
+    geometry.addSphere(
+      Vector3f(2.0f * (i % 10), 2.0f * (i / 10 % 10), 2.0f * (i / 100)),
+      Vector3ub(200, 100, 50), 0.5f);
+  }
+}
+
+} // namespace
+
 TEST(SphereGeometryTest, children)
 {
   GeometryNode root;
@@ -73,3 +93,108 @@ TEST(SphereGeometryTest, clear)
   node.clear();
   EXPECT_EQ(node.size(), static_cast<size_t>(0));
 }
+
+TEST(SphereGeometryTest, hits)
+{
+  SphereGeometry geometry;
+  addGrid(geometry);
+
+  // down the column of spheres at x = 4, y = 6, nearest first
+  const Vector3f origin(4.1f, 6.1f, -10.0f);
+  const Vector3f end(4.1f, 6.1f, 30.0f);
+  auto hits = geometry.hits(origin, end, (end - origin).normalized());
+  ASSERT_EQ(hits.size(), static_cast<size_t>(10));
+  EXPECT_EQ(hits.begin()->second.index, static_cast<size_t>(32));
+  EXPECT_NEAR(hits.begin()->first, 10.0f - std::sqrt(0.25f - 0.02f), 1e-4f);
+  EXPECT_EQ(hits.rbegin()->second.index, static_cast<size_t>(932));
+
+  // the ray is clipped at its end, and misses between the spheres
+  const Vector3f shortEnd(4.1f, 6.1f, 1.0f);
+  EXPECT_EQ(geometry.hits(origin, shortEnd, (end - origin).normalized()).size(),
+            static_cast<size_t>(1));
+  const Vector3f between(5.0f, 6.1f, -10.0f);
+  EXPECT_TRUE(geometry.hits(between, between + Vector3f(0, 0, 40),
+                            Vector3f(0, 0, 1))
+                .empty());
+
+  // spheres added after picking are found
+  geometry.addSphere(Vector3f(5.0f, 6.1f, 1.0f), Vector3ub(0, 0, 0), 0.5f);
+  hits =
+    geometry.hits(between, between + Vector3f(0, 0, 40), Vector3f(0, 0, 1));
+  ASSERT_EQ(hits.size(), static_cast<size_t>(1));
+  EXPECT_EQ(hits.begin()->second.index, static_cast<size_t>(1000));
+
+  // nothing is picked without an identifier
+  geometry.identifier().type = Avogadro::Rendering::InvalidType;
+  EXPECT_TRUE(geometry.hits(origin, end, Vector3f(0, 0, 1)).empty());
+}
+
+TEST(SphereGeometryTest, areaHits)
+{
+  SphereGeometry geometry;
+  addGrid(geometry);
+
+  // the column 3 < x, y < 9 holds the centers at 4, 6 and 8
+  Frustrum frustrum;
+  const Vector3f normals[4] = { Vector3f(1, 0, 0), Vector3f(-1, 0, 0),
+                                Vector3f(0, 1, 0), Vector3f(0, -1, 0) };
+  const Vector3f points[4] = { Vector3f(9, 0, 0), Vector3f(3, 0, 0),
+                               Vector3f(0, 9, 0), Vector3f(0, 3, 0) };
+  for (int i = 0; i < 4; ++i) {
+    frustrum.planes[i] = normals[i];
+    frustrum.points[2 * i] = points[i];
+    frustrum.points[2 * i + 1] = points[i] + Vector3f(0, 0, 1);
+  }
+
+  auto hits = geometry.areaHits(frustrum);
+  ASSERT_EQ(hits.size(), static_cast<size_t>(90));
+  for (size_t i = 0; i < hits.size(); ++i) {
+    const size_t x = hits[i].index % 10;
+    const size_t y = hits[i].index / 10 % 10;
+    EXPECT_TRUE(x >= 2 && x <= 4 && y >= 2 && y <= 4);
+    if (i > 0) {
+      EXPECT_LT(hits[i - 1].index, hits[i].index);
+    }
+  }
+
+  geometry.clear();
+  EXPECT_TRUE(geometry.areaHits(frustrum).empty());
+}
+
+TEST(SphereGeometryTest, setSphere)
+{
+  SphereGeometry geometry;
+  addGrid(geometry);
+  const Vector3f origin(20.0f, 20.0f, -10.0f);
+  const Vector3f end(20.0f, 20.0f, 30.0f);
+  EXPECT_TRUE(geometry.hits(origin, end, Vector3f(0, 0, 1)).empty());
+
+  Eigen::AlignedBox3f box;
+  geometry.bounds(box);
+  EXPECT_EQ(box.max(), Vector3f(18.5f, 18.5f, 18.5f));
+
+  // move a sphere in place, where the next pick finds it in the refit
+  // hierarchy, and out of the grid to grow the bounds
+  geometry.setSphere(123, Vector3f(20.0f, 20.0f, 5.0f), Vector3ub(1, 2, 3),
+                     1.0f);
+  EXPECT_EQ(geometry.size(), static_cast<size_t>(1000));
+  auto hits = geometry.hits(origin, end, Vector3f(0, 0, 1));
+  ASSERT_EQ(hits.size(), static_cast<size_t>(1));
+  EXPECT_EQ(hits.begin()->second.index, static_cast<size_t>(123));
+  EXPECT_NEAR(hits.begin()->first, 14.0f, 1e-5f);
+  geometry.bounds(box);
+  EXPECT_EQ(box.max(), Vector3f(21.0f, 21.0f, 18.5f));
+
+  // and back, which shrinks them again
+  geometry.setSphere(123, Vector3f(6.0f, 4.0f, 2.0f), Vector3ub(1, 2, 3),
+                     0.5f);
+  EXPECT_TRUE(geometry.hits(origin, end, Vector3f(0, 0, 1)).empty());
+  geometry.bounds(box);
+  EXPECT_EQ(box.max(), Vector3f(18.5f, 18.5f, 18.5f));
+  const SphereGeometry& constGeometry = geometry;
+  EXPECT_EQ(constGeometry.spheres()[123].color, Vector3ub(1, 2, 3));
+
+  // positions past the end are ignored
+  geometry.setSphere(1000, Vector3f::Zero(), Vector3ub(0, 0, 0), 1.0f);
+  EXPECT_EQ(geometry.size(), static_cast<size_t>(1000));
+}